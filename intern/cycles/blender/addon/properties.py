@@ -319,6 +319,13 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 min=0, max=1024,
                 default=3,
                 )
+        cls.use_importance_rr = BoolProperty(
+                name="Importance Termination",
+                description="Adapt probabilistic path termination to the brightness of each pixel, "
+                            "estimated from the samples rendered so far; spends more bounces in dark "
+                            "regions and fewer in overexposed ones",
+                default=False,
+                )
         cls.max_bounces = IntProperty(
                 name="Max Bounces",
                 description="Total maximum number of bounces",
@@ -528,6 +535,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 description="Use special type BVH optimized for hair (uses more ram but renders faster)",
                 default=True,
                 )
+        cls.debug_use_compact_geometry = BoolProperty(
+                name="Use Compact Geometry",
+                description="Store vertex normals, UV maps and hair keys in compressed form "
+                            "(uses less ram, slightly lower precision, CPU only)",
+                default=False,
+                )
         cls.debug_bvh_time_steps = IntProperty(
                 name="BVH Time Steps",
                 description="Split BVH primitives by this number of time steps to speed up render time in cost of memory",
@@ -1168,6 +1181,18 @@ class CyclesCurveRenderSettings(bpy.types.PropertyGroup):
                 min=0, max=24,
                 default=4,
                 )
+        cls.use_lod = BoolProperty(
+                name="Level of Detail",
+                description="Randomly remove strands that are thinner than the given pixel width, "
+                            "widening the remaining strands to preserve coverage",
+                default=False,
+                )
+        cls.lod_pixel_width = FloatProperty(
+                name="LOD Pixel Width",
+                description="Strands thinner than this width in pixels are thinned out",
+                min=0.01, max=100.0,
+                default=1.0,
+                )
 
     @classmethod
     def unregister(cls):
@@ -269,6 +269,12 @@ class CyclesRender_PT_geometry(CyclesButtonsPanel, Panel):
         row.prop(ccscene, "minimum_width", text="Min Pixels")
         row.prop(ccscene, "maximum_width", text="Max Extension")
 
+        row = col.row()
+        row.prop(ccscene, "use_lod", text="Level of Detail")
+        sub = row.row()
+        sub.active = ccscene.use_lod
+        sub.prop(ccscene, "lod_pixel_width", text="Pixels")
+
 
 class CyclesRender_PT_light_paths(CyclesButtonsPanel, Panel):
     bl_label = "Light Paths"
@@ -307,6 +313,7 @@ class CyclesRender_PT_light_paths(CyclesButtonsPanel, Panel):
         sub.label(text="Bounces:")
         sub.prop(cscene, "max_bounces", text="Max")
         sub.prop(cscene, "min_bounces", text="Min")
+        sub.prop(cscene, "use_importance_rr", text="Importance")
 
         sub = col.column(align=True)
         sub.prop(cscene, "diffuse_bounces", text="Diffuse")
@@ -428,6 +435,7 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
         col.label(text="Acceleration structure:")
         col.prop(cscene, "debug_use_spatial_splits")
         col.prop(cscene, "debug_use_hair_bvh")
+        col.prop(cscene, "debug_use_compact_geometry")
 
         row = col.row()
         row.active = not cscene.debug_use_spatial_splits
@@ -25,6 +25,7 @@
 #include "blender/blender_util.h"
 
 #include "util/util_foreach.h"
+#include "util/util_hash.h"
 #include "util/util_logging.h"
 
 CCL_NAMESPACE_BEGIN
@@ -72,6 +73,14 @@ static float shaperadius(float shape, float root, float tip, float time)
 	return (radius * (root - tip)) + tip;
 }
 
+/* Radius compensation for strands kept by level of detail pruning. */
+static float curve_radius_scale(ParticleCurveData *CData, int curve)
+{
+	if(curve < CData->curve_radius_scale.size())
+		return CData->curve_radius_scale[curve];
+	return 1.0f;
+}
+
 /* curve functions */
 
 static void InterpolateKeySegments(int seg,
@@ -325,6 +334,49 @@ static bool ObtainCacheParticleVcol(Mesh *mesh,
 	return true;
 }
 
+static void ApplyCurveLevelOfDetail(Camera *camera,
+                                    BL::Object *b_ob,
+                                    ParticleCurveData *CData,
+                                    float lod_pixel_width)
+{
+	/* Strands that are thinner than the given pixel width on screen are
+	 * randomly pruned, keeping a fraction proportional to their width. The
+	 * remaining strands are widened by the inverse of that fraction, so that
+	 * the overall coverage of the hair stays roughly the same. */
+	Transform tfm = get_transform(b_ob->matrix_world());
+	int num_culled = 0;
+
+	CData->curve_radius_scale.resize(CData->curve_keynum.size());
+
+	for(int sys = 0; sys < CData->psys_firstcurve.size(); sys++) {
+		for(int curve = CData->psys_firstcurve[sys]; curve < CData->psys_firstcurve[sys] + CData->psys_curvenum[sys]; curve++) {
+			CData->curve_radius_scale[curve] = 1.0f;
+
+			if(CData->curve_keynum[curve] <= 1)
+				continue;
+
+			float3 P = transform_point(&tfm, CData->curvekey_co[CData->curve_firstkey[curve]]);
+			float pixel_size = camera->world_to_raster_size(P);
+			float width = (pixel_size > 0.0f)? 2.0f*CData->psys_rootradius[sys]/pixel_size: lod_pixel_width;
+
+			if(width >= lod_pixel_width)
+				continue;
+
+			float keep = max(width/lod_pixel_width, 0.1f);
+
+			if((float)hash_int(curve)/(float)0xFFFFFFFF >= keep) {
+				CData->curve_keynum[curve] = 0;
+				num_culled++;
+			}
+			else {
+				CData->curve_radius_scale[curve] = 1.0f/keep;
+			}
+		}
+	}
+
+	VLOG(1) << "Hair level of detail pruned " << num_culled << " strands.";
+}
+
 static void set_resolution(BL::Object *b_ob, BL::Scene *scene, bool render)
 {
 	BL::Object::modifiers_iterator b_mod;
@@ -363,11 +415,12 @@ static void ExportCurveTrianglePlanes(Mesh *mesh, ParticleCurveData *CData,
 			if(CData->curve_keynum[curve] <= 1 || CData->curve_length[curve] == 0.0f)
 				continue;
 
+			const float radius_scale = curve_radius_scale(CData, curve);
 			float3 xbasis;
 			float3 v1;
 			float time = 0.0f;
 			float3 ickey_loc = CData->curvekey_co[CData->curve_firstkey[curve]];
-			float radius = shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], CData->psys_tipradius[sys], 0.0f);
+			float radius = radius_scale * shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], CData->psys_tipradius[sys], 0.0f);
 			v1 = CData->curvekey_co[CData->curve_firstkey[curve] + 1] - CData->curvekey_co[CData->curve_firstkey[curve]];
 			if(is_ortho)
 				xbasis = normalize(cross(RotCam, v1));
@@ -388,13 +441,13 @@ static void ExportCurveTrianglePlanes(Mesh *mesh, ParticleCurveData *CData,
 					v1 = CData->curvekey_co[curvekey + 1] - CData->curvekey_co[curvekey - 1];
 
 				time = CData->curvekey_time[curvekey]/CData->curve_length[curve];
-				radius = shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], CData->psys_tipradius[sys], time);
+				radius = radius_scale * shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], CData->psys_tipradius[sys], time);
 
 				if(curvekey == CData->curve_firstkey[curve] + CData->curve_keynum[curve] - 1)
-					radius = shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], CData->psys_tipradius[sys], 0.95f);
+					radius = radius_scale * shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], CData->psys_tipradius[sys], 0.95f);
 
 				if(CData->psys_closetip[sys] && (curvekey == CData->curve_firstkey[curve] + CData->curve_keynum[curve] - 1))
-					radius = shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], 0.0f, 0.95f);
+					radius = radius_scale * shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], 0.0f, 0.95f);
 
 				if(is_ortho)
 					xbasis = normalize(cross(RotCam, v1));
@@ -448,6 +501,7 @@ static void ExportCurveTriangleGeometry(Mesh *mesh,
 			if(CData->curve_keynum[curve] <= 1 || CData->curve_length[curve] == 0.0f)
 				continue;
 
+			const float radius_scale = curve_radius_scale(CData, curve);
 			float3 firstxbasis = cross(make_float3(1.0f,0.0f,0.0f),CData->curvekey_co[CData->curve_firstkey[curve]+1] - CData->curvekey_co[CData->curve_firstkey[curve]]);
 			if(!is_zero(firstxbasis))
 				firstxbasis = normalize(firstxbasis);
@@ -518,13 +572,13 @@ static void ExportCurveTriangleGeometry(Mesh *mesh,
 
 					InterpolateKeySegments(subv, 1, curvekey, curve, &ickey_loc, &time, CData);
 
-					float radius = shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], CData->psys_tipradius[sys], time);
+					float radius = radius_scale * shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], CData->psys_tipradius[sys], time);
 
 					if((curvekey == CData->curve_firstkey[curve] + CData->curve_keynum[curve] - 2) && (subv == 1))
-						radius = shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], CData->psys_tipradius[sys], 0.95f);
+						radius = radius_scale * shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], CData->psys_tipradius[sys], 0.95f);
 
 					if(CData->psys_closetip[sys] && (subv == 1) && (curvekey == CData->curve_firstkey[curve] + CData->curve_keynum[curve] - 2))
-						radius = shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], 0.0f, 0.95f);
+						radius = radius_scale * shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], 0.0f, 0.95f);
 
 					float angle = M_2PI_F / (float)resolution;
 					for(int section = 0; section < resolution; section++) {
@@ -595,12 +649,13 @@ static void ExportCurveSegments(Scene *scene, Mesh *mesh, ParticleCurveData *CDa
 			if(CData->curve_keynum[curve] <= 1 || CData->curve_length[curve] == 0.0f)
 				continue;
 
+			const float radius_scale = curve_radius_scale(CData, curve);
 			size_t num_curve_keys = 0;
 
 			for(int curvekey = CData->curve_firstkey[curve]; curvekey < CData->curve_firstkey[curve] + CData->curve_keynum[curve]; curvekey++) {
 				float3 ickey_loc = CData->curvekey_co[curvekey];
 				float time = CData->curvekey_time[curvekey]/CData->curve_length[curve];
-				float radius = shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], CData->psys_tipradius[sys], time);
+				float radius = radius_scale * shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], CData->psys_tipradius[sys], time);
 
 				if(CData->psys_closetip[sys] && (curvekey == CData->curve_firstkey[curve] + CData->curve_keynum[curve] - 1))
 					radius = 0.0f;
@@ -655,11 +710,12 @@ static void ExportCurveSegmentsMotion(Mesh *mesh, ParticleCurveData *CData, int
 			if(CData->curve_keynum[curve] <= 1 || CData->curve_length[curve] == 0.0f)
 				continue;
 
+			const float radius_scale = curve_radius_scale(CData, curve);
 			for(int curvekey = CData->curve_firstkey[curve]; curvekey < CData->curve_firstkey[curve] + CData->curve_keynum[curve]; curvekey++) {
 				if(i < mesh->curve_keys.size()) {
 					float3 ickey_loc = CData->curvekey_co[curvekey];
 					float time = CData->curvekey_time[curvekey]/CData->curve_length[curve];
-					float radius = shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], CData->psys_tipradius[sys], time);
+					float radius = radius_scale * shaperadius(CData->psys_shape[sys], CData->psys_rootradius[sys], CData->psys_tipradius[sys], time);
 
 					if(CData->psys_closetip[sys] && (curvekey == CData->curve_firstkey[curve] + CData->curve_keynum[curve] - 1))
 						radius = 0.0f;
@@ -806,6 +862,8 @@ void BlenderSync::sync_curve_settings()
 	curve_system_manager->use_curves = get_boolean(csscene, "use_curves");
 	curve_system_manager->minimum_width = get_float(csscene, "minimum_width");
 	curve_system_manager->maximum_width = get_float(csscene, "maximum_width");
+	curve_system_manager->use_lod = get_boolean(csscene, "use_lod");
+	curve_system_manager->lod_pixel_width = get_float(csscene, "lod_pixel_width");
 
 	curve_system_manager->primitive =
 	        (CurvePrimitiveType)get_enum(csscene,
@@ -916,6 +974,14 @@ void BlenderSync::sync_curves(Mesh *mesh,
 
 	ObtainCacheParticleData(mesh, &b_mesh, &b_ob, &CData, !preview);
 
+	if(scene->curve_system_manager->use_lod && scene->camera->type != CAMERA_PANORAMA) {
+		scene->camera->update();
+		ApplyCurveLevelOfDetail(scene->camera,
+		                        &b_ob,
+		                        &CData,
+		                        scene->curve_system_manager->lod_pixel_width);
+	}
+
 	/* add hair geometry to mesh */
 	if(primitive == CURVE_TRIANGLES) {
 		if(triangle_method == CURVE_CAMERA_TRIANGLES) {
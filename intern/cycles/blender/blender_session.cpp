@@ -193,6 +193,8 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 		 * them rather than trying to distinguish which settings need to be updated
 		 */
 
+		delete sync;
+		sync = NULL;
 		delete session;
 
 		create_session();
@@ -210,7 +212,8 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 	 */
 	session->stats.mem_peak = session->stats.mem_used;
 
-	/* sync object should be re-created */
+	/* sync object should be re-created, a bake batch may have kept the old one */
+	delete sync;
 	sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress, is_cpu);
 
 	/* for final render we will do full data sync per render layer, only
@@ -559,6 +562,12 @@ void BlenderSession::bake(BL::Object& b_object,
 {
 	ShaderEvalType shader_type = get_shader_type(pass_type);
 
+	/* In a bake batch Blender keeps this session alive between bakes, so the
+	 * scene, device data and BVH synced by the first bake are reused and the
+	 * following syncs only pick up what changed.
+	 */
+	const bool is_bake_batch = b_engine.is_bake_batch();
+
 	/* Set baking flag in advance, so kernel loading can check if we need
 	 * any baking capabilities.
 	 */
@@ -643,11 +652,12 @@ void BlenderSession::bake(BL::Object& b_object,
 	/* free all memory used (host and device), so we wouldn't leave render
 	 * engine with extra memory allocated
 	 */
+	if(!is_bake_batch) {
+		session->device_free();
 
-	session->device_free();
-
-	delete sync;
-	sync = NULL;
+		delete sync;
+		sync = NULL;
+	}
 }
 
 void BlenderSession::do_write_update_render_result(BL::RenderResult& b_rr,
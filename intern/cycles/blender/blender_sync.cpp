@@ -235,6 +235,7 @@ void BlenderSync::sync_integrator()
 	Integrator previntegrator = *integrator;
 
 	integrator->min_bounce = get_int(cscene, "min_bounces");
+	integrator->use_importance_rr = get_boolean(cscene, "use_importance_rr");
 	integrator->max_bounce = get_int(cscene, "max_bounces");
 
 	integrator->max_diffuse_bounce = get_int(cscene, "diffuse_bounces");
@@ -671,6 +672,9 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 		params.use_qbvh = false;
 	}
 
+	/* Compact normals and UVs are only decoded by the CPU kernel. */
+	params.use_compact_geometry = is_cpu && RNA_boolean_get(&cscene, "debug_use_compact_geometry");
+
 	return params;
 }
 
@@ -270,6 +270,7 @@ public:
 	void mem_alloc(const char *name, device_memory& mem, MemoryType /*type*/)
 	{
 		if(name) {
+			mem.name = name;
 			VLOG(1) << "Buffer allocate: " << name << ", "
 			        << string_human_readable_number(mem.memory_size()) << " bytes. ("
 			        << string_human_readable_size(mem.memory_size()) << ")";
@@ -282,7 +283,7 @@ public:
 		}
 
 		mem.device_size = mem.memory_size();
-		stats.mem_alloc(mem.device_size);
+		stats.mem_alloc(mem.device_size, mem.name, mem.owner);
 	}
 
 	void mem_copy_to(device_memory& /*mem*/)
@@ -309,7 +310,7 @@ public:
 				free((void*)mem.device_pointer);
 			}
 			mem.device_pointer = 0;
-			stats.mem_free(mem.device_size);
+			stats.mem_free(mem.device_size, mem.name, mem.owner);
 			mem.device_size = 0;
 		}
 	}
@@ -329,6 +330,8 @@ public:
 	               InterpolationType interpolation,
 	               ExtensionType extension)
 	{
+		mem.name = name;
+
 		VLOG(1) << "Texture allocate: " << name << ", "
 		        << string_human_readable_number(mem.memory_size()) << " bytes. ("
 		        << string_human_readable_size(mem.memory_size()) << ")";
@@ -342,14 +345,14 @@ public:
 		                extension);
 		mem.device_pointer = mem.data_pointer;
 		mem.device_size = mem.memory_size();
-		stats.mem_alloc(mem.device_size);
+		stats.mem_alloc(mem.device_size, mem.name, mem.owner);
 	}
 
 	void tex_free(device_memory& mem)
 	{
 		if(mem.device_pointer) {
 			mem.device_pointer = 0;
-			stats.mem_free(mem.device_size);
+			stats.mem_free(mem.device_size, mem.name, mem.owner);
 			mem.device_size = 0;
 		}
 	}
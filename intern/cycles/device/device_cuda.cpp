@@ -557,6 +557,7 @@ public:
 	void mem_alloc(const char *name, device_memory& mem, MemoryType /*type*/)
 	{
 		if(name) {
+			mem.name = name;
 			VLOG(1) << "Buffer allocate: " << name << ", "
 			        << string_human_readable_number(mem.memory_size()) << " bytes. ("
 			        << string_human_readable_size(mem.memory_size()) << ")";
@@ -568,7 +569,7 @@ public:
 		cuda_assert(cuMemAlloc(&device_pointer, size));
 		mem.device_pointer = (device_ptr)device_pointer;
 		mem.device_size = size;
-		stats.mem_alloc(size);
+		stats.mem_alloc(size, mem.name, mem.owner);
 		cuda_pop_context();
 	}
 
@@ -617,7 +618,7 @@ public:
 
 			mem.device_pointer = 0;
 
-			stats.mem_free(mem.device_size);
+			stats.mem_free(mem.device_size, mem.name, mem.owner);
 			mem.device_size = 0;
 		}
 	}
@@ -644,6 +645,8 @@ public:
 	               InterpolationType interpolation,
 	               ExtensionType extension)
 	{
+		mem.name = name;
+
 		VLOG(1) << "Texture allocate: " << name << ", "
 		        << string_human_readable_number(mem.memory_size()) << " bytes. ("
 		        << string_human_readable_size(mem.memory_size()) << ")";
@@ -823,7 +826,7 @@ public:
 			mem.device_pointer = (device_ptr)handle;
 			mem.device_size = size;
 
-			stats.mem_alloc(size);
+			stats.mem_alloc(size, mem.name, mem.owner);
 
 			/* Bindless Textures - Kepler */
 			if(has_bindless_textures) {
@@ -917,7 +920,7 @@ public:
 				tex_interp_map.erase(tex_interp_map.find(mem.device_pointer));
 				mem.device_pointer = 0;
 
-				stats.mem_free(mem.device_size);
+				stats.mem_free(mem.device_size, mem.name, mem.owner);
 				mem.device_size = 0;
 			}
 			else {
@@ -1565,7 +1568,7 @@ public:
 				pixel_mem_map[mem.device_pointer] = pmem;
 
 				mem.device_size = mem.memory_size();
-				stats.mem_alloc(mem.device_size);
+				stats.mem_alloc(mem.device_size, mem.name, mem.owner);
 
 				return;
 			}
@@ -1622,7 +1625,7 @@ public:
 				pixel_mem_map.erase(pixel_mem_map.find(mem.device_pointer));
 				mem.device_pointer = 0;
 
-				stats.mem_free(mem.device_size);
+				stats.mem_free(mem.device_size, mem.name, mem.owner);
 				mem.device_size = 0;
 
 				return;
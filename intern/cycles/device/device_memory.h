@@ -30,6 +30,7 @@
 
 #include "util/util_debug.h"
 #include "util/util_half.h"
+#include "util/util_string.h"
 #include "util/util_types.h"
 #include "util/util_vector.h"
 
@@ -192,6 +193,12 @@ public:
 	/* device pointer */
 	device_ptr device_pointer;
 
+	/* tags for memory usage statistics, name is set by the device when
+	 * allocating, owner optionally by whoever fills the memory (e.g. image
+	 * filename) */
+	string name;
+	string owner;
+
 	device_memory()
 	{
 		data_type = device_type_traits<uchar>::data_type;
@@ -108,6 +108,10 @@ public:
 
 	void mem_alloc(const char *name, device_memory& mem, MemoryType type)
 	{
+		if(name) {
+			mem.name = name;
+		}
+
 		foreach(SubDevice& sub, devices) {
 			mem.device_pointer = 0;
 			sub.device->mem_alloc(name, mem, type);
@@ -115,7 +119,7 @@ public:
 		}
 
 		mem.device_pointer = unique_ptr++;
-		stats.mem_alloc(mem.device_size);
+		stats.mem_alloc(mem.device_size, mem.name, mem.owner);
 	}
 
 	void mem_copy_to(device_memory& mem)
@@ -162,7 +166,7 @@ public:
 	void mem_free(device_memory& mem)
 	{
 		device_ptr tmp = mem.device_pointer;
-		stats.mem_free(mem.device_size);
+		stats.mem_free(mem.device_size, mem.name, mem.owner);
 
 		foreach(SubDevice& sub, devices) {
 			mem.device_pointer = sub.ptr_map[tmp];
@@ -185,6 +189,8 @@ public:
 	               interpolation,
 	               ExtensionType extension)
 	{
+		mem.name = name;
+
 		VLOG(1) << "Texture allocate: " << name << ", "
 		        << string_human_readable_number(mem.memory_size()) << " bytes. ("
 		        << string_human_readable_size(mem.memory_size()) << ")";
@@ -196,13 +202,13 @@ public:
 		}
 
 		mem.device_pointer = unique_ptr++;
-		stats.mem_alloc(mem.device_size);
+		stats.mem_alloc(mem.device_size, mem.name, mem.owner);
 	}
 
 	void tex_free(device_memory& mem)
 	{
 		device_ptr tmp = mem.device_pointer;
-		stats.mem_free(mem.device_size);
+		stats.mem_free(mem.device_size, mem.name, mem.owner);
 
 		foreach(SubDevice& sub, devices) {
 			mem.device_pointer = sub.ptr_map[tmp];
@@ -270,6 +270,7 @@ bool OpenCLDeviceBase::load_kernels(const DeviceRequestedFeatures& requested_fea
 void OpenCLDeviceBase::mem_alloc(const char *name, device_memory& mem, MemoryType type)
 {
 	if(name) {
+		mem.name = name;
 		VLOG(1) << "Buffer allocate: " << name << ", "
 			    << string_human_readable_number(mem.memory_size()) << " bytes. ("
 			    << string_human_readable_size(mem.memory_size()) << ")";
@@ -323,7 +324,7 @@ void OpenCLDeviceBase::mem_alloc(const char *name, device_memory& mem, MemoryTyp
 		mem.device_pointer = null_mem;
 	}
 
-	stats.mem_alloc(size);
+	stats.mem_alloc(size, mem.name, mem.owner);
 	mem.device_size = size;
 }
 
@@ -432,7 +433,7 @@ void OpenCLDeviceBase::mem_free(device_memory& mem)
 		}
 		mem.device_pointer = 0;
 
-		stats.mem_free(mem.device_size);
+		stats.mem_free(mem.device_size, mem.name, mem.owner);
 		mem.device_size = 0;
 	}
 }
@@ -496,6 +497,8 @@ void OpenCLDeviceBase::tex_alloc(const char *name,
                InterpolationType /*interpolation*/,
                ExtensionType /*extension*/)
 {
+	mem.name = name;
+
 	VLOG(1) << "Texture allocate: " << name << ", "
 	        << string_human_readable_number(mem.memory_size()) << " bytes. ("
 	        << string_human_readable_size(mem.memory_size()) << ")";
@@ -118,8 +118,8 @@ ccl_device float curve_thickness(KernelGlobals *kg, ShaderData *sd)
 		float4 P_curve[2];
 
 		if(sd->type & PRIMITIVE_CURVE) {
-			P_curve[0]= kernel_tex_fetch(__curve_keys, k0);
-			P_curve[1]= kernel_tex_fetch(__curve_keys, k1);
+			P_curve[0]= curve_key(kg, sd->prim, k0);
+			P_curve[1]= curve_key(kg, sd->prim, k1);
 		}
 		else {
 			motion_curve_keys(kg, sd->object, sd->prim, sd->time, k0, k1, P_curve);
@@ -142,8 +142,8 @@ ccl_device float3 curve_motion_center_location(KernelGlobals *kg, ShaderData *sd
 
 	float4 P_curve[2];
 
-	P_curve[0]= kernel_tex_fetch(__curve_keys, k0);
-	P_curve[1]= kernel_tex_fetch(__curve_keys, k1);
+	P_curve[0]= curve_key(kg, sd->prim, k0);
+	P_curve[1]= curve_key(kg, sd->prim, k1);
 
 	return float4_to_float3(P_curve[1]) * sd->u + float4_to_float3(P_curve[0]) * (1.0f - sd->u);
 }
@@ -272,7 +272,11 @@ ccl_device_curveintersect bool bvh_cardinal_curve_intersect(KernelGlobals *kg, I
 
 #if defined(__KERNEL_AVX2__) && defined(__KERNEL_SSE__) && (!defined(_MSC_VER) || _MSC_VER > 1800)
 		avxf P_curve_0_1, P_curve_2_3;
-		if(is_curve_primitive) {
+		if(is_curve_primitive && kernel_data.curve.use_compact_keys) {
+			P_curve_0_1 = avxf(curve_key(kg, prim, ka).m128, curve_key(kg, prim, k0).m128);
+			P_curve_2_3 = avxf(curve_key(kg, prim, k1).m128, curve_key(kg, prim, kb).m128);
+		}
+		else if(is_curve_primitive) {
 			P_curve_0_1 = _mm256_loadu2_m128(&kg->__curve_keys.data[k0].x, &kg->__curve_keys.data[ka].x);
 			P_curve_2_3 = _mm256_loadu2_m128(&kg->__curve_keys.data[kb].x, &kg->__curve_keys.data[k1].x);
 		}
@@ -283,7 +287,13 @@ ccl_device_curveintersect bool bvh_cardinal_curve_intersect(KernelGlobals *kg, I
 #else  /* __KERNEL_AVX2__ */
 		ssef P_curve[4];
 
-		if(is_curve_primitive) {
+		if(is_curve_primitive && kernel_data.curve.use_compact_keys) {
+			P_curve[0] = load4f(curve_key(kg, prim, ka));
+			P_curve[1] = load4f(curve_key(kg, prim, k0));
+			P_curve[2] = load4f(curve_key(kg, prim, k1));
+			P_curve[3] = load4f(curve_key(kg, prim, kb));
+		}
+		else if(is_curve_primitive) {
 			P_curve[0] = load4f(&kg->__curve_keys.data[ka].x);
 			P_curve[1] = load4f(&kg->__curve_keys.data[k0].x);
 			P_curve[2] = load4f(&kg->__curve_keys.data[k1].x);
@@ -379,10 +389,10 @@ ccl_device_curveintersect bool bvh_cardinal_curve_intersect(KernelGlobals *kg, I
 		float4 P_curve[4];
 
 		if(is_curve_primitive) {
-			P_curve[0] = kernel_tex_fetch(__curve_keys, ka);
-			P_curve[1] = kernel_tex_fetch(__curve_keys, k0);
-			P_curve[2] = kernel_tex_fetch(__curve_keys, k1);
-			P_curve[3] = kernel_tex_fetch(__curve_keys, kb);
+			P_curve[0] = curve_key(kg, prim, ka);
+			P_curve[1] = curve_key(kg, prim, k0);
+			P_curve[2] = curve_key(kg, prim, k1);
+			P_curve[3] = curve_key(kg, prim, kb);
 		}
 		else {
 			int fobject = (object == OBJECT_NONE)? kernel_tex_fetch(__prim_object, curveAddr): object;
@@ -728,8 +738,8 @@ ccl_device_curveintersect bool bvh_curve_intersect(KernelGlobals *kg, Intersecti
 	float4 P_curve[2];
 
 	if(is_curve_primitive) {
-		P_curve[0] = kernel_tex_fetch(__curve_keys, k0);
-		P_curve[1] = kernel_tex_fetch(__curve_keys, k1);
+		P_curve[0] = curve_key(kg, prim, k0);
+		P_curve[1] = curve_key(kg, prim, k1);
 	}
 	else {
 		int fobject = (object == OBJECT_NONE)? kernel_tex_fetch(__prim_object, curveAddr): object;
@@ -762,7 +772,11 @@ ccl_device_curveintersect bool bvh_curve_intersect(KernelGlobals *kg, Intersecti
 #else
 	ssef P_curve[2];
 	
-	if(is_curve_primitive) {
+	if(is_curve_primitive && kernel_data.curve.use_compact_keys) {
+		P_curve[0] = load4f(curve_key(kg, prim, k0));
+		P_curve[1] = load4f(curve_key(kg, prim, k1));
+	}
+	else if(is_curve_primitive) {
 		P_curve[0] = load4f(&kg->__curve_keys.data[k0].x);
 		P_curve[1] = load4f(&kg->__curve_keys.data[k1].x);
 	}
@@ -997,10 +1011,10 @@ ccl_device_inline float3 bvh_curve_refine(KernelGlobals *kg, ShaderData *sd, con
 		float4 P_curve[4];
 
 		if(sd->type & PRIMITIVE_CURVE) {
-			P_curve[0] = kernel_tex_fetch(__curve_keys, ka);
-			P_curve[1] = kernel_tex_fetch(__curve_keys, k0);
-			P_curve[2] = kernel_tex_fetch(__curve_keys, k1);
-			P_curve[3] = kernel_tex_fetch(__curve_keys, kb);
+			P_curve[0] = curve_key(kg, prim, ka);
+			P_curve[1] = curve_key(kg, prim, k0);
+			P_curve[2] = curve_key(kg, prim, k1);
+			P_curve[3] = curve_key(kg, prim, kb);
 		}
 		else {
 			motion_cardinal_curve_keys(kg, sd->object, sd->prim, sd->time, ka, k0, k1, kb, P_curve);
@@ -1047,8 +1061,8 @@ ccl_device_inline float3 bvh_curve_refine(KernelGlobals *kg, ShaderData *sd, con
 		float4 P_curve[2];
 
 		if(sd->type & PRIMITIVE_CURVE) {
-			P_curve[0]= kernel_tex_fetch(__curve_keys, k0);
-			P_curve[1]= kernel_tex_fetch(__curve_keys, k1);
+			P_curve[0]= curve_key(kg, sd->prim, k0);
+			P_curve[1]= curve_key(kg, sd->prim, k1);
 		}
 		else {
 			motion_curve_keys(kg, sd->object, sd->prim, sd->time, k0, k1, P_curve);
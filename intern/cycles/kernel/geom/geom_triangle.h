@@ -74,15 +74,27 @@ ccl_device_inline void triangle_vertices(KernelGlobals *kg, int prim, float3 P[3
 	P[2] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
 }
 
+/* Vertex normal, optionally stored octahedral encoded on the CPU */
+
+ccl_device_inline float3 triangle_vertex_normal(KernelGlobals *kg, uint vertex)
+{
+#ifdef __KERNEL_CPU__
+	if(kernel_data.bvh.use_compact_geometry) {
+		return oct_normal_to_float3(kernel_tex_fetch(__tri_vnormal_compact, vertex));
+	}
+#endif
+	return float4_to_float3(kernel_tex_fetch(__tri_vnormal, vertex));
+}
+
 /* Interpolate smooth vertex normal from vertices */
 
 ccl_device_inline float3 triangle_smooth_normal(KernelGlobals *kg, float3 Ng, int prim, float u, float v)
 {
 	/* load triangle vertices */
 	const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
-	float3 n0 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.x));
-	float3 n1 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.y));
-	float3 n2 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.z));
+	float3 n0 = triangle_vertex_normal(kg, tri_vindex.x);
+	float3 n1 = triangle_vertex_normal(kg, tri_vindex.y);
+	float3 n2 = triangle_vertex_normal(kg, tri_vindex.z);
 
 	float3 N = safe_normalize((1.0f - u - v)*n2 + u*n0 + v*n1);
 
@@ -149,6 +161,20 @@ ccl_device float triangle_attribute_float(KernelGlobals *kg, const ShaderData *s
 	}
 }
 
+#ifdef __KERNEL_CPU__
+/* Two half floats packed into a uint, used for compact UV maps */
+ccl_device_inline float3 triangle_attribute_half2(KernelGlobals *kg, int index)
+{
+	uint packed = kernel_tex_fetch(__attributes_half2, index);
+	half hx = (half)(packed & 0xFFFF);
+	half hy = (half)(packed >> 16);
+	/* half_to_float() does not map zero back exactly. */
+	float x = (hx & 0x7FFF)? half_to_float(hx): 0.0f;
+	float y = (hy & 0x7FFF)? half_to_float(hy): 0.0f;
+	return make_float3(x, y, 0.0f);
+}
+#endif
+
 ccl_device float3 triangle_attribute_float3(KernelGlobals *kg, const ShaderData *sd, const AttributeDescriptor desc, float3 *dx, float3 *dy)
 {
 	if(desc.element == ATTR_ELEMENT_FACE) {
@@ -171,7 +197,10 @@ ccl_device float3 triangle_attribute_float3(KernelGlobals *kg, const ShaderData
 
 		return sd->u*f0 + sd->v*f1 + (1.0f - sd->u - sd->v)*f2;
 	}
-	else if(desc.element == ATTR_ELEMENT_CORNER || desc.element == ATTR_ELEMENT_CORNER_BYTE) {
+	else if(desc.element == ATTR_ELEMENT_CORNER ||
+	        desc.element == ATTR_ELEMENT_CORNER_BYTE ||
+	        desc.element == ATTR_ELEMENT_CORNER_HALF)
+	{
 		int tri = desc.offset + sd->prim*3;
 		float3 f0, f1, f2;
 
@@ -180,6 +209,13 @@ ccl_device float3 triangle_attribute_float3(KernelGlobals *kg, const ShaderData
 			f1 = float4_to_float3(kernel_tex_fetch(__attributes_float3, tri + 1));
 			f2 = float4_to_float3(kernel_tex_fetch(__attributes_float3, tri + 2));
 		}
+#ifdef __KERNEL_CPU__
+		else if(desc.element == ATTR_ELEMENT_CORNER_HALF) {
+			f0 = triangle_attribute_half2(kg, tri + 0);
+			f1 = triangle_attribute_half2(kg, tri + 1);
+			f2 = triangle_attribute_half2(kg, tri + 2);
+		}
+#endif
 		else {
 			f0 = color_byte_to_float(kernel_tex_fetch(__attributes_uchar4, tri + 0));
 			f1 = color_byte_to_float(kernel_tex_fetch(__attributes_uchar4, tri + 1));
@@ -450,6 +450,7 @@ ccl_device_inline float kernel_path_integrate(KernelGlobals *kg,
 
 	PathState state;
 	path_state_init(kg, &emission_sd, &state, rng, sample, &ray);
+	path_state_init_importance(kg, &state, buffer, sample);
 
 #ifdef __KERNEL_DEBUG__
 	DebugData debug_data;
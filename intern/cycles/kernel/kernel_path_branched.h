@@ -283,6 +283,7 @@ ccl_device float kernel_branched_path_integrate(KernelGlobals *kg,
 
 	PathState state;
 	path_state_init(kg, &emission_sd, &state, rng, sample, &ray);
+	path_state_init_importance(kg, &state, buffer, sample);
 
 #ifdef __KERNEL_DEBUG__
 	DebugData debug_data;
@@ -596,9 +597,10 @@ ccl_device float kernel_branched_path_integrate(KernelGlobals *kg,
 			}
 #endif  /* __EMISSION__ */
 
-			/* indirect light */
+			/* indirect light, split into more samples for important pixels */
+			float split = path_state_split_factor(&state);
 			kernel_branched_path_surface_indirect_light(kg, rng,
-				&sd, &indirect_sd, &emission_sd, throughput, 1.0f, &hit_state, L);
+				&sd, &indirect_sd, &emission_sd, throughput/split, split, &hit_state, L);
 
 			/* continue in case of transparency */
 			throughput *= shader_bsdf_transparency(kg, &sd);
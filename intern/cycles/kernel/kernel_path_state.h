@@ -47,6 +47,7 @@ ccl_device_inline void path_state_init(KernelGlobals *kg,
 
 	state->min_ray_pdf = FLT_MAX;
 	state->ray_pdf = 0.0f;
+	state->rr_importance = 1.0f;
 #ifdef __LAMP_MIS__
 	state->ray_t = 0.0f;
 #endif
@@ -187,7 +188,44 @@ ccl_device_inline float path_state_terminate_probability(KernelGlobals *kg, ccl_
 	}
 
 	/* probalistic termination */
-	return average(throughput); /* todo: try using max here */
+	float probability = average(throughput); /* todo: try using max here */
+
+	if(kernel_data.integrator.use_importance_rr) {
+		return min(probability * state->rr_importance, 1.0f);
+	}
+
+	return probability;
+}
+
+/* Estimate how much the paths of this pixel matter for the final image from
+ * the samples accumulated so far. Noise in dark pixels is much more visible
+ * after display transform than in bright or overexposed ones, so terminate
+ * paths less eagerly in the former and more eagerly in the latter. */
+ccl_device_inline void path_state_init_importance(KernelGlobals *kg,
+                                                  ccl_addr_space PathState *state,
+                                                  ccl_global float *buffer,
+                                                  int sample)
+{
+	if(!kernel_data.integrator.use_importance_rr ||
+	   sample < kernel_data.integrator.importance_rr_start_sample)
+	{
+		return;
+	}
+
+	/* combined pass is always first in the buffer, see kernel_write_result() */
+	float3 sum = make_float3(buffer[0], buffer[1], buffer[2]);
+	float luminance = linear_rgb_to_gray(sum) * kernel_data.film.exposure / sample;
+
+	/* sensitivity of display values to radiance is roughly 1/sqrt(luminance) */
+	float importance = 1.0f / sqrtf(max(luminance, 1e-8f));
+	state->rr_importance = clamp(importance, 0.25f, 4.0f);
+}
+
+/* Number of indirect samples to split into at a branched path vertex, only
+ * important pixels are split, others keep their regular sample count. */
+ccl_device_inline float path_state_split_factor(ccl_addr_space PathState *state)
+{
+	return max(sqrtf(state->rr_importance), 1.0f);
 }
 
 /* TODO(DingTo): Find more meaningful name for this */
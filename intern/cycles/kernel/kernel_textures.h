@@ -44,10 +44,17 @@ KERNEL_TEX(float4, texture_float4, __tri_vnormal)
 KERNEL_TEX(uint4, texture_uint4, __tri_vindex)
 KERNEL_TEX(uint, texture_uint, __tri_patch)
 KERNEL_TEX(float2, texture_float2, __tri_patch_uv)
+#ifdef __KERNEL_CPU__
+KERNEL_TEX(uint, texture_uint, __tri_vnormal_compact)
+#endif
 
 /* curves */
 KERNEL_TEX(float4, texture_float4, __curves)
 KERNEL_TEX(float4, texture_float4, __curve_keys)
+#ifdef __KERNEL_CPU__
+KERNEL_TEX(uint, texture_uint, __curve_keys_compact)
+KERNEL_TEX(float4, texture_float4, __curve_bounds)
+#endif
 
 /* patches */
 KERNEL_TEX(uint, texture_uint, __patches)
@@ -57,6 +64,9 @@ KERNEL_TEX(uint4, texture_uint4, __attributes_map)
 KERNEL_TEX(float, texture_float, __attributes_float)
 KERNEL_TEX(float4, texture_float4, __attributes_float3)
 KERNEL_TEX(uchar4, texture_uchar4, __attributes_uchar4)
+#ifdef __KERNEL_CPU__
+KERNEL_TEX(uint, texture_uint, __attributes_half2)
+#endif
 
 /* lights */
 KERNEL_TEX(float4, texture_float4, __light_distribution)
@@ -701,6 +701,7 @@ typedef enum AttributeElement {
 	ATTR_ELEMENT_VERTEX_MOTION,
 	ATTR_ELEMENT_CORNER,
 	ATTR_ELEMENT_CORNER_BYTE,
+	ATTR_ELEMENT_CORNER_HALF,  /* device only, compact UVs on the CPU */
 	ATTR_ELEMENT_CURVE,
 	ATTR_ELEMENT_CURVE_KEY,
 	ATTR_ELEMENT_CURVE_KEY_MOTION,
@@ -1017,6 +1018,7 @@ typedef struct PathState {
 	/* multiple importance sampling */
 	float min_ray_pdf; /* smallest bounce pdf over entire path up to now */
 	float ray_pdf;     /* last bounce pdf */
+	float rr_importance; /* pixel importance scale for russian roulette */
 #ifdef __LAMP_MIS__
 	float ray_t;       /* accumulated distance through transparent surfaces */
 #endif
@@ -1290,7 +1292,9 @@ typedef struct KernelIntegrator {
 	float light_inv_rr_threshold;
 
 	int start_sample;
-	int pad1, pad2, pad3;
+	int use_importance_rr;
+	int importance_rr_start_sample;
+	int pad1;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1303,7 +1307,7 @@ typedef struct KernelBVH {
 	int have_instancing;
 	int use_qbvh;
 	int use_bvh_steps;
-	int pad1;
+	int use_compact_geometry;
 } KernelBVH;
 static_assert_align(KernelBVH, 16);
 
@@ -1324,6 +1328,9 @@ typedef struct KernelCurves {
 
 	float minimum_width;
 	float maximum_width;
+
+	int use_compact_keys;
+	int pad1, pad2, pad3;
 } KernelCurves;
 static_assert_align(KernelCurves, 16);
 
@@ -121,6 +121,10 @@ void BakeManager::set_baking(const bool value)
 
 BakeData *BakeManager::init(const int object, const size_t tri_offset, const size_t num_pixels)
 {
+	/* the manager is reused by all bakes of a batch */
+	if(m_bake_data)
+		delete m_bake_data;
+
 	m_bake_data = new BakeData(object, tri_offset, num_pixels);
 	return m_bake_data;
 }
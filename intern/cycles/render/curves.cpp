@@ -89,11 +89,13 @@ CurveSystemManager::CurveSystemManager()
 
 	minimum_width = 0.0f;
 	maximum_width = 0.0f;
+	lod_pixel_width = 1.0f;
 
 	use_curves = true;
 	use_encasing = true;
 	use_backfacing = false;
 	use_tangent_normal_geometry = false;
+	use_lod = false;
 
 	need_update = true;
 	need_mesh_update = false;
@@ -166,7 +168,9 @@ bool CurveSystemManager::modified(const CurveSystemManager& CurveSystemManager)
 		triangle_method == CurveSystemManager.triangle_method &&
 		resolution == CurveSystemManager.resolution &&
 		use_curves == CurveSystemManager.use_curves &&
-		subdivisions == CurveSystemManager.subdivisions);
+		subdivisions == CurveSystemManager.subdivisions &&
+		use_lod == CurveSystemManager.use_lod &&
+		lod_pixel_width == CurveSystemManager.lod_pixel_width);
 }
 
 bool CurveSystemManager::modified_mesh(const CurveSystemManager& CurveSystemManager)
@@ -175,7 +179,9 @@ bool CurveSystemManager::modified_mesh(const CurveSystemManager& CurveSystemMana
 		curve_shape == CurveSystemManager.curve_shape &&
 		triangle_method == CurveSystemManager.triangle_method &&
 		resolution == CurveSystemManager.resolution &&
-		use_curves == CurveSystemManager.use_curves);
+		use_curves == CurveSystemManager.use_curves &&
+		use_lod == CurveSystemManager.use_lod &&
+		lod_pixel_width == CurveSystemManager.lod_pixel_width);
 }
 
 void CurveSystemManager::tag_update(Scene * /*scene*/)
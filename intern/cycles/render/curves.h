@@ -75,6 +75,7 @@ public:
 	array<int> curve_firstkey;
 	array<int> curve_keynum;
 	array<float> curve_length;
+	array<float> curve_radius_scale;
 	array<float3> curve_uv;
 	array<float3> curve_vcol;
 
@@ -97,10 +98,15 @@ public:
 	float minimum_width;
 	float maximum_width;
 
+	/* Strands thinner than this many pixels are stochastically pruned,
+	 * with the remaining strands widened to preserve coverage. */
+	float lod_pixel_width;
+
 	bool use_curves;
 	bool use_encasing;
 	bool use_backfacing;
 	bool use_tangent_normal_geometry;
+	bool use_lod;
 
 	bool need_update;
 	bool need_mesh_update;
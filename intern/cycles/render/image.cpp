@@ -744,6 +744,7 @@ void ImageManager::device_load_image(Device *device,
 
 		if(!pack_images) {
 			thread_scoped_lock device_lock(device_mutex);
+			tex_img.owner = img->filename;
 			device->tex_alloc(name.c_str(),
 			                  tex_img,
 			                  img->interpolation,
@@ -773,6 +774,7 @@ void ImageManager::device_load_image(Device *device,
 
 		if(!pack_images) {
 			thread_scoped_lock device_lock(device_mutex);
+			tex_img.owner = img->filename;
 			device->tex_alloc(name.c_str(),
 			                  tex_img,
 			                  img->interpolation,
@@ -805,6 +807,7 @@ void ImageManager::device_load_image(Device *device,
 
 		if(!pack_images) {
 			thread_scoped_lock device_lock(device_mutex);
+			tex_img.owner = img->filename;
 			device->tex_alloc(name.c_str(),
 			                  tex_img,
 			                  img->interpolation,
@@ -833,6 +836,7 @@ void ImageManager::device_load_image(Device *device,
 
 		if(!pack_images) {
 			thread_scoped_lock device_lock(device_mutex);
+			tex_img.owner = img->filename;
 			device->tex_alloc(name.c_str(),
 			                  tex_img,
 			                  img->interpolation,
@@ -864,6 +868,7 @@ void ImageManager::device_load_image(Device *device,
 
 		if(!pack_images) {
 			thread_scoped_lock device_lock(device_mutex);
+			tex_img.owner = img->filename;
 			device->tex_alloc(name.c_str(),
 			                  tex_img,
 			                  img->interpolation,
@@ -892,6 +897,7 @@ void ImageManager::device_load_image(Device *device,
 
 		if(!pack_images) {
 			thread_scoped_lock device_lock(device_mutex);
+			tex_img.owner = img->filename;
 			device->tex_alloc(name.c_str(),
 			                  tex_img,
 			                  img->interpolation,
@@ -33,6 +33,7 @@ NODE_DEFINE(Integrator)
 
 	SOCKET_INT(min_bounce, "Min Bounce", 2);
 	SOCKET_INT(max_bounce, "Max Bounce", 7);
+	SOCKET_BOOLEAN(use_importance_rr, "Use Importance Russian Roulette", false);
 
 	SOCKET_INT(max_diffuse_bounce, "Max Diffuse Bounce", 7);
 	SOCKET_INT(max_glossy_bounce, "Max Glossy Bounce", 7);
@@ -105,6 +106,10 @@ void Integrator::device_update(Device *device, DeviceScene *dscene, Scene *scene
 	/* integrator parameters */
 	kintegrator->max_bounce = max_bounce + 1;
 	kintegrator->min_bounce = min_bounce + 1;
+	kintegrator->use_importance_rr = use_importance_rr;
+	/* pixel estimates from the first few samples are too noisy to drive
+	 * path termination, so only use them after a short warm-up */
+	kintegrator->importance_rr_start_sample = 16;
 
 	kintegrator->max_diffuse_bounce = max_diffuse_bounce + 1;
 	kintegrator->max_glossy_bounce = max_glossy_bounce + 1;
@@ -33,6 +33,7 @@ public:
 
 	int min_bounce;
 	int max_bounce;
+	bool use_importance_rr;
 
 	int max_diffuse_bounce;
 	int max_glossy_bounce;
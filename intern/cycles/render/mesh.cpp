@@ -34,6 +34,7 @@
 #include "subd/subd_patch_table.h"
 
 #include "util/util_foreach.h"
+#include "util/util_half.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
 #include "util/util_set.h"
@@ -865,7 +866,7 @@ void Mesh::add_undisplaced()
 	}
 }
 
-void Mesh::pack_normals(Scene *scene, uint *tri_shader, float4 *vnormal)
+void Mesh::pack_normals(Scene *scene, uint *tri_shader, float4 *vnormal, uint *vnormal_compact)
 {
 	Attribute *attr_vN = attributes.find(ATTR_STD_VERTEX_NORMAL);
 	if(attr_vN == NULL) {
@@ -905,7 +906,10 @@ void Mesh::pack_normals(Scene *scene, uint *tri_shader, float4 *vnormal)
 		if(do_transform)
 			vNi = safe_normalize(transform_direction(&ntfm, vNi));
 
-		vnormal[i] = make_float4(vNi.x, vNi.y, vNi.z, 0.0f);
+		if(vnormal_compact)
+			vnormal_compact[i] = float3_to_oct_normal(vNi);
+		else
+			vnormal[i] = make_float4(vNi.x, vNi.y, vNi.z, 0.0f);
 	}
 }
 
@@ -939,12 +943,17 @@ void Mesh::pack_verts(const vector<uint>& tri_prim_index,
 	}
 }
 
-void Mesh::pack_curves(Scene *scene, float4 *curve_key_co, float4 *curve_data, size_t curvekey_offset)
+void Mesh::pack_curves(Scene *scene,
+                       float4 *curve_key_co,
+                       uint *curve_key_compact,
+                       float4 *curve_data,
+                       float4 *curve_bounds,
+                       size_t curvekey_offset)
 {
 	size_t curve_keys_size = curve_keys.size();
 
 	/* pack curve keys */
-	if(curve_keys_size) {
+	if(curve_keys_size && curve_key_co) {
 		float3 *keys_ptr = curve_keys.data();
 		float *radius_ptr = curve_radius.data();
 
@@ -961,12 +970,50 @@ void Mesh::pack_curves(Scene *scene, float4 *curve_key_co, float4 *curve_data, s
 		Shader *shader = (shader_id < used_shaders.size()) ?
 			used_shaders[shader_id] : scene->default_surface;
 		shader_id = scene->shader_manager->get_shader_id(shader, false);
+		float radius_scale = 0.0f;
+
+		if(curve_key_compact) {
+			/* quantize keys to 16 bit relative to the bounds of the curve,
+			 * with a uniform scale so strands keep their shape */
+			float3 bmin = curve_keys[curve.first_key];
+			float3 bmax = bmin;
+			float max_radius = 0.0f;
+
+			for(int k = 0; k < curve.num_keys; k++) {
+				bmin = min(bmin, curve_keys[curve.first_key + k]);
+				bmax = max(bmax, curve_keys[curve.first_key + k]);
+				max_radius = max(max_radius, curve_radius[curve.first_key + k]);
+			}
+
+			float3 extent = bmax - bmin;
+			float scale = max(max(extent.x, extent.y), extent.z) / 65535.0f;
+			float inv_scale = (scale > 0.0f)? 1.0f/scale: 0.0f;
+			float inv_radius_scale = 0.0f;
+
+			radius_scale = max_radius / 65535.0f;
+			if(radius_scale > 0.0f)
+				inv_radius_scale = 1.0f/radius_scale;
+
+			for(int k = 0; k < curve.num_keys; k++) {
+				size_t key = curve.first_key + k;
+				float3 co = (curve_keys[key] - bmin) * inv_scale;
+				uint x = (uint)clamp(co.x + 0.5f, 0.0f, 65535.0f);
+				uint y = (uint)clamp(co.y + 0.5f, 0.0f, 65535.0f);
+				uint z = (uint)clamp(co.z + 0.5f, 0.0f, 65535.0f);
+				uint r = (uint)clamp(curve_radius[key]*inv_radius_scale + 0.5f, 0.0f, 65535.0f);
+
+				curve_key_compact[key*2 + 0] = x | (y << 16);
+				curve_key_compact[key*2 + 1] = z | (r << 16);
+			}
+
+			curve_bounds[i] = make_float4(bmin.x, bmin.y, bmin.z, scale);
+		}
 
 		curve_data[i] = make_float4(
 			__int_as_float(curve.first_key + curvekey_offset),
 			__int_as_float(curve.num_keys),
 			__int_as_float(shader_id),
-			0.0f);
+			radius_scale);
 	}
 }
 
@@ -1358,12 +1405,40 @@ void MeshManager::update_svm_attributes(Device *device, DeviceScene *dscene, Sce
 	device->tex_alloc("__attributes_map", dscene->attributes_map);
 }
 
+/* With compact geometry, UV maps are stored as two half floats per corner.
+ * Half floats only have enough precision for coordinates close to the unit
+ * range, so maps extending further out keep full precision. */
+static bool attribute_use_half2(Attribute *mattr,
+                                AttributePrimitive prim,
+                                bool use_compact_geometry)
+{
+	if(!use_compact_geometry ||
+	   prim != ATTR_PRIM_TRIANGLE ||
+	   mattr->std != ATTR_STD_UV ||
+	   mattr->element != ATTR_ELEMENT_CORNER)
+	{
+		return false;
+	}
+
+	const size_t size = mattr->buffer.size() / mattr->data_sizeof();
+	const float3 *data = mattr->data_float3();
+
+	for(size_t k = 0; k < size; k++) {
+		if(fabsf(data[k].x) > 2.0f || fabsf(data[k].y) > 2.0f)
+			return false;
+	}
+
+	return true;
+}
+
 static void update_attribute_element_size(Mesh *mesh,
                                           Attribute *mattr,
                                           AttributePrimitive prim,
+                                          bool use_compact_geometry,
                                           size_t *attr_float_size,
                                           size_t *attr_float3_size,
-                                          size_t *attr_uchar4_size)
+                                          size_t *attr_uchar4_size,
+                                          size_t *attr_half2_size)
 {
 	if(mattr) {
 		size_t size = mattr->element_size(mesh, prim);
@@ -1374,6 +1449,9 @@ static void update_attribute_element_size(Mesh *mesh,
 		else if(mattr->element == ATTR_ELEMENT_CORNER_BYTE) {
 			*attr_uchar4_size += size;
 		}
+		else if(attribute_use_half2(mattr, prim, use_compact_geometry)) {
+			*attr_half2_size += size;
+		}
 		else if(mattr->type == TypeDesc::TypeFloat) {
 			*attr_float_size += size;
 		}
@@ -1393,8 +1471,11 @@ static void update_attribute_element_offset(Mesh *mesh,
                                             size_t& attr_float3_offset,
                                             vector<uchar4>& attr_uchar4,
                                             size_t& attr_uchar4_offset,
+                                            vector<uint>& attr_half2,
+                                            size_t& attr_half2_offset,
                                             Attribute *mattr,
                                             AttributePrimitive prim,
+                                            bool use_compact_geometry,
                                             TypeDesc& type,
                                             AttributeDescriptor& desc)
 {
@@ -1425,6 +1506,18 @@ static void update_attribute_element_offset(Mesh *mesh,
 			}
 			attr_uchar4_offset += size;
 		}
+		else if(attribute_use_half2(mattr, prim, use_compact_geometry)) {
+			float3 *data = mattr->data_float3();
+			offset = attr_half2_offset;
+			element = ATTR_ELEMENT_CORNER_HALF;
+
+			assert(attr_half2.capacity() >= offset + size);
+			for(size_t k = 0; k < size; k++) {
+				attr_half2[offset+k] = (uint)float_to_half(data[k].x) |
+				                       ((uint)float_to_half(data[k].y) << 16);
+			}
+			attr_half2_offset += size;
+		}
 		else if(mattr->type == TypeDesc::TypeFloat) {
 			float *data = mattr->data_float();
 			offset = attr_float_offset;
@@ -1472,7 +1565,10 @@ static void update_attribute_element_offset(Mesh *mesh,
 			else
 				offset -= mesh->face_offset;
 		}
-		else if(element == ATTR_ELEMENT_CORNER || element == ATTR_ELEMENT_CORNER_BYTE) {
+		else if(element == ATTR_ELEMENT_CORNER ||
+		        element == ATTR_ELEMENT_CORNER_BYTE ||
+		        element == ATTR_ELEMENT_CORNER_HALF)
+		{
 			if(prim == ATTR_PRIM_TRIANGLE)
 				offset -= 3*mesh->tri_offset;
 			else
@@ -1521,6 +1617,8 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 	size_t attr_float_size = 0;
 	size_t attr_float3_size = 0;
 	size_t attr_uchar4_size = 0;
+	size_t attr_half2_size = 0;
+	const bool use_compact_geometry = scene->params.use_compact_geometry;
 	for(size_t i = 0; i < scene->meshes.size(); i++) {
 		Mesh *mesh = scene->meshes[i];
 		AttributeRequestSet& attributes = mesh_attributes[i];
@@ -1532,31 +1630,39 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 			update_attribute_element_size(mesh,
 			                              triangle_mattr,
 			                              ATTR_PRIM_TRIANGLE,
+			                              use_compact_geometry,
 			                              &attr_float_size,
 			                              &attr_float3_size,
-			                              &attr_uchar4_size);
+			                              &attr_uchar4_size,
+			                              &attr_half2_size);
 			update_attribute_element_size(mesh,
 			                              curve_mattr,
 			                              ATTR_PRIM_CURVE,
+			                              use_compact_geometry,
 			                              &attr_float_size,
 			                              &attr_float3_size,
-			                              &attr_uchar4_size);
+			                              &attr_uchar4_size,
+			                              &attr_half2_size);
 			update_attribute_element_size(mesh,
 			                              subd_mattr,
 			                              ATTR_PRIM_SUBD,
+			                              use_compact_geometry,
 			                              &attr_float_size,
 			                              &attr_float3_size,
-			                              &attr_uchar4_size);
+			                              &attr_uchar4_size,
+			                              &attr_half2_size);
 		}
 	}
 
 	vector<float> attr_float(attr_float_size);
 	vector<float4> attr_float3(attr_float3_size);
 	vector<uchar4> attr_uchar4(attr_uchar4_size);
+	vector<uint> attr_half2(attr_half2_size);
 
 	size_t attr_float_offset = 0;
 	size_t attr_float3_offset = 0;
 	size_t attr_uchar4_offset = 0;
+	size_t attr_half2_offset = 0;
 
 	/* Fill in attributes. */
 	for(size_t i = 0; i < scene->meshes.size(); i++) {
@@ -1574,8 +1680,10 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 			                                attr_float, attr_float_offset,
 			                                attr_float3, attr_float3_offset,
 			                                attr_uchar4, attr_uchar4_offset,
+			                                attr_half2, attr_half2_offset,
 			                                triangle_mattr,
 			                                ATTR_PRIM_TRIANGLE,
+			                                use_compact_geometry,
 			                                req.triangle_type,
 			                                req.triangle_desc);
 
@@ -1583,8 +1691,10 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 			                                attr_float, attr_float_offset,
 			                                attr_float3, attr_float3_offset,
 			                                attr_uchar4, attr_uchar4_offset,
+			                                attr_half2, attr_half2_offset,
 			                                curve_mattr,
 			                                ATTR_PRIM_CURVE,
+			                                use_compact_geometry,
 			                                req.curve_type,
 			                                req.curve_desc);
 
@@ -1592,8 +1702,10 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 			                                attr_float, attr_float_offset,
 			                                attr_float3, attr_float3_offset,
 			                                attr_uchar4, attr_uchar4_offset,
+			                                attr_half2, attr_half2_offset,
 			                                subd_mattr,
 			                                ATTR_PRIM_SUBD,
+			                                use_compact_geometry,
 			                                req.subd_type,
 			                                req.subd_desc);
 
@@ -1624,6 +1736,10 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 		dscene->attributes_uchar4.copy(&attr_uchar4[0], attr_uchar4.size());
 		device->tex_alloc("__attributes_uchar4", dscene->attributes_uchar4);
 	}
+	if(attr_half2.size()) {
+		dscene->attributes_half2.copy(&attr_half2[0], attr_half2.size());
+		device->tex_alloc("__attributes_half2", dscene->attributes_half2);
+	}
 }
 
 void MeshManager::mesh_calc_offset(Scene *scene)
@@ -1732,8 +1848,17 @@ void MeshManager::device_update_mesh(Device *device,
 		/* normals */
 		progress.set_status("Updating Mesh", "Computing normals");
 
+		/* with compact geometry normals are stored octahedral encoded in a
+		 * single uint per vertex, instead of a float4 */
+		const bool use_compact_geometry = scene->params.use_compact_geometry;
+
 		uint *tri_shader = dscene->tri_shader.resize(tri_size);
-		float4 *vnormal = dscene->tri_vnormal.resize(vert_size);
+		float4 *vnormal = NULL;
+		uint *vnormal_compact = NULL;
+		if(use_compact_geometry)
+			vnormal_compact = dscene->tri_vnormal_compact.resize(vert_size);
+		else
+			vnormal = dscene->tri_vnormal.resize(vert_size);
 		uint4 *tri_vindex = dscene->tri_vindex.resize(tri_size);
 		uint *tri_patch = dscene->tri_patch.resize(tri_size);
 		float2 *tri_patch_uv = dscene->tri_patch_uv.resize(vert_size);
@@ -1741,7 +1866,8 @@ void MeshManager::device_update_mesh(Device *device,
 		foreach(Mesh *mesh, scene->meshes) {
 			mesh->pack_normals(scene,
 			                   &tri_shader[mesh->tri_offset],
-			                   &vnormal[mesh->vert_offset]);
+			                   (vnormal)? &vnormal[mesh->vert_offset]: NULL,
+			                   (vnormal_compact)? &vnormal_compact[mesh->vert_offset]: NULL);
 			mesh->pack_verts(tri_prim_index,
 			                 &tri_vindex[mesh->tri_offset],
 			                 &tri_patch[mesh->tri_offset],
@@ -1755,7 +1881,11 @@ void MeshManager::device_update_mesh(Device *device,
 		progress.set_status("Updating Mesh", "Copying Mesh to device");
 
 		device->tex_alloc("__tri_shader", dscene->tri_shader);
-		device->tex_alloc("__tri_vnormal", dscene->tri_vnormal);
+		if(use_compact_geometry)
+			device->tex_alloc("__tri_vnormal_compact", dscene->tri_vnormal_compact);
+		else
+			device->tex_alloc("__tri_vnormal", dscene->tri_vnormal);
+		dscene->data.bvh.use_compact_geometry = use_compact_geometry;
 		device->tex_alloc("__tri_vindex", dscene->tri_vindex);
 		device->tex_alloc("__tri_patch", dscene->tri_patch);
 		device->tex_alloc("__tri_patch_uv", dscene->tri_patch_uv);
@@ -1764,16 +1894,39 @@ void MeshManager::device_update_mesh(Device *device,
 	if(curve_size != 0) {
 		progress.set_status("Updating Mesh", "Copying Strands to device");
 
-		float4 *curve_keys = dscene->curve_keys.resize(curve_key_size);
+		/* with compact geometry curve keys are stored as 16 bit integers
+		 * relative to per curve bounds, instead of a float4 */
+		const bool use_compact_keys = scene->params.use_compact_geometry;
+
+		float4 *curve_keys = NULL;
+		uint *curve_keys_compact = NULL;
+		float4 *curve_bounds = NULL;
+		if(use_compact_keys) {
+			curve_keys_compact = dscene->curve_keys_compact.resize(curve_key_size*2);
+			curve_bounds = dscene->curve_bounds.resize(curve_size);
+		}
+		else
+			curve_keys = dscene->curve_keys.resize(curve_key_size);
 		float4 *curves = dscene->curves.resize(curve_size);
 
 		foreach(Mesh *mesh, scene->meshes) {
-			mesh->pack_curves(scene, &curve_keys[mesh->curvekey_offset], &curves[mesh->curve_offset], mesh->curvekey_offset);
+			mesh->pack_curves(scene,
+			                  (curve_keys)? &curve_keys[mesh->curvekey_offset]: NULL,
+			                  (curve_keys_compact)? &curve_keys_compact[mesh->curvekey_offset*2]: NULL,
+			                  &curves[mesh->curve_offset],
+			                  (curve_bounds)? &curve_bounds[mesh->curve_offset]: NULL,
+			                  mesh->curvekey_offset);
 			if(progress.get_cancel()) return;
 		}
 
-		device->tex_alloc("__curve_keys", dscene->curve_keys);
+		if(use_compact_keys) {
+			device->tex_alloc("__curve_keys_compact", dscene->curve_keys_compact);
+			device->tex_alloc("__curve_bounds", dscene->curve_bounds);
+		}
+		else
+			device->tex_alloc("__curve_keys", dscene->curve_keys);
 		device->tex_alloc("__curves", dscene->curves);
+		dscene->data.curve.use_compact_keys = use_compact_keys;
 	}
 
 	if(patch_size != 0) {
@@ -2161,16 +2314,20 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	device->tex_free(dscene->prim_time);
 	device->tex_free(dscene->tri_shader);
 	device->tex_free(dscene->tri_vnormal);
+	device->tex_free(dscene->tri_vnormal_compact);
 	device->tex_free(dscene->tri_vindex);
 	device->tex_free(dscene->tri_patch);
 	device->tex_free(dscene->tri_patch_uv);
 	device->tex_free(dscene->curves);
 	device->tex_free(dscene->curve_keys);
+	device->tex_free(dscene->curve_keys_compact);
+	device->tex_free(dscene->curve_bounds);
 	device->tex_free(dscene->patches);
 	device->tex_free(dscene->attributes_map);
 	device->tex_free(dscene->attributes_float);
 	device->tex_free(dscene->attributes_float3);
 	device->tex_free(dscene->attributes_uchar4);
+	device->tex_free(dscene->attributes_half2);
 
 	dscene->bvh_nodes.clear();
 	dscene->object_node.clear();
@@ -2183,16 +2340,20 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	dscene->prim_time.clear();
 	dscene->tri_shader.clear();
 	dscene->tri_vnormal.clear();
+	dscene->tri_vnormal_compact.clear();
 	dscene->tri_vindex.clear();
 	dscene->tri_patch.clear();
 	dscene->tri_patch_uv.clear();
 	dscene->curves.clear();
 	dscene->curve_keys.clear();
+	dscene->curve_keys_compact.clear();
+	dscene->curve_bounds.clear();
 	dscene->patches.clear();
 	dscene->attributes_map.clear();
 	dscene->attributes_float.clear();
 	dscene->attributes_float3.clear();
 	dscene->attributes_uchar4.clear();
+	dscene->attributes_half2.clear();
 
 #ifdef WITH_OSL
 	OSLGlobals *og = (OSLGlobals*)device->osl_memory();
@@ -272,14 +272,19 @@ public:
 	void add_vertex_normals();
 	void add_undisplaced();
 
-	void pack_normals(Scene *scene, uint *shader, float4 *vnormal);
+	void pack_normals(Scene *scene, uint *shader, float4 *vnormal, uint *vnormal_compact);
 	void pack_verts(const vector<uint>& tri_prim_index,
 	                uint4 *tri_vindex,
 	                uint *tri_patch,
 	                float2 *tri_patch_uv,
 	                size_t vert_offset,
 	                size_t tri_offset);
-	void pack_curves(Scene *scene, float4 *curve_key_co, float4 *curve_data, size_t curvekey_offset);
+	void pack_curves(Scene *scene,
+	                 float4 *curve_key_co,
+	                 uint *curve_key_compact,
+	                 float4 *curve_data,
+	                 float4 *curve_bounds,
+	                 size_t curvekey_offset);
 	void pack_patches(uint *patch_data, uint vert_offset, uint face_offset, uint corner_offset);
 
 	void compute_bvh(DeviceScene *dscene,
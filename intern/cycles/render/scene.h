@@ -74,12 +74,15 @@ public:
 	/* mesh */
 	device_vector<uint> tri_shader;
 	device_vector<float4> tri_vnormal;
+	device_vector<uint> tri_vnormal_compact;
 	device_vector<uint4> tri_vindex;
 	device_vector<uint> tri_patch;
 	device_vector<float2> tri_patch_uv;
 
 	device_vector<float4> curves;
 	device_vector<float4> curve_keys;
+	device_vector<uint> curve_keys_compact;
+	device_vector<float4> curve_bounds;
 
 	device_vector<uint> patches;
 
@@ -92,6 +95,7 @@ public:
 	device_vector<float> attributes_float;
 	device_vector<float4> attributes_float3;
 	device_vector<uchar4> attributes_uchar4;
+	device_vector<uint> attributes_half2;
 
 	/* lights */
 	device_vector<float4> light_distribution;
@@ -146,6 +150,7 @@ public:
 	bool use_bvh_unaligned_nodes;
 	int num_bvh_time_steps;
 	bool use_qbvh;
+	bool use_compact_geometry;
 	bool persistent_data;
 	int texture_limit;
 
@@ -157,6 +162,7 @@ public:
 		use_bvh_unaligned_nodes = true;
 		num_bvh_time_steps = 0;
 		use_qbvh = false;
+		use_compact_geometry = false;
 		persistent_data = false;
 		texture_limit = 0;
 	}
@@ -168,6 +174,7 @@ public:
 		&& use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes
 		&& num_bvh_time_steps == params.num_bvh_time_steps
 		&& use_qbvh == params.use_qbvh
+		&& use_compact_geometry == params.use_compact_geometry
 		&& persistent_data == params.persistent_data
 		&& texture_limit == params.texture_limit); }
 };
@@ -28,6 +28,7 @@
 #include "render/session.h"
 #include "render/bake.h"
 
+#include "util/util_algorithm.h"
 #include "util/util_foreach.h"
 #include "util/util_function.h"
 #include "util/util_logging.h"
@@ -912,7 +913,87 @@ void Session::update_scene()
 
 		progress.set_status("Updating Scene");
 		MEM_GUARDED_CALL(&progress, scene->device_update, device, progress);
+
+		VLOG(1) << get_memory_report();
+	}
+}
+
+/* Group device arrays by what they are used for, based on their name. */
+static const char *memory_category(const string& name)
+{
+	static const struct {
+		const char *prefix;
+		const char *category;
+	} categories[] = {
+		{"__tex_image", "Images"},
+		{"__bvh_", "BVH"},
+		{"__object_node", "BVH"},
+		{"__prim_", "BVH"},
+		{"__curve", "Hair"},
+		{"__tri_", "Meshes"},
+		{"__patches", "Meshes"},
+		{"__attributes", "Attributes"},
+		{"__object", "Objects"},
+		{"__particles", "Objects"},
+		{"__svm_nodes", "Shaders"},
+		{"__shader", "Shaders"},
+		{"__lookup_table", "Shaders"},
+		{"__light", "Lights"},
+		{"render_buffer", "Render Buffers"},
+		{"rng_state", "Render Buffers"},
+	};
+
+	for(size_t i = 0; i < sizeof(categories) / sizeof(*categories); i++) {
+		if(string_startswith(name, categories[i].prefix)) {
+			return categories[i].category;
+		}
 	}
+
+	return "Other";
+}
+
+static bool memory_size_greater(const pair<size_t, const Stats::MemoryTag*>& a,
+                                const pair<size_t, const Stats::MemoryTag*>& b)
+{
+	return a.first > b.first;
+}
+
+string Session::get_memory_report(int top_n)
+{
+	const Stats::MemoryBreakdown breakdown = stats.get_mem_breakdown();
+
+	map<string, size_t> category_size;
+	vector<pair<size_t, const Stats::MemoryTag*> > allocations;
+	allocations.reserve(breakdown.size());
+
+	for(Stats::MemoryBreakdown::const_iterator it = breakdown.begin(); it != breakdown.end(); ++it) {
+		category_size[memory_category(it->first.first)] += it->second;
+		allocations.push_back(std::make_pair(it->second, &it->first));
+	}
+
+	sort(allocations.begin(), allocations.end(), memory_size_greater);
+
+	string report = string_printf("Device memory: %s used, %s peak\n",
+	                              string_human_readable_size(stats.mem_used).c_str(),
+	                              string_human_readable_size(stats.mem_peak).c_str());
+
+	report += "  Categories:\n";
+	for(map<string, size_t>::const_iterator it = category_size.begin(); it != category_size.end(); ++it) {
+		report += string_printf("    %-16s %s\n",
+		                        it->first.c_str(),
+		                        string_human_readable_size(it->second).c_str());
+	}
+
+	report += string_printf("  Top %d allocations:\n", top_n);
+	for(int i = 0; i < top_n && i < (int)allocations.size(); i++) {
+		const Stats::MemoryTag *tag = allocations[i].second;
+		report += string_printf("    %-32s %-12s %s\n",
+		                        tag->first.c_str(),
+		                        string_human_readable_size(allocations[i].first).c_str(),
+		                        tag->second.c_str());
+	}
+
+	return report;
 }
 
 void Session::update_status_time(bool show_pause, bool show_done)
@@ -161,6 +161,10 @@ public:
 	 * (for example, when rendering with unlimited samples). */
 	float get_progress();
 
+	/* Human readable breakdown of device memory usage, per category and the
+	 * top_n biggest allocations with their owners. */
+	string get_memory_report(int top_n = 10);
+
 protected:
 	struct DelayedReset {
 		thread_mutex mutex;
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* ******** Tests for float3_to_oct_normal() ******** */
+
+static void expect_oct_normal_round_trip(const float3 n)
+{
+	const uint packed = float3_to_oct_normal(n);
+	EXPECT_NE(0u, packed);
+	const float3 decoded = oct_normal_to_float3(packed);
+	EXPECT_GT(dot(normalize(n), decoded), 0.99999f);
+}
+
+TEST(util_oct_normal, zero)
+{
+	EXPECT_EQ(0u, float3_to_oct_normal(make_float3(0.0f, 0.0f, 0.0f)));
+	const float3 decoded = oct_normal_to_float3(0);
+	EXPECT_EQ(0.0f, decoded.x);
+	EXPECT_EQ(0.0f, decoded.y);
+	EXPECT_EQ(0.0f, decoded.z);
+}
+
+TEST(util_oct_normal, poles)
+{
+	expect_oct_normal_round_trip(make_float3(0.0f, 0.0f, 1.0f));
+	expect_oct_normal_round_trip(make_float3(0.0f, 0.0f, -1.0f));
+	/* Folds onto the corners of the octahedron, next to the zero code. */
+	expect_oct_normal_round_trip(make_float3(-1e-6f, -1e-6f, -1.0f));
+	expect_oct_normal_round_trip(make_float3(1e-6f, -1e-6f, -1.0f));
+	expect_oct_normal_round_trip(make_float3(-1e-6f, 1e-6f, -1.0f));
+	expect_oct_normal_round_trip(make_float3(1e-6f, 1e-6f, -1.0f));
+}
+
+TEST(util_oct_normal, fold_edges)
+{
+	const float3 edges[] = {
+		make_float3(1.0f, 0.0f, 0.0f),
+		make_float3(-1.0f, 0.0f, 0.0f),
+		make_float3(0.0f, 1.0f, 0.0f),
+		make_float3(0.0f, -1.0f, 0.0f),
+		make_float3(0.6f, 0.8f, 0.0f),
+		make_float3(-0.6f, -0.8f, 0.0f),
+	};
+	for(size_t i = 0; i < sizeof(edges) / sizeof(*edges); i++) {
+		expect_oct_normal_round_trip(edges[i]);
+		expect_oct_normal_round_trip(edges[i] + make_float3(0.0f, 0.0f, 1e-6f));
+		expect_oct_normal_round_trip(edges[i] - make_float3(0.0f, 0.0f, 1e-6f));
+	}
+}
+
+TEST(util_oct_normal, sphere)
+{
+	for(int i = 0; i <= 64; i++) {
+		const float theta = M_PI_F * i / 64.0f;
+		for(int j = 0; j < 128; j++) {
+			const float phi = M_2PI_F * j / 128.0f;
+			expect_oct_normal_round_trip(make_float3(sinf(theta) * cosf(phi),
+			                                         sinf(theta) * sinf(phi),
+			                                         cosf(theta)));
+		}
+	}
+}
+
+CCL_NAMESPACE_END
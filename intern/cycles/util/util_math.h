@@ -558,6 +558,44 @@ ccl_device_inline float2 map_to_sphere(const float3 co)
 	return make_float2(u, v);
 }
 
+/* Octahedral normal encoding, maps a unit vector to two 16 bit unsigned
+ * integers packed into a single uint. Directions are quantized into 1..65535
+ * only, so zero is never produced for a valid direction and is used to store
+ * zero length normals. */
+ccl_device_inline uint float3_to_oct_normal(const float3 n)
+{
+	float sum = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+	if(!(sum > 0.0f)) {
+		return 0;
+	}
+	float u = n.x / sum;
+	float v = n.y / sum;
+	if(n.z < 0.0f) {
+		float fu = (1.0f - fabsf(v)) * signf(u);
+		float fv = (1.0f - fabsf(u)) * signf(v);
+		u = fu;
+		v = fv;
+	}
+	uint iu = (uint)float_to_int(clamp(u, -1.0f, 1.0f) * 32767.0f + 32768.5f);
+	uint iv = (uint)float_to_int(clamp(v, -1.0f, 1.0f) * 32767.0f + 32768.5f);
+	return iu | (iv << 16);
+}
+
+ccl_device_inline float3 oct_normal_to_float3(const uint packed)
+{
+	if(packed == 0) {
+		return make_float3(0.0f, 0.0f, 0.0f);
+	}
+	float u = ((float)(packed & 0xFFFF) - 32768.0f) * (1.0f / 32767.0f);
+	float v = ((float)(packed >> 16) - 32768.0f) * (1.0f / 32767.0f);
+	float3 n = make_float3(u, v, 1.0f - fabsf(u) - fabsf(v));
+	if(n.z < 0.0f) {
+		n.x = (1.0f - fabsf(v)) * signf(u);
+		n.y = (1.0f - fabsf(u)) * signf(v);
+	}
+	return normalize(n);
+}
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_MATH_H__ */
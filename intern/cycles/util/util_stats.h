@@ -18,6 +18,9 @@
 #define __UTIL_STATS_H__
 
 #include "util/util_atomic.h"
+#include "util/util_map.h"
+#include "util/util_string.h"
+#include "util/util_thread.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -38,8 +41,51 @@ public:
 		atomic_sub_and_fetch_z(&mem_used, size);
 	}
 
+	/* Tagged allocations, besides the totals these keep track of how much
+	 * memory each named array and owner (image filename, ...) is using, so
+	 * we can tell what is responsible for the memory usage.
+	 *
+	 * Only used for device memory, the global guarded allocator stats are
+	 * untagged and don't depend on the breakdown map being constructed.
+	 */
+	typedef pair<string, string> MemoryTag; /* name, owner */
+	typedef map<MemoryTag, size_t> MemoryBreakdown;
+
+	void mem_alloc(size_t size, const string& name, const string& owner) {
+		mem_alloc(size);
+		if(!name.empty()) {
+			thread_scoped_lock lock(mem_breakdown_mutex);
+			mem_breakdown[MemoryTag(name, owner)] += size;
+		}
+	}
+
+	void mem_free(size_t size, const string& name, const string& owner) {
+		mem_free(size);
+		if(!name.empty()) {
+			thread_scoped_lock lock(mem_breakdown_mutex);
+			MemoryBreakdown::iterator it = mem_breakdown.find(MemoryTag(name, owner));
+			if(it != mem_breakdown.end()) {
+				assert(it->second >= size);
+				it->second -= size;
+				if(it->second == 0) {
+					mem_breakdown.erase(it);
+				}
+			}
+		}
+	}
+
+	/* Copy of the current breakdown, safe to use while rendering. */
+	MemoryBreakdown get_mem_breakdown() {
+		thread_scoped_lock lock(mem_breakdown_mutex);
+		return mem_breakdown;
+	}
+
 	size_t mem_used;
 	size_t mem_peak;
+
+protected:
+	MemoryBreakdown mem_breakdown;
+	thread_mutex mem_breakdown_mutex;
 };
 
 CCL_NAMESPACE_END
@@ -171,7 +171,7 @@ extern "C" {
 	/** Get amount of memory blocks in use. */
 	extern unsigned int (*MEM_get_memory_blocks_in_use)(void);
 
-	/** Reset the peak memory statistic to zero. */
+	/** Reset the peak memory statistic to zero (including the peak of each memory scope). */
 	extern void (*MEM_reset_peak_memory)(void);
 
 	/** Get the peak memory usage in bytes, including mmap allocations. */
@@ -206,6 +206,46 @@ extern const char *(*MEM_name_ptr)(void *vmemh);
 /* Switch allocator to slower but fully guarded mode. */
 void MEM_use_guarded_allocator(void);
 
+/* Serve small blocks of the lock-free allocator from per-thread caches,
+ * no effect with the guarded allocator. Blocks allocated before are still handled. */
+void MEM_use_small_allocator(void);
+
+/**
+ * Memory scopes: allocations are tagged with the scope of the thread allocating them,
+ * so the current and peak memory usage of each subsystem can be reported.
+ *
+ * \code{.c}
+ * const eMemScope scope_prev = MEM_scope_begin(MEM_SCOPE_MODIFIERS);
+ * ...
+ * MEM_scope_end(scope_prev);
+ * \endcode
+ *
+ * \note The lock-free allocator only stores the scope on 64 bit platforms,
+ * elsewhere all its blocks count as #MEM_SCOPE_OTHER.
+ */
+typedef enum eMemScope {
+	MEM_SCOPE_OTHER = 0,
+	MEM_SCOPE_BLENDFILE,
+	MEM_SCOPE_UNDO,
+	MEM_SCOPE_DEPSGRAPH,
+	MEM_SCOPE_MODIFIERS,
+	MEM_SCOPE_IMAGE,
+	MEM_SCOPE_RENDER,
+
+	MEM_SCOPE_TOT
+} eMemScope;
+
+/** Set the scope of the allocations done by the calling thread, returns the previous one. */
+eMemScope MEM_scope_begin(eMemScope scope);
+/** Restore the scope returned by #MEM_scope_begin. */
+void MEM_scope_end(eMemScope scope_prev);
+eMemScope MEM_scope_get(void) ATTR_WARN_UNUSED_RESULT;
+const char *MEM_scope_name(eMemScope scope) ATTR_WARN_UNUSED_RESULT;
+size_t MEM_get_scope_memory_in_use(eMemScope scope) ATTR_WARN_UNUSED_RESULT;
+size_t MEM_get_scope_peak_memory(eMemScope scope) ATTR_WARN_UNUSED_RESULT;
+/** Print current and peak memory usage of every scope. */
+void MEM_printmemlist_scopes(void);
+
 #ifdef __cplusplus
 /* alloc funcs for C++ only */
 #define MEM_CXX_CLASS_ALLOC_FUNCS(_id)                                        \
@@ -35,8 +35,14 @@
 
 #include <assert.h>
 
+#include "atomic_ops.h"
 #include "mallocn_intern.h"
 
+#ifdef MEM_USE_PTHREAD_KEY
+#  include <pthread.h>
+#  include <stdint.h> /* intptr_t */
+#endif
+
 size_t (*MEM_allocN_len)(const void *vmemh) = MEM_lockfree_allocN_len;
 void (*MEM_freeN)(void *vmemh) = MEM_lockfree_freeN;
 void *(*MEM_dupallocN)(const void *vmemh) = MEM_lockfree_dupallocN;
@@ -99,6 +105,11 @@ void aligned_free(void *ptr)
 #endif
 }
 
+void MEM_use_small_allocator(void)
+{
+	MEM_lockfree_use_small_allocator();
+}
+
 void MEM_use_guarded_allocator(void)
 {
 	MEM_allocN_len = MEM_guarded_allocN_len;
@@ -128,3 +139,126 @@ void MEM_use_guarded_allocator(void)
 	MEM_name_ptr = MEM_guarded_name_ptr;
 #endif
 }
+
+/* -------------------------------------------------------------------- */
+/* Memory Scopes */
+
+static const char *mem_scope_names[MEM_SCOPE_TOT] = {
+	"Other",
+	"Blend File",
+	"Undo",
+	"Dependency Graph",
+	"Modifiers",
+	"Image",
+	"Render",
+};
+
+static size_t mem_scope_in_use[MEM_SCOPE_TOT] = {0};
+static size_t mem_scope_peak[MEM_SCOPE_TOT] = {0};
+
+#ifdef MEM_USE_PTHREAD_KEY
+static pthread_once_t mem_scope_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t mem_scope_key;
+
+static void mem_scope_key_init(void)
+{
+	pthread_key_create(&mem_scope_key, NULL);
+}
+#else
+static MEM_THREAD_LOCAL eMemScope mem_scope = MEM_SCOPE_OTHER;
+#endif
+
+eMemScope mem_scope_current(void)
+{
+#ifdef MEM_USE_PTHREAD_KEY
+	pthread_once(&mem_scope_key_once, mem_scope_key_init);
+	return (eMemScope)(intptr_t)pthread_getspecific(mem_scope_key);
+#else
+	return mem_scope;
+#endif
+}
+
+void mem_scope_alloc(const eMemScope scope, const size_t len)
+{
+	const size_t in_use = atomic_add_and_fetch_z(&mem_scope_in_use[scope], len);
+	size_t peak = mem_scope_peak[scope];
+
+	while (peak < in_use) {
+		const size_t peak_prev = atomic_cas_z(&mem_scope_peak[scope], peak, in_use);
+		if (peak_prev == peak) {
+			break;
+		}
+		peak = peak_prev;
+	}
+}
+
+void mem_scope_free(const eMemScope scope, const size_t len)
+{
+	atomic_sub_and_fetch_z(&mem_scope_in_use[scope], len);
+}
+
+void mem_scope_reset_peak(void)
+{
+	int scope;
+
+	for (scope = 0; scope < MEM_SCOPE_TOT; scope++) {
+		mem_scope_peak[scope] = mem_scope_in_use[scope];
+	}
+}
+
+eMemScope MEM_scope_begin(eMemScope scope)
+{
+	const eMemScope scope_prev = mem_scope_current();
+
+	assert(scope < MEM_SCOPE_TOT);
+
+#ifdef MEM_USE_PTHREAD_KEY
+	pthread_setspecific(mem_scope_key, (void *)(intptr_t)scope);
+#else
+	mem_scope = scope;
+#endif
+
+	return scope_prev;
+}
+
+void MEM_scope_end(eMemScope scope_prev)
+{
+	MEM_scope_begin(scope_prev);
+}
+
+eMemScope MEM_scope_get(void)
+{
+	return mem_scope_current();
+}
+
+const char *MEM_scope_name(eMemScope scope)
+{
+	assert(scope < MEM_SCOPE_TOT);
+	return mem_scope_names[scope];
+}
+
+size_t MEM_get_scope_memory_in_use(eMemScope scope)
+{
+	assert(scope < MEM_SCOPE_TOT);
+	return mem_scope_in_use[scope];
+}
+
+size_t MEM_get_scope_peak_memory(eMemScope scope)
+{
+	assert(scope < MEM_SCOPE_TOT);
+	return mem_scope_peak[scope];
+}
+
+void MEM_printmemlist_scopes(void)
+{
+	int scope;
+
+	printf("\nmemory scopes:\n");
+	printf(" CURRENT-MiB    PEAK-MiB SCOPE\n");
+	for (scope = 0; scope < MEM_SCOPE_TOT; scope++) {
+		printf("%12.3f %11.3f %s\n",
+		       (double)mem_scope_in_use[scope] / (double)(1024 * 1024),
+		       (double)mem_scope_peak[scope] / (double)(1024 * 1024),
+		       mem_scope_names[scope]);
+	}
+}
@@ -118,6 +118,7 @@ typedef struct MemHead {
 	short alignment;  /* if non-zero aligned alloc was used
 	                   * and alignment is stored here.
 	                   */
+	short scope;  /* eMemScope the block was allocated in */
 #ifdef DEBUG_MEMCOUNTER
 	int _count;
 #endif
@@ -492,6 +493,7 @@ static void make_memhead_header(MemHead *memh, size_t len, const char *str)
 	memh->len = len;
 	memh->mmap = 0;
 	memh->alignment = 0;
+	memh->scope = (short)mem_scope_current();
 	memh->tag2 = MEMTAG2;
 
 #ifdef DEBUG_MEMDUPLINAME
@@ -507,6 +509,7 @@ static void make_memhead_header(MemHead *memh, size_t len, const char *str)
 
 	atomic_add_and_fetch_u(&totblock, 1);
 	atomic_add_and_fetch_z(&mem_in_use, len);
+	mem_scope_alloc((eMemScope)memh->scope, len);
 
 	mem_lock_thread();
 	addtail(membase, &memh->next);
@@ -758,6 +761,8 @@ void MEM_guarded_printmemlist_stats(void)
 	
 	mem_unlock_thread();
 
+	MEM_printmemlist_scopes();
+
 #ifdef HAVE_MALLOC_STATS
 	printf("System Statistics:\n");
 	malloc_stats();
@@ -1009,6 +1014,7 @@ static void rem_memblock(MemHead *memh)
 
 	atomic_sub_and_fetch_u(&totblock, 1);
 	atomic_sub_and_fetch_z(&mem_in_use, memh->len);
+	mem_scope_free((eMemScope)memh->scope, memh->len);
 
 #ifdef DEBUG_MEMDUPLINAME
 	if (memh->need_free_name)
@@ -1152,6 +1158,8 @@ void MEM_guarded_reset_peak_memory(void)
 	mem_lock_thread();
 	peak_mem = mem_in_use;
 	mem_unlock_thread();
+
+	mem_scope_reset_peak();
 }
 
 size_t MEM_guarded_get_memory_in_use(void)
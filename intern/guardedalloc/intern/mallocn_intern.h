@@ -106,6 +106,15 @@
 
 #define IS_POW2(a) (((a) & ((a) - 1)) == 0)
 
+/* Thread local storage, platforms where the compiler doesn't support it use a pthread key. */
+#if defined(__APPLE__)
+#  define MEM_USE_PTHREAD_KEY
+#elif defined(_MSC_VER)
+#  define MEM_THREAD_LOCAL __declspec(thread)
+#else
+#  define MEM_THREAD_LOCAL __thread
+#endif
+
 /* Extra padding which needs to be applied on MemHead to make it aligned. */
 #define MEMHEAD_ALIGN_PADDING(alignment) ((size_t)alignment - (sizeof(MemHeadAligned) % (size_t)alignment))
 
@@ -115,6 +124,23 @@
 void *aligned_malloc(size_t size, size_t alignment);
 void aligned_free(void *ptr);
 
+/* Thread caching small block allocator, blocks (including the MemHead) up to MEM_SMALL_MAX bytes. */
+#define MEM_SMALL_GRANULARITY 16
+#define MEM_SMALL_MAX 512
+#define MEM_SMALL_CLASSES (MEM_SMALL_MAX / MEM_SMALL_GRANULARITY)
+/* Size class of a block of given size (including the MemHead). */
+#define MEM_SMALL_CLASS(size) ((unsigned int)(((size) + MEM_SMALL_GRANULARITY - 1) / MEM_SMALL_GRANULARITY) - 1)
+
+void *mem_small_alloc(const unsigned int size_class) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+void mem_small_free(void *ptr, const unsigned int size_class) ATTR_NONNULL(1);
+size_t mem_small_get_memory_reserved(void) ATTR_WARN_UNUSED_RESULT;
+
+/* Memory scopes statistics, shared by the allocators. */
+eMemScope mem_scope_current(void) ATTR_WARN_UNUSED_RESULT;
+void mem_scope_alloc(const eMemScope scope, const size_t len);
+void mem_scope_free(const eMemScope scope, const size_t len);
+void mem_scope_reset_peak(void);
+
 /* Prototypes for counted allocator functions */
 size_t MEM_lockfree_allocN_len(const void *vmemh) ATTR_WARN_UNUSED_RESULT;
 void MEM_lockfree_freeN(void *vmemh);
@@ -141,6 +167,7 @@ size_t MEM_lockfree_get_peak_memory(void) ATTR_WARN_UNUSED_RESULT;
 #ifndef NDEBUG
 const char *MEM_lockfree_name_ptr(void *vmemh);
 #endif
+void MEM_lockfree_use_small_allocator(void);
 
 /* Prototypes for fully guarded allocator functions */
 size_t MEM_guarded_allocN_len(const void *vmemh) ATTR_WARN_UNUSED_RESULT;
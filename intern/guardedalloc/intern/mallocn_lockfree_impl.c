@@ -31,6 +31,7 @@
 #include <stdlib.h>
 #include <string.h> /* memcpy */
 #include <stdarg.h>
+#include <stdint.h> /* SIZE_MAX */
 #include <sys/types.h>
 
 #include "MEM_guardedalloc.h"
@@ -54,21 +55,46 @@ typedef struct MemHeadAligned {
 static unsigned int totblock = 0;
 static size_t mem_in_use = 0, mmap_in_use = 0, peak_mem = 0;
 static bool malloc_debug_memset = false;
+static bool use_small_alloc = false;
 
 static void (*error_callback)(const char *) = NULL;
 static void (*thread_lock_callback)(void) = NULL;
 static void (*thread_unlock_callback)(void) = NULL;
 
+/* Kind of block, stored in the lower bits of the length (which is aligned to 4). */
 enum {
 	MEMHEAD_MMAP_FLAG = 1,
 	MEMHEAD_ALIGN_FLAG = 2,
+	/* Block of the thread caching small block allocator. */
+	MEMHEAD_SMALL_FLAG = MEMHEAD_MMAP_FLAG | MEMHEAD_ALIGN_FLAG,
 };
 
+#define MEMHEAD_FLAG_MASK ((size_t) (MEMHEAD_MMAP_FLAG | MEMHEAD_ALIGN_FLAG))
+
+/* Memory scope of the block, stored in the upper bits of the length on 64 bit,
+ * on 32 bit all blocks are accounted to #MEM_SCOPE_OTHER. */
+#if SIZE_MAX > 0xFFFFFFFFu
+#  define MEMHEAD_SCOPE_SHIFT 56
+#  define MEMHEAD_SCOPE_MASK ((size_t) 0xff << MEMHEAD_SCOPE_SHIFT)
+#  define MEMHEAD_SCOPE(memhead) ((eMemScope) ((memhead)->len >> MEMHEAD_SCOPE_SHIFT))
+#  define MEMHEAD_SCOPE_BITS(scope) ((size_t) (scope) << MEMHEAD_SCOPE_SHIFT)
+#  define MEMHEAD_SCOPE_CURRENT() mem_scope_current()
+#else
+#  define MEMHEAD_SCOPE_MASK ((size_t) 0)
+#  define MEMHEAD_SCOPE(memhead) MEM_SCOPE_OTHER
+#  define MEMHEAD_SCOPE_BITS(scope) ((size_t) 0)
+#  define MEMHEAD_SCOPE_CURRENT() MEM_SCOPE_OTHER
+#endif
+
 #define MEMHEAD_FROM_PTR(ptr) (((MemHead*) ptr) - 1)
 #define PTR_FROM_MEMHEAD(memhead) (memhead + 1)
 #define MEMHEAD_ALIGNED_FROM_PTR(ptr) (((MemHeadAligned*) ptr) - 1)
-#define MEMHEAD_IS_MMAP(memhead) ((memhead)->len & (size_t) MEMHEAD_MMAP_FLAG)
-#define MEMHEAD_IS_ALIGNED(memhead) ((memhead)->len & (size_t) MEMHEAD_ALIGN_FLAG)
+#define MEMHEAD_IS_MMAP(memhead) (((memhead)->len & MEMHEAD_FLAG_MASK) == (size_t) MEMHEAD_MMAP_FLAG)
+#define MEMHEAD_IS_ALIGNED(memhead) (((memhead)->len & MEMHEAD_FLAG_MASK) == (size_t) MEMHEAD_ALIGN_FLAG)
+#define MEMHEAD_IS_SMALL(memhead) (((memhead)->len & MEMHEAD_FLAG_MASK) == (size_t) MEMHEAD_SMALL_FLAG)
+
+/* Whether a block of given (aligned) length is served by the small block allocator. */
+#define MEM_USE_SMALL_ALLOC(len) (use_small_alloc && ((len) + sizeof(MemHead) <= MEM_SMALL_MAX))
 
 /* Uncomment this to have proper peak counter. */
 #define USE_ATOMIC_MAX
@@ -122,7 +148,7 @@ static void mem_unlock_thread(void)
 size_t MEM_lockfree_allocN_len(const void *vmemh)
 {
 	if (vmemh) {
-		return MEMHEAD_FROM_PTR(vmemh)->len & ~((size_t) (MEMHEAD_MMAP_FLAG | MEMHEAD_ALIGN_FLAG));
+		return MEMHEAD_FROM_PTR(vmemh)->len & ~(MEMHEAD_FLAG_MASK | MEMHEAD_SCOPE_MASK);
 	}
 	else {
 		return 0;
@@ -144,6 +170,7 @@ void MEM_lockfree_freeN(void *vmemh)
 
 	atomic_sub_and_fetch_u(&totblock, 1);
 	atomic_sub_and_fetch_z(&mem_in_use, len);
+	mem_scope_free(MEMHEAD_SCOPE(memh), len);
 
 	if (MEMHEAD_IS_MMAP(memh)) {
 		atomic_sub_and_fetch_z(&mmap_in_use, len);
@@ -161,7 +188,10 @@ void MEM_lockfree_freeN(void *vmemh)
 		if (UNLIKELY(malloc_debug_memset && len)) {
 			memset(memh + 1, 255, len);
 		}
-		if (UNLIKELY(MEMHEAD_IS_ALIGNED(memh))) {
+		if (MEMHEAD_IS_SMALL(memh)) {
+			mem_small_free(memh, MEM_SMALL_CLASS(len + sizeof(MemHead)));
+		}
+		else if (UNLIKELY(MEMHEAD_IS_ALIGNED(memh))) {
 			MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
 			aligned_free(MEMHEAD_REAL_PTR(memh_aligned));
 		}
@@ -279,17 +309,30 @@ void *MEM_lockfree_recallocN_id(void *vmemh, size_t len, const char *str)
 
 void *MEM_lockfree_callocN(size_t len, const char *str)
 {
+	const eMemScope scope = MEMHEAD_SCOPE_CURRENT();
 	MemHead *memh;
 
 	len = SIZET_ALIGN_4(len);
 
-	memh = (MemHead *)calloc(1, len + sizeof(MemHead));
+	if (MEM_USE_SMALL_ALLOC(len)) {
+		memh = (MemHead *)mem_small_alloc(MEM_SMALL_CLASS(len + sizeof(MemHead)));
+		if (LIKELY(memh)) {
+			memset(memh + 1, 0, len);
+			memh->len = len | (size_t) MEMHEAD_SMALL_FLAG | MEMHEAD_SCOPE_BITS(scope);
+		}
+	}
+	else {
+		memh = (MemHead *)calloc(1, len + sizeof(MemHead));
+		if (LIKELY(memh)) {
+			memh->len = len | MEMHEAD_SCOPE_BITS(scope);
+		}
+	}
 
 	if (LIKELY(memh)) {
-		memh->len = len;
 		atomic_add_and_fetch_u(&totblock, 1);
 		atomic_add_and_fetch_z(&mem_in_use, len);
 		update_maximum(&peak_mem, mem_in_use);
+		mem_scope_alloc(scope, len);
 
 		return PTR_FROM_MEMHEAD(memh);
 	}
@@ -300,21 +343,33 @@ void *MEM_lockfree_callocN(size_t len, const char *str)
 
 void *MEM_lockfree_mallocN(size_t len, const char *str)
 {
+	const eMemScope scope = MEMHEAD_SCOPE_CURRENT();
 	MemHead *memh;
 
 	len = SIZET_ALIGN_4(len);
 
-	memh = (MemHead *)malloc(len + sizeof(MemHead));
+	if (MEM_USE_SMALL_ALLOC(len)) {
+		memh = (MemHead *)mem_small_alloc(MEM_SMALL_CLASS(len + sizeof(MemHead)));
+		if (LIKELY(memh)) {
+			memh->len = len | (size_t) MEMHEAD_SMALL_FLAG | MEMHEAD_SCOPE_BITS(scope);
+		}
+	}
+	else {
+		memh = (MemHead *)malloc(len + sizeof(MemHead));
+		if (LIKELY(memh)) {
+			memh->len = len | MEMHEAD_SCOPE_BITS(scope);
+		}
+	}
 
 	if (LIKELY(memh)) {
 		if (UNLIKELY(malloc_debug_memset && len)) {
 			memset(memh + 1, 255, len);
 		}
 
-		memh->len = len;
 		atomic_add_and_fetch_u(&totblock, 1);
 		atomic_add_and_fetch_z(&mem_in_use, len);
 		update_maximum(&peak_mem, mem_in_use);
+		mem_scope_alloc(scope, len);
 
 		return PTR_FROM_MEMHEAD(memh);
 	}
@@ -325,6 +380,7 @@ void *MEM_lockfree_mallocN(size_t len, const char *str)
 
 void *MEM_lockfree_mallocN_aligned(size_t len, size_t alignment, const char *str)
 {
+	const eMemScope scope = MEMHEAD_SCOPE_CURRENT();
 	MemHeadAligned *memh;
 
 	/* It's possible that MemHead's size is not properly aligned,
@@ -359,11 +415,12 @@ void *MEM_lockfree_mallocN_aligned(size_t len, size_t alignment, const char *str
 			memset(memh + 1, 255, len);
 		}
 
-		memh->len = len | (size_t) MEMHEAD_ALIGN_FLAG;
+		memh->len = len | (size_t) MEMHEAD_ALIGN_FLAG | MEMHEAD_SCOPE_BITS(scope);
 		memh->alignment = (short) alignment;
 		atomic_add_and_fetch_u(&totblock, 1);
 		atomic_add_and_fetch_z(&mem_in_use, len);
 		update_maximum(&peak_mem, mem_in_use);
+		mem_scope_alloc(scope, len);
 
 		return PTR_FROM_MEMHEAD(memh);
 	}
@@ -374,6 +431,7 @@ void *MEM_lockfree_mallocN_aligned(size_t len, size_t alignment, const char *str
 
 void *MEM_lockfree_mapallocN(size_t len, const char *str)
 {
+	const eMemScope scope = MEMHEAD_SCOPE_CURRENT();
 	MemHead *memh;
 
 	/* on 64 bit, simply use calloc instead, as mmap does not support
@@ -395,10 +453,11 @@ void *MEM_lockfree_mapallocN(size_t len, const char *str)
 #endif
 
 	if (memh != (MemHead *)-1) {
-		memh->len = len | (size_t) MEMHEAD_MMAP_FLAG;
+		memh->len = len | (size_t) MEMHEAD_MMAP_FLAG | MEMHEAD_SCOPE_BITS(scope);
 		atomic_add_and_fetch_u(&totblock, 1);
 		atomic_add_and_fetch_z(&mem_in_use, len);
 		atomic_add_and_fetch_z(&mmap_in_use, len);
+		mem_scope_alloc(scope, len);
 
 		update_maximum(&peak_mem, mem_in_use);
 		update_maximum(&peak_mem, mmap_in_use);
@@ -431,6 +490,11 @@ void MEM_lockfree_printmemlist_stats(void)
 	       (double)mem_in_use / (double)(1024 * 1024));
 	printf("peak memory len: %.3f MB\n",
 	       (double)peak_mem / (double)(1024 * 1024));
+	if (use_small_alloc) {
+		printf("small blocks reserved: %.3f MB\n",
+		       (double)mem_small_get_memory_reserved() / (double)(1024 * 1024));
+	}
+	MEM_printmemlist_scopes();
 	printf("\nFor more detailed per-block statistics run Blender with memory debugging command line argument.\n");
 
 #ifdef HAVE_MALLOC_STATS
@@ -460,6 +524,11 @@ void MEM_lockfree_set_memory_debug(void)
 	malloc_debug_memset = true;
 }
 
+void MEM_lockfree_use_small_allocator(void)
+{
+	use_small_alloc = true;
+}
+
 size_t MEM_lockfree_get_memory_in_use(void)
 {
 	return mem_in_use;
@@ -479,6 +548,7 @@ unsigned int MEM_lockfree_get_memory_blocks_in_use(void)
 void MEM_lockfree_reset_peak_memory(void)
 {
 	peak_mem = mem_in_use;
+	mem_scope_reset_peak();
 }
 
 size_t MEM_lockfree_get_peak_memory(void)
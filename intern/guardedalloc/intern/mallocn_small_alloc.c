@@ -0,0 +1,312 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file guardedalloc/intern/mallocn_small_alloc.c
+ *  \ingroup MEM
+ *
+ * Thread caching allocator for small blocks, used by the lock-free allocator.
+ *
+ * Blocks are grouped in size classes of #MEM_SMALL_GRANULARITY bytes. Each thread keeps a free list
+ * per size class, so allocating and freeing a block is a couple of pointer operations without any
+ * lock or atomic. Blocks are only exchanged with the global pool by batches, when a thread list runs
+ * empty or grows too long, and new blocks are carved from slabs allocated from the system.
+ *
+ * Slabs are never given back to the system, but their blocks are reused by all threads,
+ * and the cache of a thread is moved back to the global pool when it exits.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "MEM_guardedalloc.h"
+
+/* to ensure strict conversions */
+#include "../../source/blender/blenlib/BLI_strict_flags.h"
+
+#include "mallocn_intern.h"
+
+/* Blocks moved at once between a thread cache and the global pool (for the biggest size class). */
+#define MEM_SMALL_BATCH_BYTES (8 * 1024)
+/* Upper limit of blocks per batch, for the smallest size classes. */
+#define MEM_SMALL_BATCH_MAX 256
+
+/* Free block, the first word of the block (the MemHead of the lock-free allocator). */
+typedef struct MemSmallBlock {
+	struct MemSmallBlock *next;
+	/* Only used by the first block of a batch in the global pool. */
+	struct MemSmallBlock *next_batch;
+} MemSmallBlock;
+
+typedef struct MemSmallList {
+	MemSmallBlock *first;
+	unsigned int count;
+} MemSmallList;
+
+typedef struct MemSmallCache {
+	MemSmallList lists[MEM_SMALL_CLASSES];
+} MemSmallCache;
+
+typedef struct MemSmallSlab {
+	struct MemSmallSlab *next;
+	size_t size;
+} MemSmallSlab;
+
+/* Keep blocks 16 bytes aligned, after the slab header. */
+#define MEM_SMALL_SLAB_HEADER (((sizeof(MemSmallSlab) + 15) / 16) * 16)
+
+typedef struct MemSmallPool {
+	pthread_mutex_t mutex;
+	MemSmallBlock *batches;
+} MemSmallPool;
+
+static MemSmallPool small_pools[MEM_SMALL_CLASSES];
+static MemSmallSlab *small_slabs = NULL;
+static size_t small_slabs_in_use = 0;
+static pthread_mutex_t small_slabs_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_once_t small_init_once = PTHREAD_ONCE_INIT;
+static pthread_key_t small_cache_key;
+#ifndef MEM_USE_PTHREAD_KEY
+static MEM_THREAD_LOCAL MemSmallCache *small_cache = NULL;
+#endif
+
+MEM_INLINE size_t mem_small_block_size(const unsigned int size_class)
+{
+	return (size_t)(size_class + 1) * MEM_SMALL_GRANULARITY;
+}
+
+MEM_INLINE unsigned int mem_small_batch_len(const unsigned int size_class)
+{
+	const size_t len = MEM_SMALL_BATCH_BYTES / mem_small_block_size(size_class);
+	return (unsigned int)(len < MEM_SMALL_BATCH_MAX ? len : MEM_SMALL_BATCH_MAX);
+}
+
+/* Give a whole list back to the global pool, as a single batch. */
+static void mem_small_list_release(MemSmallList *list, const unsigned int size_class)
+{
+	MemSmallPool *pool = &small_pools[size_class];
+
+	if (list->first == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&pool->mutex);
+	list->first->next_batch = pool->batches;
+	pool->batches = list->first;
+	pthread_mutex_unlock(&pool->mutex);
+
+	list->first = NULL;
+	list->count = 0;
+}
+
+static void mem_small_cache_free(void *cache_v)
+{
+	MemSmallCache *cache = cache_v;
+	unsigned int size_class;
+
+	for (size_class = 0; size_class < MEM_SMALL_CLASSES; size_class++) {
+		mem_small_list_release(&cache->lists[size_class], size_class);
+	}
+	free(cache);
+
+#ifndef MEM_USE_PTHREAD_KEY
+	/* In case other thread exit handlers still allocate, they get a new cache. */
+	small_cache = NULL;
+#endif
+}
+
+static void mem_small_init(void)
+{
+	unsigned int size_class;
+
+	for (size_class = 0; size_class < MEM_SMALL_CLASSES; size_class++) {
+		pthread_mutex_init(&small_pools[size_class].mutex, NULL);
+		small_pools[size_class].batches = NULL;
+	}
+	pthread_key_create(&small_cache_key, mem_small_cache_free);
+}
+
+static MemSmallCache *mem_small_cache_ensure(void)
+{
+	MemSmallCache *cache;
+
+#ifdef MEM_USE_PTHREAD_KEY
+	pthread_once(&small_init_once, mem_small_init);
+	cache = pthread_getspecific(small_cache_key);
+#else
+	cache = small_cache;
+	if (LIKELY(cache)) {
+		return cache;
+	}
+	pthread_once(&small_init_once, mem_small_init);
+#endif
+
+	if (UNLIKELY(cache == NULL)) {
+		cache = calloc(1, sizeof(MemSmallCache));
+		if (UNLIKELY(cache == NULL)) {
+			return NULL;
+		}
+		/* Only used to get the cache back to the global pool when the thread exits. */
+		pthread_setspecific(small_cache_key, cache);
+#ifndef MEM_USE_PTHREAD_KEY
+		small_cache = cache;
+#endif
+	}
+
+	return cache;
+}
+
+/* Fill an empty list, from the global pool or from a new slab. */
+static bool mem_small_list_refill(MemSmallList *list, const unsigned int size_class)
+{
+	MemSmallPool *pool = &small_pools[size_class];
+	const size_t block_size = mem_small_block_size(size_class);
+	const unsigned int batch_len = mem_small_batch_len(size_class);
+	MemSmallBlock *block;
+	MemSmallSlab *slab;
+	unsigned int i;
+
+	assert(list->first == NULL);
+
+	if (pool->batches) {
+		pthread_mutex_lock(&pool->mutex);
+		block = pool->batches;
+		if (block) {
+			pool->batches = block->next_batch;
+		}
+		pthread_mutex_unlock(&pool->mutex);
+
+		if (block) {
+			list->first = block;
+			for (list->count = 0; block; block = block->next) {
+				list->count++;
+			}
+			return true;
+		}
+	}
+
+	slab = malloc(MEM_SMALL_SLAB_HEADER + block_size * batch_len);
+	if (UNLIKELY(slab == NULL)) {
+		return false;
+	}
+	slab->size = MEM_SMALL_SLAB_HEADER + block_size * batch_len;
+
+	pthread_mutex_lock(&small_slabs_mutex);
+	slab->next = small_slabs;
+	small_slabs = slab;
+	small_slabs_in_use += slab->size;
+	pthread_mutex_unlock(&small_slabs_mutex);
+
+	block = (MemSmallBlock *)((char *)slab + MEM_SMALL_SLAB_HEADER);
+	list->first = block;
+	for (i = 1; i < batch_len; i++) {
+		MemSmallBlock *block_next = (MemSmallBlock *)((char *)block + block_size);
+		block->next = block_next;
+		block = block_next;
+	}
+	block->next = NULL;
+	list->count = batch_len;
+
+	return true;
+}
+
+/**
+ * Allocate a block of #mem_small_block_size bytes for given size class.
+ *
+ * \return NULL when the system is out of memory.
+ */
+void *mem_small_alloc(const unsigned int size_class)
+{
+	MemSmallCache *cache = mem_small_cache_ensure();
+	MemSmallList *list;
+	MemSmallBlock *block;
+
+	assert(size_class < MEM_SMALL_CLASSES);
+
+	if (UNLIKELY(cache == NULL)) {
+		return NULL;
+	}
+
+	list = &cache->lists[size_class];
+	if (UNLIKELY(list->first == NULL)) {
+		if (!mem_small_list_refill(list, size_class)) {
+			return NULL;
+		}
+	}
+
+	block = list->first;
+	list->first = block->next;
+	list->count--;
+
+	return block;
+}
+
+/**
+ * Free a block returned by #mem_small_alloc, from any thread.
+ */
+void mem_small_free(void *ptr, const unsigned int size_class)
+{
+	MemSmallCache *cache = mem_small_cache_ensure();
+	const unsigned int batch_len = mem_small_batch_len(size_class);
+	MemSmallBlock *block = ptr;
+	MemSmallList *list;
+
+	assert(size_class < MEM_SMALL_CLASSES);
+
+	if (UNLIKELY(cache == NULL)) {
+		/* Can only happen when the thread cache couldn't be allocated,
+		 * give the block back to the global pool directly. */
+		MemSmallList list_single = {block, 1};
+		block->next = NULL;
+		mem_small_list_release(&list_single, size_class);
+		return;
+	}
+
+	list = &cache->lists[size_class];
+	block->next = list->first;
+	list->first = block;
+	list->count++;
+
+	/* Keep at most two batches per thread, give the oldest blocks back to the global pool. */
+	if (UNLIKELY(list->count >= 2 * batch_len)) {
+		MemSmallList list_release;
+		MemSmallBlock *last = list->first;
+		unsigned int i;
+
+		for (i = 1; i < batch_len; i++) {
+			last = last->next;
+		}
+		list_release.first = last->next;
+		list_release.count = list->count - batch_len;
+		last->next = NULL;
+		list->count = batch_len;
+
+		mem_small_list_release(&list_release, size_class);
+	}
+}
+
+/**
+ * Memory allocated from the system for small blocks, including the blocks currently free.
+ */
+size_t mem_small_get_memory_reserved(void)
+{
+	return small_slabs_in_use;
+}
@@ -44,6 +44,7 @@ extern "C" {
 #include "DNA_space_types.h"  /* for FILE_MAX */
 
 #include "BLI_string.h"
+#include "BLI_task.h"
 
 #ifdef WIN32
 /* needed for MSCV because of snprintf from BLI_string */
@@ -96,6 +97,12 @@ ExportSettings::ExportSettings()
     , do_convert_axis(false)
 {}
 
+static void prepare_shape_cb(void *userdata, const int index)
+{
+	std::vector<AbcObjectWriter *> &shapes = *static_cast<std::vector<AbcObjectWriter *> *>(userdata);
+	shapes[index]->prepare();
+}
+
 static bool object_is_smoke_sim(Object *ob)
 {
 	ModifierData *md = modifiers_findByType(ob, eModifierType_Smoke);
@@ -291,6 +298,16 @@ void AbcExporter::operator()(Main *bmain, float &progress, bool &was_canceled)
 	createTransformWritersHierarchy(bmain->eval_ctx);
 	createShapeWriters(bmain->eval_ctx);
 
+	/* Shapes whose data can be evaluated independently of each other are
+	 * prepared in parallel, only writing to the archive is serialized. */
+	std::vector<AbcObjectWriter *> threaded_shapes;
+
+	for (int i = 0, e = m_shapes.size(); i != e; ++i) {
+		if (m_shapes[i]->prepareIsThreadSafe()) {
+			threaded_shapes.push_back(m_shapes[i]);
+		}
+	}
+
 	/* Make a list of frames to export. */
 
 	std::set<double> xform_frames;
@@ -325,6 +342,9 @@ void AbcExporter::operator()(Main *bmain, float &progress, bool &was_canceled)
 		setCurrentFrame(bmain, frame);
 
 		if (shape_frames.count(frame) != 0) {
+			BLI_task_parallel_range(0, threaded_shapes.size(), &threaded_shapes,
+			                        prepare_shape_cb, threaded_shapes.size() > 1);
+
 			for (int i = 0, e = m_shapes.size(); i != e; ++i) {
 				m_shapes[i]->write();
 			}
@@ -295,7 +295,9 @@ AbcMeshWriter::AbcMeshWriter(Scene *scene,
     : AbcObjectWriter(scene, ob, time_sampling, settings, parent)
 {
 	m_is_animated = isAnimated();
+	m_prepare_threaded = isSelfContained();
 	m_subsurf_mod = NULL;
+	m_prepared_dm = NULL;
 	m_is_subd = false;
 
 	/* If the object is static, use the default static time sampling. */
@@ -330,6 +332,10 @@ AbcMeshWriter::AbcMeshWriter(Scene *scene,
 
 AbcMeshWriter::~AbcMeshWriter()
 {
+	if (m_prepared_dm) {
+		freeMesh(m_prepared_dm);
+	}
+
 	if (m_subsurf_mod) {
 		m_subsurf_mod->mode &= ~eModifierMode_DisableTemporary;
 	}
@@ -358,13 +364,73 @@ bool AbcMeshWriter::isAnimated() const
 	return me->adt != NULL;
 }
 
-void AbcMeshWriter::do_write()
+static void find_object_link_cb(void *userData, Object *UNUSED(ob), Object **obpoin)
+{
+	if (*obpoin) {
+		*static_cast<bool *>(userData) = true;
+	}
+}
+
+/* Whether evaluating the modifier stack only reads and writes data owned by
+ * this object, so that it can run while other objects are being evaluated. */
+bool AbcMeshWriter::isSelfContained() const
+{
+	ModifierData *md = static_cast<ModifierData *>(m_object->modifiers.first);
+
+	for (; md; md = md->next) {
+		const ModifierTypeInfo *mti = modifierType_getInfo(static_cast<ModifierType>(md->type));
+
+		/* Simulations read effectors, collision objects and shared caches. */
+		if (mti->flags & eModifierTypeFlag_UsesPointCache) {
+			return false;
+		}
+
+		/* Armatures and hooks only read the evaluated pose or matrix of
+		 * their target, other links may evaluate the target's data. */
+		if (ELEM(md->type, eModifierType_Armature, eModifierType_Hook)) {
+			continue;
+		}
+
+		if (mti->foreachObjectLink) {
+			bool has_link = false;
+			mti->foreachObjectLink(md, m_object, find_object_link_cb, &has_link);
+
+			if (has_link) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool AbcMeshWriter::needsSample() const
 {
 	/* We have already stored a sample for this object. */
-	if (!m_first_frame && !m_is_animated)
+	return m_first_frame || m_is_animated;
+}
+
+void AbcMeshWriter::prepare()
+{
+	if (!needsSample() || m_prepared_dm) {
+		return;
+	}
+
+	m_prepared_dm = getFinalMesh();
+}
+
+bool AbcMeshWriter::prepareIsThreadSafe() const
+{
+	return m_prepare_threaded;
+}
+
+void AbcMeshWriter::do_write()
+{
+	if (!needsSample())
 		return;
 
-	DerivedMesh *dm = getFinalMesh();
+	DerivedMesh *dm = m_prepared_dm ? m_prepared_dm : getFinalMesh();
+	m_prepared_dm = NULL;
 
 	try {
 		if (m_settings.use_subdiv_schema && m_subdiv_schema.valid()) {
@@ -42,8 +42,12 @@ class AbcMeshWriter : public AbcObjectWriter {
 	Alembic::Abc::OArrayProperty m_mat_indices;
 
 	bool m_is_animated;
+	bool m_prepare_threaded;
 	ModifierData *m_subsurf_mod;
 
+	/* Final mesh evaluated by prepare(), consumed by the next write(). */
+	DerivedMesh *m_prepared_dm;
+
 	CDStreamConfig m_custom_data_config;
 
 	bool m_is_liquid;
@@ -58,10 +62,15 @@ public:
 
 	~AbcMeshWriter();
 
+	virtual void prepare();
+	virtual bool prepareIsThreadSafe() const;
+
 private:
 	virtual void do_write();
 
 	bool isAnimated() const;
+	bool isSelfContained() const;
+	bool needsSample() const;
 
 	void writeMesh(DerivedMesh *dm);
 	void writeSubD(DerivedMesh *dm);
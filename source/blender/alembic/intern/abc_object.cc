@@ -109,6 +109,15 @@ Imath::Box3d AbcObjectWriter::bounds()
 	return this->m_bounds;
 }
 
+void AbcObjectWriter::prepare()
+{
+}
+
+bool AbcObjectWriter::prepareIsThreadSafe() const
+{
+	return false;
+}
+
 void AbcObjectWriter::write()
 {
 	do_write();
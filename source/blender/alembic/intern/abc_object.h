@@ -68,6 +68,13 @@ public:
 
 	virtual Imath::Box3d bounds();
 
+	/* Evaluate the data to be written for the current frame, without touching
+	 * the archive. When prepareIsThreadSafe() returns true this may run
+	 * concurrently with the prepare() of other writers; write() then only has
+	 * to store the prepared sample. */
+	virtual void prepare();
+	virtual bool prepareIsThreadSafe() const;
+
 	void write();
 
 private:
@@ -740,6 +740,15 @@ void makeDerivedMesh(
         struct Scene *scene, struct Object *ob, struct BMEditMesh *em,
         CustomDataMask dataMask, const bool build_shapekey_layers);
 
+/* Evaluated meshes shared between objects during one depsgraph evaluation. */
+typedef struct DerivedMeshShareCache DerivedMeshShareCache;
+
+DerivedMeshShareCache *DM_share_cache_new(void);
+void DM_share_cache_free(DerivedMeshShareCache *cache);
+void makeDerivedMesh_shared(
+        DerivedMeshShareCache *cache, struct Scene *scene, struct Object *ob,
+        CustomDataMask dataMask);
+
 void weight_to_rgb(float r_rgb[3], const float weight);
 /** Update the weight MCOL preview layer.
  * If weights are NULL, use object's active vgroup(s).
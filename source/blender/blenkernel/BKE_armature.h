@@ -184,6 +184,12 @@ void BKE_pose_constraints_evaluate(struct EvaluationContext *eval_ctx,
 void BKE_pose_bone_done(struct EvaluationContext *eval_ctx,
                         struct bPoseChannel *pchan);
 
+void BKE_pose_eval_bone_batch(struct EvaluationContext *eval_ctx,
+                              struct Scene *scene,
+                              struct Object *ob,
+                              struct bPoseChannel **pchans,
+                              int num_pchans);
+
 void BKE_pose_iktree_evaluate(struct EvaluationContext *eval_ctx,
                               struct Scene *scene,
                               struct Object *ob,
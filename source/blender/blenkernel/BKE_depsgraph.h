@@ -44,6 +44,7 @@
 extern "C" {
 #endif
 
+struct DerivedMeshShareCache;
 struct ID;
 struct Main;
 struct Object;
@@ -57,6 +58,9 @@ struct Scene;
 typedef struct EvaluationContext {
 	int mode;               /* evaluation mode */
 	float ctime;            /* evaluation time */
+
+	/* Evaluated meshes shared between objects, only set while evaluating. */
+	struct DerivedMeshShareCache *mesh_share_cache;
 } EvaluationContext;
 
 typedef enum eEvaluationMode {
@@ -91,6 +95,10 @@ void DAG_exit(void);
  * be rebuilt later. The graph is not rebuilt immediately to avoid slowdowns
  * when this function is call multiple times from different operators.
  *
+ * DAG_id_relations_tag_update is the same, for changes of relations of a
+ * single ID. The new dependency graph only rebuilds the part of the graph
+ * depending on that ID then.
+ *
  * DAG_scene_relations_rebuild forces an immediaterebuild of the dependency
  * graph, this is only needed in rare cases
  */
@@ -98,6 +106,7 @@ void DAG_exit(void);
 void DAG_scene_relations_update(struct Main *bmain, struct Scene *sce);
 void DAG_scene_relations_validate(struct Main *bmain, struct Scene *sce);
 void DAG_relations_tag_update(struct Main *bmain);
+void DAG_id_relations_tag_update(struct Main *bmain, struct ID *id);
 void DAG_scene_relations_rebuild(struct Main *bmain, struct Scene *scene);
 void DAG_scene_free(struct Scene *sce);
 
@@ -40,16 +40,20 @@
 #include "DNA_material_types.h"
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 
 #include "BLI_array.h"
 #include "BLI_blenlib.h"
 #include "BLI_bitmap.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 #include "BLI_linklist.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_cdderivedmesh.h"
 #include "BKE_editmesh.h"
@@ -1774,6 +1778,7 @@ static void mesh_calc_modifiers(
 	ModifierApplyFlag app_flags = useRenderParams ? MOD_APPLY_RENDER : 0;
 	ModifierApplyFlag deform_app_flags = app_flags;
 
+	const eMemScope mem_scope = MEM_scope_begin(MEM_SCOPE_MODIFIERS);
 
 	if (useCache)
 		app_flags |= MOD_APPLY_USECACHE;
@@ -2248,6 +2253,8 @@ static void mesh_calc_modifiers(
 		MEM_freeN(deformedVerts);
 
 	BLI_linklist_free((LinkNode *)datamasks, NULL);
+
+	MEM_scope_end(mem_scope);
 }
 
 float (*editbmesh_get_vertex_cos(BMEditMesh *em, int *r_numVerts))[3]
@@ -2314,6 +2321,8 @@ static void editbmesh_calc_modifiers(
 	const bool do_loop_normals = (((Mesh *)(ob->data))->flag & ME_AUTOSMOOTH) != 0;
 	const float loop_normals_split_angle = ((Mesh *)(ob->data))->smoothresh;
 
+	const eMemScope mem_scope = MEM_scope_begin(MEM_SCOPE_MODIFIERS);
+
 	modifiers_clearErrors(ob);
 
 	if (r_cage && cageIndex == -1) {
@@ -2580,6 +2589,8 @@ static void editbmesh_calc_modifiers(
 
 	if (deformedVerts)
 		MEM_freeN(deformedVerts);
+
+	MEM_scope_end(mem_scope);
 }
 
 #ifdef WITH_OPENSUBDIV
@@ -2730,6 +2741,266 @@ void makeDerivedMesh(
 	}
 }
 
+/* -------------------------------------------------------------------- */
+/* Evaluated mesh sharing
+ *
+ * Objects which instance the same mesh with an identical modifier stack
+ * evaluate to the same result, so within one dependency graph evaluation
+ * the stack is only computed for the first of them. The others receive a
+ * copy of the stored result instead.
+ *
+ * Only modifiers whose result depends on nothing but the mesh and their own
+ * settings are supported; anything else is evaluated as usual.
+ */
+
+typedef struct DerivedMeshShareEntry {
+	/* Key. */
+	Object *ob;  /* object which owns the entry, its stack is compared against */
+	Mesh *me;
+	CustomDataMask dataMask;
+	bool need_mapping;
+	unsigned int hash;
+
+	/* Private copies of the result, NULL while the owner is still evaluating. */
+	DerivedMesh *dm_final, *dm_deform;
+} DerivedMeshShareEntry;
+
+struct DerivedMeshShareCache {
+	GHash *entries;  /* DerivedMeshShareEntry, keyed by itself */
+	SpinLock lock;
+};
+
+/* Size of the settings following ModifierData which fully define the modifier
+ * result, or zero when the modifier can not be shared between objects. */
+static size_t dm_share_modifier_settings_size(ModifierData *md)
+{
+	switch (md->type) {
+		case eModifierType_Subsurf:
+		{
+			SubsurfModifierData *smd = (SubsurfModifierData *)md;
+			if (smd->use_opensubdiv) {
+				return 0;
+			}
+			/* Caches are private to each object. */
+			return offsetof(SubsurfModifierData, emCache) - sizeof(ModifierData);
+		}
+		case eModifierType_Mirror:
+		{
+			MirrorModifierData *mmd = (MirrorModifierData *)md;
+			/* Vertex group flipping uses the object's group names. */
+			if (mmd->mirror_ob || (mmd->flag & MOD_MIR_VGROUP)) {
+				return 0;
+			}
+			return sizeof(MirrorModifierData) - sizeof(ModifierData);
+		}
+		case eModifierType_EdgeSplit:
+			return sizeof(EdgeSplitModifierData) - sizeof(ModifierData);
+		case eModifierType_Triangulate:
+			return sizeof(TriangulateModifierData) - sizeof(ModifierData);
+		default:
+			return 0;
+	}
+}
+
+static const unsigned char *dm_share_modifier_settings(ModifierData *md)
+{
+	return (const unsigned char *)md + sizeof(ModifierData);
+}
+
+/* Returns false when the object's evaluated mesh can not be shared,
+ * otherwise fills in the hash of its modifier stack. */
+static bool dm_share_object_hash(Object *ob, unsigned int *r_hash)
+{
+	Mesh *me = ob->data;
+	VirtualModifierData virtualModifierData;
+	ModifierData *md;
+	unsigned int hash = 0;
+
+	if (ob->mode != OB_MODE_OBJECT || ob->sculpt || me->edit_btmesh || me->key) {
+		return false;
+	}
+	if (me->id.us <= 1) {
+		/* No other object can use the result, storing a copy is only overhead. */
+		return false;
+	}
+	if (BLI_listbase_is_empty(&ob->modifiers)) {
+		/* Nothing worth sharing, the result is a plain copy of the mesh. */
+		return false;
+	}
+
+	/* Virtual modifiers (armature parenting, shape keys) are object dependent
+	 * and therefore rejected here too. */
+	for (md = modifiers_getVirtualModifierList(ob, &virtualModifierData); md; md = md->next) {
+		const size_t size = dm_share_modifier_settings_size(md);
+		if (size == 0) {
+			return false;
+		}
+		hash = BLI_hash_mm2((const unsigned char *)&md->type, sizeof(md->type), hash);
+		hash = BLI_hash_mm2((const unsigned char *)&md->mode, sizeof(md->mode), hash);
+		hash = BLI_hash_mm2(dm_share_modifier_settings(md), size, hash);
+	}
+
+	*r_hash = hash;
+	return true;
+}
+
+static bool dm_share_object_stack_equals(Object *ob_a, Object *ob_b)
+{
+	VirtualModifierData virtual_a, virtual_b;
+	ModifierData *md_a = modifiers_getVirtualModifierList(ob_a, &virtual_a);
+	ModifierData *md_b = modifiers_getVirtualModifierList(ob_b, &virtual_b);
+
+	for (; md_a && md_b; md_a = md_a->next, md_b = md_b->next) {
+		if (md_a->type != md_b->type || md_a->mode != md_b->mode) {
+			return false;
+		}
+		/* Both stacks passed dm_share_object_hash, so the size is non-zero. */
+		if (memcmp(dm_share_modifier_settings(md_a),
+		           dm_share_modifier_settings(md_b),
+		           dm_share_modifier_settings_size(md_a)) != 0)
+		{
+			return false;
+		}
+	}
+
+	return (md_a == NULL && md_b == NULL);
+}
+
+static unsigned int dm_share_entry_hash(const void *key)
+{
+	const DerivedMeshShareEntry *entry = key;
+	return entry->hash;
+}
+
+static bool dm_share_entry_cmp(const void *a, const void *b)
+{
+	const DerivedMeshShareEntry *entry_a = a;
+	const DerivedMeshShareEntry *entry_b = b;
+
+	return !((entry_a->hash == entry_b->hash) &&
+	         (entry_a->me == entry_b->me) &&
+	         (entry_a->dataMask == entry_b->dataMask) &&
+	         (entry_a->need_mapping == entry_b->need_mapping) &&
+	         dm_share_object_stack_equals(entry_a->ob, entry_b->ob));
+}
+
+static void dm_share_entry_free(void *val)
+{
+	DerivedMeshShareEntry *entry = val;
+
+	if (entry->dm_final) {
+		entry->dm_final->release(entry->dm_final);
+	}
+	if (entry->dm_deform) {
+		entry->dm_deform->release(entry->dm_deform);
+	}
+	MEM_freeN(entry);
+}
+
+DerivedMeshShareCache *DM_share_cache_new(void)
+{
+	DerivedMeshShareCache *cache = MEM_callocN(sizeof(*cache), __func__);
+
+	cache->entries = BLI_ghash_new(dm_share_entry_hash, dm_share_entry_cmp, __func__);
+	BLI_spin_init(&cache->lock);
+
+	return cache;
+}
+
+void DM_share_cache_free(DerivedMeshShareCache *cache)
+{
+	BLI_ghash_free(cache->entries, NULL, dm_share_entry_free);
+	BLI_spin_end(&cache->lock);
+	MEM_freeN(cache);
+}
+
+/* Copies keep the tessellation requested by the mask, as #mesh_calc_modifiers ensures it. */
+static DerivedMesh *dm_share_copy(DerivedMesh *dm, CustomDataMask dataMask)
+{
+	return (dataMask & CD_MASK_MFACE) ? CDDM_copy_with_tessface(dm) : CDDM_copy(dm);
+}
+
+/**
+ * Same as #makeDerivedMesh for objects outside of edit-mode, but reuses the result
+ * of another object in \a cache with the same mesh and modifier stack when possible.
+ *
+ * Safe to call from multiple threads at once.
+ */
+void makeDerivedMesh_shared(
+        DerivedMeshShareCache *cache, Scene *scene, Object *ob, CustomDataMask dataMask)
+{
+	DerivedMeshShareEntry key, *entry;
+	DerivedMesh *dm_final = NULL, *dm_deform = NULL;
+	bool need_mapping, is_owner = false;
+
+	dataMask |= object_get_datamask(scene, ob, &need_mapping);
+
+	if (!dm_share_object_hash(ob, &key.hash)) {
+		mesh_build_data(scene, ob, dataMask, false, need_mapping);
+		return;
+	}
+
+	key.ob = ob;
+	key.me = ob->data;
+	key.dataMask = dataMask;
+	key.need_mapping = need_mapping;
+
+	BLI_spin_lock(&cache->lock);
+	entry = BLI_ghash_lookup(cache->entries, &key);
+	if (entry == NULL) {
+		entry = MEM_mallocN(sizeof(*entry), __func__);
+		*entry = key;
+		entry->dm_final = entry->dm_deform = NULL;
+		BLI_ghash_insert(cache->entries, entry, entry);
+		is_owner = true;
+	}
+	else if (entry->dm_final) {
+		/* Result is never modified once stored, copying it needs no lock. */
+		dm_final = entry->dm_final;
+		dm_deform = entry->dm_deform;
+	}
+	BLI_spin_unlock(&cache->lock);
+
+	if (dm_final == NULL) {
+		/* Owner, or the owner has not finished yet: rather than waiting on it,
+		 * evaluate the stack here too. */
+		mesh_build_data(scene, ob, dataMask, false, need_mapping);
+
+		if (is_owner) {
+			/* Store a plain copy, so others never touch the owner's mesh
+			 * (which may also be a lazily filled CCGDM). */
+			dm_final = dm_share_copy(ob->derivedFinal, dataMask);
+			dm_deform = CDDM_copy(ob->derivedDeform);
+
+			BLI_spin_lock(&cache->lock);
+			entry->dm_deform = dm_deform;
+			entry->dm_final = dm_final;
+			BLI_spin_unlock(&cache->lock);
+		}
+		return;
+	}
+
+	BKE_object_free_derived_caches(ob);
+	BKE_object_sculpt_modifiers_changed(ob);
+
+	ob->derivedFinal = dm_share_copy(dm_final, dataMask);
+	ob->derivedDeform = CDDM_copy(dm_deform);
+
+	/* Same finalization as #mesh_calc_modifiers, so nothing is computed lazily
+	 * from other threads reading this object's mesh. */
+	DM_ensure_looptri(ob->derivedFinal);
+	DM_ensure_normals(ob->derivedFinal);
+
+	DM_set_object_boundbox(ob, ob->derivedFinal);
+
+	ob->derivedFinal->needsFree = 0;
+	ob->derivedDeform->needsFree = 0;
+	ob->lastDataMask = dataMask;
+	ob->lastNeedMapping = need_mapping;
+
+	BLI_assert(!(ob->derivedFinal->dirty & DM_DIRTY_NORMALS));
+}
+
 /***/
 
 DerivedMesh *mesh_get_derived_final(Scene *scene, Object *ob, CustomDataMask dataMask)
@@ -659,6 +659,46 @@ void BKE_pose_bone_done(EvaluationContext *UNUSED(eval_ctx),
 	}
 }
 
+/* Evaluate bones which have no constraints and are not part of IK chains,
+ * pchans is ordered so parents always come before their children.
+ */
+void BKE_pose_eval_bone_batch(EvaluationContext *UNUSED(eval_ctx),
+                              Scene *scene,
+                              Object *ob,
+                              bPoseChannel **pchans,
+                              int num_pchans)
+{
+	bArmature *arm = (bArmature *)ob->data;
+	const bool use_restpose = (arm->edbo || (arm->flag & ARM_RESTPOS));
+	float ctime = BKE_scene_frame_get(scene); /* not accurate... */
+	float imat[4][4];
+	int i;
+
+	DEBUG_PRINT("%s on %s, %d bones\n", __func__, ob->id.name, num_pchans);
+	BLI_assert(ob->type == OB_ARMATURE);
+
+	for (i = 0; i < num_pchans; i++) {
+		bPoseChannel *pchan = pchans[i];
+		Bone *bone = pchan->bone;
+
+		if (use_restpose) {
+			if (bone) {
+				copy_m4_m4(pchan->pose_mat, bone->arm_mat);
+				copy_v3_v3(pchan->pose_head, bone->arm_head);
+				copy_v3_v3(pchan->pose_tail, bone->arm_tail);
+			}
+		}
+		else if ((pchan->flag & (POSE_IKTREE | POSE_IKSPLINE | POSE_DONE)) == 0) {
+			BKE_pose_where_is_bone(scene, ob, pchan, ctime, 1);
+		}
+
+		if (bone) {
+			invert_m4_m4(imat, bone->arm_mat);
+			mul_m4_m4m4(pchan->chan_mat, pchan->pose_mat, imat);
+		}
+	}
+}
+
 void BKE_pose_iktree_evaluate(EvaluationContext *UNUSED(eval_ctx),
                               Scene *scene,
                               Object *ob,
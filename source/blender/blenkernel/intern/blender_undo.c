@@ -40,6 +40,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "DNA_object_types.h"
+#include "DNA_particle_types.h"
 #include "DNA_scene_types.h"
 
 #include "BLI_fileops.h"
@@ -59,6 +61,7 @@
 #include "BKE_depsgraph.h"
 #include "BKE_global.h"
 #include "BKE_image.h"
+#include "BKE_library.h"
 #include "BKE_main.h"
 #include "RE_pipeline.h"
 
@@ -78,7 +81,6 @@ typedef struct UndoElem {
 	char str[FILE_MAX];
 	char name[BKE_UNDO_STR_MAX];
 	MemFile memfile;
-	uintptr_t undosize;
 } UndoElem;
 
 static ListBase undobase = {NULL, NULL};
@@ -94,14 +96,69 @@ void BKE_undo_callback_wm_kill_jobs_set(void (*callback)(struct bContext *C))
 	undo_wm_job_kill_callback = callback;
 }
 
+/**
+ * Tag the IDs which were read again for update, the ones kept as is from the previous state
+ * (#LIB_TAG_UNDO_OLD_ID_REUSED) don't need to be evaluated again.
+ */
+static void undo_tag_update_changed_ids(Main *bmain)
+{
+	ListBase *lbarray[MAX_LIBARRAY];
+	bool is_changed = false;
+	int a;
+
+	a = set_listbasepointers(bmain, lbarray);
+	while (a--) {
+		ID *id;
+		for (id = lbarray[a]->first; id; id = id->next) {
+			/* linked data and UI are not read again */
+			if (id->lib || ELEM(GS(id->name), ID_LI, ID_WM, ID_SCR)) {
+				continue;
+			}
+
+			if (id->tag & LIB_TAG_UNDO_OLD_ID_REUSED) {
+				id->tag &= ~LIB_TAG_UNDO_OLD_ID_REUSED;
+			}
+			else {
+				switch (GS(id->name)) {
+					case ID_OB:
+						DAG_id_tag_update_ex(bmain, id, OB_RECALC_OB | OB_RECALC_DATA | OB_RECALC_TIME);
+						break;
+					case ID_PA:
+						DAG_id_tag_update_ex(bmain, id, PSYS_RECALC_RESET);
+						break;
+					default:
+						DAG_id_tag_update_ex(bmain, id, 0);
+						break;
+				}
+				is_changed = true;
+			}
+		}
+	}
+
+	if (is_changed) {
+		DAG_relations_tag_update(bmain);
+	}
+}
+
 static int read_undosave(bContext *C, UndoElem *uel)
 {
 	char mainstr[sizeof(G.main->name)];
 	int success = 0, fileflags;
+	MemFile memfile_oldmain = {{NULL}};
 
 	/* This is needed so undoing/redoing doesn't crash with threaded previews going */
 	undo_wm_job_kill_callback(C);
 
+	if (!UNDO_DISK) {
+		const eMemScope mem_scope = MEM_scope_begin(MEM_SCOPE_UNDO);
+		BLO_memfile_uncompress(&uel->memfile);
+		MEM_scope_end(mem_scope);
+
+		/* Write the current state the same way as undo steps, so the IDs which are identical
+		 * in the step can be kept as is instead of being read again. */
+		BLO_write_file_mem(G.main, &uel->memfile, &memfile_oldmain, G.fileflags);
+	}
+
 	BLI_strncpy(mainstr, G.main->name, sizeof(mainstr));    /* temporal store */
 
 	fileflags = G.fileflags;
@@ -110,13 +167,19 @@ static int read_undosave(bContext *C, UndoElem *uel)
 	if (UNDO_DISK)
 		success = (BKE_blendfile_read(C, uel->str, NULL, 0) != BKE_BLENDFILE_READ_FAIL);
 	else
-		success = BKE_blendfile_read_from_memfile(C, &uel->memfile, NULL, 0);
+		success = BKE_blendfile_read_from_memfile(C, &uel->memfile, &memfile_oldmain, NULL, 0);
+
+	BLO_memfile_free(&memfile_oldmain);
 
 	/* restore */
 	BLI_strncpy(G.main->name, mainstr, sizeof(G.main->name)); /* restore */
 	G.fileflags = fileflags;
 
 	if (success) {
+		if (!UNDO_DISK) {
+			undo_tag_update_changed_ids(G.main);
+		}
+
 		/* important not to update time here, else non keyed tranforms are lost */
 		DAG_on_visible_update(G.main, false);
 	}
@@ -124,12 +187,38 @@ static int read_undosave(bContext *C, UndoElem *uel)
 	return success;
 }
 
+static void undo_elem_free(UndoElem *uel)
+{
+	BLI_remlink(&undobase, uel);
+	BLO_memfile_free(&uel->memfile);
+	MEM_freeN(uel);
+}
+
+/**
+ * Compress the steps which aren't next to the current one, they're unlikely to be read soon.
+ */
+static void undo_compress_cold_steps(void)
+{
+	UndoElem *uel;
+
+	if (UNDO_DISK || (U.uiflag2 & USER_GLOBALUNDO_COMPRESS) == 0 || curundo == NULL) {
+		return;
+	}
+
+	for (uel = undobase.first; uel; uel = uel->next) {
+		if (!ELEM(uel, curundo, curundo->prev, curundo->next)) {
+			BLO_memfile_compress(&uel->memfile);
+		}
+	}
+}
+
 /* name can be a dynamic string */
 void BKE_undo_write(bContext *C, const char *name)
 {
-	uintptr_t maxmem, totmem, memused;
+	uintptr_t maxmem;
 	int nr /*, success */ /* UNUSED */;
 	UndoElem *uel;
+	eMemScope mem_scope;
 
 	if ((U.uiflag & USER_GLOBALUNDO) == 0) {
 		return;
@@ -139,12 +228,11 @@ void BKE_undo_write(bContext *C, const char *name)
 		return;
 	}
 
+	mem_scope = MEM_scope_begin(MEM_SCOPE_UNDO);
+
 	/* remove all undos after (also when curundo == NULL) */
 	while (undobase.last != curundo) {
-		uel = undobase.last;
-		BLI_remlink(&undobase, uel);
-		BLO_memfile_free(&uel->memfile);
-		MEM_freeN(uel);
+		undo_elem_free(undobase.last);
 	}
 
 	/* make new */
@@ -162,11 +250,8 @@ void BKE_undo_write(bContext *C, const char *name)
 	}
 	if (uel) {
 		while (undobase.first != uel) {
-			UndoElem *first = undobase.first;
-			BLI_remlink(&undobase, first);
-			/* the merge is because of compression */
-			BLO_memfile_merge(&first->memfile, &first->next->memfile);
-			MEM_freeN(first);
+			/* chunks shared with the next steps stay alive */
+			undo_elem_free(undobase.first);
 		}
 	}
 
@@ -194,42 +279,32 @@ void BKE_undo_write(bContext *C, const char *name)
 
 		if (curundo->prev) prevfile = &(curundo->prev->memfile);
 
-		memused = MEM_get_memory_in_use();
 		/* success = */ /* UNUSED */ BLO_write_file_mem(CTX_data_main(C), prevfile, &curundo->memfile, G.fileflags);
-		curundo->undosize = MEM_get_memory_in_use() - memused;
+
+		undo_compress_cold_steps();
 	}
 
-	if (U.undomemory != 0) {
-		/* limit to maximum memory (afterwards, we can't know in advance) */
-		totmem = 0;
+	if (U.undomemory != 0 && !UNDO_DISK) {
+		/* limit to maximum memory (afterwards, we can't know in advance),
+		 * chunks shared between steps are only counted once */
 		maxmem = ((uintptr_t)U.undomemory) * 1024 * 1024;
 
 		/* keep at least two (original + other) */
-		uel = undobase.last;
-		while (uel && uel->prev) {
-			totmem += uel->undosize;
-			if (totmem > maxmem) break;
-			uel = uel->prev;
-		}
-
-		if (uel) {
-			if (uel->prev && uel->prev->prev)
-				uel = uel->prev;
-
-			while (undobase.first != uel) {
-				UndoElem *first = undobase.first;
-				BLI_remlink(&undobase, first);
-				/* the merge is because of compression */
-				BLO_memfile_merge(&first->memfile, &first->next->memfile);
-				MEM_freeN(first);
-			}
+		while ((BLO_memfile_buffers_size() > maxmem) &&
+		       (undobase.first != undobase.last) &&
+		       (((UndoElem *)undobase.first)->next != undobase.last))
+		{
+			undo_elem_free(undobase.first);
 		}
 	}
+
+	MEM_scope_end(mem_scope);
 }
 
 /* 1 = an undo, -1 is a redo. we have to make sure 'curundo' remains at current situation */
 void BKE_undo_step(bContext *C, int step)
 {
+	eMemScope mem_scope;
 
 	if (step == 0) {
 		read_undosave(C, curundo);
@@ -257,6 +332,10 @@ void BKE_undo_step(bContext *C, int step)
 			if (G.debug & G_DEBUG) printf("redo %s\n", curundo->name);
 		}
 	}
+
+	mem_scope = MEM_scope_begin(MEM_SCOPE_UNDO);
+	undo_compress_cold_steps();
+	MEM_scope_end(mem_scope);
 }
 
 void BKE_undo_reset(void)
@@ -369,8 +448,10 @@ bool BKE_undo_save_file(const char *filename)
 		return false;
 	}
 
+	BLO_memfile_uncompress(&uel->memfile);
+
 	for (chunk = uel->memfile.chunks.first; chunk; chunk = chunk->next) {
-		if (write(file, chunk->buf, chunk->size) != chunk->size) {
+		if (write(file, chunk->buffer->buf, chunk->size) != chunk->size) {
 			break;
 		}
 	}
@@ -389,7 +470,7 @@ bool BKE_undo_save_file(const char *filename)
 Main *BKE_undo_get_main(Scene **r_scene)
 {
 	Main *mainp = NULL;
-	BlendFileData *bfd = BLO_read_from_memfile(G.main, G.main->name, &curundo->memfile, NULL, BLO_READ_SKIP_NONE);
+	BlendFileData *bfd = BLO_read_from_memfile(G.main, G.main->name, &curundo->memfile, NULL, NULL, BLO_READ_SKIP_NONE);
 
 	if (bfd) {
 		mainp = bfd->main;
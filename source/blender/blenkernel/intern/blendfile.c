@@ -404,12 +404,12 @@ bool BKE_blendfile_read_from_memory(
 
 /* memfile is the undo buffer */
 bool BKE_blendfile_read_from_memfile(
-        bContext *C, struct MemFile *memfile,
+        bContext *C, struct MemFile *memfile, const struct MemFile *memfile_oldmain,
         ReportList *reports, int skip_flags)
 {
 	BlendFileData *bfd;
 
-	bfd = BLO_read_from_memfile(CTX_data_main(C), G.main->name, memfile, reports, skip_flags);
+	bfd = BLO_read_from_memfile(CTX_data_main(C), G.main->name, memfile, memfile_oldmain, reports, skip_flags);
 	if (bfd) {
 		/* remove the unused screens and wm */
 		while (bfd->main->wm.first)
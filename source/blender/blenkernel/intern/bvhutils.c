@@ -811,7 +811,7 @@ static BVHTree *bvhtree_from_mesh_faces_create_tree(
 
 		/* Create a bvh-tree of the given target */
 		/* printf("%s: building BVH, total=%d\n", __func__, numFaces); */
-		tree = BLI_bvhtree_new(faces_num_active, epsilon, tree_type, axis);
+		tree = BLI_bvhtree_new_ex(faces_num_active, epsilon, tree_type, axis, BVH_TREE_SIMD);
 		if (tree) {
 			if (vert && face) {
 				for (i = 0; i < faces_num; i++) {
@@ -966,7 +966,7 @@ static BVHTree *bvhtree_from_editmesh_looptri_create_tree(
 
 		/* Create a bvh-tree of the given target */
 		/* printf("%s: building BVH, total=%d\n", __func__, numFaces); */
-		tree = BLI_bvhtree_new(looptri_num_active, epsilon, tree_type, axis);
+		tree = BLI_bvhtree_new_ex(looptri_num_active, epsilon, tree_type, axis, BVH_TREE_SIMD);
 		if (tree) {
 			if (em) {
 				const struct BMLoop *(*looptris)[3] = (void *)em->looptris;
@@ -1016,7 +1016,7 @@ static BVHTree *bvhtree_from_mesh_looptri_create_tree(
 
 		/* Create a bvh-tree of the given target */
 		/* printf("%s: building BVH, total=%d\n", __func__, numFaces); */
-		tree = BLI_bvhtree_new(looptri_num_active, epsilon, tree_type, axis);
+		tree = BLI_bvhtree_new_ex(looptri_num_active, epsilon, tree_type, axis, BVH_TREE_SIMD);
 		if (tree) {
 			if (vert && looptri) {
 				for (i = 0; i < looptri_num; i++) {
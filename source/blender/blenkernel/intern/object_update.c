@@ -186,6 +186,9 @@ void BKE_object_handle_data_update(EvaluationContext *eval_ctx,
 			if (em) {
 				makeDerivedMesh(scene, ob, em,  data_mask, false); /* was CD_MASK_BAREMESH */
 			}
+			else if (eval_ctx->mesh_share_cache) {
+				makeDerivedMesh_shared(eval_ctx->mesh_share_cache, scene, ob, data_mask);
+			}
 			else {
 				makeDerivedMesh(scene, ob, NULL, data_mask, false);
 			}
@@ -2066,9 +2066,26 @@ void psys_find_parents(ParticleSimulationData *sim, const bool use_render_params
 
 	BLI_kdtree_balance(tree);
 
-	for (; p < totchild; p++, cpa++) {
-		psys_particle_on_emitter(sim->psmd, from, cpa->num, DMCACHE_ISCHILD, cpa->fuv, cpa->foffset, co, 0, 0, 0, orco, 0);
-		cpa->parent = BLI_kdtree_find_nearest(tree, orco, NULL);
+	/* look up the parents of all remaining children at once, the tree queries run threaded */
+	if (p < totchild) {
+		const int totfind = totchild - p;
+		float (*find_orco)[3] = MEM_mallocN(sizeof(*find_orco) * (size_t)totfind, __func__);
+		int *find_parent = MEM_mallocN(sizeof(*find_parent) * (size_t)totfind, __func__);
+		ChildParticle *cpa_first = cpa;
+		int i;
+
+		for (i = 0; i < totfind; i++, cpa++) {
+			psys_particle_on_emitter(sim->psmd, from, cpa->num, DMCACHE_ISCHILD, cpa->fuv, cpa->foffset, co, 0, 0, 0, find_orco[i], 0);
+		}
+
+		BLI_kdtree_find_nearest_batch(tree, (const float (*)[3])find_orco, (unsigned int)totfind, find_parent, NULL);
+
+		for (i = 0, cpa = cpa_first; i < totfind; i++, cpa++) {
+			cpa->parent = find_parent[i];
+		}
+
+		MEM_freeN(find_orco);
+		MEM_freeN(find_parent);
 	}
 
 	BLI_kdtree_free(tree);
@@ -82,6 +82,14 @@ typedef struct BVHTreeRayHit {
 	float dist;         /* distance to the hit point */
 } BVHTreeRayHit;
 
+enum {
+	/* Build the hierarchy using the surface area heuristic,
+	 * slower to balance but faster to ray cast on uneven geometry (only for trees with x/y/z axes). */
+	BVH_TREE_SAH                = (1 << 0),
+	/* Store the bounds of each branch's children packed for 4-wide SIMD ray traversal (tree_type <= 4). */
+	BVH_TREE_SIMD               = (1 << 1),
+};
+
 enum {
 	/* calculate IsectRayPrecalc data */
 	BVH_RAYCAST_WATERTIGHT		= (1 << 0),
@@ -111,6 +119,7 @@ typedef bool (*BVHTree_WalkLeafCallback)(const BVHTreeAxisRange *bounds, int ind
 typedef bool (*BVHTree_WalkOrderCallback)(const BVHTreeAxisRange *bounds, char axis, void *userdata);
 
 
+BVHTree *BLI_bvhtree_new_ex(int maxsize, float epsilon, char tree_type, char axis, int flag);
 BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis);
 void BLI_bvhtree_free(BVHTree *tree);
 
@@ -155,6 +164,11 @@ void BLI_bvhtree_ray_cast_all(
         BVHTree *tree, const float co[3], const float dir[3], float radius, float hit_dist,
         BVHTree_RayCastCallback callback, void *userdata);
 
+void BLI_bvhtree_ray_cast_packet(
+        BVHTree *tree, const float (*co)[3], const float (*dir)[3], int rays_num, BVHTreeRayHit *hits,
+        BVHTree_RayCastCallback callback, void *userdata,
+        int flag);
+
 float BLI_bvhtree_bb_raycast(const float bv[6], const float light_start[3], const float light_end[3], float pos[3]);
 
 /* range query */
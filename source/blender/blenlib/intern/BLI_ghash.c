@@ -113,6 +113,10 @@ struct GHash {
 
 	unsigned int nentries;
 	unsigned int flag;
+
+	/* Open addressing storage, see #GHASH_FLAG_OPEN_ADDRESSING. */
+	char *slots;
+	unsigned int slot_size, slot_bit, slot_bit_min;
 };
 
 
@@ -378,6 +382,270 @@ BLI_INLINE void ghash_buckets_reset(GHash *gh, const unsigned int nentries)
 	ghash_buckets_expand(gh, nentries, (nentries != 0));
 }
 
+/* -------------------------------------------------------------------- */
+/* Open Addressing
+ *
+ * Tables created with the GHASH_FLAG_OPEN_ADDRESSING flag store their entries in the bucket array itself,
+ * using linear probing with backward shift deletion (so there are no tombstones).
+ * Each slot stores the full hash of its key, so most mismatches are rejected without calling the comparison
+ * function, and a lookup typically touches a single cache line instead of chasing a pointer per entry.
+ *
+ * Slots share the layout of #Entry and #GHashEntry (the hash takes the place of the 'next' pointer),
+ * so they can be handed out as entries to the iterator and the rest of the API.
+ *
+ * \note Entries move when the table is resized or when another entry is removed,
+ * so pointers returned by #BLI_ghash_lookup_p, #BLI_ghash_ensure_p & co. are only valid until the next
+ * insertion or removal.
+ */
+
+#define GHASH_OPEN_BIT_MIN 3
+#define GHASH_OPEN_BIT_MAX 30
+
+typedef struct GHashSlot {
+	uintptr_t hash;  /* Zero for empty slots. */
+
+	void *key;
+} GHashSlot;
+
+BLI_INLINE unsigned int ghash_open_keyhash(GHash *gh, const void *key)
+{
+	const unsigned int hash = gh->hashfp(key);
+	/* Zero is reserved for empty slots. */
+	return hash ? hash : 1u;
+}
+
+/**
+ * Get the ideal slot for a hash, using fibonacci hashing so weak hashes (like pointers) still spread evenly.
+ */
+BLI_INLINE unsigned int ghash_open_slot_index(GHash *gh, const unsigned int hash)
+{
+	return (hash * 2654435769u) >> (32 - gh->slot_bit);
+}
+
+BLI_INLINE GHashSlot *ghash_open_slot(GHash *gh, const unsigned int index)
+{
+	return (GHashSlot *)(gh->slots + (size_t)index * gh->slot_size);
+}
+
+static void ghash_open_resize(GHash *gh, const unsigned int slot_bit)
+{
+	char *slots_old = gh->slots;
+	const unsigned int nslots_old = gh->nbuckets;
+	unsigned int i;
+
+	gh->slot_bit = slot_bit;
+	gh->nbuckets = 1u << slot_bit;
+	gh->limit_grow   = GHASH_LIMIT_GROW(gh->nbuckets);
+	gh->limit_shrink = GHASH_LIMIT_SHRINK(gh->nbuckets);
+	gh->slots = MEM_callocN((size_t)gh->nbuckets * gh->slot_size, __func__);
+
+	if (slots_old) {
+		const unsigned int mask = gh->nbuckets - 1;
+
+		for (i = 0; i < nslots_old; i++) {
+			const GHashSlot *s_old = (const GHashSlot *)(slots_old + (size_t)i * gh->slot_size);
+			if (s_old->hash) {
+				unsigned int index = ghash_open_slot_index(gh, (unsigned int)s_old->hash);
+				while (ghash_open_slot(gh, index)->hash) {
+					index = (index + 1) & mask;
+				}
+				memcpy(ghash_open_slot(gh, index), s_old, gh->slot_size);
+			}
+		}
+		MEM_freeN(slots_old);
+	}
+}
+
+static void ghash_open_expand(GHash *gh, const unsigned int nentries, const bool user_defined)
+{
+	unsigned int slot_bit = gh->slot_bit;
+
+	if (LIKELY(gh->slots && (nentries <= gh->limit_grow))) {
+		return;
+	}
+
+	while ((nentries > GHASH_LIMIT_GROW(1u << slot_bit)) &&
+	       (slot_bit < GHASH_OPEN_BIT_MAX))
+	{
+		slot_bit++;
+	}
+
+	if (user_defined) {
+		gh->slot_bit_min = slot_bit;
+	}
+
+	if ((slot_bit == gh->slot_bit) && gh->slots) {
+		return;
+	}
+
+	ghash_open_resize(gh, slot_bit);
+}
+
+static void ghash_open_contract(
+        GHash *gh, const unsigned int nentries, const bool user_defined, const bool force_shrink)
+{
+	unsigned int slot_bit = gh->slot_bit;
+
+	if (!(force_shrink || (gh->flag & GHASH_FLAG_ALLOW_SHRINK))) {
+		return;
+	}
+
+	if (LIKELY(gh->slots && (nentries > gh->limit_shrink))) {
+		return;
+	}
+
+	while ((nentries < GHASH_LIMIT_SHRINK(1u << slot_bit)) &&
+	       (slot_bit > gh->slot_bit_min))
+	{
+		slot_bit--;
+	}
+
+	if (user_defined) {
+		gh->slot_bit_min = slot_bit;
+	}
+
+	if ((slot_bit == gh->slot_bit) && gh->slots) {
+		return;
+	}
+
+	ghash_open_resize(gh, slot_bit);
+}
+
+BLI_INLINE void ghash_open_reset(GHash *gh, const unsigned int nentries)
+{
+	MEM_SAFE_FREE(gh->slots);
+
+	gh->slot_bit = GHASH_OPEN_BIT_MIN;
+	gh->slot_bit_min = GHASH_OPEN_BIT_MIN;
+	gh->nbuckets = 1u << gh->slot_bit;
+	gh->limit_grow   = GHASH_LIMIT_GROW(gh->nbuckets);
+	gh->limit_shrink = GHASH_LIMIT_SHRINK(gh->nbuckets);
+
+	gh->nentries = 0;
+
+	ghash_open_expand(gh, nentries, (nentries != 0));
+}
+
+BLI_INLINE GHashSlot *ghash_open_lookup_slot(GHash *gh, const void *key, const unsigned int hash)
+{
+	const unsigned int mask = gh->nbuckets - 1;
+	unsigned int index = ghash_open_slot_index(gh, hash);
+	GHashSlot *s;
+
+	/* There is always at least one empty slot, since the table never gets full. */
+	while ((s = ghash_open_slot(gh, index))->hash) {
+		if (s->hash == hash && UNLIKELY(gh->cmpfp(key, s->key) == false)) {
+			return s;
+		}
+		index = (index + 1) & mask;
+	}
+
+	return NULL;
+}
+
+/**
+ * Add a slot for a key which is not in \a gh yet, the value is left for the caller to set.
+ */
+BLI_INLINE GHashSlot *ghash_open_insert_slot(GHash *gh, void *key, const unsigned int hash)
+{
+	unsigned int mask, index;
+	GHashSlot *s;
+
+	ghash_open_expand(gh, gh->nentries + 1, false);
+
+	mask = gh->nbuckets - 1;
+	index = ghash_open_slot_index(gh, hash);
+	while ((s = ghash_open_slot(gh, index))->hash) {
+		index = (index + 1) & mask;
+	}
+
+	s->hash = hash;
+	s->key = key;
+	gh->nentries++;
+
+	return s;
+}
+
+/**
+ * Remove the entry of given slot, caller is responsible for freeing the key and value.
+ */
+static void ghash_open_remove_slot(GHash *gh, GHashSlot *s)
+{
+	const unsigned int mask = gh->nbuckets - 1;
+	unsigned int index = (unsigned int)(((char *)s - gh->slots) / gh->slot_size);
+	unsigned int index_next = index;
+
+	/* Move the following entries of the probe sequence back into the hole, unless that would
+	 * place them before their ideal slot (i.e. their ideal slot is cyclically in (index, index_next]). */
+	while (true) {
+		GHashSlot *s_next;
+		unsigned int index_ideal;
+		bool is_in_range;
+
+		index_next = (index_next + 1) & mask;
+		s_next = ghash_open_slot(gh, index_next);
+		if (s_next->hash == 0) {
+			break;
+		}
+
+		index_ideal = ghash_open_slot_index(gh, (unsigned int)s_next->hash);
+		is_in_range = (index <= index_next) ?
+		              ((index < index_ideal) && (index_ideal <= index_next)) :
+		              ((index < index_ideal) || (index_ideal <= index_next));
+		if (!is_in_range) {
+			memcpy(ghash_open_slot(gh, index), s_next, gh->slot_size);
+			index = index_next;
+		}
+	}
+
+	ghash_open_slot(gh, index)->hash = 0;
+
+	ghash_open_contract(gh, --gh->nentries, false, false);
+}
+
+/**
+ * Remove a random entry, returning false if \a gh is empty.
+ */
+static bool ghash_open_pop(GHash *gh, GHashIterState *state, void **r_key, void **r_val)
+{
+	const unsigned int mask = gh->nbuckets - 1;
+	unsigned int index = state->curr_bucket;
+	GHashSlot *s;
+
+	if (gh->nentries == 0) {
+		return false;
+	}
+
+	if (index >= gh->nbuckets) {
+		index = 0;
+	}
+	while ((s = ghash_open_slot(gh, index))->hash == 0) {
+		index = (index + 1) & mask;
+	}
+
+	*r_key = s->key;
+	if (r_val) {
+		*r_val = ((GHashEntry *)s)->val;
+	}
+	ghash_open_remove_slot(gh, s);
+
+	state->curr_bucket = index;
+	return true;
+}
+
+/**
+ * Find the index of the next used slot, starting from \a index, or nbuckets when there is none.
+ */
+BLI_INLINE unsigned int ghash_open_find_next_slot_index(GHash *gh, unsigned int index)
+{
+	while ((index < gh->nbuckets) && (ghash_open_slot(gh, index)->hash == 0)) {
+		index++;
+	}
+	return index;
+}
+
+/* -------------------------------------------------------------------- */
+
 /**
  * Internal lookup function.
  * Takes hash and bucket_index arguments to avoid calling #ghash_keyhash and #ghash_bucket_index multiple times.
@@ -424,6 +692,10 @@ BLI_INLINE Entry *ghash_lookup_entry_prev_ex(
  */
 BLI_INLINE Entry *ghash_lookup_entry(GHash *gh, const void *key)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		return (Entry *)ghash_open_lookup_slot(gh, key, ghash_open_keyhash(gh, key));
+	}
+
 	const unsigned int hash = ghash_keyhash(gh, key);
 	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
 	return ghash_lookup_entry_ex(gh, key, bucket_index);
@@ -438,10 +710,18 @@ static GHash *ghash_new(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
 	gh->cmpfp = cmpfp;
 
 	gh->buckets = NULL;
+	gh->slots = NULL;
+	gh->slot_size = (unsigned int)GHASH_ENTRY_SIZE(flag & GHASH_FLAG_IS_GSET);
 	gh->flag = flag;
 
-	ghash_buckets_reset(gh, nentries_reserve);
-	gh->entrypool = BLI_mempool_create(GHASH_ENTRY_SIZE(flag & GHASH_FLAG_IS_GSET), 64, 64, BLI_MEMPOOL_NOP);
+	if (flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		ghash_open_reset(gh, nentries_reserve);
+		gh->entrypool = NULL;
+	}
+	else {
+		ghash_buckets_reset(gh, nentries_reserve);
+		gh->entrypool = BLI_mempool_create(GHASH_ENTRY_SIZE(flag & GHASH_FLAG_IS_GSET), 64, 64, BLI_MEMPOOL_NOP);
+	}
 
 	return gh;
 }
@@ -502,6 +782,14 @@ BLI_INLINE void ghash_insert_ex_keyonly(
 
 BLI_INLINE void ghash_insert(GHash *gh, void *key, void *val)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		BLI_assert((gh->flag & GHASH_FLAG_ALLOW_DUPES) || (BLI_ghash_haskey(gh, key) == 0));
+		BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
+		GHashEntry *e = (GHashEntry *)ghash_open_insert_slot(gh, key, ghash_open_keyhash(gh, key));
+		e->val = val;
+		return;
+	}
+
 	const unsigned int hash = ghash_keyhash(gh, key);
 	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
 
@@ -512,9 +800,12 @@ BLI_INLINE bool ghash_insert_safe(
         GHash *gh, void *key, void *val, const bool override,
         GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
 {
-	const unsigned int hash = ghash_keyhash(gh, key);
-	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
-	GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
+	const bool is_open = (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) != 0;
+	const unsigned int hash = is_open ? ghash_open_keyhash(gh, key) : ghash_keyhash(gh, key);
+	const unsigned int bucket_index = is_open ? 0 : ghash_bucket_index(gh, hash);
+	GHashEntry *e = is_open ?
+	        (GHashEntry *)ghash_open_lookup_slot(gh, key, hash) :
+	        (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
 
 	BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
 
@@ -531,6 +822,11 @@ BLI_INLINE bool ghash_insert_safe(
 		}
 		return false;
 	}
+	else if (is_open) {
+		e = (GHashEntry *)ghash_open_insert_slot(gh, key, hash);
+		e->val = val;
+		return true;
+	}
 	else {
 		ghash_insert_ex(gh, key, val, bucket_index);
 		return true;
@@ -541,9 +837,12 @@ BLI_INLINE bool ghash_insert_safe_keyonly(
         GHash *gh, void *key, const bool override,
         GHashKeyFreeFP keyfreefp)
 {
-	const unsigned int hash = ghash_keyhash(gh, key);
-	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
-	Entry *e = ghash_lookup_entry_ex(gh, key, bucket_index);
+	const bool is_open = (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) != 0;
+	const unsigned int hash = is_open ? ghash_open_keyhash(gh, key) : ghash_keyhash(gh, key);
+	const unsigned int bucket_index = is_open ? 0 : ghash_bucket_index(gh, hash);
+	Entry *e = is_open ?
+	        (Entry *)ghash_open_lookup_slot(gh, key, hash) :
+	        ghash_lookup_entry_ex(gh, key, bucket_index);
 
 	BLI_assert((gh->flag & GHASH_FLAG_IS_GSET) != 0);
 
@@ -556,6 +855,10 @@ BLI_INLINE bool ghash_insert_safe_keyonly(
 		}
 		return false;
 	}
+	else if (is_open) {
+		ghash_open_insert_slot(gh, key, hash);
+		return true;
+	}
 	else {
 		ghash_insert_ex_keyonly(gh, key, bucket_index);
 		return true;
@@ -631,6 +934,22 @@ static void ghash_free_cb(
 	BLI_assert(keyfreefp  || valfreefp);
 	BLI_assert(!valfreefp || !(gh->flag & GHASH_FLAG_IS_GSET));
 
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		for (i = 0; i < gh->nbuckets; i++) {
+			GHashSlot *s = ghash_open_slot(gh, i);
+
+			if (s->hash) {
+				if (keyfreefp) {
+					keyfreefp(s->key);
+				}
+				if (valfreefp) {
+					valfreefp(((GHashEntry *)s)->val);
+				}
+			}
+		}
+		return;
+	}
+
 	for (i = 0; i < gh->nbuckets; i++) {
 		Entry *e;
 
@@ -658,6 +977,28 @@ static GHash *ghash_copy(GHash *gh, GHashKeyCopyFP keycopyfp, GHashValCopyFP val
 	BLI_assert(!valcopyfp || !(gh->flag & GHASH_FLAG_IS_GSET));
 
 	gh_new = ghash_new(gh->hashfp, gh->cmpfp, __func__, 0, gh->flag);
+
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		/* Same number of slots, so all entries can stay at the same place. */
+		if (gh_new->slot_bit != gh->slot_bit) {
+			ghash_open_resize(gh_new, gh->slot_bit);
+		}
+		gh_new->slot_bit_min = gh->slot_bit_min;
+		memcpy(gh_new->slots, gh->slots, (size_t)gh->nbuckets * gh->slot_size);
+
+		if (keycopyfp || valcopyfp) {
+			for (i = 0; i < gh->nbuckets; i++) {
+				GHashSlot *s = ghash_open_slot(gh, i);
+				if (s->hash) {
+					ghash_entry_copy(gh_new, (Entry *)ghash_open_slot(gh_new, i), gh, (Entry *)s, keycopyfp, valcopyfp);
+				}
+			}
+		}
+		gh_new->nentries = gh->nentries;
+
+		return gh_new;
+	}
+
 	ghash_buckets_expand(gh_new, reserve_nentries_new, false);
 
 	BLI_assert(gh_new->nbuckets == gh->nbuckets);
@@ -713,6 +1054,20 @@ GHash *BLI_ghash_new(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info)
 	return BLI_ghash_new_ex(hashfp, cmpfp, info, 0);
 }
 
+/**
+ * Same as #BLI_ghash_new_ex, but entries are stored directly in the buckets array (open addressing),
+ * saving the memory of the entries pool and a cache miss for each visited entry.
+ * Best suited to pointer-sized keys with cheap hash functions, used mostly for lookups.
+ *
+ * \warning Entries are moved when the table is modified, pointers returned by #BLI_ghash_lookup_p,
+ * #BLI_ghash_ensure_p & co. are only valid until the next insertion or removal.
+ */
+GHash *BLI_ghash_new_open_ex(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+                             const unsigned int nentries_reserve)
+{
+	return ghash_new(hashfp, cmpfp, info, nentries_reserve, GHASH_FLAG_OPEN_ADDRESSING);
+}
+
 /**
  * Copy given GHash. Keys and values are also copied if relevant callback is provided, else pointers remain the same.
  */
@@ -726,6 +1081,12 @@ GHash *BLI_ghash_copy(GHash *gh, GHashKeyCopyFP keycopyfp, GHashValCopyFP valcop
  */
 void BLI_ghash_reserve(GHash *gh, const unsigned int nentries_reserve)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		ghash_open_expand(gh, nentries_reserve, true);
+		ghash_open_contract(gh, nentries_reserve, true, false);
+		return;
+	}
+
 	ghash_buckets_expand(gh, nentries_reserve, true);
 	ghash_buckets_contract(gh, nentries_reserve, true, false);
 }
@@ -821,6 +1182,19 @@ void **BLI_ghash_lookup_p(GHash *gh, const void *key)
  */
 bool BLI_ghash_ensure_p(GHash *gh, void *key, void ***r_val)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		const unsigned int hash = ghash_open_keyhash(gh, key);
+		GHashEntry *e = (GHashEntry *)ghash_open_lookup_slot(gh, key, hash);
+		const bool haskey = (e != NULL);
+
+		if (!haskey) {
+			e = (GHashEntry *)ghash_open_insert_slot(gh, key, hash);
+		}
+
+		*r_val = &e->val;
+		return haskey;
+	}
+
 	const unsigned int hash = ghash_keyhash(gh, key);
 	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
 	GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
@@ -844,6 +1218,20 @@ bool BLI_ghash_ensure_p(GHash *gh, void *key, void ***r_val)
 bool BLI_ghash_ensure_p_ex(
         GHash *gh, const void *key, void ***r_key, void ***r_val)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		const unsigned int hash = ghash_open_keyhash(gh, key);
+		GHashEntry *e = (GHashEntry *)ghash_open_lookup_slot(gh, key, hash);
+		const bool haskey = (e != NULL);
+
+		if (!haskey) {
+			e = (GHashEntry *)ghash_open_insert_slot(gh, NULL, hash);  /* caller must re-assign */
+		}
+
+		*r_key = &e->e.key;
+		*r_val = &e->val;
+		return haskey;
+	}
+
 	const unsigned int hash = ghash_keyhash(gh, key);
 	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
 	GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
@@ -871,6 +1259,24 @@ bool BLI_ghash_ensure_p_ex(
  */
 bool BLI_ghash_remove(GHash *gh, const void *key, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		GHashSlot *s = ghash_open_lookup_slot(gh, key, ghash_open_keyhash(gh, key));
+
+		BLI_assert(!valfreefp || !(gh->flag & GHASH_FLAG_IS_GSET));
+
+		if (s == NULL) {
+			return false;
+		}
+		if (keyfreefp) {
+			keyfreefp(s->key);
+		}
+		if (valfreefp) {
+			valfreefp(((GHashEntry *)s)->val);
+		}
+		ghash_open_remove_slot(gh, s);
+		return true;
+	}
+
 	const unsigned int hash = ghash_keyhash(gh, key);
 	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
 	Entry *e = ghash_remove_ex(gh, key, keyfreefp, valfreefp, bucket_index);
@@ -894,6 +1300,23 @@ bool BLI_ghash_remove(GHash *gh, const void *key, GHashKeyFreeFP keyfreefp, GHas
  */
 void *BLI_ghash_popkey(GHash *gh, const void *key, GHashKeyFreeFP keyfreefp)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		GHashEntry *e = (GHashEntry *)ghash_open_lookup_slot(gh, key, ghash_open_keyhash(gh, key));
+		void *val;
+
+		BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
+
+		if (e == NULL) {
+			return NULL;
+		}
+		if (keyfreefp) {
+			keyfreefp(e->e.key);
+		}
+		val = e->val;
+		ghash_open_remove_slot(gh, (GHashSlot *)e);
+		return val;
+	}
+
 	const unsigned int hash = ghash_keyhash(gh, key);
 	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
 	GHashEntry *e = (GHashEntry *)ghash_remove_ex(gh, key, keyfreefp, NULL, bucket_index);
@@ -928,6 +1351,16 @@ bool BLI_ghash_pop(
         GHash *gh, GHashIterState *state,
         void **r_key, void **r_val)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
+
+		if (ghash_open_pop(gh, state, r_key, r_val)) {
+			return true;
+		}
+		*r_key = *r_val = NULL;
+		return false;
+	}
+
 	GHashEntry *e = (GHashEntry *)ghash_pop(gh, state);
 
 	BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
@@ -958,6 +1391,11 @@ void BLI_ghash_clear_ex(GHash *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valf
 	if (keyfreefp || valfreefp)
 		ghash_free_cb(gh, keyfreefp, valfreefp);
 
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		ghash_open_reset(gh, nentries_reserve);
+		return;
+	}
+
 	ghash_buckets_reset(gh, nentries_reserve);
 	BLI_mempool_clear_ex(gh->entrypool, nentries_reserve ? (int)nentries_reserve : -1);
 }
@@ -979,12 +1417,17 @@ void BLI_ghash_clear(GHash *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfree
  */
 void BLI_ghash_free(GHash *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
 {
-	BLI_assert((int)gh->nentries == BLI_mempool_count(gh->entrypool));
+	BLI_assert(!gh->entrypool || (int)gh->nentries == BLI_mempool_count(gh->entrypool));
 	if (keyfreefp || valfreefp)
 		ghash_free_cb(gh, keyfreefp, valfreefp);
 
-	MEM_freeN(gh->buckets);
-	BLI_mempool_destroy(gh->entrypool);
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		MEM_freeN(gh->slots);
+	}
+	else {
+		MEM_freeN(gh->buckets);
+		BLI_mempool_destroy(gh->entrypool);
+	}
 	MEM_freeN(gh);
 }
 
@@ -1040,6 +1483,13 @@ void BLI_ghashIterator_init(GHashIterator *ghi, GHash *gh)
 {
 	ghi->gh = gh;
 	ghi->curEntry = NULL;
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		ghi->curBucket = ghash_open_find_next_slot_index(gh, 0);
+		if (ghi->curBucket < gh->nbuckets) {
+			ghi->curEntry = (Entry *)ghash_open_slot(gh, ghi->curBucket);
+		}
+		return;
+	}
 	ghi->curBucket = UINT_MAX;  /* wraps to zero */
 	if (gh->nentries) {
 		do {
@@ -1058,6 +1508,14 @@ void BLI_ghashIterator_init(GHashIterator *ghi, GHash *gh)
  */
 void BLI_ghashIterator_step(GHashIterator *ghi)
 {
+	if (ghi->gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		if (ghi->curEntry) {
+			ghi->curBucket = ghash_open_find_next_slot_index(ghi->gh, ghi->curBucket + 1);
+			ghi->curEntry = (ghi->curBucket < ghi->gh->nbuckets) ?
+			                (Entry *)ghash_open_slot(ghi->gh, ghi->curBucket) : NULL;
+		}
+		return;
+	}
 	if (ghi->curEntry) {
 		ghi->curEntry = ghi->curEntry->next;
 		while (!ghi->curEntry) {
@@ -1364,6 +1822,16 @@ GSet *BLI_gset_new(GSetHashFP hashfp, GSetCmpFP cmpfp, const char *info)
 	return BLI_gset_new_ex(hashfp, cmpfp, info, 0);
 }
 
+/**
+ * GSet version of #BLI_ghash_new_open_ex.
+ */
+GSet *BLI_gset_new_open_ex(GSetHashFP hashfp, GSetCmpFP cmpfp, const char *info,
+                           const unsigned int nentries_reserve)
+{
+	return (GSet *)ghash_new(hashfp, cmpfp, info, nentries_reserve,
+	                         GHASH_FLAG_IS_GSET | GHASH_FLAG_OPEN_ADDRESSING);
+}
+
 /**
  * Copy given GSet. Keys are also copied if callback is provided, else pointers remain the same.
  */
@@ -1383,6 +1851,12 @@ unsigned int BLI_gset_size(GSet *gs)
  */
 void BLI_gset_insert(GSet *gs, void *key)
 {
+	if (((GHash *)gs)->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		BLI_assert((((GHash *)gs)->flag & GHASH_FLAG_ALLOW_DUPES) || (BLI_gset_haskey(gs, key) == 0));
+		ghash_open_insert_slot((GHash *)gs, key, ghash_open_keyhash((GHash *)gs, key));
+		return;
+	}
+
 	const unsigned int hash = ghash_keyhash((GHash *)gs, key);
 	const unsigned int bucket_index = ghash_bucket_index((GHash *)gs, hash);
 	ghash_insert_ex_keyonly((GHash *)gs, key, bucket_index);
@@ -1407,6 +1881,19 @@ bool BLI_gset_add(GSet *gs, void *key)
  */
 bool BLI_gset_ensure_p_ex(GSet *gs, const void *key, void ***r_key)
 {
+	if (((GHash *)gs)->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		const unsigned int hash = ghash_open_keyhash((GHash *)gs, key);
+		GHashSlot *s = ghash_open_lookup_slot((GHash *)gs, key, hash);
+		const bool haskey = (s != NULL);
+
+		if (!haskey) {
+			s = ghash_open_insert_slot((GHash *)gs, NULL, hash);  /* caller must re-assign */
+		}
+
+		*r_key = &s->key;
+		return haskey;
+	}
+
 	const unsigned int hash = ghash_keyhash((GHash *)gs, key);
 	const unsigned int bucket_index = ghash_bucket_index((GHash *)gs, hash);
 	GSetEntry *e = (GSetEntry *)ghash_lookup_entry_ex((GHash *)gs, key, bucket_index);
@@ -1456,6 +1943,14 @@ bool BLI_gset_pop(
         GSet *gs, GSetIterState *state,
         void **r_key)
 {
+	if (((GHash *)gs)->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		if (ghash_open_pop((GHash *)gs, (GHashIterState *)state, r_key, NULL)) {
+			return true;
+		}
+		*r_key = NULL;
+		return false;
+	}
+
 	GSetEntry *e = (GSetEntry *)ghash_pop((GHash *)gs, (GHashIterState *)state);
 
 	if (e) {
@@ -1583,6 +2078,49 @@ double BLI_ghash_calc_quality_ex(
 		return 0.0;
 	}
 
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		/* Use the probe length of each entry as its 'bucket' size, 1.0 meaning every entry is in its ideal slot. */
+		const unsigned int mask = gh->nbuckets - 1;
+		uint64_t sum = 0, sum_sq = 0, sum_overloaded = 0;
+		double mean_probe;
+
+		if (r_biggest_bucket) {
+			*r_biggest_bucket = 0;
+		}
+		for (i = 0; i < gh->nbuckets; i++) {
+			const GHashSlot *s = ghash_open_slot(gh, i);
+			uint64_t probe;
+
+			if (s->hash == 0) {
+				continue;
+			}
+			probe = (uint64_t)((i - ghash_open_slot_index(gh, (unsigned int)s->hash)) & mask) + 1;
+			sum += probe;
+			sum_sq += probe * probe;
+			if (probe > 1) {
+				sum_overloaded++;
+			}
+			if (r_biggest_bucket) {
+				*r_biggest_bucket = max_ii(*r_biggest_bucket, (int)probe);
+			}
+		}
+
+		mean_probe = (double)sum / (double)gh->nentries;
+		if (r_load) {
+			*r_load = (double)gh->nentries / (double)gh->nbuckets;
+		}
+		if (r_variance) {
+			*r_variance = (double)sum_sq / (double)gh->nentries - mean_probe * mean_probe;
+		}
+		if (r_prop_empty_buckets) {
+			*r_prop_empty_buckets = (double)(gh->nbuckets - gh->nentries) / (double)gh->nbuckets;
+		}
+		if (r_prop_overloaded_buckets) {
+			*r_prop_overloaded_buckets = (double)sum_overloaded / (double)gh->nbuckets;
+		}
+		return mean_probe;
+	}
+
 	mean = (double)gh->nentries / (double)gh->nbuckets;
 	if (r_load) {
 		*r_load = mean;
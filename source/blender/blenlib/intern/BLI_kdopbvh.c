@@ -44,6 +44,9 @@
  *   #BLI_bvhtree_overlap, #BVHOverlapData_Shared, #BVHOverlapData_Thread
  * - Range Query:
  *   #BLI_bvhtree_range_query
+ *
+ * Trees can optionally be built with a surface area heuristic (#BVH_TREE_SAH),
+ * and store their children bounds packed for SIMD ray traversal (#BVH_TREE_SIMD).
  */
 
 #include <assert.h>
@@ -57,6 +60,12 @@
 #include "BLI_math.h"
 #include "BLI_task.h"
 
+#include "atomic_ops.h"
+
+#ifdef __SSE2__
+#  include <xmmintrin.h>
+#endif
+
 #include "BLI_strict_flags.h"
 
 /* used for iterative_raycast */
@@ -106,17 +115,19 @@ struct BVHTree {
 	BVHNode *nodearray;     /* pre-alloc branch nodes */
 	BVHNode **nodechild;    /* pre-alloc childs for nodes */
 	float   *nodebv;        /* pre-alloc bounding-volumes for nodes */
+	float (*nodebv4)[6][4]; /* x/y/z bounds of the children of each branch, packed for SIMD (BVH_TREE_SIMD only) */
 	float epsilon;          /* epslion is used for inflation of the k-dop	   */
 	int totleaf;            /* leafs */
 	int totbranch;
 	axis_t start_axis, stop_axis;  /* bvhtree_kdop_axes array indices according to axis */
 	axis_t axis;                   /* kdop type (6 => OBB, 7 => AABB, ...) */
 	char tree_type;                /* type of tree (4 => quadtree) */
+	char flag;                     /* BVH_TREE_SAH, BVH_TREE_SIMD */
 };
 
 /* optimization, ensure we stay small */
-BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 48) ||
-                  (sizeof(void *) == 4 && sizeof(BVHTree) <= 32),
+BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 64) ||
+                  (sizeof(void *) == 4 && sizeof(BVHTree) <= 40),
                   "over sized")
 
 /* avoid duplicating vars in BVHOverlapData_Thread */
@@ -939,6 +950,325 @@ static void non_recursive_bvh_div_nodes(
 /** \} */
 
 
+/* -------------------------------------------------------------------- */
+
+/** \name SAH Build
+ *
+ * Alternative to the implicit tree build, used for #BVH_TREE_SAH:
+ * leafs of each branch are split with a binned surface area heuristic until the branch has tree_type children.
+ * The result is not balanced anymore, but its branches are much tighter on uneven geometry.
+ *
+ * Branches are allocated in pre-order, so all children still have a greater index than their parent
+ * (which #BLI_bvhtree_update_tree relies on).
+ * \{ */
+
+#define BVH_SAH_BINS 16
+
+/* Sub-trees with more leafs than this are built in their own task. */
+#ifdef DEBUG
+#  define BVH_SAH_THREAD_LEAF_THRESHOLD 64
+#else
+#  define BVH_SAH_THREAD_LEAF_THRESHOLD 4096
+#endif
+
+typedef struct BVHSAHBuildData {
+	const BVHTree *tree;
+	BVHNode *branches_array;
+	BVHNode **leafs_array;
+	unsigned int branches_num;  /* allocated branches, atomic */
+	TaskPool *pool;
+} BVHSAHBuildData;
+
+typedef struct BVHSAHBuildTask {
+	BVHNode *node;
+	int begin, end;
+} BVHSAHBuildTask;
+
+typedef struct BVHSAHBin {
+	float min[3], max[3];
+	int count;
+} BVHSAHBin;
+
+/* Twice the centroid of the leaf along given x/y/z axis, only used for comparisons. */
+BLI_INLINE float bvh_sah_centroid(const BVHNode *node, const int axis)
+{
+	return node->bv[2 * axis] + node->bv[2 * axis + 1];
+}
+
+/* Half of the surface area of given bounds. */
+BLI_INLINE float bvh_sah_half_area(const float min[3], const float max[3])
+{
+	const float d[3] = {max[0] - min[0], max[1] - min[1], max[2] - min[2]};
+	return d[0] * d[1] + d[1] * d[2] + d[2] * d[0];
+}
+
+BLI_INLINE int bvh_sah_bin_index(const BVHNode *node, const int axis, const float cmin, const float scale)
+{
+	const int bin = (int)((bvh_sah_centroid(node, axis) - cmin) * scale);
+	return min_ii(bin, BVH_SAH_BINS - 1);
+}
+
+/**
+ * Split leafs of the range [begin, end) in two with the lowest cost according to the surface area heuristic.
+ *
+ * \return the first leaf of the second half.
+ */
+static int bvh_sah_split(BVHNode **leafs_array, const int begin, const int end, int *r_axis)
+{
+	BVHSAHBin bins[BVH_SAH_BINS];
+	float cost_right[BVH_SAH_BINS];
+	float cmin[3], cmax[3], min[3], max[3];
+	float scale, cost_best = FLT_MAX;
+	int count, split_best = -1;
+	int axis, i, j;
+
+	INIT_MINMAX(cmin, cmax);
+	for (i = begin; i < end; i++) {
+		for (axis = 0; axis < 3; axis++) {
+			const float c = bvh_sah_centroid(leafs_array[i], axis);
+			cmin[axis] = min_ff(cmin[axis], c);
+			cmax[axis] = max_ff(cmax[axis], c);
+		}
+	}
+
+	axis = (cmax[0] - cmin[0] > cmax[1] - cmin[1]) ? 0 : 1;
+	if (cmax[2] - cmin[2] > cmax[axis] - cmin[axis]) {
+		axis = 2;
+	}
+	*r_axis = axis;
+
+	if (!(cmax[axis] - cmin[axis] > 0.0f)) {
+		/* All centroids are the same, any split is as good as another. */
+		return (begin + end) / 2;
+	}
+
+	/* Bin the leafs along the axis. */
+	scale = (float)BVH_SAH_BINS / (cmax[axis] - cmin[axis]);
+	for (j = 0; j < BVH_SAH_BINS; j++) {
+		INIT_MINMAX(bins[j].min, bins[j].max);
+		bins[j].count = 0;
+	}
+	for (i = begin; i < end; i++) {
+		const BVHNode *node = leafs_array[i];
+		BVHSAHBin *bin = &bins[bvh_sah_bin_index(node, axis, cmin[axis], scale)];
+		const float bv_min[3] = {node->bv[0], node->bv[2], node->bv[4]};
+		const float bv_max[3] = {node->bv[1], node->bv[3], node->bv[5]};
+
+		minmax_v3v3_v3(bin->min, bin->max, bv_min);
+		minmax_v3v3_v3(bin->min, bin->max, bv_max);
+		bin->count++;
+	}
+
+	/* Sweep from the right, then from the left to find the cheapest split between two bins. */
+	INIT_MINMAX(min, max);
+	count = 0;
+	for (j = BVH_SAH_BINS - 1; j > 0; j--) {
+		if (bins[j].count) {
+			minmax_v3v3_v3(min, max, bins[j].min);
+			minmax_v3v3_v3(min, max, bins[j].max);
+			count += bins[j].count;
+		}
+		cost_right[j] = count ? bvh_sah_half_area(min, max) * (float)count : 0.0f;
+	}
+
+	INIT_MINMAX(min, max);
+	count = 0;
+	for (j = 1; j < BVH_SAH_BINS; j++) {
+		if (bins[j - 1].count) {
+			minmax_v3v3_v3(min, max, bins[j - 1].min);
+			minmax_v3v3_v3(min, max, bins[j - 1].max);
+			count += bins[j - 1].count;
+		}
+		if (count && (count != end - begin)) {
+			const float cost = bvh_sah_half_area(min, max) * (float)count + cost_right[j];
+			if (cost < cost_best) {
+				cost_best = cost;
+				split_best = j;
+			}
+		}
+	}
+
+	if (split_best == -1) {
+		/* Every centroid is in the same bin, fall back to a median split. */
+		const int mid = (begin + end) / 2;
+		partition_nth_element(leafs_array, begin, end, mid, 2 * axis + 1);
+		return mid;
+	}
+
+	/* Partition the leafs in place. */
+	i = begin;
+	j = end - 1;
+	while (i <= j) {
+		if (bvh_sah_bin_index(leafs_array[i], axis, cmin[axis], scale) < split_best) {
+			i++;
+		}
+		else {
+			SWAP(BVHNode *, leafs_array[i], leafs_array[j]);
+			j--;
+		}
+	}
+	return i;
+}
+
+static void bvh_sah_build_task_cb(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid));
+
+static void bvh_sah_build_node(BVHSAHBuildData *data, BVHNode *node, const int begin, const int end)
+{
+	const BVHTree *tree = data->tree;
+	int ranges[MAX_TREETYPE][2];
+	int ranges_num = 1;
+	int k;
+
+	BLI_assert(end - begin > 1);
+
+	refit_kdop_hull(tree, node, begin, end);
+
+	/* Split the biggest range until there is one for each child. */
+	ranges[0][0] = begin;
+	ranges[0][1] = end;
+	while (ranges_num < tree->tree_type) {
+		int r_split = -1, r, split, axis;
+
+		for (r = 0; r < ranges_num; r++) {
+			const int len = ranges[r][1] - ranges[r][0];
+			if ((len > 1) && ((r_split == -1) || (len > ranges[r_split][1] - ranges[r_split][0]))) {
+				r_split = r;
+			}
+		}
+		if (r_split == -1) {
+			break;
+		}
+
+		split = bvh_sah_split(data->leafs_array, ranges[r_split][0], ranges[r_split][1], &axis);
+		if (ranges_num == 1) {
+			node->main_axis = (char)axis;
+		}
+
+		/* Insert the second half right after the first one, keeping the children ordered. */
+		memmove(ranges[r_split + 2], ranges[r_split + 1], sizeof(*ranges) * (size_t)(ranges_num - r_split - 1));
+		ranges[r_split + 1][0] = split;
+		ranges[r_split + 1][1] = ranges[r_split][1];
+		ranges[r_split][1] = split;
+		ranges_num++;
+	}
+
+	node->totnode = (char)ranges_num;
+	for (k = 0; k < ranges_num; k++) {
+		BVHNode *child;
+
+		if (ranges[k][1] - ranges[k][0] == 1) {
+			child = data->leafs_array[ranges[k][0]];
+		}
+		else {
+			child = &data->branches_array[atomic_fetch_and_add_u(&data->branches_num, 1)];
+		}
+		child->parent = node;
+		node->children[k] = child;
+	}
+
+	for (k = 0; k < ranges_num; k++) {
+		const int len = ranges[k][1] - ranges[k][0];
+
+		if (len == 1) {
+			continue;
+		}
+		if (data->pool && (len > BVH_SAH_THREAD_LEAF_THRESHOLD)) {
+			BVHSAHBuildTask *task = MEM_mallocN(sizeof(*task), __func__);
+			task->node = node->children[k];
+			task->begin = ranges[k][0];
+			task->end = ranges[k][1];
+			BLI_task_pool_push(data->pool, bvh_sah_build_task_cb, task, true, TASK_PRIORITY_HIGH);
+		}
+		else {
+			bvh_sah_build_node(data, node->children[k], ranges[k][0], ranges[k][1]);
+		}
+	}
+}
+
+static void bvh_sah_build_task_cb(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	BVHSAHBuildData *data = BLI_task_pool_userdata(pool);
+	BVHSAHBuildTask *task = taskdata;
+
+	bvh_sah_build_node(data, task->node, task->begin, task->end);
+}
+
+/**
+ * Build a SAH tree from the given leafs (at least two) on branches_array.
+ *
+ * \return the number of branches used.
+ */
+static int bvh_sah_div_nodes(
+        const BVHTree *tree, BVHNode *branches_array, BVHNode **leafs_array, int num_leafs)
+{
+	BVHSAHBuildData data = {
+		.tree = tree, .branches_array = branches_array, .leafs_array = leafs_array,
+		.branches_num = 1, .pool = NULL,
+	};
+	BVHNode *root = &branches_array[0];
+
+	root->parent = NULL;
+
+	if (num_leafs > BVH_SAH_THREAD_LEAF_THRESHOLD) {
+		data.pool = BLI_task_pool_create(BLI_task_scheduler_get(), &data);
+	}
+
+	bvh_sah_build_node(&data, root, 0, num_leafs);
+
+	if (data.pool) {
+		BLI_task_pool_work_and_wait(data.pool);
+		BLI_task_pool_free(data.pool);
+	}
+
+	return (int)data.branches_num;
+}
+
+/** \} */
+
+
+/* -------------------------------------------------------------------- */
+
+/** \name SIMD Bounds
+ *
+ * With #BVH_TREE_SIMD, the x/y/z bounds of the (up to 4) children of each branch are also stored
+ * as structure of arrays, so a ray can be tested against all of them at once.
+ * Unused lanes get inverted bounds, which no ray can hit.
+ * \{ */
+
+BLI_INLINE int bvhtree_branch_index(const BVHTree *tree, const BVHNode *node)
+{
+	return (int)(node - tree->nodearray) - tree->totleaf;
+}
+
+static void bvhtree_simd_bounds_update(BVHTree *tree)
+{
+	int i, j, k;
+
+	for (i = 0; i < tree->totbranch; i++) {
+		const BVHNode *node = tree->nodes[tree->totleaf + i];
+		float (*bv4)[4] = tree->nodebv4[bvhtree_branch_index(tree, node)];
+
+		BLI_assert(node->totnode <= 4);
+
+		for (k = 0; k < 4; k++) {
+			if (k < node->totnode) {
+				for (j = 0; j < 6; j++) {
+					bv4[j][k] = node->children[k]->bv[j];
+				}
+			}
+			else {
+				for (j = 0; j < 6; j += 2) {
+					bv4[j][k] = FLT_MAX;
+					bv4[j + 1][k] = -FLT_MAX;
+				}
+			}
+		}
+	}
+}
+
+/** \} */
+
+
 /* -------------------------------------------------------------------- */
 
 /** \name BLI_bvhtree API
@@ -946,11 +1276,13 @@ static void non_recursive_bvh_div_nodes(
 
 /**
  * \note many callers don't check for ``NULL`` return.
+ *
+ * \param flag: #BVH_TREE_SAH, #BVH_TREE_SIMD, ignored when not supported by the tree type or axis.
  */
-BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis)
+BVHTree *BLI_bvhtree_new_ex(int maxsize, float epsilon, char tree_type, char axis, int flag)
 {
 	BVHTree *tree;
-	int numnodes, i;
+	int numnodes, numbranches, i;
 
 	BLI_assert(tree_type >= 2 && tree_type <= MAX_TREETYPE);
 
@@ -993,19 +1325,33 @@ BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis)
 			goto fail;
 		}
 
+		/* Both need the x/y/z axes. */
+		if (tree->start_axis != 0) {
+			flag &= ~(BVH_TREE_SAH | BVH_TREE_SIMD);
+		}
+		if (tree_type > 4) {
+			flag &= ~BVH_TREE_SIMD;
+		}
+		tree->flag = (char)flag;
 
 		/* Allocate arrays */
-		numnodes = maxsize + implicit_needed_branches(tree_type, maxsize) + tree_type;
+		/* SAH trees are not balanced, in the worst case every branch only has two children. */
+		numbranches = (flag & BVH_TREE_SAH) ? max_ii(1, maxsize - 1) : implicit_needed_branches(tree_type, maxsize);
+		numnodes = maxsize + numbranches + tree_type;
 
 		tree->nodes = MEM_callocN(sizeof(BVHNode *) * (size_t)numnodes, "BVHNodes");
 		tree->nodebv = MEM_callocN(sizeof(float) * (size_t)(axis * numnodes), "BVHNodeBV");
 		tree->nodechild = MEM_callocN(sizeof(BVHNode *) * (size_t)(tree_type * numnodes), "BVHNodeBV");
 		tree->nodearray = MEM_callocN(sizeof(BVHNode) * (size_t)numnodes, "BVHNodeArray");
+		if (flag & BVH_TREE_SIMD) {
+			tree->nodebv4 = MEM_mallocN(sizeof(*tree->nodebv4) * (size_t)numbranches, "BVHNodeBV4");
+		}
 		
 		if (UNLIKELY((!tree->nodes) ||
 		             (!tree->nodebv) ||
 		             (!tree->nodechild) ||
-		             (!tree->nodearray)))
+		             (!tree->nodearray) ||
+		             ((flag & BVH_TREE_SIMD) && !tree->nodebv4)))
 		{
 			goto fail;
 		}
@@ -1025,12 +1371,18 @@ fail:
 	MEM_SAFE_FREE(tree->nodebv);
 	MEM_SAFE_FREE(tree->nodechild);
 	MEM_SAFE_FREE(tree->nodearray);
+	MEM_SAFE_FREE(tree->nodebv4);
 
 	MEM_freeN(tree);
 
 	return NULL;
 }
 
+BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis)
+{
+	return BLI_bvhtree_new_ex(maxsize, epsilon, tree_type, axis, 0);
+}
+
 void BLI_bvhtree_free(BVHTree *tree)
 {
 	if (tree) {
@@ -1038,6 +1390,7 @@ void BLI_bvhtree_free(BVHTree *tree)
 		MEM_freeN(tree->nodearray);
 		MEM_freeN(tree->nodebv);
 		MEM_freeN(tree->nodechild);
+		MEM_SAFE_FREE(tree->nodebv4);
 		MEM_freeN(tree);
 	}
 }
@@ -1053,15 +1406,24 @@ void BLI_bvhtree_balance(BVHTree *tree)
 	 * (some big bug goes here if its being called more than once per tree) */
 	BLI_assert(tree->totbranch == 0);
 
-	/* Build the implicit tree */
-	non_recursive_bvh_div_nodes(tree, branches_array, leafs_array, tree->totleaf);
+	if ((tree->flag & BVH_TREE_SAH) && (tree->totleaf > 1)) {
+		tree->totbranch = bvh_sah_div_nodes(tree, branches_array, leafs_array, tree->totleaf);
+	}
+	else {
+		/* Build the implicit tree */
+		non_recursive_bvh_div_nodes(tree, branches_array, leafs_array, tree->totleaf);
+		tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
+	}
 
 	/* current code expects the branches to be linked to the nodes array
 	 * we perform that linkage here */
-	tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
 	for (i = 0; i < tree->totbranch; i++)
 		tree->nodes[tree->totleaf + i] = branches_array + i;
 
+	if (tree->nodebv4) {
+		bvhtree_simd_bounds_update(tree);
+	}
+
 #ifdef USE_SKIP_LINKS
 	build_skip_links(tree, tree->nodes[tree->totleaf], NULL, NULL);
 #endif
@@ -1136,6 +1498,10 @@ void BLI_bvhtree_update_tree(BVHTree *tree)
 
 	for (; index >= root; index--)
 		node_join(tree, *index);
+
+	if (tree->nodebv4) {
+		bvhtree_simd_bounds_update(tree);
+	}
 }
 /**
  * Number of times #BLI_bvhtree_insert has been called.
@@ -1733,6 +2099,118 @@ static void dfs_raycast_all(BVHRayCastData *data, BVHNode *node)
 	}
 }
 
+#ifdef __SSE2__
+/**
+ * Same as #fast_ray_nearest_hit for the (up to 4) children of a branch at once, see #BVH_TREE_SIMD.
+ *
+ * \return a bit-mask of the children which can hold a closer hit, their distances are written in \a r_dist.
+ */
+BLI_INLINE int fast_ray_nearest_hit_simd(const BVHRayCastData *data, const float (*bv4)[4], float r_dist[4])
+{
+	const __m128 ox = _mm_set1_ps(data->ray.origin[0]);
+	const __m128 oy = _mm_set1_ps(data->ray.origin[1]);
+	const __m128 oz = _mm_set1_ps(data->ray.origin[2]);
+	const __m128 idx = _mm_set1_ps(data->idot_axis[0]);
+	const __m128 idy = _mm_set1_ps(data->idot_axis[1]);
+	const __m128 idz = _mm_set1_ps(data->idot_axis[2]);
+
+	const __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bv4[data->index[0]]), ox), idx);
+	const __m128 t2x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bv4[data->index[1]]), ox), idx);
+	const __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bv4[data->index[2]]), oy), idy);
+	const __m128 t2y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bv4[data->index[3]]), oy), idy);
+	const __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bv4[data->index[4]]), oz), idz);
+	const __m128 t2z = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bv4[data->index[5]]), oz), idz);
+
+	const __m128 tnear = _mm_max_ps(t1x, _mm_max_ps(t1y, t1z));
+	const __m128 tfar  = _mm_min_ps(t2x, _mm_min_ps(t2y, t2z));
+
+	const __m128 mask = _mm_and_ps(
+	        _mm_and_ps(_mm_cmple_ps(tnear, tfar), _mm_cmpge_ps(tfar, _mm_setzero_ps())),
+	        _mm_cmplt_ps(tnear, _mm_set1_ps(data->hit.dist)));
+
+	_mm_storeu_ps(r_dist, tnear);
+	return _mm_movemask_ps(mask);
+}
+
+/**
+ * SIMD version of #dfs_raycast, \a node must be a branch whose bounds are already known to be hit.
+ */
+static void dfs_raycast_simd(BVHRayCastData *data, const BVHNode *node)
+{
+	float dist[4];
+	int order[4], order_num = 0;
+	int i, j;
+
+	const int mask = fast_ray_nearest_hit_simd(
+	        data, (const float (*)[4])data->tree->nodebv4[bvhtree_branch_index(data->tree, node)], dist);
+
+	if (mask == 0) {
+		return;
+	}
+
+	/* Visit children front to back, so the further ones are likely culled by the closest hit found so far. */
+	for (i = 0; i < node->totnode; i++) {
+		if (mask & (1 << i)) {
+			for (j = order_num++; (j > 0) && (dist[order[j - 1]] > dist[i]); j--) {
+				order[j] = order[j - 1];
+			}
+			order[j] = i;
+		}
+	}
+
+	for (j = 0; j < order_num; j++) {
+		const BVHNode *child = node->children[order[j]];
+		const float child_dist = dist[order[j]];
+
+		if (child_dist >= data->hit.dist) {
+			continue;
+		}
+
+		if (child->totnode == 0) {
+			if (data->callback) {
+				data->callback(data->userdata, child->index, &data->ray, &data->hit);
+			}
+			else {
+				data->hit.index = child->index;
+				data->hit.dist  = child_dist;
+				madd_v3_v3v3fl(data->hit.co, data->ray.origin, data->ray.direction, child_dist);
+			}
+		}
+		else {
+			dfs_raycast_simd(data, child);
+		}
+	}
+}
+
+/**
+ * SIMD version of #dfs_raycast_all, \a node must be a branch whose bounds are already known to be hit.
+ */
+static void dfs_raycast_all_simd(BVHRayCastData *data, const BVHNode *node)
+{
+	float dist[4];
+	int i;
+
+	const int mask = fast_ray_nearest_hit_simd(
+	        data, (const float (*)[4])data->tree->nodebv4[bvhtree_branch_index(data->tree, node)], dist);
+
+	for (i = 0; i < node->totnode; i++) {
+		if (mask & (1 << i)) {
+			const BVHNode *child = node->children[i];
+
+			if (child->totnode == 0) {
+				const float hit_dist = data->hit.dist;
+				data->callback(data->userdata, child->index, &data->ray, &data->hit);
+				data->hit.index = -1;
+				data->hit.dist = hit_dist;
+			}
+			else {
+				dfs_raycast_all_simd(data, child);
+			}
+		}
+	}
+}
+#endif  /* __SSE2__ */
+
 #if 0
 static void iterative_raycast(BVHRayCastData *data, BVHNode *node)
 {
@@ -1822,8 +2300,18 @@ int BLI_bvhtree_ray_cast_ex(
 	}
 
 	if (root) {
-		dfs_raycast(&data, root);
-//		iterative_raycast(&data, root);
+#ifdef __SSE2__
+		if (tree->nodebv4 && (radius == 0.0f)) {
+			if (fast_ray_nearest_hit(&data, root) < data.hit.dist) {
+				dfs_raycast_simd(&data, root);
+			}
+		}
+		else
+#endif
+		{
+			dfs_raycast(&data, root);
+//			iterative_raycast(&data, root);
+		}
 	}
 
 
@@ -1899,7 +2387,17 @@ void BLI_bvhtree_ray_cast_all_ex(
 	data.hit.dist = hit_dist;
 
 	if (root) {
-		dfs_raycast_all(&data, root);
+#ifdef __SSE2__
+		if (tree->nodebv4 && (radius == 0.0f)) {
+			if (fast_ray_nearest_hit(&data, root) < data.hit.dist) {
+				dfs_raycast_all_simd(&data, root);
+			}
+		}
+		else
+#endif
+		{
+			dfs_raycast_all(&data, root);
+		}
 	}
 }
 
@@ -1910,6 +2408,197 @@ void BLI_bvhtree_ray_cast_all(
 	BLI_bvhtree_ray_cast_all_ex(tree, co, dir, radius, hit_dist, callback, userdata, BVH_RAYCAST_DEFAULT);
 }
 
+/** \} */
+
+
+/* -------------------------------------------------------------------- */
+
+/** \name BLI_bvhtree_ray_cast_packet
+ *
+ * Rays are cast in packets sharing a single traversal: the bounds of each visited node are tested
+ * against all the rays of the packet at once (using SIMD when available).
+ * This amortizes the traversal over coherent rays (similar origins and directions).
+ *
+ * \{ */
+
+#define BVH_RAYCAST_PACKET_SIZE 4
+
+typedef struct BVHRayCastPacketData {
+	BVHRayCastData rays[BVH_RAYCAST_PACKET_SIZE];
+
+	/* Transposed copies of the rays, for SIMD tests. */
+	float origin[3][BVH_RAYCAST_PACKET_SIZE];
+	float idot_axis[3][BVH_RAYCAST_PACKET_SIZE];
+	float hit_dist[BVH_RAYCAST_PACKET_SIZE];
+} BVHRayCastPacketData;
+
+/**
+ * Test the bounds of \a node against the rays of the packet in \a mask.
+ *
+ * \return the bit-mask of the rays which can find a closer hit in \a node, their distances are written in \a r_dist.
+ */
+BLI_INLINE int packet_ray_nearest_hit(
+        const BVHRayCastPacketData *data, const BVHNode *node, const int mask, float r_dist[BVH_RAYCAST_PACKET_SIZE])
+{
+	const float *bv = node->bv;
+#ifdef __SSE2__
+	__m128 tnear = _mm_set1_ps(-FLT_MAX);
+	__m128 tfar = _mm_set1_ps(FLT_MAX);
+	__m128 hit;
+	int axis;
+
+	for (axis = 0; axis < 3; axis++) {
+		const __m128 origin = _mm_loadu_ps(data->origin[axis]);
+		const __m128 idot = _mm_loadu_ps(data->idot_axis[axis]);
+		const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bv[2 * axis]), origin), idot);
+		const __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bv[2 * axis + 1]), origin), idot);
+		tnear = _mm_max_ps(tnear, _mm_min_ps(t1, t2));
+		tfar = _mm_min_ps(tfar, _mm_max_ps(t1, t2));
+	}
+
+	hit = _mm_and_ps(
+	        _mm_and_ps(_mm_cmple_ps(tnear, tfar), _mm_cmpge_ps(tfar, _mm_setzero_ps())),
+	        _mm_cmplt_ps(tnear, _mm_loadu_ps(data->hit_dist)));
+
+	_mm_storeu_ps(r_dist, tnear);
+	return mask & _mm_movemask_ps(hit);
+#else
+	int i, axis, mask_hit = 0;
+
+	for (i = 0; i < BVH_RAYCAST_PACKET_SIZE; i++) {
+		float tnear = -FLT_MAX, tfar = FLT_MAX;
+
+		if (!(mask & (1 << i))) {
+			continue;
+		}
+		for (axis = 0; axis < 3; axis++) {
+			const float t1 = (bv[2 * axis] - data->origin[axis][i]) * data->idot_axis[axis][i];
+			const float t2 = (bv[2 * axis + 1] - data->origin[axis][i]) * data->idot_axis[axis][i];
+			tnear = max_ff(tnear, min_ff(t1, t2));
+			tfar = min_ff(tfar, max_ff(t1, t2));
+		}
+		r_dist[i] = tnear;
+		if ((tnear <= tfar) && (tfar >= 0.0f) && (tnear < data->hit_dist[i])) {
+			mask_hit |= (1 << i);
+		}
+	}
+	return mask_hit;
+#endif
+}
+
+static void dfs_raycast_packet(BVHRayCastPacketData *data, const BVHNode *node, int mask)
+{
+	float dist[BVH_RAYCAST_PACKET_SIZE];
+	int i;
+
+	mask = packet_ray_nearest_hit(data, node, mask, dist);
+	if (mask == 0) {
+		return;
+	}
+
+	if (node->totnode == 0) {
+		for (i = 0; i < BVH_RAYCAST_PACKET_SIZE; i++) {
+			if (mask & (1 << i)) {
+				BVHRayCastData *ray_data = &data->rays[i];
+
+				if (ray_data->callback) {
+					ray_data->callback(ray_data->userdata, node->index, &ray_data->ray, &ray_data->hit);
+				}
+				else {
+					ray_data->hit.index = node->index;
+					ray_data->hit.dist  = dist[i];
+					madd_v3_v3v3fl(ray_data->hit.co, ray_data->ray.origin, ray_data->ray.direction, dist[i]);
+				}
+				data->hit_dist[i] = ray_data->hit.dist;
+			}
+		}
+	}
+	else {
+		/* pick loop direction from the first active ray (based on ray direction and split axis) */
+		int first = 0;
+		while (!(mask & (1 << first))) {
+			first++;
+		}
+
+		if (data->rays[first].ray_dot_axis[(int)node->main_axis] > 0.0f) {
+			for (i = 0; i != node->totnode; i++) {
+				dfs_raycast_packet(data, node->children[i], mask);
+			}
+		}
+		else {
+			for (i = node->totnode - 1; i >= 0; i--) {
+				dfs_raycast_packet(data, node->children[i], mask);
+			}
+		}
+	}
+}
+
+/**
+ * Cast \a rays_num rays, giving the same results as calling #BLI_bvhtree_ray_cast_ex with a zero radius for each,
+ * but traversing the tree for packets of rays at once.
+ *
+ * \param co, dir: Origins and (normalized) directions of the rays.
+ * \param hits: Array of \a rays_num hits, read and written like the \a hit argument of #BLI_bvhtree_ray_cast_ex.
+ */
+void BLI_bvhtree_ray_cast_packet(
+        BVHTree *tree, const float (*co)[3], const float (*dir)[3], int rays_num, BVHTreeRayHit *hits,
+        BVHTree_RayCastCallback callback, void *userdata,
+        int flag)
+{
+	BVHRayCastPacketData data;
+	BVHNode *root = tree->nodes[tree->totleaf];
+	int i, j;
+
+	if (root == NULL) {
+		return;
+	}
+
+	for (i = 0; i < rays_num; i += BVH_RAYCAST_PACKET_SIZE) {
+		const int packet_num = min_ii(BVH_RAYCAST_PACKET_SIZE, rays_num - i);
+
+		for (j = 0; j < BVH_RAYCAST_PACKET_SIZE; j++) {
+			BVHRayCastData *ray_data = &data.rays[j];
+			int axis;
+
+			if (j >= packet_num) {
+				for (axis = 0; axis < 3; axis++) {
+					data.origin[axis][j] = 0.0f;
+					data.idot_axis[axis][j] = 0.0f;
+				}
+				data.hit_dist[j] = -FLT_MAX;
+				continue;
+			}
+
+			BLI_ASSERT_UNIT_V3(dir[i + j]);
+
+			ray_data->tree = tree;
+			ray_data->callback = callback;
+			ray_data->userdata = userdata;
+			copy_v3_v3(ray_data->ray.origin,    co[i + j]);
+			copy_v3_v3(ray_data->ray.direction, dir[i + j]);
+			ray_data->ray.radius = 0.0f;
+
+			bvhtree_ray_cast_data_precalc(ray_data, flag);
+
+			ray_data->hit = hits[i + j];
+
+			for (axis = 0; axis < 3; axis++) {
+				data.origin[axis][j] = ray_data->ray.origin[axis];
+				data.idot_axis[axis][j] = ray_data->idot_axis[axis];
+			}
+			data.hit_dist[j] = ray_data->hit.dist;
+		}
+
+		dfs_raycast_packet(&data, root, (1 << packet_num) - 1);
+
+		for (j = 0; j < packet_num; j++) {
+			hits[i + j] = data.rays[j].hit;
+		}
+	}
+}
+
+/** \} */
+
 
 /* -------------------------------------------------------------------- */
 
@@ -29,6 +29,7 @@
 
 #include "BLI_math.h"
 #include "BLI_kdtree.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 #include "BLI_strict_flags.h"
 
@@ -61,6 +62,26 @@ struct KDTree {
 
 #define KD_NODE_UNSET ((unsigned int)-1)
 
+/* Sub-trees with more nodes than this are balanced in their own task. */
+#ifdef DEBUG
+#  define KD_THREAD_NODE_THRESHOLD 64
+#else
+#  define KD_THREAD_NODE_THRESHOLD 8192
+#endif
+
+/* Number of query points handled at once by each task of the batched queries. */
+#define KD_BATCH_CHUNK_SIZE 256
+
+/**
+ * Traversal stack, either the caller's fixed size array or a heap allocated one once that is exhausted,
+ * so the batched queries can reuse the same one for all points handled by a task.
+ */
+typedef struct KDTreeStack {
+	unsigned int *data;
+	unsigned int tot;
+	bool is_alloc;
+} KDTreeStack;
+
 /**
  * Creates or free a kdtree
  */
@@ -113,8 +134,35 @@ void BLI_kdtree_insert(KDTree *tree, int index, const float co[3])
 #endif
 }
 
-static unsigned int kdtree_balance(KDTreeNode *nodes, unsigned int totnode, unsigned int axis, const unsigned int ofs)
+typedef struct KDTreeBalanceData {
+	KDTreeNode *nodes;
+	TaskPool *pool;
+} KDTreeBalanceData;
+
+typedef struct KDTreeBalanceTask {
+	unsigned int totnode, axis, ofs;
+	unsigned int *r_node;
+} KDTreeBalanceTask;
+
+static unsigned int kdtree_balance(
+        KDTreeBalanceData *data, unsigned int totnode, unsigned int axis, const unsigned int ofs);
+
+static void kdtree_balance_task_cb(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	KDTreeBalanceData *data = BLI_task_pool_userdata(pool);
+	KDTreeBalanceTask *task = taskdata;
+
+	*task->r_node = kdtree_balance(data, task->totnode, task->axis, task->ofs);
+}
+
+/**
+ * Sub-trees never overlap in the nodes array, so once a range is partitioned around its median,
+ * both halves can be balanced independently (large ones are pushed to the task pool).
+ */
+static unsigned int kdtree_balance(
+        KDTreeBalanceData *data, unsigned int totnode, unsigned int axis, const unsigned int ofs)
 {
+	KDTreeNode *nodes = data->nodes + ofs;
 	KDTreeNode *node;
 	float co;
 	unsigned int left, right, median, i, j;
@@ -155,15 +203,37 @@ static unsigned int kdtree_balance(KDTreeNode *nodes, unsigned int totnode, unsi
 	node = &nodes[median];
 	node->d = axis;
 	axis = (axis + 1) % 3;
-	node->left = kdtree_balance(nodes, median, axis, ofs);
-	node->right = kdtree_balance(nodes + median + 1, (totnode - (median + 1)), axis, (median + 1) + ofs);
+
+	if (data->pool && (totnode - (median + 1) > KD_THREAD_NODE_THRESHOLD)) {
+		KDTreeBalanceTask *task = MEM_mallocN(sizeof(*task), __func__);
+		task->totnode = totnode - (median + 1);
+		task->axis = axis;
+		task->ofs = (median + 1) + ofs;
+		task->r_node = &node->right;
+		BLI_task_pool_push(data->pool, kdtree_balance_task_cb, task, true, TASK_PRIORITY_HIGH);
+	}
+	else {
+		node->right = kdtree_balance(data, (totnode - (median + 1)), axis, (median + 1) + ofs);
+	}
+	node->left = kdtree_balance(data, median, axis, ofs);
 
 	return median + ofs;
 }
 
 void BLI_kdtree_balance(KDTree *tree)
 {
-	tree->root = kdtree_balance(tree->nodes, tree->totnode, 0, 0);
+	KDTreeBalanceData data = {.nodes = tree->nodes, .pool = NULL};
+
+	if (tree->totnode > KD_THREAD_NODE_THRESHOLD) {
+		data.pool = BLI_task_pool_create(BLI_task_scheduler_get(), &data);
+	}
+
+	tree->root = kdtree_balance(&data, tree->totnode, 0, 0);
+
+	if (data.pool) {
+		BLI_task_pool_work_and_wait(data.pool);
+		BLI_task_pool_free(data.pool);
+	}
 
 #ifdef DEBUG
 	tree->is_balanced = true;
@@ -199,18 +269,29 @@ static unsigned int *realloc_nodes(unsigned int *stack, unsigned int *totstack,
 	return stack_new;
 }
 
-/**
- * Find nearest returns index, and -1 if no node is found.
- */
-int BLI_kdtree_find_nearest(
+static unsigned int *kdtree_stack_grow(KDTreeStack *kd_stack)
+{
+	kd_stack->data = realloc_nodes(kd_stack->data, &kd_stack->tot, kd_stack->is_alloc);
+	kd_stack->is_alloc = true;
+	return kd_stack->data;
+}
+
+static void kdtree_stack_free(KDTreeStack *kd_stack)
+{
+	if (kd_stack->is_alloc) {
+		MEM_freeN(kd_stack->data);
+	}
+}
+
+static int kdtree_find_nearest_ex(
         const KDTree *tree, const float co[3],
-        KDTreeNearest *r_nearest)
+        KDTreeNearest *r_nearest, KDTreeStack *kd_stack)
 {
 	const KDTreeNode *nodes = tree->nodes;
 	const KDTreeNode *root, *min_node;
-	unsigned int *stack, defaultstack[KD_STACK_INIT];
+	unsigned int *stack = kd_stack->data;
 	float min_dist, cur_dist;
-	unsigned int totstack, cur = 0;
+	unsigned int cur = 0;
 
 #ifdef DEBUG
 	BLI_assert(tree->is_balanced == true);
@@ -219,9 +300,6 @@ int BLI_kdtree_find_nearest(
 	if (UNLIKELY(tree->root == KD_NODE_UNSET))
 		return -1;
 
-	stack = defaultstack;
-	totstack = KD_STACK_INIT;
-
 	root = &nodes[tree->root];
 	min_node = root;
 	min_dist = len_squared_v3v3(root->co, co);
@@ -274,8 +352,8 @@ int BLI_kdtree_find_nearest(
 			if (node->left != KD_NODE_UNSET)
 				stack[cur++] = node->left;
 		}
-		if (UNLIKELY(cur + 3 > totstack)) {
-			stack = realloc_nodes(stack, &totstack, defaultstack != stack);
+		if (UNLIKELY(cur + 3 > kd_stack->tot)) {
+			stack = kdtree_stack_grow(kd_stack);
 		}
 	}
 
@@ -285,12 +363,27 @@ int BLI_kdtree_find_nearest(
 		copy_v3_v3(r_nearest->co, min_node->co);
 	}
 
-	if (stack != defaultstack)
-		MEM_freeN(stack);
-
 	return min_node->index;
 }
 
+/**
+ * Find nearest returns index, and -1 if no node is found.
+ */
+int BLI_kdtree_find_nearest(
+        const KDTree *tree, const float co[3],
+        KDTreeNearest *r_nearest)
+{
+	unsigned int defaultstack[KD_STACK_INIT];
+	KDTreeStack kd_stack = {defaultstack, KD_STACK_INIT, false};
+	int index;
+
+	index = kdtree_find_nearest_ex(tree, co, r_nearest, &kd_stack);
+
+	kdtree_stack_free(&kd_stack);
+
+	return index;
+}
+
 
 /**
  * A version of #BLI_kdtree_find_nearest which runs a callback
@@ -416,22 +509,16 @@ static void add_nearest(KDTreeNearest *ptn, unsigned int *found, unsigned int n,
 	copy_v3_v3(ptn[i].co, co);
 }
 
-/**
- * Find n nearest returns number of points found, with results in nearest.
- * Normal is optional, but if given will limit results to points in normal direction from co.
- *
- * \param r_nearest  An array of nearest, sized at least \a n.
- */
-int BLI_kdtree_find_nearest_n__normal(
+static int kdtree_find_nearest_n_ex(
         const KDTree *tree, const float co[3], const float nor[3],
         KDTreeNearest r_nearest[],
-        unsigned int n)
+        unsigned int n, KDTreeStack *kd_stack)
 {
 	const KDTreeNode *nodes = tree->nodes;
 	const KDTreeNode *root;
-	unsigned int *stack, defaultstack[KD_STACK_INIT];
+	unsigned int *stack = kd_stack->data;
 	float cur_dist;
-	unsigned int totstack, cur = 0;
+	unsigned int cur = 0;
 	unsigned int i, found = 0;
 
 #ifdef DEBUG
@@ -441,9 +528,6 @@ int BLI_kdtree_find_nearest_n__normal(
 	if (UNLIKELY((tree->root == KD_NODE_UNSET) || n == 0))
 		return 0;
 
-	stack = defaultstack;
-	totstack = KD_STACK_INIT;
-
 	root = &nodes[tree->root];
 
 	cur_dist = squared_distance(root->co, co, nor);
@@ -496,20 +580,39 @@ int BLI_kdtree_find_nearest_n__normal(
 			if (node->left != KD_NODE_UNSET)
 				stack[cur++] = node->left;
 		}
-		if (UNLIKELY(cur + 3 > totstack)) {
-			stack = realloc_nodes(stack, &totstack, defaultstack != stack);
+		if (UNLIKELY(cur + 3 > kd_stack->tot)) {
+			stack = kdtree_stack_grow(kd_stack);
 		}
 	}
 
 	for (i = 0; i < found; i++)
 		r_nearest[i].dist = sqrtf(r_nearest[i].dist);
 
-	if (stack != defaultstack)
-		MEM_freeN(stack);
-
 	return (int)found;
 }
 
+/**
+ * Find n nearest returns number of points found, with results in nearest.
+ * Normal is optional, but if given will limit results to points in normal direction from co.
+ *
+ * \param r_nearest  An array of nearest, sized at least \a n.
+ */
+int BLI_kdtree_find_nearest_n__normal(
+        const KDTree *tree, const float co[3], const float nor[3],
+        KDTreeNearest r_nearest[],
+        unsigned int n)
+{
+	unsigned int defaultstack[KD_STACK_INIT];
+	KDTreeStack kd_stack = {defaultstack, KD_STACK_INIT, false};
+	int found;
+
+	found = kdtree_find_nearest_n_ex(tree, co, nor, r_nearest, n, &kd_stack);
+
+	kdtree_stack_free(&kd_stack);
+
+	return found;
+}
+
 static int range_compare(const void *a, const void *b)
 {
 	const KDTreeNearest *kda = a;
@@ -610,23 +713,16 @@ int BLI_kdtree_range_search__normal(
 	return (int)found;
 }
 
-/**
- * A version of #BLI_kdtree_range_search which runs a callback
- * instead of allocating an array.
- *
- * \param search_cb: Called for every node found in \a range, false return value performs an early exit.
- *
- * \note the order of calls isn't sorted based on distance.
- */
-void BLI_kdtree_range_search_cb(
+static void kdtree_range_search_cb_ex(
         const KDTree *tree, const float co[3], float range,
-        bool (*search_cb)(void *user_data, int index, const float co[3], float dist_sq), void *user_data)
+        bool (*search_cb)(void *user_data, int index, const float co[3], float dist_sq), void *user_data,
+        KDTreeStack *kd_stack)
 {
 	const KDTreeNode *nodes = tree->nodes;
 
-	unsigned int *stack, defaultstack[KD_STACK_INIT];
+	unsigned int *stack = kd_stack->data;
 	float range_sq = range * range, dist_sq;
-	unsigned int totstack, cur = 0;
+	unsigned int cur = 0;
 
 #ifdef DEBUG
 	BLI_assert(tree->is_balanced == true);
@@ -635,9 +731,6 @@ void BLI_kdtree_range_search_cb(
 	if (UNLIKELY(tree->root == KD_NODE_UNSET))
 		return;
 
-	stack = defaultstack;
-	totstack = KD_STACK_INIT;
-
 	stack[cur++] = tree->root;
 
 	while (cur--) {
@@ -655,7 +748,7 @@ void BLI_kdtree_range_search_cb(
 			dist_sq = len_squared_v3v3(node->co, co);
 			if (dist_sq <= range_sq) {
 				if (search_cb(user_data, node->index, node->co, dist_sq) == false) {
-					goto finally;
+					return;
 				}
 			}
 
@@ -665,12 +758,226 @@ void BLI_kdtree_range_search_cb(
 				stack[cur++] = node->right;
 		}
 
-		if (UNLIKELY(cur + 3 > totstack)) {
-			stack = realloc_nodes(stack, &totstack, defaultstack != stack);
+		if (UNLIKELY(cur + 3 > kd_stack->tot)) {
+			stack = kdtree_stack_grow(kd_stack);
 		}
 	}
+}
 
-finally:
-	if (stack != defaultstack)
-		MEM_freeN(stack);
+/**
+ * A version of #BLI_kdtree_range_search which runs a callback
+ * instead of allocating an array.
+ *
+ * \param search_cb: Called for every node found in \a range, false return value performs an early exit.
+ *
+ * \note the order of calls isn't sorted based on distance.
+ */
+void BLI_kdtree_range_search_cb(
+        const KDTree *tree, const float co[3], float range,
+        bool (*search_cb)(void *user_data, int index, const float co[3], float dist_sq), void *user_data)
+{
+	unsigned int defaultstack[KD_STACK_INIT];
+	KDTreeStack kd_stack = {defaultstack, KD_STACK_INIT, false};
+
+	kdtree_range_search_cb_ex(tree, co, range, search_cb, user_data, &kd_stack);
+
+	kdtree_stack_free(&kd_stack);
+}
+
+
+/* -------------------------------------------------------------------- */
+
+/** \name Batched Queries
+ *
+ * Answer an array of query points at once, split in chunks of #KD_BATCH_CHUNK_SIZE points over threads.
+ * Each chunk reuses a single traversal stack for all of its points, so there is no allocation per query.
+ * \{ */
+
+typedef struct KDTreeBatchData {
+	const KDTree *tree;
+	const float (*co)[3];
+	unsigned int co_num;
+
+	/* find nearest (n) */
+	int *r_index;
+	KDTreeNearest *r_nearest;
+	int *r_found;
+	unsigned int n;
+
+	/* range search */
+	float range;
+	bool (*search_cb)(void *user_data, unsigned int co_index, int index, const float co[3], float dist_sq);
+	void *user_data;
+} KDTreeBatchData;
+
+typedef struct KDTreeBatchRangeData {
+	const KDTreeBatchData *data;
+	unsigned int co_index;
+} KDTreeBatchRangeData;
+
+static void kdtree_batch_range(const KDTreeBatchData *data, const int chunk, unsigned int *r_start, unsigned int *r_end)
+{
+	*r_start = (unsigned int)chunk * KD_BATCH_CHUNK_SIZE;
+	*r_end = MIN2(*r_start + KD_BATCH_CHUNK_SIZE, data->co_num);
+}
+
+static void kdtree_batch_parallel(KDTreeBatchData *data, TaskParallelRangeFuncEx func)
+{
+	const int chunks_num = (int)((data->co_num + KD_BATCH_CHUNK_SIZE - 1) / KD_BATCH_CHUNK_SIZE);
+
+	BLI_task_parallel_range_ex(0, chunks_num, data, NULL, 0, func, (chunks_num > 1), true);
+}
+
+static void kdtree_find_nearest_batch_cb(
+        void *userdata, void *UNUSED(userdata_chunk), const int chunk, const int UNUSED(threadid))
+{
+	const KDTreeBatchData *data = userdata;
+	unsigned int defaultstack[KD_STACK_INIT];
+	KDTreeStack kd_stack = {defaultstack, KD_STACK_INIT, false};
+	unsigned int i, start, end;
+
+	kdtree_batch_range(data, chunk, &start, &end);
+
+	for (i = start; i < end; i++) {
+		KDTreeNearest nearest;
+		const int index = kdtree_find_nearest_ex(data->tree, data->co[i], &nearest, &kd_stack);
+
+		if (data->r_index) {
+			data->r_index[i] = index;
+		}
+		if (data->r_nearest) {
+			if (index == -1) {
+				data->r_nearest[i].index = -1;
+				data->r_nearest[i].dist = FLT_MAX;
+				zero_v3(data->r_nearest[i].co);
+			}
+			else {
+				data->r_nearest[i] = nearest;
+			}
+		}
+	}
+
+	kdtree_stack_free(&kd_stack);
 }
+
+/**
+ * Batched version of #BLI_kdtree_find_nearest, evaluated in parallel.
+ *
+ * \param r_index: Optional, an array of \a co_num indices (-1 when the tree is empty).
+ * \param r_nearest: Optional, an array of \a co_num nearest (index of -1 when the tree is empty).
+ */
+void BLI_kdtree_find_nearest_batch(
+        const KDTree *tree, const float (*co)[3], unsigned int co_num,
+        int *r_index, KDTreeNearest *r_nearest)
+{
+	KDTreeBatchData data = {
+		.tree = tree, .co = co, .co_num = co_num,
+		.r_index = r_index, .r_nearest = r_nearest,
+	};
+
+#ifdef DEBUG
+	BLI_assert(tree->is_balanced == true);
+#endif
+
+	kdtree_batch_parallel(&data, kdtree_find_nearest_batch_cb);
+}
+
+static void kdtree_find_nearest_n_batch_cb(
+        void *userdata, void *UNUSED(userdata_chunk), const int chunk, const int UNUSED(threadid))
+{
+	const KDTreeBatchData *data = userdata;
+	unsigned int defaultstack[KD_STACK_INIT];
+	KDTreeStack kd_stack = {defaultstack, KD_STACK_INIT, false};
+	unsigned int i, start, end;
+
+	kdtree_batch_range(data, chunk, &start, &end);
+
+	for (i = start; i < end; i++) {
+		const int found = kdtree_find_nearest_n_ex(
+		        data->tree, data->co[i], NULL, &data->r_nearest[(size_t)i * data->n], data->n, &kd_stack);
+
+		if (data->r_found) {
+			data->r_found[i] = found;
+		}
+	}
+
+	kdtree_stack_free(&kd_stack);
+}
+
+/**
+ * Batched version of #BLI_kdtree_find_nearest_n, evaluated in parallel.
+ *
+ * \param r_nearest: An array of \a co_num * \a n nearest, the results of each point are sorted by distance.
+ * \param r_found: Optional, an array of \a co_num number of points found.
+ */
+void BLI_kdtree_find_nearest_n_batch(
+        const KDTree *tree, const float (*co)[3], unsigned int co_num,
+        KDTreeNearest *r_nearest, int *r_found,
+        unsigned int n)
+{
+	KDTreeBatchData data = {
+		.tree = tree, .co = co, .co_num = co_num,
+		.r_nearest = r_nearest, .r_found = r_found, .n = n,
+	};
+
+#ifdef DEBUG
+	BLI_assert(tree->is_balanced == true);
+#endif
+
+	kdtree_batch_parallel(&data, kdtree_find_nearest_n_batch_cb);
+}
+
+static bool kdtree_range_search_batch_search_cb(void *user_data, int index, const float co[3], float dist_sq)
+{
+	const KDTreeBatchRangeData *range_data = user_data;
+	const KDTreeBatchData *data = range_data->data;
+
+	return data->search_cb(data->user_data, range_data->co_index, index, co, dist_sq);
+}
+
+static void kdtree_range_search_batch_cb(
+        void *userdata, void *UNUSED(userdata_chunk), const int chunk, const int UNUSED(threadid))
+{
+	const KDTreeBatchData *data = userdata;
+	unsigned int defaultstack[KD_STACK_INIT];
+	KDTreeStack kd_stack = {defaultstack, KD_STACK_INIT, false};
+	KDTreeBatchRangeData range_data = {data};
+	unsigned int start, end;
+
+	kdtree_batch_range(data, chunk, &start, &end);
+
+	for (range_data.co_index = start; range_data.co_index < end; range_data.co_index++) {
+		kdtree_range_search_cb_ex(
+		        data->tree, data->co[range_data.co_index], data->range,
+		        kdtree_range_search_batch_search_cb, &range_data, &kd_stack);
+	}
+
+	kdtree_stack_free(&kd_stack);
+}
+
+/**
+ * Batched version of #BLI_kdtree_range_search_cb, evaluated in parallel.
+ *
+ * \param search_cb: Called for every node found in \a range of the point \a co_index,
+ * false return value stops the search for that point only.
+ *
+ * \note \a search_cb is called from multiple threads, but never concurrently for the same \a co_index.
+ */
+void BLI_kdtree_range_search_batch_cb(
+        const KDTree *tree, const float (*co)[3], unsigned int co_num, float range,
+        bool (*search_cb)(void *user_data, unsigned int co_index, int index, const float co[3], float dist_sq),
+        void *user_data)
+{
+	KDTreeBatchData data = {
+		.tree = tree, .co = co, .co_num = co_num,
+		.range = range, .search_cb = search_cb, .user_data = user_data,
+	};
+
+#ifdef DEBUG
+	BLI_assert(tree->is_balanced == true);
+#endif
+
+	kdtree_batch_parallel(&data, kdtree_range_search_batch_cb);
+}
+
+/** \} */
@@ -203,15 +203,43 @@ struct TaskPool {
 #endif
 };
 
+/* Queue of tasks which belongs to a single thread.
+ *
+ * Tasks pushed from a worker thread go to its own queue, so it keeps working
+ * on the data it just touched. Threads which run out of tasks in their own
+ * queue steal tasks from the queues of other threads. Every queue has its own
+ * lock, so threads only contend when they access the same queue.
+ */
+typedef struct TaskQueue {
+	SpinLock lock;
+	ListBase tasks;
+} TaskQueue;
+
 struct TaskScheduler {
 	pthread_t *threads;
 	struct TaskThread *task_threads;
 	int num_threads;
 	bool background_thread_only;
 
-	ListBase queue;
+	/* Per-thread queues, indexed by thread ID (main thread included). */
+	TaskQueue *queues;
+	int num_queues;
+
+	/* Tasks of background pools, so the background-only thread never has to
+	 * skip over tasks it is not allowed to run. */
+	TaskQueue background_queue;
+
+	/* Number of tasks in the regular and the background queues. */
+	size_t num_queued;
+	size_t num_queued_background;
+
+	/* Round-robin counter for tasks pushed from outside of worker threads. */
+	unsigned int next_queue;
+
+	/* Only used for sleeping while there are no tasks in any queue. */
 	ThreadMutex queue_mutex;
 	ThreadCondition queue_cond;
+	unsigned int num_sleeping;
 
 	volatile bool do_exit;
 
@@ -351,54 +379,99 @@ static void task_pool_num_increase(TaskPool *pool, size_t new)
 	BLI_mutex_unlock(&pool->num_mutex);
 }
 
-static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, Task **task)
+static Task *task_queue_pop(TaskQueue *queue, TaskPool *pool)
 {
-	bool found_task = false;
-	BLI_mutex_lock(&scheduler->queue_mutex);
-
-	while (!scheduler->queue.first && !scheduler->do_exit)
-		BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+	Task *task;
 
-	do {
-		Task *current_task;
+	/* Unlocked check, avoids locking queues which are known to be empty. */
+	if (queue->tasks.first == NULL) {
+		return NULL;
+	}
 
-		/* Assuming we can only have a void queue in 'exit' case here seems logical (we should only be here after
-		 * our worker thread has been woken up from a condition_wait(), which only happens after a new task was
-		 * added to the queue), but it is wrong.
-		 * Waiting on condition may wake up the thread even if condition is not signaled (spurious wake-ups), and some
-		 * race condition may also empty the queue **after** condition has been signaled, but **before** awoken thread
-		 * reaches this point...
-		 * See http://stackoverflow.com/questions/8594591
-		 *
-		 * So we only abort here if do_exit is set.
-		 */
-		if (scheduler->do_exit) {
-			BLI_mutex_unlock(&scheduler->queue_mutex);
-			return false;
+	BLI_spin_lock(&queue->lock);
+	for (task = queue->tasks.first; task != NULL; task = task->next) {
+		if (pool == NULL || task->pool == pool) {
+			BLI_remlink(&queue->tasks, task);
+			break;
 		}
+	}
+	BLI_spin_unlock(&queue->lock);
+
+	return task;
+}
+
+BLI_INLINE bool task_scheduler_has_tasks(TaskScheduler *scheduler)
+{
+	if (scheduler->background_thread_only) {
+		return scheduler->num_queued_background != 0;
+	}
+	return scheduler->num_queued != 0 || scheduler->num_queued_background != 0;
+}
+
+static void task_scheduler_wake(TaskScheduler *scheduler, TaskPool *pool, bool all)
+{
+	/* Queued counters are increased before this, so either a sleeping thread
+	 * sees them changed or we see it sleeping. */
+	if (scheduler->num_sleeping == 0) {
+		return;
+	}
+	/* Background-only thread would go back to sleep right away. */
+	if (scheduler->background_thread_only && !pool->run_in_background) {
+		return;
+	}
+
+	BLI_mutex_lock(&scheduler->queue_mutex);
+	if (all)
+		BLI_condition_notify_all(&scheduler->queue_cond);
+	else
+		BLI_condition_notify_one(&scheduler->queue_cond);
+	BLI_mutex_unlock(&scheduler->queue_mutex);
+}
 
-		for (current_task = scheduler->queue.first;
-		     current_task != NULL;
-		     current_task = current_task->next)
-		{
-			TaskPool *pool = current_task->pool;
+/* Find a task for the given thread, first in its own queue, then stealing
+ * from the others. If pool is given only its tasks are considered. */
+static Task *task_scheduler_pop(TaskScheduler *scheduler, TaskPool *pool, int thread_id)
+{
+	Task *task;
 
-			if (scheduler->background_thread_only && !pool->run_in_background) {
-				continue;
+	if (pool != NULL ? !pool->run_in_background : !scheduler->background_thread_only) {
+		for (int i = 0; i < scheduler->num_queues; i++) {
+			TaskQueue *queue = &scheduler->queues[(thread_id + i) % scheduler->num_queues];
+			if ((task = task_queue_pop(queue, pool))) {
+				atomic_sub_and_fetch_z(&scheduler->num_queued, 1);
+				return task;
 			}
+		}
+	}
 
-			*task = current_task;
-			found_task = true;
-			BLI_remlink(&scheduler->queue, *task);
-			break;
+	if (pool == NULL || pool->run_in_background) {
+		if ((task = task_queue_pop(&scheduler->background_queue, pool))) {
+			atomic_sub_and_fetch_z(&scheduler->num_queued_background, 1);
+			return task;
 		}
-		if (!found_task)
-			BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
-	} while (!found_task);
+	}
 
-	BLI_mutex_unlock(&scheduler->queue_mutex);
+	return NULL;
+}
+
+static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, int thread_id, Task **task)
+{
+	while (!scheduler->do_exit) {
+		if ((*task = task_scheduler_pop(scheduler, NULL, thread_id))) {
+			return true;
+		}
+
+		/* Nothing found, sleep until new tasks are pushed. Tasks might have
+		 * been counted but not yet put in a queue, then we try again. */
+		BLI_mutex_lock(&scheduler->queue_mutex);
+		atomic_add_and_fetch_u(&scheduler->num_sleeping, 1);
+		while (!scheduler->do_exit && !task_scheduler_has_tasks(scheduler))
+			BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+		atomic_sub_and_fetch_u(&scheduler->num_sleeping, 1);
+		BLI_mutex_unlock(&scheduler->queue_mutex);
+	}
 
-	return true;
+	return false;
 }
 
 BLI_INLINE void handle_local_queue(TaskThreadLocalStorage *tls,
@@ -432,7 +505,7 @@ static void *task_scheduler_thread_run(void *thread_p)
 	pthread_setspecific(scheduler->tls_id_key, thread);
 
 	/* keep popping off tasks */
-	while (task_scheduler_thread_wait_pop(scheduler, &task)) {
+	while (task_scheduler_thread_wait_pop(scheduler, thread_id, &task)) {
 		TaskPool *pool = task->pool;
 
 		/* run task */
@@ -461,7 +534,6 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 	 * threads, so we keep track of the number of users. */
 	scheduler->do_exit = false;
 
-	BLI_listbase_clear(&scheduler->queue);
 	BLI_mutex_init(&scheduler->queue_mutex);
 	BLI_condition_init(&scheduler->queue_cond);
 
@@ -485,6 +557,15 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 	/* Initialize TLS for main thread. */
 	initialize_task_tls(&scheduler->task_threads[0].tls);
 
+	/* One queue per thread, including the main thread. */
+	scheduler->num_queues = num_threads + 1;
+	scheduler->queues = MEM_callocN(sizeof(TaskQueue) * scheduler->num_queues,
+	                                "TaskScheduler queues");
+	for (int i = 0; i < scheduler->num_queues; i++) {
+		BLI_spin_init(&scheduler->queues[i].lock);
+	}
+	BLI_spin_init(&scheduler->background_queue.lock);
+
 	pthread_key_create(&scheduler->tls_id_key, NULL);
 
 	/* launch threads that will be waiting for work */
@@ -544,10 +625,16 @@ void BLI_task_scheduler_free(TaskScheduler *scheduler)
 	}
 
 	/* delete leftover tasks */
-	for (task = scheduler->queue.first; task; task = task->next) {
-		task_data_free(task, 0);
+	for (int i = 0; i < scheduler->num_queues + 1; i++) {
+		TaskQueue *queue = (i < scheduler->num_queues) ? &scheduler->queues[i] : &scheduler->background_queue;
+
+		for (task = queue->tasks.first; task; task = task->next) {
+			task_data_free(task, 0);
+		}
+		BLI_freelistN(&queue->tasks);
+		BLI_spin_end(&queue->lock);
 	}
-	BLI_freelistN(&scheduler->queue);
+	MEM_freeN(scheduler->queues);
 
 	/* delete mutex/condition */
 	BLI_mutex_end(&scheduler->queue_mutex);
@@ -561,26 +648,48 @@ int BLI_task_scheduler_num_threads(TaskScheduler *scheduler)
 	return scheduler->num_threads + 1;
 }
 
-static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriority priority)
+static TaskQueue *task_scheduler_push_queue(TaskScheduler *scheduler, TaskPool *pool, int thread_id)
+{
+	if (pool->run_in_background) {
+		atomic_add_and_fetch_z(&scheduler->num_queued_background, 1);
+		return &scheduler->background_queue;
+	}
+
+	atomic_add_and_fetch_z(&scheduler->num_queued, 1);
+
+	/* Worker threads keep the tasks they push, others spread them out. */
+	if (thread_id <= 0) {
+		thread_id = atomic_fetch_and_add_u(&scheduler->next_queue, 1) % scheduler->num_queues;
+	}
+	return &scheduler->queues[thread_id];
+}
+
+static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriority priority, int thread_id)
 {
 	task_pool_num_increase(task->pool, 1);
 
 	/* add task to queue */
-	BLI_mutex_lock(&scheduler->queue_mutex);
+	TaskQueue *queue = task_scheduler_push_queue(scheduler, task->pool, thread_id);
+
+	BLI_spin_lock(&queue->lock);
 
 	if (priority == TASK_PRIORITY_HIGH)
-		BLI_addhead(&scheduler->queue, task);
+		BLI_addhead(&queue->tasks, task);
 	else
-		BLI_addtail(&scheduler->queue, task);
+		BLI_addtail(&queue->tasks, task);
 
-	BLI_condition_notify_one(&scheduler->queue_cond);
-	BLI_mutex_unlock(&scheduler->queue_mutex);
+	BLI_spin_unlock(&queue->lock);
+
+	task_scheduler_wake(scheduler, task->pool, false);
 }
 
-static void task_scheduler_push_all(TaskScheduler *scheduler,
-                                    TaskPool *pool,
-                                    Task **tasks,
-                                    int num_tasks)
+/* Push a list of tasks from the same pool at once, spread evenly over all
+ * the queues so every thread starts with its own share of the work. */
+static void task_scheduler_push_list(TaskScheduler *scheduler,
+                                     TaskPool *pool,
+                                     ListBase *tasks,
+                                     size_t num_tasks,
+                                     bool at_head)
 {
 	if (num_tasks == 0) {
 		return;
@@ -588,36 +697,101 @@ static void task_scheduler_push_all(TaskScheduler *scheduler,
 
 	task_pool_num_increase(pool, num_tasks);
 
-	BLI_mutex_lock(&scheduler->queue_mutex);
+	if (pool->run_in_background) {
+		atomic_add_and_fetch_z(&scheduler->num_queued_background, num_tasks);
+	}
+	else {
+		atomic_add_and_fetch_z(&scheduler->num_queued, num_tasks);
+	}
+
+	const int num_queues = pool->run_in_background ? 1 : scheduler->num_queues;
+	const size_t chunk_size = (num_tasks + num_queues - 1) / num_queues;
+	int queue_index = atomic_fetch_and_add_u(&scheduler->next_queue, 1);
+
+	while (tasks->first) {
+		TaskQueue *queue = pool->run_in_background ?
+		        &scheduler->background_queue :
+		        &scheduler->queues[(queue_index++) % num_queues];
+		ListBase chunk = {NULL, NULL};
+
+		for (size_t i = 0; i < chunk_size && tasks->first; i++) {
+			Task *task = tasks->first;
+			BLI_remlink(tasks, task);
+			BLI_addtail(&chunk, task);
+		}
+
+		BLI_spin_lock(&queue->lock);
+		if (at_head) {
+			BLI_movelisttolist(&chunk, &queue->tasks);
+			queue->tasks = chunk;
+		}
+		else {
+			BLI_movelisttolist(&queue->tasks, &chunk);
+		}
+		BLI_spin_unlock(&queue->lock);
+	}
+
+	task_scheduler_wake(scheduler, pool, true);
+}
+
+static void task_scheduler_push_all(TaskScheduler *scheduler,
+                                    TaskPool *pool,
+                                    Task **tasks,
+                                    int num_tasks)
+{
+	ListBase list = {NULL, NULL};
 
 	for (int i = 0; i < num_tasks; i++) {
-		BLI_addhead(&scheduler->queue, tasks[i]);
+		BLI_addtail(&list, tasks[i]);
 	}
 
-	BLI_condition_notify_all(&scheduler->queue_cond);
-	BLI_mutex_unlock(&scheduler->queue_mutex);
+	task_scheduler_push_list(scheduler, pool, &list, num_tasks, true);
 }
 
-static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
+static size_t task_queue_clear(TaskQueue *queue, TaskPool *pool)
 {
+	ListBase cleared = {NULL, NULL};
 	Task *task, *nexttask;
 	size_t done = 0;
 
-	BLI_mutex_lock(&scheduler->queue_mutex);
+	BLI_spin_lock(&queue->lock);
 
-	/* free all tasks from this pool from the queue */
-	for (task = scheduler->queue.first; task; task = nexttask) {
+	for (task = queue->tasks.first; task; task = nexttask) {
 		nexttask = task->next;
 
 		if (task->pool == pool) {
-			task_data_free(task, pool->thread_id);
-			BLI_freelinkN(&scheduler->queue, task);
-
+			BLI_remlink(&queue->tasks, task);
+			BLI_addtail(&cleared, task);
 			done++;
 		}
 	}
 
-	BLI_mutex_unlock(&scheduler->queue_mutex);
+	BLI_spin_unlock(&queue->lock);
+
+	/* free outside of the lock, free callbacks may take a while */
+	for (task = cleared.first; task; task = task->next) {
+		task_data_free(task, pool->thread_id);
+	}
+	BLI_freelistN(&cleared);
+
+	return done;
+}
+
+static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
+{
+	size_t done = 0;
+
+	/* free all tasks from this pool from the queues */
+	if (pool->run_in_background) {
+		done = task_queue_clear(&scheduler->background_queue, pool);
+		atomic_sub_and_fetch_z(&scheduler->num_queued_background, done);
+	}
+	else {
+		for (int i = 0; i < scheduler->num_queues; i++) {
+			done += task_queue_clear(&scheduler->queues[i], pool);
+		}
+		atomic_sub_and_fetch_z(&scheduler->num_queued, done);
+	}
 
 	/* notify done */
 	task_pool_num_decrease(pool, done);
@@ -818,7 +992,7 @@ static void task_pool_push(
 	/* Do push to a global execution ppol, slowest possible method,
 	 * causes quite reasonable amount of threading overhead.
 	 */
-	task_scheduler_push(pool->scheduler, task, priority);
+	task_scheduler_push(pool->scheduler, task, priority, thread_id);
 }
 
 void BLI_task_pool_push_ex(
@@ -847,13 +1021,7 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 
 	if (atomic_fetch_and_and_uint8((uint8_t *)&pool->is_suspended, 0)) {
 		if (pool->num_suspended) {
-			task_pool_num_increase(pool, pool->num_suspended);
-			BLI_mutex_lock(&scheduler->queue_mutex);
-
-			BLI_movelisttolist(&scheduler->queue, &pool->suspended_queue);
-
-			BLI_condition_notify_all(&scheduler->queue_cond);
-			BLI_mutex_unlock(&scheduler->queue_mutex);
+			task_scheduler_push_list(scheduler, pool, &pool->suspended_queue, pool->num_suspended, false);
 		}
 	}
 
@@ -864,26 +1032,15 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 	BLI_mutex_lock(&pool->num_mutex);
 
 	while (pool->num != 0) {
-		Task *task, *work_task = NULL;
-		bool found_task = false;
+		Task *work_task;
+		bool found_task;
 
 		BLI_mutex_unlock(&pool->num_mutex);
 
-		BLI_mutex_lock(&scheduler->queue_mutex);
-
 		/* find task from this pool. if we get a task from another pool,
 		 * we can get into deadlock */
-
-		for (task = scheduler->queue.first; task; task = task->next) {
-			if (task->pool == pool) {
-				work_task = task;
-				found_task = true;
-				BLI_remlink(&scheduler->queue, task);
-				break;
-			}
-		}
-
-		BLI_mutex_unlock(&scheduler->queue_mutex);
+		work_task = task_scheduler_pop(scheduler, pool, pool->thread_id);
+		found_task = (work_task != NULL);
 
 		/* if found task, do it, otherwise wait until other tasks are done */
 		if (found_task) {
@@ -893,7 +1050,7 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 			BLI_assert(!tls->do_delayed_push);
 
 			/* delete task */
-			task_free(pool, task, pool->thread_id);
+			task_free(pool, work_task, pool->thread_id);
 
 			/* Handle all tasks from local queue. */
 			handle_local_queue(tls, pool->thread_id);
@@ -1123,7 +1280,7 @@ static void task_parallel_range_ex(
 		state.chunk_size = max_ii(1, (stop - start) / (num_tasks));
 	}
 
-	num_tasks = min_ii(num_tasks, (stop - start) / state.chunk_size);
+	num_tasks = min_ii(num_tasks, max_ii(1, (stop - start) / state.chunk_size));
 	atomic_fetch_and_add_uint32((uint32_t *)(&state.iter), 0);
 
 	if (use_userdata_chunk) {
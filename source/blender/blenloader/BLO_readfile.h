@@ -51,6 +51,9 @@ struct FileData;
 
 typedef struct BlendHandle BlendHandle;
 
+/* Start of .blend files compressed in chunks (G_FILE_COMPRESS_CHUNKED), instead of "BLENDER". */
+#define BLO_CHUNKFILE_MAGIC "BLENDCHK"
+
 typedef enum BlenFileType {
 	BLENFILETYPE_BLEND = 1,
 	BLENFILETYPE_PUB = 2,
@@ -88,7 +91,7 @@ BlendFileData *BLO_read_from_memory(
         const void *mem, int memsize,
         struct ReportList *reports, eBLOReadSkip skip_flag);
 BlendFileData *BLO_read_from_memfile(
-        struct Main *oldmain, const char *filename, struct MemFile *memfile,
+        struct Main *oldmain, const char *filename, struct MemFile *memfile, const struct MemFile *memfile_oldmain,
         struct ReportList *reports, eBLOReadSkip skip_flag);
 
 void BLO_blendfiledata_free(BlendFileData *bfd);
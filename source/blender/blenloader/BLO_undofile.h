@@ -33,25 +33,41 @@
  *  \ingroup blenloader
  */
 
+struct GHash;
+
+/* chunk data, shared by all the chunks storing the same content (in any memfile) */
+typedef struct MemFileBuffer {
+	char *buf;
+	unsigned int size;             /* size of the data */
+	unsigned int size_compressed;  /* size of 'buf' when compressed, 0 otherwise */
+	unsigned int hash;
+	int users;
+} MemFileBuffer;
+
 typedef struct {
 	void *next, *prev;
 	
-	char *buf;
-	unsigned int ident, size;
+	MemFileBuffer *buffer;
+	unsigned int size;
 	
+	/* address of the ID this chunk belongs to, NULL for other blocks */
+	const void *id;
 } MemFileChunk;
 
 typedef struct MemFile {
 	ListBase chunks;
-	unsigned int size;
+	unsigned int size;  /* size of the buffers added by this memfile */
 } MemFile;
 
 /* actually only used writefile.c */
-extern void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size);
+extern void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size, const void *id);
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
-extern void BLO_memfile_merge(MemFile *first, MemFile *second);
+extern void BLO_memfile_compress(MemFile *memfile);
+extern void BLO_memfile_uncompress(MemFile *memfile);
+extern size_t BLO_memfile_buffers_size(void);
+extern struct GHash *BLO_memfile_compare_ids(const MemFile *memfile, const MemFile *memfile_ref);
 
 #endif
 
@@ -0,0 +1,696 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenloader/intern/chunkfile.c
+ *  \ingroup blenloader
+ *
+ * Chunked compression of .blend files (see G_FILE_COMPRESS_CHUNKED).
+ *
+ * The file is compressed in independent chunks, so they can be compressed and decompressed
+ * in parallel, and a table with the location of each chunk is written at the end of the file:
+ *
+ * - Header: #BLO_CHUNKFILE_MAGIC, format version, codec and (uncompressed) chunk size.
+ * - The compressed chunks, one after the other.
+ * - Table: offset in the file, compressed and uncompressed size of each chunk.
+ * - Footer: offset of the table in the file and number of chunks.
+ *
+ * Integers are stored little endian, chunks which don't get smaller are stored uncompressed.
+ *
+ * The reader only decompresses the chunks it needs, starting with a single chunk and reading
+ * more chunks at once while the file is read sequentially. So reading only the start of a file
+ * (file header, thumbnail) stays cheap.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+#include "zlib.h"
+
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#endif
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_endian_switch.h"
+#include "BLI_fileops.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "BKE_global.h"  /* for ENDIAN_ORDER */
+
+#include "BLO_readfile.h"
+
+#include "chunkfile.h"
+
+#ifdef WIN32
+#  define chunkfile_lseek _lseeki64
+#else
+#  define chunkfile_lseek lseek
+#endif
+
+#define CHUNKFILE_VERSION 1
+
+/* Uncompressed size of a chunk (except for the last one). */
+#define CHUNKFILE_CHUNK_SIZE (1 << 20)
+/* Upper limit accepted when reading, to catch corrupt files. */
+#define CHUNKFILE_CHUNK_SIZE_MAX (1 << 26)
+
+enum {
+	CHUNKFILE_CODEC_ZLIB = 1,
+	CHUNKFILE_CODEC_LZO  = 2,
+};
+
+typedef struct ChunkFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t codec;
+	uint32_t chunk_size;
+	uint32_t _pad;
+} ChunkFileHeader;
+
+typedef struct ChunkFileEntry {
+	uint64_t offset;
+	uint32_t size_compressed;
+	uint32_t size;
+} ChunkFileEntry;
+
+typedef struct ChunkFileFooter {
+	uint64_t table_offset;
+	uint64_t table_len;
+} ChunkFileFooter;
+
+/* -------------------------------------------------------------------- */
+/** \name Utilities
+ * \{ */
+
+static void chunkfile_header_switch_endian(ChunkFileHeader *header)
+{
+	if (ENDIAN_ORDER == B_ENDIAN) {
+		BLI_endian_switch_uint32(&header->version);
+		BLI_endian_switch_uint32(&header->codec);
+		BLI_endian_switch_uint32(&header->chunk_size);
+	}
+}
+
+static void chunkfile_table_switch_endian(ChunkFileEntry *table, const uint64_t table_len)
+{
+	if (ENDIAN_ORDER == B_ENDIAN) {
+		uint64_t i;
+		for (i = 0; i < table_len; i++) {
+			BLI_endian_switch_uint64(&table[i].offset);
+			BLI_endian_switch_uint32(&table[i].size_compressed);
+			BLI_endian_switch_uint32(&table[i].size);
+		}
+	}
+}
+
+static void chunkfile_footer_switch_endian(ChunkFileFooter *footer)
+{
+	if (ENDIAN_ORDER == B_ENDIAN) {
+		BLI_endian_switch_uint64(&footer->table_offset);
+		BLI_endian_switch_uint64(&footer->table_len);
+	}
+}
+
+static bool chunkfile_read_exact(int file, void *buffer, size_t size)
+{
+	char *buf = buffer;
+
+	while (size) {
+		const int readsize = read(file, buf, (unsigned int)MIN2(size, INT_MAX));
+		if (readsize <= 0) {
+			return false;
+		}
+		buf += readsize;
+		size -= (size_t)readsize;
+	}
+
+	return true;
+}
+
+static bool chunkfile_write_exact(int file, const void *buffer, size_t size)
+{
+	const char *buf = buffer;
+
+	while (size) {
+		const int writesize = write(file, buf, (unsigned int)MIN2(size, INT_MAX));
+		if (writesize <= 0) {
+			return false;
+		}
+		buf += writesize;
+		size -= (size_t)writesize;
+	}
+
+	return true;
+}
+
+/* Compressed chunks must fit in this size, worst case of both codecs (see LZO documentation). */
+static size_t chunkfile_compress_bound(const size_t size)
+{
+	return size + size / 16 + 64 + 3;
+}
+
+/**
+ * \return The compressed size, or zero when the chunk couldn't be made smaller.
+ */
+static size_t chunkfile_compress(
+        const int codec, const char *in, const size_t in_len, char *out)
+{
+	size_t out_len = 0;
+
+	switch (codec) {
+		case CHUNKFILE_CODEC_ZLIB:
+		{
+			uLongf dest_len = (uLongf)chunkfile_compress_bound(in_len);
+			if (compress2((Bytef *)out, &dest_len, (const Bytef *)in, (uLong)in_len, Z_BEST_SPEED) == Z_OK) {
+				out_len = (size_t)dest_len;
+			}
+			break;
+		}
+#ifdef WITH_LZO
+		case CHUNKFILE_CODEC_LZO:
+		{
+			void *wrkmem = MEM_mallocN(LZO1X_MEM_COMPRESS, __func__);
+			lzo_uint dest_len = 0;
+			if (lzo1x_1_compress((const lzo_bytep)in, (lzo_uint)in_len, (lzo_bytep)out, &dest_len, wrkmem) == LZO_E_OK) {
+				out_len = (size_t)dest_len;
+			}
+			MEM_freeN(wrkmem);
+			break;
+		}
+#endif
+		default:
+			BLI_assert(0);
+			break;
+	}
+
+	return (out_len < in_len) ? out_len : 0;
+}
+
+static bool chunkfile_decompress(
+        const int codec, const char *in, const size_t in_len, char *out, const size_t out_len)
+{
+	switch (codec) {
+		case CHUNKFILE_CODEC_ZLIB:
+		{
+			uLongf dest_len = (uLongf)out_len;
+			return ((uncompress((Bytef *)out, &dest_len, (const Bytef *)in, (uLong)in_len) == Z_OK) &&
+			        (dest_len == out_len));
+		}
+#ifdef WITH_LZO
+		case CHUNKFILE_CODEC_LZO:
+		{
+			lzo_uint dest_len = (lzo_uint)out_len;
+			return ((lzo1x_decompress_safe((const lzo_bytep)in, (lzo_uint)in_len, (lzo_bytep)out, &dest_len, NULL) ==
+			         LZO_E_OK) &&
+			        (dest_len == out_len));
+		}
+#endif
+		default:
+			return false;
+	}
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Writing
+ *
+ * Data is gathered in a batch of chunks (one per thread), which are compressed in parallel
+ * once the batch is full, and written to the file in order.
+ * \{ */
+
+struct ChunkFileWriter {
+	int file;
+	int codec;
+
+	/* Uncompressed data of the current batch. */
+	char *batch;
+	size_t batch_used;
+	unsigned int batch_len;
+
+	/* Compressed chunks of the current batch, each one has #chunkfile_compress_bound bytes. */
+	char *batch_compressed;
+	size_t *batch_compressed_size;
+
+	ChunkFileEntry *table;
+	uint64_t table_len;
+	uint64_t table_alloc;
+
+	uint64_t offset;
+	bool error;
+};
+
+static void chunkfile_writer_compress_cb(void *userdata, const int index)
+{
+	ChunkFileWriter *cw = userdata;
+	const size_t offset = (size_t)index * CHUNKFILE_CHUNK_SIZE;
+	const size_t size = MIN2(cw->batch_used - offset, CHUNKFILE_CHUNK_SIZE);
+
+	cw->batch_compressed_size[index] = chunkfile_compress(
+	        cw->codec, cw->batch + offset, size,
+	        cw->batch_compressed + (size_t)index * chunkfile_compress_bound(CHUNKFILE_CHUNK_SIZE));
+}
+
+/* Compress the current batch and write it to the file. */
+static void chunkfile_writer_flush(ChunkFileWriter *cw)
+{
+	const int chunks_num = (int)((cw->batch_used + CHUNKFILE_CHUNK_SIZE - 1) / CHUNKFILE_CHUNK_SIZE);
+	int i;
+
+	if (chunks_num == 0 || cw->error) {
+		return;
+	}
+
+	BLI_task_parallel_range(0, chunks_num, cw, chunkfile_writer_compress_cb, chunks_num > 1);
+
+	if (cw->table_len + (uint64_t)chunks_num > cw->table_alloc) {
+		cw->table_alloc = (cw->table_len + (uint64_t)chunks_num) * 2;
+		cw->table = MEM_reallocN(cw->table, sizeof(*cw->table) * cw->table_alloc);
+	}
+
+	for (i = 0; i < chunks_num; i++) {
+		const size_t offset = (size_t)i * CHUNKFILE_CHUNK_SIZE;
+		const size_t size = MIN2(cw->batch_used - offset, CHUNKFILE_CHUNK_SIZE);
+		const size_t size_compressed = cw->batch_compressed_size[i];
+		ChunkFileEntry *entry = &cw->table[cw->table_len++];
+		bool ok;
+
+		if (size_compressed) {
+			ok = chunkfile_write_exact(
+			        cw->file, cw->batch_compressed + (size_t)i * chunkfile_compress_bound(CHUNKFILE_CHUNK_SIZE),
+			        size_compressed);
+		}
+		else {
+			ok = chunkfile_write_exact(cw->file, cw->batch + offset, size);
+		}
+
+		if (!ok) {
+			cw->error = true;
+			break;
+		}
+
+		entry->offset = cw->offset;
+		entry->size_compressed = (uint32_t)(size_compressed ? size_compressed : size);
+		entry->size = (uint32_t)size;
+		cw->offset += entry->size_compressed;
+	}
+
+	cw->batch_used = 0;
+}
+
+ChunkFileWriter *blo_chunkfile_writer_open(const char *filepath)
+{
+	ChunkFileWriter *cw;
+	ChunkFileHeader header = {{0}};
+	int file;
+
+	file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
+	if (file == -1) {
+		return NULL;
+	}
+
+	cw = MEM_callocN(sizeof(*cw), __func__);
+	cw->file = file;
+#ifdef WITH_LZO
+	cw->codec = CHUNKFILE_CODEC_LZO;
+#else
+	cw->codec = CHUNKFILE_CODEC_ZLIB;
+#endif
+	cw->batch_len = (unsigned int)MAX2(BLI_system_thread_count(), 1);
+	cw->batch = MEM_mallocN((size_t)cw->batch_len * CHUNKFILE_CHUNK_SIZE, "chunkfile batch");
+	cw->batch_compressed = MEM_mallocN(
+	        (size_t)cw->batch_len * chunkfile_compress_bound(CHUNKFILE_CHUNK_SIZE), "chunkfile batch compressed");
+	cw->batch_compressed_size = MEM_mallocN(sizeof(size_t) * cw->batch_len, "chunkfile batch sizes");
+
+	memcpy(header.magic, BLO_CHUNKFILE_MAGIC, sizeof(header.magic));
+	header.version = CHUNKFILE_VERSION;
+	header.codec = (uint32_t)cw->codec;
+	header.chunk_size = CHUNKFILE_CHUNK_SIZE;
+	chunkfile_header_switch_endian(&header);
+
+	if (!chunkfile_write_exact(file, &header, sizeof(header))) {
+		cw->error = true;
+	}
+	cw->offset = sizeof(header);
+
+	return cw;
+}
+
+bool blo_chunkfile_writer_write(ChunkFileWriter *cw, const char *data, size_t data_len)
+{
+	const size_t batch_size = (size_t)cw->batch_len * CHUNKFILE_CHUNK_SIZE;
+
+	while (data_len && !cw->error) {
+		const size_t len = MIN2(data_len, batch_size - cw->batch_used);
+
+		memcpy(cw->batch + cw->batch_used, data, len);
+		cw->batch_used += len;
+		data += len;
+		data_len -= len;
+
+		if (cw->batch_used == batch_size) {
+			chunkfile_writer_flush(cw);
+		}
+	}
+
+	return !cw->error;
+}
+
+/**
+ * Write the remaining data and the table of chunks, and free the writer.
+ *
+ * \return Success.
+ */
+bool blo_chunkfile_writer_close(ChunkFileWriter *cw)
+{
+	ChunkFileFooter footer;
+	bool ok;
+
+	chunkfile_writer_flush(cw);
+
+	footer.table_offset = cw->offset;
+	footer.table_len = cw->table_len;
+	chunkfile_table_switch_endian(cw->table, cw->table_len);
+	chunkfile_footer_switch_endian(&footer);
+
+	ok = (!cw->error &&
+	      (cw->table_len == 0 || chunkfile_write_exact(cw->file, cw->table, sizeof(*cw->table) * cw->table_len)) &&
+	      chunkfile_write_exact(cw->file, &footer, sizeof(footer)));
+	ok = (close(cw->file) != -1) && ok;
+
+	MEM_SAFE_FREE(cw->table);
+	MEM_freeN(cw->batch);
+	MEM_freeN(cw->batch_compressed);
+	MEM_freeN(cw->batch_compressed_size);
+	MEM_freeN(cw);
+
+	return ok;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Reading
+ *
+ * Decompressed chunks are kept in a window, which is decompressed in parallel.
+ * \{ */
+
+struct ChunkFileReader {
+	int file;
+	int codec;
+	unsigned int chunk_size;
+
+	ChunkFileEntry *table;
+	uint64_t table_len;
+
+	/* Position in the uncompressed data. */
+	uint64_t size;
+	uint64_t seek;
+
+	/* Decompressed chunks [window_first, window_first + window_len). */
+	char *window;
+	uint64_t window_first;
+	unsigned int window_len;
+	unsigned int window_alloc;
+	/* Number of chunks decompressed at once, doubled on every sequential read. */
+	unsigned int readahead;
+	unsigned int readahead_max;
+
+	char *compressed;
+	size_t compressed_alloc;
+
+	bool error;
+};
+
+static void chunkfile_reader_decompress_cb(void *userdata, const int index)
+{
+	ChunkFileReader *cr = userdata;
+	const ChunkFileEntry *entry_first = &cr->table[cr->window_first];
+	const ChunkFileEntry *entry = &entry_first[index];
+	const char *in = cr->compressed + (entry->offset - entry_first->offset);
+	char *out = cr->window + (size_t)index * cr->chunk_size;
+
+	if (entry->size_compressed == entry->size) {
+		memcpy(out, in, entry->size);
+	}
+	else if (!chunkfile_decompress(cr->codec, in, entry->size_compressed, out, entry->size)) {
+		cr->error = true;
+	}
+}
+
+/* Decompress the chunks from given one, in the window. */
+static bool chunkfile_reader_window_load(ChunkFileReader *cr, const uint64_t chunk_first)
+{
+	const ChunkFileEntry *entry_first = &cr->table[chunk_first];
+	const ChunkFileEntry *entry_last;
+	unsigned int chunks_num;
+	size_t compressed_size;
+
+	if (cr->window_len && chunk_first == cr->window_first + cr->window_len) {
+		cr->readahead = MIN2(cr->readahead * 2, cr->readahead_max);
+	}
+	else {
+		cr->readahead = 1;
+	}
+
+	chunks_num = (unsigned int)MIN2((uint64_t)cr->readahead, cr->table_len - chunk_first);
+	entry_last = &entry_first[chunks_num - 1];
+	/* chunks are contiguous in the file, checked when opening */
+	compressed_size = (size_t)(entry_last->offset + entry_last->size_compressed - entry_first->offset);
+
+	if (compressed_size > cr->compressed_alloc) {
+		MEM_SAFE_FREE(cr->compressed);
+		cr->compressed = MEM_mallocN(compressed_size, "chunkfile compressed");
+		cr->compressed_alloc = compressed_size;
+	}
+	if (chunks_num > cr->window_alloc) {
+		MEM_SAFE_FREE(cr->window);
+		cr->window = MEM_mallocN((size_t)chunks_num * cr->chunk_size, "chunkfile window");
+		cr->window_alloc = chunks_num;
+	}
+
+	cr->window_first = chunk_first;
+	cr->window_len = 0;
+
+	if ((chunkfile_lseek(cr->file, (off_t)entry_first->offset, SEEK_SET) == -1) ||
+	    !chunkfile_read_exact(cr->file, cr->compressed, compressed_size))
+	{
+		return false;
+	}
+
+	BLI_task_parallel_range(0, (int)chunks_num, cr, chunkfile_reader_decompress_cb, chunks_num > 1);
+
+	if (cr->error) {
+		return false;
+	}
+
+	cr->window_len = chunks_num;
+	return true;
+}
+
+/**
+ * Open a file written with #blo_chunkfile_writer_open.
+ *
+ * \return NULL when the file can't be opened, \a r_error is only set when the file
+ * uses the chunked format but can't be read.
+ */
+ChunkFileReader *blo_chunkfile_reader_open(const char *filepath, const char **r_error)
+{
+	ChunkFileReader *cr;
+	ChunkFileHeader header;
+	ChunkFileFooter footer;
+	off_t file_size;
+	uint64_t i;
+	int file;
+
+	*r_error = NULL;
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1) {
+		return NULL;
+	}
+
+	if (!chunkfile_read_exact(file, &header, sizeof(header)) ||
+	    !STREQLEN(header.magic, BLO_CHUNKFILE_MAGIC, sizeof(header.magic)))
+	{
+		close(file);
+		return NULL;
+	}
+
+	chunkfile_header_switch_endian(&header);
+
+	if (header.version != CHUNKFILE_VERSION) {
+		*r_error = "unsupported version of compressed file";
+	}
+	else if (!ELEM(header.codec, CHUNKFILE_CODEC_ZLIB, CHUNKFILE_CODEC_LZO)) {
+		*r_error = "unknown compression";
+	}
+#ifndef WITH_LZO
+	else if (header.codec == CHUNKFILE_CODEC_LZO) {
+		*r_error = "file compressed with LZO, which is not supported by this build";
+	}
+#endif
+	else if (header.chunk_size == 0 || header.chunk_size > CHUNKFILE_CHUNK_SIZE_MAX) {
+		*r_error = "invalid chunk size";
+	}
+
+	if (*r_error) {
+		close(file);
+		return NULL;
+	}
+
+	file_size = chunkfile_lseek(file, -(off_t)sizeof(footer), SEEK_END);
+	if (file_size == -1 || !chunkfile_read_exact(file, &footer, sizeof(footer))) {
+		*r_error = "truncated compressed file";
+		close(file);
+		return NULL;
+	}
+	chunkfile_footer_switch_endian(&footer);
+
+	if ((footer.table_offset < sizeof(header)) ||
+	    (footer.table_offset > (uint64_t)file_size) ||
+	    (footer.table_len != ((uint64_t)file_size - footer.table_offset) / sizeof(ChunkFileEntry)) ||
+	    (((uint64_t)file_size - footer.table_offset) % sizeof(ChunkFileEntry) != 0))
+	{
+		*r_error = "invalid table of compressed chunks";
+		close(file);
+		return NULL;
+	}
+
+	cr = MEM_callocN(sizeof(*cr), __func__);
+	cr->file = file;
+	cr->codec = (int)header.codec;
+	cr->chunk_size = header.chunk_size;
+	cr->table_len = footer.table_len;
+	cr->readahead_max = (unsigned int)MAX2(BLI_system_thread_count(), 1);
+
+	if (cr->table_len) {
+		cr->table = MEM_mallocN(sizeof(*cr->table) * cr->table_len, "chunkfile table");
+		if ((chunkfile_lseek(file, (off_t)footer.table_offset, SEEK_SET) == -1) ||
+		    !chunkfile_read_exact(file, cr->table, sizeof(*cr->table) * cr->table_len))
+		{
+			*r_error = "truncated compressed file";
+		}
+		chunkfile_table_switch_endian(cr->table, cr->table_len);
+	}
+
+	/* Chunks must be contiguous and all full except for the last one,
+	 * so the chunk of a position in the uncompressed data is known directly. */
+	for (i = 0; i < cr->table_len && *r_error == NULL; i++) {
+		const ChunkFileEntry *entry = &cr->table[i];
+		const uint64_t offset_expect = i ? cr->table[i - 1].offset + cr->table[i - 1].size_compressed : sizeof(header);
+		const bool is_last = (i == cr->table_len - 1);
+
+		if ((entry->offset != offset_expect) ||
+		    (entry->size_compressed > entry->size) ||
+		    (is_last ? (entry->size == 0 || entry->size > cr->chunk_size) : (entry->size != cr->chunk_size)) ||
+		    (is_last && (entry->offset + entry->size_compressed != footer.table_offset)))
+		{
+			*r_error = "invalid table of compressed chunks";
+		}
+		cr->size += entry->size;
+	}
+
+	if (*r_error) {
+		blo_chunkfile_reader_close(cr);
+		return NULL;
+	}
+
+	return cr;
+}
+
+/**
+ * Read the next \a size bytes of uncompressed data, behaves like read().
+ */
+int blo_chunkfile_reader_read(ChunkFileReader *cr, void *buffer, unsigned int size)
+{
+	char *buf = buffer;
+	unsigned int readsize = 0;
+
+	while ((readsize < size) && (cr->seek < cr->size)) {
+		const uint64_t chunk = cr->seek / cr->chunk_size;
+		uint64_t window_offset, window_size;
+		size_t len;
+
+		if ((cr->window_len == 0) || (chunk < cr->window_first) || (chunk >= cr->window_first + cr->window_len)) {
+			if (!chunkfile_reader_window_load(cr, chunk)) {
+				return -1;
+			}
+		}
+
+		window_offset = cr->seek - cr->window_first * cr->chunk_size;
+		window_size = (uint64_t)(cr->window_len - 1) * cr->chunk_size +
+		              cr->table[cr->window_first + cr->window_len - 1].size;
+		len = (size_t)MIN2((uint64_t)(size - readsize), window_size - window_offset);
+
+		memcpy(buf + readsize, cr->window + window_offset, len);
+		readsize += (unsigned int)len;
+		cr->seek += len;
+	}
+
+	return (int)readsize;
+}
+
+/**
+ * Move the read position in the uncompressed data, only the chunks at the new position are decompressed.
+ */
+bool blo_chunkfile_reader_seek(ChunkFileReader *cr, const uint64_t offset)
+{
+	if (offset > cr->size) {
+		return false;
+	}
+
+	cr->seek = offset;
+	return true;
+}
+
+/**
+ * Size of the uncompressed data.
+ */
+uint64_t blo_chunkfile_reader_size(const ChunkFileReader *cr)
+{
+	return cr->size;
+}
+
+void blo_chunkfile_reader_close(ChunkFileReader *cr)
+{
+	close(cr->file);
+	MEM_SAFE_FREE(cr->table);
+	MEM_SAFE_FREE(cr->window);
+	MEM_SAFE_FREE(cr->compressed);
+	MEM_freeN(cr);
+}
+
+/** \} */
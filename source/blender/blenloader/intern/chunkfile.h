@@ -0,0 +1,42 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ * blenloader chunked compression private function prototypes
+ */
+
+/** \file blender/blenloader/intern/chunkfile.h
+ *  \ingroup blenloader
+ */
+
+#ifndef __CHUNKFILE_H__
+#define __CHUNKFILE_H__
+
+typedef struct ChunkFileWriter ChunkFileWriter;
+typedef struct ChunkFileReader ChunkFileReader;
+
+ChunkFileWriter *blo_chunkfile_writer_open(const char *filepath);
+bool blo_chunkfile_writer_write(ChunkFileWriter *cw, const char *data, size_t data_len);
+bool blo_chunkfile_writer_close(ChunkFileWriter *cw);
+
+ChunkFileReader *blo_chunkfile_reader_open(const char *filepath, const char **r_error);
+int blo_chunkfile_reader_read(ChunkFileReader *cr, void *buffer, unsigned int size);
+bool blo_chunkfile_reader_seek(ChunkFileReader *cr, const uint64_t offset);
+uint64_t blo_chunkfile_reader_size(const ChunkFileReader *cr);
+void blo_chunkfile_reader_close(ChunkFileReader *cr);
+
+#endif  /* __CHUNKFILE_H__ */
@@ -83,7 +83,7 @@ BlendHandle *BLO_blendhandle_from_file(const char *filepath, ReportList *reports
 {
 	BlendHandle *bh;
 
-	bh = (BlendHandle *)blo_openblenderfile(filepath, reports);
+	bh = (BlendHandle *)blo_openblenderfile_for_link(filepath, reports);
 
 	return bh;
 }
@@ -214,7 +214,7 @@ LinkNode *BLO_blendhandle_get_previews(BlendHandle *bh, int ofblocktype, int *to
 							size_t len = new_prv->w[0] * new_prv->h[0] * sizeof(unsigned int);
 							new_prv->rect[0] = MEM_callocN(len, __func__);
 							bhead = blo_nextbhead(fd, bhead);
-							rect = (unsigned int *)(bhead + 1);
+							rect = BHEAD_DATA(bhead);
 							BLI_assert(len == bhead->len);
 							memcpy(new_prv->rect[0], rect, len);
 						}
@@ -231,7 +231,7 @@ LinkNode *BLO_blendhandle_get_previews(BlendHandle *bh, int ofblocktype, int *to
 							size_t len = new_prv->w[1] * new_prv->h[1] * sizeof(unsigned int);
 							new_prv->rect[1] = MEM_callocN(len, __func__);
 							bhead = blo_nextbhead(fd, bhead);
-							rect = (unsigned int *)(bhead + 1);
+							rect = BHEAD_DATA(bhead);
 							BLI_assert(len == bhead->len);
 							memcpy(new_prv->rect[1], rect, len);
 						}
@@ -367,9 +367,12 @@ BlendFileData *BLO_read_from_memory(
  *
  * \param oldmain old main, from which we will keep libraries and other datablocks that should not have changed.
  * \param filename current file, only for retrieving library data.
+ * \param memfile_oldmain \a oldmain written to a memfile compared with \a memfile (can be NULL).
+ * Its IDs which are unchanged in \a memfile are kept as is instead of being read again (tagged
+ * #LIB_TAG_UNDO_OLD_ID_REUSED), the other ones are read at the same address.
  */
 BlendFileData *BLO_read_from_memfile(
-        Main *oldmain, const char *filename, MemFile *memfile,
+        Main *oldmain, const char *filename, MemFile *memfile, const MemFile *memfile_oldmain,
         ReportList *reports, eBLOReadSkip skip_flags)
 {
 	BlendFileData *bfd = NULL;
@@ -382,6 +385,10 @@ BlendFileData *BLO_read_from_memfile(
 		fd->skip_flags = skip_flags;
 		BLI_strncpy(fd->relabase, filename, sizeof(fd->relabase));
 		
+		if (memfile_oldmain) {
+			fd->undo_old_ids = BLO_memfile_compare_ids(memfile, memfile_oldmain);
+		}
+
 		/* clear ob->proxy_from pointers in old main */
 		blo_clear_proxy_pointers_from_lib(oldmain);
 
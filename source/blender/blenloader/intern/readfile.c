@@ -45,6 +45,8 @@
 #include "BLI_utildefines.h"
 #ifndef WIN32
 #  include <unistd.h> // for read close
+#  include <sys/mman.h> // for mmap
+#  include <sys/stat.h> // for fstat
 #else
 #  include <io.h> // for open close read
 #  include "winsock2.h"
@@ -109,6 +111,7 @@
 #include "BLI_math.h"
 #include "BLI_threads.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -159,6 +162,7 @@
 #include "RE_engine.h"
 
 #include "readfile.h"
+#include "chunkfile.h"
 
 
 #include <errno.h>
@@ -219,6 +223,11 @@
 /* Use GHash for restoring pointers by name */
 #define USE_GHASH_RESTORE_POINTER
 
+/* Memory map uncompressed files, blocks then point into the mapping instead of being read in memory */
+#ifndef WIN32
+#  define USE_BHEAD_MMAP
+#endif
+
 /***/
 
 typedef struct OldNew {
@@ -237,10 +246,12 @@ typedef struct OldNewMap {
 
 /* local prototypes */
 static void *read_struct(FileData *fd, BHead *bh, const char *blockname);
+static const char *dataname(short id_code);
 static void direct_link_modifiers(FileData *fd, ListBase *lb);
 static void convert_tface_mt(FileData *fd, Main *main);
 static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const char *name);
 static BHead *find_bhead_from_idname(FileData *fd, const char *idname);
+static BHead *blo_bhead_from_offset(FileData *fd, const uint64_t offset);
 
 /* this function ensures that reports are printed,
  * in the case of libraray linking errors this is important!
@@ -552,7 +563,10 @@ static void read_file_version(FileData *fd, Main *main)
 {
 	BHead *bhead;
 	
-	for (bhead= blo_firstbhead(fd); bhead; bhead= blo_nextbhead(fd, bhead)) {
+	/* with the ID index, go to the GLOB block directly instead of reading the whole file */
+	bhead = fd->index ? blo_bhead_from_offset(fd, fd->index_glob_offset) : blo_firstbhead(fd);
+
+	for (; bhead; bhead= blo_nextbhead(fd, bhead)) {
 		if (bhead->code == GLOB) {
 			FileGlobal *fg= read_struct(fd, bhead, "Global");
 			if (fg) {
@@ -563,6 +577,10 @@ static void read_file_version(FileData *fd, Main *main)
 			}
 			else if (bhead->code == ENDB)
 				break;
+
+			if (fd->index) {
+				break;
+			}
 		}
 	}
 	if (main->curlib) {
@@ -581,6 +599,11 @@ static void read_file_bhead_idname_map_create(FileData *fd)
 	int code_prev = ENDB;
 	unsigned int reserve = 0;
 
+	if (fd->index) {
+		/* uses fd->index_idname_hash, see read_file_index */
+		return;
+	}
+
 	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
 		if (code_prev != bhead->code) {
 			code_prev = bhead->code;
@@ -788,21 +811,44 @@ static BHeadN *get_bhead(FileData *fd)
 			 * the associated data and put everything in a BHeadN (creative naming !)
 			 */
 			if (!fd->eof) {
-				new_bhead = MEM_mallocN(sizeof(BHeadN) + bhead.len, "new_bhead");
-				if (new_bhead) {
-					new_bhead->next = new_bhead->prev = NULL;
-					new_bhead->bhead = bhead;
-					
-					readsize = fd->read(fd, new_bhead + 1, bhead.len);
-					
-					if (readsize != bhead.len) {
+#ifdef USE_BHEAD_MMAP
+				if (fd->mmap_buffer) {
+					/* no copy, the data stays in the mapping until it's read */
+					if ((size_t)bhead.len <= fd->mmap_size - fd->mmap_seek) {
+						new_bhead = MEM_mallocN(sizeof(BHeadN), "new_bhead");
+						new_bhead->next = new_bhead->prev = NULL;
+						new_bhead->offset = 0;
+						new_bhead->data = fd->mmap_buffer + fd->mmap_seek;
+						new_bhead->data_read = NULL;
+						new_bhead->bhead = bhead;
+						fd->mmap_seek += (size_t)bhead.len;
+					}
+					else {
 						fd->eof = 1;
-						MEM_freeN(new_bhead);
-						new_bhead = NULL;
 					}
 				}
-				else {
-					fd->eof = 1;
+				else
+#endif
+				{
+					new_bhead = MEM_mallocN(sizeof(BHeadN) + bhead.len, "new_bhead");
+					if (new_bhead) {
+						new_bhead->next = new_bhead->prev = NULL;
+						new_bhead->offset = 0;
+						new_bhead->data = new_bhead + 1;
+						new_bhead->data_read = NULL;
+						new_bhead->bhead = bhead;
+
+						readsize = fd->read(fd, new_bhead + 1, bhead.len);
+
+						if (readsize != bhead.len) {
+							fd->eof = 1;
+							MEM_freeN(new_bhead);
+							new_bhead = NULL;
+						}
+					}
+					else {
+						fd->eof = 1;
+					}
 				}
 			}
 		}
@@ -818,11 +864,84 @@ static BHeadN *get_bhead(FileData *fd)
 	return(new_bhead);
 }
 
+static bool fd_seek(FileData *fd, const uint64_t offset)
+{
+#ifdef USE_BHEAD_MMAP
+	if (fd->mmap_buffer) {
+		if (offset > fd->mmap_size) {
+			return false;
+		}
+		fd->mmap_seek = (size_t)offset;
+		return true;
+	}
+#endif
+	if (fd->chunkfile) {
+		return blo_chunkfile_reader_seek(fd->chunkfile, offset);
+	}
+	return false;
+}
+
+/* Size of files which can be seeked, else zero. */
+static uint64_t fd_size(FileData *fd)
+{
+#ifdef USE_BHEAD_MMAP
+	if (fd->mmap_buffer) {
+		return fd->mmap_size;
+	}
+#endif
+	if (fd->chunkfile) {
+		return blo_chunkfile_reader_size(fd->chunkfile);
+	}
+	return 0;
+}
+
+static unsigned int bhead_offset_hash(const void *key)
+{
+	const uint64_t offset = *(const uint64_t *)key;
+	return BLI_ghashutil_uinthash((unsigned int)(offset ^ (offset >> 32)));
+}
+
+static bool bhead_offset_cmp(const void *a, const void *b)
+{
+	return (*(const uint64_t *)a != *(const uint64_t *)b);
+}
+
+/**
+ * Read the block at given offset in the file, when reading with the ID index (see read_file_index).
+ * Blocks are read in any order, but only once.
+ */
+static BHead *blo_bhead_from_offset(FileData *fd, const uint64_t offset)
+{
+	BHeadN *new_bhead = BLI_ghash_lookup(fd->bhead_offset_hash, &offset);
+
+	if (new_bhead == NULL) {
+		if (!fd_seek(fd, offset)) {
+			return NULL;
+		}
+
+		fd->eof = 0;
+		new_bhead = get_bhead(fd);
+		if (new_bhead == NULL) {
+			return NULL;
+		}
+
+		new_bhead->offset = offset;
+		BLI_ghash_insert(fd->bhead_offset_hash, &new_bhead->offset, new_bhead);
+	}
+
+	return &new_bhead->bhead;
+}
+
 BHead *blo_firstbhead(FileData *fd)
 {
 	BHeadN *new_bhead;
 	BHead *bhead = NULL;
 	
+	if (fd->index) {
+		/* the list isn't in file order */
+		return blo_bhead_from_offset(fd, SIZEOFBLENDERHEADER);
+	}
+
 	/* Rewind the file
 	 * Read in a new block if necessary
 	 */
@@ -838,10 +957,14 @@ BHead *blo_firstbhead(FileData *fd)
 	return(bhead);
 }
 
-BHead *blo_prevbhead(FileData *UNUSED(fd), BHead *thisblock)
+BHead *blo_prevbhead(FileData *fd, BHead *thisblock)
 {
-	BHeadN *bheadn = (BHeadN *)POINTER_OFFSET(thisblock, -offsetof(BHeadN, bhead));
+	BHeadN *bheadn = BHEADN_FROM_BHEAD(thisblock);
 	BHeadN *prev = bheadn->prev;
+
+	/* not supported when reading with the ID index, see find_previous_lib */
+	BLI_assert(fd->index == NULL);
+	UNUSED_VARS_NDEBUG(fd);
 	
 	return (prev) ? &prev->bhead : NULL;
 }
@@ -851,10 +974,16 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock)
 	BHeadN *new_bhead = NULL;
 	BHead *bhead = NULL;
 	
+	if (thisblock && fd->index) {
+		/* blocks follow each other in the file */
+		new_bhead = BHEADN_FROM_BHEAD(thisblock);
+		return blo_bhead_from_offset(fd, new_bhead->offset + sizeof(BHead) + (uint64_t)thisblock->len);
+	}
+
 	if (thisblock) {
 		/* bhead is actually a sub part of BHeadN
 		 * We calculate the BHeadN pointer from the BHead pointer below */
-		new_bhead = (BHeadN *)POINTER_OFFSET(thisblock, -offsetof(BHeadN, bhead));
+		new_bhead = BHEADN_FROM_BHEAD(thisblock);
 		
 		/* get the next BHeadN. If it doesn't exist we read in the next one */
 		new_bhead = new_bhead->next;
@@ -875,7 +1004,7 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock)
 /* Warning! Caller's responsability to ensure given bhead **is** and ID one! */
 const char *bhead_id_name(const FileData *fd, const BHead *bhead)
 {
-	return (const char *)POINTER_OFFSET(bhead, sizeof(*bhead) + fd->id_name_offs);
+	return (const char *)POINTER_OFFSET(BHEAD_DATA(bhead), fd->id_name_offs);
 }
 
 static void decode_blender_header(FileData *fd)
@@ -925,14 +1054,17 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
 {
 	BHead *bhead;
 	
-	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
+	/* with the ID index, go to the DNA block directly instead of reading the whole file */
+	bhead = fd->index ? blo_bhead_from_offset(fd, fd->index_dna_offset) : blo_firstbhead(fd);
+
+	for (; bhead; bhead = blo_nextbhead(fd, bhead)) {
 		if (bhead->code == DNA1) {
 			const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
 			
-			fd->filesdna = DNA_sdna_from_data(&bhead[1], bhead->len, do_endian_swap, true, r_error_message);
+			fd->filesdna = DNA_sdna_from_data(BHEAD_DATA(bhead), bhead->len, do_endian_swap, true, r_error_message);
 			if (fd->filesdna) {
 				fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
-				/* used to retrieve ID names from (bhead+1) */
+				/* used to retrieve ID names from the ID blocks data */
 				fd->id_name_offs = DNA_elem_offset(fd->filesdna, "ID", "char", "name[]");
 
 				return true;
@@ -950,6 +1082,90 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
 	return false;
 }
 
+static int verg_index_entry_old(const void *v1, const void *v2)
+{
+	const BlendIndexEntry *x1 = v1, *x2 = v2;
+
+	if (x1->old > x2->old) return 1;
+	else if (x1->old < x2->old) return -1;
+	return 0;
+}
+
+/**
+ * Read the ID index written at the end of files (see #BlendIndexEntry), when the file can be seeked.
+ * Blocks are then only read when they're needed, starting from the offsets in the index.
+ */
+static void read_file_index(FileData *fd)
+{
+	const uint64_t size = fd_size(fd);
+	BlendIndexFooter footer;
+	uint64_t footer_offset, index_offset;
+	BHead *bhead;
+	unsigned int i;
+
+	/* the index uses the pointer size and endianness of the file */
+	if ((fd->flags & (FD_FLAGS_SWITCH_ENDIAN | FD_FLAGS_POINTSIZE_DIFFERS)) ||
+	    (size < SIZEOFBLENDERHEADER + 2 * sizeof(BHead) + sizeof(footer)))
+	{
+		return;
+	}
+
+	footer_offset = size - sizeof(BHead) - sizeof(footer);
+	if (!fd_seek(fd, footer_offset) ||
+	    (fd->read(fd, &footer, sizeof(footer)) != sizeof(footer)) ||
+	    !STREQLEN(footer.magic, BLEND_INDEX_MAGIC, sizeof(footer.magic)) ||
+	    (footer.entries_len > (footer_offset - SIZEOFBLENDERHEADER - sizeof(BHead)) / sizeof(BlendIndexEntry)) ||
+	    (footer.dna_offset < SIZEOFBLENDERHEADER) || (footer.dna_offset >= footer_offset) ||
+	    (footer.glob_offset < SIZEOFBLENDERHEADER) || (footer.glob_offset >= footer_offset))
+	{
+		fd_seek(fd, SIZEOFBLENDERHEADER);
+		return;
+	}
+
+	fd->bhead_offset_hash = BLI_ghash_new(bhead_offset_hash, bhead_offset_cmp, __func__);
+
+	index_offset = footer_offset - footer.entries_len * sizeof(BlendIndexEntry);
+	bhead = blo_bhead_from_offset(fd, index_offset - sizeof(BHead));
+	if ((bhead == NULL) || (bhead->code != DATA) ||
+	    ((uint64_t)bhead->len != footer.entries_len * sizeof(BlendIndexEntry) + sizeof(footer)))
+	{
+		/* not a valid index, read the file as usual */
+		BLI_ghash_free(fd->bhead_offset_hash, NULL, NULL);
+		fd->bhead_offset_hash = NULL;
+		BLI_freelistN(&fd->listbase);
+		fd->eof = 0;
+		fd_seek(fd, SIZEOFBLENDERHEADER);
+		return;
+	}
+
+	fd->index_len = (unsigned int)footer.entries_len;
+	fd->index_dna_offset = footer.dna_offset;
+	fd->index_glob_offset = footer.glob_offset;
+	fd->index = MEM_mallocN(sizeof(*fd->index) * MAX2(fd->index_len, 1), "BlendIndexEntry");
+	memcpy(fd->index, BHEAD_DATA(bhead), sizeof(*fd->index) * fd->index_len);
+
+	/* sorted for find_bhead */
+	qsort(fd->index, fd->index_len, sizeof(*fd->index), verg_index_entry_old);
+
+	/* see: USE_GHASH_BHEAD, same as read_file_bhead_idname_map_create */
+	fd->index_idname_hash = BLI_ghash_str_new_ex(__func__, fd->index_len);
+	for (i = 0; i < fd->index_len; i++) {
+		BlendIndexEntry *entry = &fd->index[i];
+		entry->name[sizeof(entry->name) - 1] = '\0';
+		if (BKE_idcode_is_valid(entry->code) && BKE_idcode_is_linkable(entry->code)) {
+			BLI_ghash_insert(fd->index_idname_hash, entry->name, entry);
+		}
+	}
+}
+
+static BlendIndexEntry *read_file_index_find_old(FileData *fd, const void *old)
+{
+	BlendIndexEntry entry_s;
+
+	entry_s.old = (uint64_t)(uintptr_t)old;
+	return bsearch(&entry_s, fd->index, fd->index_len, sizeof(*fd->index), verg_index_entry_old);
+}
+
 static int *read_file_thumbnail(FileData *fd)
 {
 	BHead *bhead;
@@ -958,7 +1174,7 @@ static int *read_file_thumbnail(FileData *fd)
 	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
 		if (bhead->code == TEST) {
 			const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
-			int *data = (int *)(bhead + 1);
+			int *data = BHEAD_DATA(bhead);
 
 			if (bhead->len < (2 * sizeof(int))) {
 				break;
@@ -1024,6 +1240,33 @@ static int fd_read_from_memory(FileData *filedata, void *buffer, unsigned int si
 	return (readsize);
 }
 
+static int fd_read_from_chunkfile(FileData *filedata, void *buffer, unsigned int size)
+{
+	int readsize = blo_chunkfile_reader_read(filedata->chunkfile, buffer, size);
+
+	if (readsize < 0) {
+		readsize = EOF;
+	}
+	else {
+		filedata->seek += readsize;
+	}
+
+	return (readsize);
+}
+
+#ifdef USE_BHEAD_MMAP
+static int fd_read_from_mmap(FileData *filedata, void *buffer, unsigned int size)
+{
+	/* don't read more bytes then there are available in the mapping */
+	const size_t readsize = MIN2((size_t)size, filedata->mmap_size - filedata->mmap_seek);
+
+	memcpy(buffer, filedata->mmap_buffer + filedata->mmap_seek, readsize);
+	filedata->mmap_seek += readsize;
+
+	return (int)readsize;
+}
+#endif
+
 static int fd_read_from_memfile(FileData *filedata, void *buffer, unsigned int size)
 {
 	static unsigned int seek = (1<<30);	/* the current position */
@@ -1071,7 +1314,7 @@ static int fd_read_from_memfile(FileData *filedata, void *buffer, unsigned int s
 			if (chunkoffset+readsize > chunk->size)
 				readsize= chunk->size-chunkoffset;
 			
-			memcpy(POINTER_OFFSET(buffer, totread), chunk->buf + chunkoffset, readsize);
+			memcpy(POINTER_OFFSET(buffer, totread), chunk->buffer->buf + chunkoffset, readsize);
 			totread += readsize;
 			filedata->seek += readsize;
 			seek += readsize;
@@ -1105,6 +1348,9 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 	
 	if (fd->flags & FD_FLAGS_FILE_OK) {
 		const char *error_message = NULL;
+		if (fd->flags & FD_FLAGS_USE_INDEX) {
+			read_file_index(fd);
+		}
 		if (read_file_dna(fd, &error_message) == false) {
 			BKE_reportf(reports, RPT_ERROR,
 			            "Failed to read blend file '%s': %s",
@@ -1122,29 +1368,130 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 	return fd;
 }
 
-/* cannot be called with relative paths anymore! */
-/* on each new library added, it now checks for the current FileData and expands relativeness */
-FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
+#ifdef USE_BHEAD_MMAP
+/**
+ * Memory map an uncompressed file saved with the endianness of this platform,
+ * so the blocks data don't have to be read in memory up front (see get_bhead).
+ *
+ * The mapping is private and writable, pages are only copied when modified.
+ * Returns NULL when the file can't be mapped, it's then read as a (possibly compressed) stream.
+ */
+static FileData *blo_openblenderfile_mmap(const char *filepath)
 {
-	gzFile gzfile;
-	errno = 0;
-	gzfile = BLI_gzopen(filepath, "rb");
-	
-	if (gzfile == (gzFile)Z_NULL) {
-		BKE_reportf(reports, RPT_WARNING, "Unable to open '%s': %s",
-		            filepath, errno ? strerror(errno) : TIP_("unknown error reading file"));
+	FileData *fd = NULL;
+	char header[SIZEOFBLENDERHEADER];
+	struct stat st;
+	void *buffer;
+	int file;
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1) {
 		return NULL;
 	}
-	else {
-		FileData *fd = filedata_new();
+
+	if ((read(file, header, sizeof(header)) != sizeof(header)) ||
+	    !STREQLEN(header, "BLENDER", 7) ||
+	    (((header[8] == 'v') ? L_ENDIAN : B_ENDIAN) != ENDIAN_ORDER) ||
+	    (fstat(file, &st) == -1) ||
+	    /* too big for the address space */
+	    ((off_t)(size_t)st.st_size != st.st_size))
+	{
+		close(file);
+		return NULL;
+	}
+
+	buffer = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+	/* the mapping stays valid after closing the file */
+	close(file);
+
+	if (buffer != MAP_FAILED) {
+		fd = filedata_new();
+		fd->mmap_buffer = buffer;
+		fd->mmap_size = (size_t)st.st_size;
+		fd->read = fd_read_from_mmap;
+	}
+
+	return fd;
+}
+#endif
+
+/**
+ * Open a file compressed in chunks (see G_FILE_COMPRESS_CHUNKED).
+ * Returns NULL when the file isn't in that format, or when it is but can't be read, \a r_error is then set.
+ */
+static FileData *blo_openblenderfile_chunked(const char *filepath, const char **r_error)
+{
+	FileData *fd = NULL;
+	ChunkFileReader *chunkfile;
+
+	chunkfile = blo_chunkfile_reader_open(filepath, r_error);
+	if (chunkfile) {
+		fd = filedata_new();
+		fd->chunkfile = chunkfile;
+		fd->read = fd_read_from_chunkfile;
+	}
+
+	return fd;
+}
+
+static FileData *blo_openblenderfile_ex(const char *filepath, const bool use_index, ReportList *reports)
+{
+	FileData *fd = NULL;
+	const char *error;
+
+#ifdef USE_BHEAD_MMAP
+	fd = blo_openblenderfile_mmap(filepath);
+#endif
+
+	if (fd == NULL) {
+		fd = blo_openblenderfile_chunked(filepath, &error);
+		if (error) {
+			BKE_reportf(reports, RPT_WARNING, "Unable to read '%s': %s", filepath, error);
+			return NULL;
+		}
+	}
+
+	if (fd == NULL) {
+		gzFile gzfile;
+
+		errno = 0;
+		gzfile = BLI_gzopen(filepath, "rb");
+
+		if (gzfile == (gzFile)Z_NULL) {
+			BKE_reportf(reports, RPT_WARNING, "Unable to open '%s': %s",
+			            filepath, errno ? strerror(errno) : TIP_("unknown error reading file"));
+			return NULL;
+		}
+
+		fd = filedata_new();
 		fd->gzfiledes = gzfile;
 		fd->read = fd_read_gzip_from_file;
-		
-		/* needed for library_append and read_libraries */
-		BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
-		
-		return blo_decode_and_check(fd, reports);
 	}
+
+	/* needed for library_append and read_libraries */
+	BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
+
+	if (use_index) {
+		fd->flags |= FD_FLAGS_USE_INDEX;
+	}
+
+	return blo_decode_and_check(fd, reports);
+}
+
+/* cannot be called with relative paths anymore! */
+/* on each new library added, it now checks for the current FileData and expands relativeness */
+FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
+{
+	return blo_openblenderfile_ex(filepath, false, reports);
+}
+
+/**
+ * Same as blo_openblenderfile(), for files only partially read (library linking, listing data-blocks).
+ * Uses the ID index of the file when possible, so blocks are only read when they're needed.
+ */
+FileData *blo_openblenderfile_for_link(const char *filepath, ReportList *reports)
+{
+	return blo_openblenderfile_ex(filepath, true, reports);
 }
 
 /**
@@ -1153,15 +1500,23 @@ FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
  */
 static FileData *blo_openblenderfile_minimal(const char *filepath)
 {
+	FileData *fd;
 	gzFile gzfile;
-	errno = 0;
-	gzfile = BLI_gzopen(filepath, "rb");
+	const char *error;
 
-	if (gzfile != (gzFile)Z_NULL) {
-		FileData *fd = filedata_new();
-		fd->gzfiledes = gzfile;
-		fd->read = fd_read_gzip_from_file;
+	fd = blo_openblenderfile_chunked(filepath, &error);
+	if (fd == NULL && error == NULL) {
+		errno = 0;
+		gzfile = BLI_gzopen(filepath, "rb");
+
+		if (gzfile != (gzFile)Z_NULL) {
+			fd = filedata_new();
+			fd->gzfiledes = gzfile;
+			fd->read = fd_read_gzip_from_file;
+		}
+	}
 
+	if (fd) {
 		decode_blender_header(fd);
 
 		if (fd->flags & FD_FLAGS_FILE_OK) {
@@ -1253,6 +1608,9 @@ FileData *blo_openblendermemfile(MemFile *memfile, ReportList *reports)
 		FileData *fd = filedata_new();
 		fd->memfile = memfile;
 		
+		/* cold undo steps may be compressed */
+		BLO_memfile_uncompress(memfile);
+		
 		fd->read = fd_read_from_memfile;
 		fd->flags |= FD_FLAGS_NOT_MY_BUFFER;
 		
@@ -1271,6 +1629,10 @@ void blo_freefiledata(FileData *fd)
 		if (fd->gzfiledes != NULL) {
 			gzclose(fd->gzfiledes);
 		}
+
+		if (fd->chunkfile != NULL) {
+			blo_chunkfile_reader_close(fd->chunkfile);
+		}
 		
 		if (fd->strm.next_in) {
 			if (inflateEnd(&fd->strm) != Z_OK) {
@@ -1282,8 +1644,23 @@ void blo_freefiledata(FileData *fd)
 			MEM_freeN((void *)fd->buffer);
 			fd->buffer = NULL;
 		}
+
+#ifdef USE_BHEAD_MMAP
+		if (fd->mmap_buffer) {
+			munmap(fd->mmap_buffer, fd->mmap_size);
+			fd->mmap_buffer = NULL;
+		}
+#endif
 		
 		// Free all BHeadN data blocks
+		{
+			BHeadN *bheadn;
+			for (bheadn = fd->listbase.first; bheadn; bheadn = bheadn->next) {
+				if (bheadn->data_read) {
+					MEM_freeN(bheadn->data_read);
+				}
+			}
+		}
 		BLI_freelistN(&fd->listbase);
 
 		if (fd->filesdna)
@@ -1314,6 +1691,17 @@ void blo_freefiledata(FileData *fd)
 		}
 #endif
 
+		if (fd->index) {
+			MEM_freeN(fd->index);
+			BLI_ghash_free(fd->index_idname_hash, NULL, NULL);
+		}
+		if (fd->undo_old_ids) {
+			BLI_ghash_free(fd->undo_old_ids, NULL, NULL);
+		}
+		if (fd->bhead_offset_hash) {
+			BLI_ghash_free(fd->bhead_offset_hash, NULL, NULL);
+		}
+
 		MEM_freeN(fd);
 	}
 }
@@ -1863,7 +2251,7 @@ static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
 	int blocksize, nblocks;
 	char *data;
 	
-	data = (char *)(bhead+1);
+	data = BHEAD_DATA(bhead);
 	blocksize = filesdna->typelens[ filesdna->structs[bhead->SDNAnr][0] ];
 	
 	nblocks = bhead->nr;
@@ -1874,7 +2262,7 @@ static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
 	}
 }
 
-static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
+static void *read_struct_convert(FileData *fd, BHead *bh, const char *blockname)
 {
 	void *temp = NULL;
 	
@@ -1885,12 +2273,12 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 		
 		if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
 			if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
-				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, (bh+1));
+				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, BHEAD_DATA(bh));
 			}
 			else {
 				/* SDNA_CMP_EQUAL */
 				temp = MEM_mallocN(bh->len, blockname);
-				memcpy(temp, (bh+1), bh->len);
+				memcpy(temp, BHEAD_DATA(bh), bh->len);
 			}
 		}
 	}
@@ -1898,6 +2286,134 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 	return temp;
 }
 
+static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
+{
+	BHeadN *bheadn = BHEADN_FROM_BHEAD(bh);
+
+	if (bheadn->data_read) {
+		/* converted ahead of time by read_file_prepare_blocks */
+		void *temp = bheadn->data_read;
+		bheadn->data_read = NULL;
+		return temp;
+	}
+
+	return read_struct_convert(fd, bh, blockname);
+}
+
+/* ************ PREPARE BLOCKS ***************** */
+
+/* Less blocks to convert aren't worth the threading overhead. */
+#define PREPARE_BLOCKS_THREADED_MIN 64
+
+typedef struct PrepareBlocksData {
+	FileData *fd;
+	BHeadN **bheads;
+	const char **blocknames;
+} PrepareBlocksData;
+
+/* Blocks which read_struct has to do more than copying for. */
+static bool read_struct_needs_convert(const FileData *fd, const BHead *bh)
+{
+	if (bh->len == 0 || bh->SDNAnr < 0 || bh->SDNAnr >= fd->filesdna->nr_structs) {
+		return false;
+	}
+	if (fd->compflags[bh->SDNAnr] == SDNA_CMP_REMOVED) {
+		return false;
+	}
+	return ((bh->SDNAnr && (fd->flags & FD_FLAGS_SWITCH_ENDIAN)) ||
+	        (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL));
+}
+
+/* Block name the ordered reading passes to read_struct for \a bh,
+ * \a parent_code is the code of the last non DATA block.
+ * Returns NULL when it isn't known up front, the block is then converted when read. */
+static const char *read_struct_blockname(const BHead *bh, const int parent_code)
+{
+	switch (bh->code) {
+		case GLOB:
+			return "Global";
+		case USER:
+			return "user def";
+		case DATA:
+			if (parent_code == USER) {
+				return "user def";
+			}
+			if (parent_code != ID_ID && BKE_idcode_is_valid((short)parent_code)) {
+				return dataname((short)parent_code);
+			}
+			return NULL;
+		default:
+			if (bh->code == ID_ID || BKE_idcode_is_valid((short)bh->code)) {
+				return "lib block";
+			}
+			return NULL;
+	}
+}
+
+static void read_file_prepare_block_cb(void *userdata, const int index)
+{
+	PrepareBlocksData *data = userdata;
+	BHeadN *bheadn = data->bheads[index];
+	/* worker threads don't inherit the scope of the reading thread */
+	const eMemScope mem_scope = MEM_scope_begin(MEM_SCOPE_BLENDFILE);
+
+	bheadn->data_read = read_struct_convert(data->fd, &bheadn->bhead, data->blocknames[index]);
+
+	MEM_scope_end(mem_scope);
+}
+
+/**
+ * Read all blocks of the file up front (including decompression), and convert
+ * the ones from an older or differently ordered DNA in parallel.
+ *
+ * Linking the data stays ordered, read_struct then only picks up the converted blocks.
+ * Blocks which end up not being read are freed with the FileData.
+ */
+static void read_file_prepare_blocks(FileData *fd)
+{
+	PrepareBlocksData data;
+	BHead *bhead;
+	int bheads_len = 0, i = 0;
+	int parent_code = 0;
+
+	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
+		if (read_struct_needs_convert(fd, bhead)) {
+			bheads_len++;
+		}
+	}
+
+	if (bheads_len == 0) {
+		return;
+	}
+
+	data.fd = fd;
+	data.bheads = MEM_mallocN(sizeof(*data.bheads) * (size_t)bheads_len, __func__);
+	data.blocknames = MEM_mallocN(sizeof(*data.blocknames) * (size_t)bheads_len, __func__);
+
+	/* Allocate with the names the ordered reading uses, for memory reports and leaks. */
+	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
+		const char *blockname;
+
+		if (bhead->code != DATA) {
+			parent_code = bhead->code;
+		}
+		if (read_struct_needs_convert(fd, bhead) &&
+		    (blockname = read_struct_blockname(bhead, parent_code)))
+		{
+			data.bheads[i] = BHEADN_FROM_BHEAD(bhead);
+			data.blocknames[i] = blockname;
+			i++;
+		}
+	}
+	bheads_len = i;
+
+	BLI_task_parallel_range(0, bheads_len, &data, read_file_prepare_block_cb,
+	                        bheads_len >= PREPARE_BLOCKS_THREADED_MIN);
+
+	MEM_freeN(data.bheads);
+	MEM_freeN(data.blocknames);
+}
+
 typedef void (*link_list_cb)(FileData *fd, void *data);
 
 static void link_list_ex(FileData *fd, ListBase *lb, link_list_cb callback)		/* only direct data */
@@ -8120,6 +8636,88 @@ static BHead *read_data_into_oldnewmap(FileData *fd, BHead *bhead, const char *a
 	return bhead;
 }
 
+/* Undo: the ID in the old main at the same address as the one being read, if any. */
+static ID *read_libblock_undo_old_id(FileData *fd, BHead *bhead, bool *r_is_identical)
+{
+	void **val_p;
+	ID *id_old;
+
+	if (!fd->undo_old_ids || ELEM(bhead->code, ID_LI, ID_ID, ID_WM, ID_SCR)) {
+		return NULL;
+	}
+
+	val_p = BLI_ghash_lookup_p(fd->undo_old_ids, bhead->old);
+	if (val_p == NULL) {
+		return NULL;
+	}
+
+	/* the key is an ID of the old main (written to the memfile it was compared with) */
+	id_old = (ID *)bhead->old;
+	if ((GS(id_old->name) != bhead->code) || (id_old->lib != NULL)) {
+		return NULL;
+	}
+
+	*r_is_identical = GET_INT_FROM_POINTER(*val_p) != 0;
+
+	/* sculpt data isn't written, always start over (see direct_link_object) */
+	if ((bhead->code == ID_OB) && ((Object *)id_old)->sculpt) {
+		*r_is_identical = false;
+	}
+
+	return id_old;
+}
+
+/**
+ * Undo: keep the ID of the old main as is, since it didn't change.
+ * Its pointers to other IDs are checked in #lib_link_undo_reused_ids.
+ */
+static BHead *read_libblock_undo_reuse(FileData *fd, Main *main, BHead *bhead, ID *id_old, const short tag)
+{
+	Main *oldmain = fd->old_mainlist->first;
+
+	BLI_remlink(which_libbase(oldmain, bhead->code), id_old);
+	BLI_addtail(which_libbase(main, bhead->code), id_old);
+	oldnewmap_insert(fd->libmap, bhead->old, id_old, bhead->code);
+
+	id_old->tag = tag | LIB_TAG_UNDO_OLD_ID_REUSED;
+	id_old->lib = main->curlib;
+	id_old->us = ID_FAKE_USERS(id_old);
+	id_old->newid = NULL;
+
+	/* skip its data */
+	bhead = blo_nextbhead(fd, bhead);
+	while (bhead && bhead->code == DATA) {
+		bhead = blo_nextbhead(fd, bhead);
+	}
+
+	return bhead;
+}
+
+/**
+ * Undo: read the ID at the address of the one in the old main, so other IDs (and the UI) keep pointing to it.
+ * The old data is moved to the newly read ID memory, freed with the old main.
+ */
+static ID *read_libblock_undo_old_address(FileData *fd, BHead *bhead, ID *id, ID *id_old)
+{
+	Main *oldmain = fd->old_mainlist->first;
+	const size_t id_size = MEM_allocN_len(id);
+	void *id_temp;
+
+	if (MEM_allocN_len(id_old) != id_size) {
+		return id;
+	}
+
+	BLI_insertlinkreplace(which_libbase(oldmain, bhead->code), id_old, id);
+
+	id_temp = MEM_mallocN(id_size, __func__);
+	memcpy(id_temp, id_old, id_size);
+	memcpy(id_old, id, id_size);
+	memcpy(id, id_temp, id_size);
+	MEM_freeN(id_temp);
+
+	return id_old;
+}
+
 static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short tag, ID **r_id)
 {
 	/* this routine reads a libblock and its direct data. Use link functions to connect it all
@@ -8196,8 +8794,28 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 		}
 	}
 
-	/* read libblock */
-	id = read_struct(fd, bhead, "lib block");
+	if (fd->undo_old_ids) {
+		bool is_identical = false;
+		ID *id_old = read_libblock_undo_old_id(fd, bhead, &is_identical);
+
+		if (id_old && is_identical) {
+			if (r_id) {
+				*r_id = id_old;
+			}
+			return read_libblock_undo_reuse(fd, main, bhead, id_old, tag);
+		}
+
+		/* read libblock */
+		id = read_struct(fd, bhead, "lib block");
+
+		if (id && id_old) {
+			id = read_libblock_undo_old_address(fd, bhead, id, id_old);
+		}
+	}
+	else {
+		/* read libblock */
+		id = read_struct(fd, bhead, "lib block");
+	}
 
 	if (id) {
 		const short idcode = (bhead->code == ID_ID) ? GS(id->name) : bhead->code;
@@ -8499,10 +9117,97 @@ static void do_versions_after_linking(Main *main)
 	do_versions_after_linking_270(main);
 }
 
+typedef struct LibLinkUndoData {
+	FileData *fd;
+	bool is_changed;
+} LibLinkUndoData;
+
+static int lib_link_undo_reused_id_cb(void *user_data, ID *UNUSED(id_self), ID **id_pointer, int cb_flag)
+{
+	LibLinkUndoData *data = user_data;
+	ID *id;
+
+	/* embedded node-trees are part of their owner */
+	if ((cb_flag & IDWALK_CB_PRIVATE) || (*id_pointer == NULL)) {
+		return IDWALK_RET_NOP;
+	}
+
+	id = newlibadr(data->fd, NULL, *id_pointer);
+	if ((id == NULL) || (id != *id_pointer) ||
+	    ((id->lib == NULL) && (id->tag & LIB_TAG_UNDO_OLD_ID_REUSED) == 0))
+	{
+		data->is_changed = true;
+	}
+	*id_pointer = id;
+
+	/* same as newlibadr_us and newlibadr_real_us in lib_link functions */
+	if (cb_flag & IDWALK_CB_USER) {
+		id_us_plus_no_lib(id);
+	}
+	else if (cb_flag & IDWALK_CB_USER_ONE) {
+		id_us_ensure_real(id);
+	}
+
+	return IDWALK_RET_NOP;
+}
+
+/**
+ * Undo: IDs kept from the old main aren't linked again, but the IDs they use may have been read again.
+ * Remap their pointers, count their users, and treat them as changed if they use a changed ID,
+ * since their runtime data may depend on the data that was freed.
+ */
+static void lib_link_undo_reused_ids(FileData *fd, Main *main)
+{
+	ListBase *lbarray[MAX_LIBARRAY];
+	LibLinkUndoData data = {.fd = fd};
+	int a;
+
+	a = set_listbasepointers(main, lbarray);
+	while (a--) {
+		ID *id;
+		for (id = lbarray[a]->first; id; id = id->next) {
+			if ((id->tag & LIB_TAG_UNDO_OLD_ID_REUSED) == 0) {
+				continue;
+			}
+
+			data.is_changed = false;
+			BKE_library_foreach_ID_link(NULL, id, lib_link_undo_reused_id_cb, &data, IDWALK_NOP);
+
+			id->tag &= ~LIB_TAG_DOIT;
+			if (data.is_changed) {
+				id->tag |= LIB_TAG_DOIT;
+			}
+		}
+	}
+
+	/* only now, so IDs using changed IDs are not treated as changed themselves */
+	a = set_listbasepointers(main, lbarray);
+	while (a--) {
+		ID *id;
+		for (id = lbarray[a]->first; id; id = id->next) {
+			if ((id->tag & LIB_TAG_UNDO_OLD_ID_REUSED) && (id->tag & LIB_TAG_DOIT)) {
+				id->tag &= ~(LIB_TAG_UNDO_OLD_ID_REUSED | LIB_TAG_DOIT);
+
+				if (GS(id->name) == ID_OB) {
+					Object *ob = (Object *)id;
+					BKE_object_free_derived_caches(ob);
+					if (ob->pose) {
+						ob->pose->flag |= POSE_RECALC;
+					}
+				}
+			}
+		}
+	}
+}
+
 static void lib_link_all(FileData *fd, Main *main)
 {
 	oldnewmap_sort(fd);
 	
+	if (fd->undo_old_ids) {
+		lib_link_undo_reused_ids(fd, main);
+	}
+	
 	/* No load UI for undo memfiles */
 	if (fd->memfile == NULL) {
 		lib_link_windowmanager(fd, main);
@@ -8624,6 +9329,11 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 	BHead *bhead = blo_firstbhead(fd);
 	BlendFileData *bfd;
 	ListBase mainlist = {NULL, NULL};
+	const eMemScope mem_scope = MEM_scope_begin(MEM_SCOPE_BLENDFILE);
+	
+	if ((fd->skip_flags & BLO_READ_SKIP_DATA) == 0) {
+		read_file_prepare_blocks(fd);
+	}
 	
 	bfd = MEM_callocN(sizeof(BlendFileData), "blendfiledata");
 	bfd->main = BKE_main_new();
@@ -8733,6 +9443,8 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 	
 	fd->mainlist = NULL;  /* Safety, this is local variable, shall not be used afterward. */
 
+	MEM_scope_end(mem_scope);
+
 	return bfd;
 }
 
@@ -8780,6 +9492,11 @@ static BHead *find_previous_lib(FileData *fd, BHead *bhead)
 	if (fd->memfile)
 		return NULL;
 
+	if (fd->index) {
+		const BlendIndexEntry *entry = read_file_index_find_old(fd, bhead->old);
+		return (entry && entry->lib_offset) ? blo_bhead_from_offset(fd, entry->lib_offset) : NULL;
+	}
+
 	for (; bhead; bhead = blo_prevbhead(fd, bhead)) {
 		if (bhead->code == ID_LI)
 			break;
@@ -8798,6 +9515,12 @@ static BHead *find_bhead(FileData *fd, void *old)
 	if (!old)
 		return NULL;
 
+	if (fd->index) {
+		/* only ID blocks are in the index, which is all expanding needs */
+		const BlendIndexEntry *entry = read_file_index_find_old(fd, old);
+		return entry ? blo_bhead_from_offset(fd, entry->offset) : NULL;
+	}
+
 	if (fd->bheadmap == NULL)
 		sort_bhead_old_map(fd);
 	
@@ -8826,6 +9549,10 @@ static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const
 	*((short *)idname_full) = idcode;
 	BLI_strncpy(idname_full + 2, name, sizeof(idname_full) - 2);
 
+	if (fd->index) {
+		return find_bhead_from_idname(fd, idname_full);
+	}
+
 	return BLI_ghash_lookup(fd->bhead_idname_hash, idname_full);
 
 #else
@@ -8849,6 +9576,11 @@ static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const
 
 static BHead *find_bhead_from_idname(FileData *fd, const char *idname)
 {
+	if (fd->index) {
+		const BlendIndexEntry *entry = BLI_ghash_lookup(fd->index_idname_hash, idname);
+		return entry ? blo_bhead_from_offset(fd, entry->offset) : NULL;
+	}
+
 #ifdef USE_GHASH_BHEAD
 	return BLI_ghash_lookup(fd->bhead_idname_hash, idname);
 #else
@@ -10490,7 +11222,7 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 						        mainptr->curlib->filepath,
 						        mainptr->curlib->name,
 						        library_parent_filepath(mainptr->curlib));
-						fd = blo_openblenderfile(mainptr->curlib->filepath, basefd->reports);
+						fd = blo_openblenderfile_for_link(mainptr->curlib->filepath, basefd->reports);
 					}
 					/* allow typing in a new lib path */
 					if (G.debug_value == -666) {
@@ -10507,7 +11239,7 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 								BLI_strncpy(mainptr->curlib->filepath, newlib_path, sizeof(mainptr->curlib->filepath));
 								BLI_cleanup_path(G.main->name, mainptr->curlib->filepath);
 								
-								fd = blo_openblenderfile(mainptr->curlib->filepath, basefd->reports);
+								fd = blo_openblenderfile_for_link(mainptr->curlib->filepath, basefd->reports);
 
 								if (fd) {
 									fd->mainlist = mainlist;
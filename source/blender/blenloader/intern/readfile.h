@@ -34,6 +34,7 @@
 #define __READFILE_H__
 
 #include "zlib.h"
+#include "BLI_sys_types.h"
 #include "DNA_windowmanager_types.h"  /* for ReportType */
 
 struct OldNewMap;
@@ -57,10 +58,18 @@ typedef struct FileData {
 	const char *buffer;
 	// variables needed for reading from memfile (undo)
 	struct MemFile *memfile;
+	// IDs of the old main, mapped to whether they're unchanged in memfile (see BLO_memfile_compare_ids)
+	struct GHash *undo_old_ids;
+
+	// variables needed for reading from a memory mapped file (see USE_BHEAD_MMAP)
+	char *mmap_buffer;
+	size_t mmap_size;
+	size_t mmap_seek;
 
 	// variables needed for reading from file
 	int filedes;
 	gzFile gzfiledes;
+	struct ChunkFileReader *chunkfile;
 
 	// now only in use for library appending
 	char relabase[FILE_MAX];
@@ -96,6 +105,13 @@ typedef struct FileData {
 
 	/* see: USE_GHASH_BHEAD */
 	struct GHash *bhead_idname_hash;
+
+	/* ID index of the file, blocks are then only read when needed (see read_file_index). */
+	struct BlendIndexEntry *index;  /* sorted by old address */
+	unsigned int index_len;
+	uint64_t index_dna_offset, index_glob_offset;
+	struct GHash *index_idname_hash;
+	struct GHash *bhead_offset_hash;
 	
 	ListBase *mainlist;
 	ListBase *old_mainlist;  /* Used for undo. */
@@ -109,9 +125,44 @@ typedef struct FileData {
 
 typedef struct BHeadN {
 	struct BHeadN *next, *prev;
+	/* Offset of the block in the file, only set when reading with the ID index. */
+	uint64_t offset;
+	/* Block data, following the BHeadN or pointing into the memory mapped file. */
+	void *data;
+	/* Block data already converted to the current DNA (see read_file_prepare_blocks),
+	 * owned by the BHeadN until it's read. */
+	void *data_read;
 	struct BHead bhead;
 } BHeadN;
 
+/**
+ * ID index, written after the DNA1 block as a DATA block (ignored by older versions),
+ * followed by a #BlendIndexFooter which ends right before the ENDB block.
+ *
+ * Lets library linking read only the ID blocks it needs (and the ones they use),
+ * instead of reading the whole file.
+ */
+typedef struct BlendIndexEntry {
+	uint64_t offset;        /* offset of the ID block in the (uncompressed) file */
+	uint64_t old;           /* BHead.old */
+	uint64_t lib_offset;    /* for ID_ID blocks, offset of the ID_LI block of their library */
+	int code;               /* BHead.code */
+	char name[MAX_ID_NAME]; /* ID.name */
+	char _pad[2];
+} BlendIndexEntry;
+
+typedef struct BlendIndexFooter {
+	uint64_t dna_offset;
+	uint64_t glob_offset;
+	uint64_t entries_len;
+	char magic[8];
+} BlendIndexFooter;
+
+#define BLEND_INDEX_MAGIC "BLENDIDX"
+
+#define BHEADN_FROM_BHEAD(bh) ((BHeadN *)POINTER_OFFSET(bh, -offsetof(BHeadN, bhead)))
+#define BHEAD_DATA(bh) (BHEADN_FROM_BHEAD(bh)->data)
+
 /* FileData->flags */
 enum {
 	FD_FLAGS_SWITCH_ENDIAN         = 1 << 0,
@@ -120,6 +171,7 @@ enum {
 	FD_FLAGS_FILE_OK               = 1 << 3,
 	FD_FLAGS_NOT_MY_BUFFER         = 1 << 4,
 	FD_FLAGS_NOT_MY_LIBMAP         = 1 << 5,  /* XXX Unused in practice (checked once but never set). */
+	FD_FLAGS_USE_INDEX             = 1 << 6,  /* Read with the ID index of the file when it has one. */
 };
 
 #define SIZEOFBLENDERHEADER 12
@@ -132,6 +184,7 @@ void blo_split_main(ListBase *mainlist, struct Main *main);
 BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath);
 
 FileData *blo_openblenderfile(const char *filepath, struct ReportList *reports);
+FileData *blo_openblenderfile_for_link(const char *filepath, struct ReportList *reports);
 FileData *blo_openblendermemory(const void *buffer, int buffersize, struct ReportList *reports);
 FileData *blo_openblendermemfile(struct MemFile *memfile, struct ReportList *reports);
 
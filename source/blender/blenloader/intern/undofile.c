@@ -35,55 +35,266 @@
 #include <stdio.h>
 #include <math.h>
 
+#include "zlib.h"
+
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 
 #include "BLO_undofile.h"
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/* -------------------------------------------------------------------- */
+/** \name Shared Buffers
+ *
+ * Chunks with the same content share one buffer, whatever memfile and position they're in,
+ * so inserting data doesn't duplicate everything written after it.
+ * Only used from the main thread, like the rest of the undo writing.
+ * \{ */
+
+/* don't bother compressing small chunks, mostly ID structs */
+#define MEMFILE_COMPRESS_MIN_SIZE 1024
+
+/* all the buffers in use, by content */
+static GHash *memfile_buffers = NULL;
+static size_t memfile_buffers_size = 0;
+
+static unsigned int memfile_buffer_hash(const void *key)
+{
+	return ((const MemFileBuffer *)key)->hash;
+}
+
+static bool memfile_buffer_decompress(const MemFileBuffer *buffer, char *out)
+{
+#ifdef WITH_LZO
+	lzo_uint out_len = (lzo_uint)buffer->size;
+	return ((lzo1x_decompress_safe((const lzo_bytep)buffer->buf, (lzo_uint)buffer->size_compressed,
+	                               (lzo_bytep)out, &out_len, NULL) == LZO_E_OK) &&
+	        (out_len == buffer->size));
+#else
+	uLongf out_len = (uLongf)buffer->size;
+	return ((uncompress((Bytef *)out, &out_len, (const Bytef *)buffer->buf, (uLong)buffer->size_compressed) == Z_OK) &&
+	        (out_len == buffer->size));
+#endif
+}
+
+/* uncompressed data of the buffer, freed with #memfile_buffer_data_end */
+static const char *memfile_buffer_data_begin(const MemFileBuffer *buffer)
+{
+	char *data;
+
+	if (buffer->size_compressed == 0) {
+		return buffer->buf;
+	}
+
+	data = MEM_mallocN(buffer->size, __func__);
+	if (!memfile_buffer_decompress(buffer, data)) {
+		BLI_assert(0);
+		memset(data, 0, buffer->size);
+	}
+	return data;
+}
+
+static void memfile_buffer_data_end(const MemFileBuffer *buffer, const char *data)
+{
+	if (data != buffer->buf) {
+		MEM_freeN((void *)data);
+	}
+}
+
+static bool memfile_buffer_cmp(const void *a, const void *b)
+{
+	const MemFileBuffer *buffer_a = a, *buffer_b = b;
+	const char *data_a, *data_b;
+	bool is_different;
+
+	if (buffer_a == buffer_b) {
+		return false;
+	}
+	if ((buffer_a->hash != buffer_b->hash) || (buffer_a->size != buffer_b->size)) {
+		return true;
+	}
+
+	data_a = memfile_buffer_data_begin(buffer_a);
+	data_b = memfile_buffer_data_begin(buffer_b);
+	is_different = (memcmp(data_a, data_b, buffer_a->size) != 0);
+	memfile_buffer_data_end(buffer_a, data_a);
+	memfile_buffer_data_end(buffer_b, data_b);
+
+	return is_different;
+}
+
+static size_t memfile_buffer_size_stored(const MemFileBuffer *buffer)
+{
+	return buffer->size_compressed ? buffer->size_compressed : buffer->size;
+}
+
+/* buffer with the same content as 'buf', or a new one when there is none */
+static MemFileBuffer *memfile_buffer_ensure(const char *buf, unsigned int size, bool *r_is_new)
+{
+	MemFileBuffer buffer_key = {NULL};
+	MemFileBuffer *buffer;
+
+	if (memfile_buffers == NULL) {
+		memfile_buffers = BLI_ghash_new(memfile_buffer_hash, memfile_buffer_cmp, __func__);
+	}
+
+	buffer_key.buf = (char *)buf;
+	buffer_key.size = size;
+	buffer_key.hash = BLI_hash_mm2((const unsigned char *)buf, size, 0);
+
+	buffer = BLI_ghash_lookup(memfile_buffers, &buffer_key);
+	*r_is_new = (buffer == NULL);
+
+	if (buffer == NULL) {
+		buffer = MEM_mallocN(sizeof(MemFileBuffer), "MemFileBuffer");
+		*buffer = buffer_key;
+		buffer->buf = MEM_mallocN(size, "Chunk buffer");
+		memcpy(buffer->buf, buf, size);
+		BLI_ghash_insert(memfile_buffers, buffer, buffer);
+		memfile_buffers_size += size;
+	}
+
+	buffer->users++;
+	return buffer;
+}
+
+static void memfile_buffer_release(MemFileBuffer *buffer)
+{
+	BLI_assert(buffer->users > 0);
+
+	if (--buffer->users == 0) {
+		BLI_ghash_remove(memfile_buffers, buffer, NULL, NULL);
+		memfile_buffers_size -= memfile_buffer_size_stored(buffer);
+		MEM_freeN(buffer->buf);
+		MEM_freeN(buffer);
+
+		if (BLI_ghash_size(memfile_buffers) == 0) {
+			BLI_ghash_free(memfile_buffers, NULL, NULL);
+			memfile_buffers = NULL;
+		}
+	}
+}
+
+static void memfile_buffer_compress(MemFileBuffer *buffer)
+{
+	const size_t out_len_max = (size_t)buffer->size + buffer->size / 16 + 64 + 3;
+	char *out = MEM_mallocN(out_len_max, __func__);
+	size_t out_len = 0;
+
+#ifdef WITH_LZO
+	{
+		void *wrkmem = MEM_mallocN(LZO1X_MEM_COMPRESS, __func__);
+		lzo_uint dest_len = 0;
+		if (lzo1x_1_compress((const lzo_bytep)buffer->buf, (lzo_uint)buffer->size,
+		                     (lzo_bytep)out, &dest_len, wrkmem) == LZO_E_OK)
+		{
+			out_len = (size_t)dest_len;
+		}
+		MEM_freeN(wrkmem);
+	}
+#else
+	{
+		uLongf dest_len = (uLongf)out_len_max;
+		if (compress2((Bytef *)out, &dest_len, (const Bytef *)buffer->buf, (uLong)buffer->size, Z_BEST_SPEED) == Z_OK) {
+			out_len = (size_t)dest_len;
+		}
+	}
+#endif
+
+	if (out_len != 0 && out_len < buffer->size) {
+		MEM_freeN(buffer->buf);
+		buffer->buf = MEM_reallocN(out, out_len);
+		buffer->size_compressed = (unsigned int)out_len;
+		memfile_buffers_size -= buffer->size - out_len;
+	}
+	else {
+		MEM_freeN(out);
+	}
+}
+
+static void memfile_buffer_uncompress(MemFileBuffer *buffer)
+{
+	char *data = (char *)memfile_buffer_data_begin(buffer);
+
+	MEM_freeN(buffer->buf);
+	buffer->buf = data;
+	memfile_buffers_size += buffer->size - buffer->size_compressed;
+	buffer->size_compressed = 0;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name MemFile
+ * \{ */
+
 /* not memfile itself */
 void BLO_memfile_free(MemFile *memfile)
 {
 	MemFileChunk *chunk;
 	
 	while ((chunk = BLI_pophead(&memfile->chunks))) {
-		if (chunk->ident == 0)
-			MEM_freeN(chunk->buf);
+		memfile_buffer_release(chunk->buffer);
 		MEM_freeN(chunk);
 	}
 	memfile->size = 0;
 }
 
-/* to keep list of memfiles consistent, 'first' is always first in list */
-/* result is that 'first' is being freed */
-void BLO_memfile_merge(MemFile *first, MemFile *second)
+/**
+ * Compress the buffers only used by this memfile,
+ * for undo steps which aren't likely to be read soon.
+ */
+void BLO_memfile_compress(MemFile *memfile)
 {
-	MemFileChunk *fc, *sc;
-	
-	fc = first->chunks.first;
-	sc = second->chunks.first;
-	while (fc || sc) {
-		if (fc && sc) {
-			if (sc->ident) {
-				sc->ident = 0;
-				fc->ident = 1;
-			}
+	MemFileChunk *chunk;
+
+	for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+		MemFileBuffer *buffer = chunk->buffer;
+		if ((buffer->users == 1) && (buffer->size_compressed == 0) && (buffer->size >= MEMFILE_COMPRESS_MIN_SIZE)) {
+			memfile_buffer_compress(buffer);
 		}
-		if (fc) fc = fc->next;
-		if (sc) sc = sc->next;
 	}
-	
-	BLO_memfile_free(first);
 }
 
-void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size)
+/* needed before reading the memfile */
+void BLO_memfile_uncompress(MemFile *memfile)
+{
+	MemFileChunk *chunk;
+
+	for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+		if (chunk->buffer->size_compressed != 0) {
+			memfile_buffer_uncompress(chunk->buffer);
+		}
+	}
+}
+
+/**
+ * Memory used by the data of all memfiles, chunks shared between memfiles are only counted once.
+ */
+size_t BLO_memfile_buffers_size(void)
+{
+	return memfile_buffers_size;
+}
+
+void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size, const void *id)
 {
 	static MemFileChunk *compchunk = NULL;
 	MemFileChunk *curchunk;
+	bool is_new = false;
 	
 	/* this function inits when compare != NULL or when current == NULL  */
 	if (compare) {
@@ -97,26 +308,78 @@ void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsi
 	
 	curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
 	curchunk->size = size;
-	curchunk->buf = NULL;
-	curchunk->ident = 0;
+	curchunk->buffer = NULL;
+	curchunk->id = id;
 	BLI_addtail(&current->chunks, curchunk);
 	
-	/* we compare compchunk with buf */
+	/* we compare compchunk with buf, the common case of unchanged data at the same position */
 	if (compchunk) {
-		if (compchunk->size == curchunk->size) {
-			if (memcmp(compchunk->buf, buf, size) == 0) {
-				curchunk->buf = compchunk->buf;
-				curchunk->ident = 1;
+		MemFileBuffer *compbuffer = compchunk->buffer;
+		if ((compbuffer->size == size) && (compbuffer->size_compressed == 0)) {
+			if (memcmp(compbuffer->buf, buf, size) == 0) {
+				curchunk->buffer = compbuffer;
+				compbuffer->users++;
 			}
 		}
 		compchunk = compchunk->next;
 	}
 	
-	/* not equal... */
-	if (curchunk->buf == NULL) {
-		curchunk->buf = MEM_mallocN(size, "Chunk buffer");
-		memcpy(curchunk->buf, buf, size);
-		current->size += size;
+	/* not equal... look for the same content anywhere else */
+	if (curchunk->buffer == NULL) {
+		curchunk->buffer = memfile_buffer_ensure(buf, size, &is_new);
+		if (is_new) {
+			current->size += size;
+		}
+	}
+}
+
+/* chunks of the ID starting at 'chunk' are the same as the ones starting at 'chunk_ref' */
+static bool memfile_id_chunks_equal(const MemFileChunk *chunk, const MemFileChunk *chunk_ref)
+{
+	const void *id = chunk_ref->id;
+
+	for (; chunk_ref && chunk_ref->id == id; chunk = chunk->next, chunk_ref = chunk_ref->next) {
+		/* buffers are shared by content, so different buffers means different data */
+		if ((chunk == NULL) || (chunk->id != id) || (chunk->buffer != chunk_ref->buffer)) {
+			return false;
+		}
+	}
+
+	return ((chunk == NULL) || (chunk->id != id));
+}
+
+/**
+ * Map the IDs written in 'memfile_ref' to whether they're written identically (same address and data)
+ * in 'memfile', so undo can keep them as is instead of reading them again.
+ *
+ * Values are SET_INT_IN_POINTER(true) for identical IDs, SET_INT_IN_POINTER(false) otherwise.
+ */
+GHash *BLO_memfile_compare_ids(const MemFile *memfile, const MemFile *memfile_ref)
+{
+	GHash *id_chunks = BLI_ghash_ptr_new(__func__);
+	GHash *ids = BLI_ghash_ptr_new(__func__);
+	const MemFileChunk *chunk;
+
+	/* first chunk of each ID */
+	for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+		const MemFileChunk *chunk_prev = chunk->prev;
+		if (chunk->id && (chunk_prev == NULL || chunk_prev->id != chunk->id)) {
+			BLI_ghash_insert(id_chunks, (void *)chunk->id, (void *)chunk);
+		}
+	}
+
+	for (chunk = memfile_ref->chunks.first; chunk; chunk = chunk->next) {
+		const MemFileChunk *chunk_prev = chunk->prev;
+		if (chunk->id && (chunk_prev == NULL || chunk_prev->id != chunk->id)) {
+			const MemFileChunk *chunk_other = BLI_ghash_lookup(id_chunks, chunk->id);
+			const bool is_identical = chunk_other && memfile_id_chunks_equal(chunk_other, chunk);
+			BLI_ghash_insert(ids, (void *)chunk->id, SET_INT_IN_POINTER(is_identical));
+		}
 	}
+
+	BLI_ghash_free(id_chunks, NULL, NULL);
+
+	return ids;
 }
 
+/** \} */
@@ -184,6 +184,7 @@
 #include "BLO_blend_defs.h"
 
 #include "readfile.h"
+#include "chunkfile.h"
 
 /* for SDNA_TYPE_FROM_STRUCT() macro */
 #include "dna_type_offsets.h"
@@ -203,6 +204,7 @@
 typedef enum {
 	WW_WRAP_NONE = 1,
 	WW_WRAP_ZLIB,
+	WW_WRAP_CHUNKED,
 } eWriteWrapType;
 
 typedef struct WriteWrap WriteWrap;
@@ -216,6 +218,7 @@ struct WriteWrap {
 	union {
 		int file_handle;
 		gzFile gz_handle;
+		struct ChunkFileWriter *chunk_handle;
 	} _user_data;
 };
 
@@ -275,6 +278,34 @@ static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
+/* chunked */
+#define FILE_HANDLE(ww) \
+	(ww)->_user_data.chunk_handle
+
+static bool ww_open_chunked(WriteWrap *ww, const char *filepath)
+{
+	ChunkFileWriter *file;
+
+	file = blo_chunkfile_writer_open(filepath);
+
+	if (file != NULL) {
+		FILE_HANDLE(ww) = file;
+		return true;
+	}
+	else {
+		return false;
+	}
+}
+static bool ww_close_chunked(WriteWrap *ww)
+{
+	return blo_chunkfile_writer_close(FILE_HANDLE(ww));
+}
+static size_t ww_write_chunked(WriteWrap *ww, const char *buf, size_t buf_len)
+{
+	return blo_chunkfile_writer_write(FILE_HANDLE(ww), buf, buf_len) ? buf_len : 0;
+}
+#undef FILE_HANDLE
+
 /* --- end compression types --- */
 
 static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
@@ -289,6 +320,13 @@ static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
 			r_ww->write = ww_write_zlib;
 			break;
 		}
+		case WW_WRAP_CHUNKED:
+		{
+			r_ww->open  = ww_open_chunked;
+			r_ww->close = ww_close_chunked;
+			r_ww->write = ww_write_chunked;
+			break;
+		}
 		default:
 		{
 			r_ww->open  = ww_open_none;
@@ -308,10 +346,24 @@ typedef struct {
 
 	unsigned char *buf;
 	MemFile *compare, *current;
-
-	int tot, count;
+	/* ID being written to 'current', see mywrite_id_begin */
+	const void *current_id;
+	/* copy of ID structs written to 'current' */
+	void *current_id_buf;
+	size_t current_id_buf_len;
+
+	uint64_t tot;  /* offset in the (uncompressed) file */
+	int count;
 	bool error;
 
+	/* ID index written at the end of the file, see #BlendIndexEntry.
+	 * Not used for UNDO. */
+	struct {
+		BlendIndexEntry *entries;
+		unsigned int entries_len, entries_alloc;
+		uint64_t lib_offset, dna_offset, glob_offset;
+	} index;
+
 	/* Wrap writing, so we can use zlib or
 	 * other compression types later, see: G_FILE_COMPRESS
 	 * Will be NULL for UNDO. */
@@ -347,7 +399,7 @@ static void writedata_do_write(WriteData *wd, const void *mem, int memlen)
 
 	/* memory based save */
 	if (wd->current) {
-		memfile_chunk_add(NULL, wd->current, mem, memlen);
+		memfile_chunk_add(NULL, wd->current, mem, memlen, wd->current_id);
 	}
 	else {
 		if (wd->ww->write(wd->ww, mem, memlen) != memlen) {
@@ -358,6 +410,12 @@ static void writedata_do_write(WriteData *wd, const void *mem, int memlen)
 
 static void writedata_free(WriteData *wd)
 {
+	if (wd->index.entries) {
+		MEM_freeN(wd->index.entries);
+	}
+	if (wd->current_id_buf) {
+		MEM_freeN(wd->current_id_buf);
+	}
 	MEM_freeN(wd->buf);
 	MEM_freeN(wd);
 }
@@ -442,7 +500,7 @@ static WriteData *bgnwrite(WriteWrap *ww, MemFile *compare, MemFile *current)
 	wd->compare = compare;
 	wd->current = current;
 	/* this inits comparing */
-	memfile_chunk_add(compare, NULL, NULL, 0);
+	memfile_chunk_add(compare, NULL, NULL, 0, NULL);
 
 	return wd;
 }
@@ -466,8 +524,91 @@ static bool endwrite(WriteData *wd)
 	return err;
 }
 
+/**
+ * Undo: each ID starts a new chunk, so undo can compare IDs as a whole (see #BLO_memfile_compare_ids).
+ */
+static void mywrite_id_begin(WriteData *wd, const int filecode, const void *adr)
+{
+	if (wd->current && (filecode != DATA)) {
+		mywrite_flush(wd);
+		wd->current_id = BKE_idcode_is_valid(filecode) ? adr : NULL;
+	}
+}
+
+/**
+ * Undo: copy of the ID struct without the members which aren't read back,
+ * but change when other IDs are added, removed or evaluated.
+ * Avoids detecting changes in IDs which didn't change.
+ */
+static const void *mywrite_id_struct_for_undo(WriteData *wd, const void *data, const int len)
+{
+	ID *id;
+
+	if (wd->current_id_buf_len < (size_t)len) {
+		if (wd->current_id_buf) {
+			MEM_freeN(wd->current_id_buf);
+		}
+		wd->current_id_buf_len = (size_t)len;
+		wd->current_id_buf = MEM_mallocN(wd->current_id_buf_len, __func__);
+	}
+
+	memcpy(wd->current_id_buf, data, (size_t)len);
+
+	id = wd->current_id_buf;
+	id->next = id->prev = NULL;
+	id->newid = NULL;
+	id->tag = 0;
+	id->us = 0;
+	id->icon_id = 0;
+
+	return id;
+}
+
 /* ********** WRITE FILE ****************** */
 
+/**
+ * Add the block about to be written to the ID index, see #write_index.
+ */
+static void writefile_index_add(WriteData *wd, const BHead *bh, const void *data)
+{
+	if (wd->current || bh->code == DATA) {
+		return;
+	}
+
+	switch (bh->code) {
+		case GLOB:
+			wd->index.glob_offset = wd->tot;
+			return;
+		case DNA1:
+			wd->index.dna_offset = wd->tot;
+			return;
+		case ID_LI:
+			wd->index.lib_offset = wd->tot;
+			break;
+		case ID_ID:
+			break;
+		default:
+			if (!BKE_idcode_is_valid(bh->code)) {
+				return;
+			}
+			break;
+	}
+
+	if (wd->index.entries_len == wd->index.entries_alloc) {
+		wd->index.entries_alloc = MAX2(wd->index.entries_alloc * 2, 64);
+		wd->index.entries = MEM_reallocN_id(
+		        wd->index.entries, sizeof(*wd->index.entries) * wd->index.entries_alloc, __func__);
+	}
+
+	BlendIndexEntry *entry = &wd->index.entries[wd->index.entries_len++];
+	memset(entry, 0, sizeof(*entry));
+	entry->offset = wd->tot;
+	entry->old = (uint64_t)(uintptr_t)bh->old;
+	entry->lib_offset = (bh->code == ID_ID) ? wd->index.lib_offset : 0;
+	entry->code = bh->code;
+	BLI_strncpy(entry->name, ((const ID *)data)->name, sizeof(entry->name));
+}
+
 static void writestruct_at_address_nr(
         WriteData *wd, int filecode, const int struct_nr, int nr,
         const void *adr, const void *data)
@@ -495,6 +636,13 @@ static void writestruct_at_address_nr(
 		return;
 	}
 
+	writefile_index_add(wd, &bh, data);
+	mywrite_id_begin(wd, filecode, adr);
+
+	if (wd->current && wd->current_id && (wd->current_id == adr) && (bh.len >= (int)sizeof(ID))) {
+		data = mywrite_id_struct_for_undo(wd, data, bh.len);
+	}
+
 	mywrite(wd, &bh, sizeof(BHead));
 	mywrite(wd, data, bh.len);
 }
@@ -548,6 +696,9 @@ static void writedata(WriteData *wd, int filecode, int len, const void *adr)  /*
 	bh.SDNAnr = 0;
 	bh.len    = len;
 
+	writefile_index_add(wd, &bh, adr);
+	mywrite_id_begin(wd, filecode, adr);
+
 	mywrite(wd, &bh, sizeof(BHead));
 	mywrite(wd, adr, len);
 }
@@ -3788,6 +3939,35 @@ static void write_thumb(WriteData *wd, const BlendThumbnail *thumb)
 	}
 }
 
+/**
+ * Write the ID index as a DATA block followed by its footer, right before ENDB (see #BlendIndexEntry).
+ */
+static void write_index(WriteData *wd)
+{
+	const size_t entries_size = sizeof(*wd->index.entries) * wd->index.entries_len;
+	BlendIndexFooter *footer;
+	char *data;
+
+	if (wd->current || (wd->index.dna_offset == 0) || (wd->index.glob_offset == 0)) {
+		return;
+	}
+
+	data = MEM_mallocN(entries_size + sizeof(*footer), __func__);
+	if (entries_size) {
+		memcpy(data, wd->index.entries, entries_size);
+	}
+
+	footer = (BlendIndexFooter *)(data + entries_size);
+	footer->dna_offset = wd->index.dna_offset;
+	footer->glob_offset = wd->index.glob_offset;
+	footer->entries_len = wd->index.entries_len;
+	memcpy(footer->magic, BLEND_INDEX_MAGIC, sizeof(footer->magic));
+
+	writedata(wd, DATA, (int)(entries_size + sizeof(*footer)), data);
+
+	MEM_freeN(data);
+}
+
 /* if MemFile * there's filesave to memory */
 static bool write_file_handle(
         Main *mainvar,
@@ -3982,6 +4162,8 @@ static bool write_file_handle(
 	}
 #endif
 
+	write_index(wd);
+
 	/* end of file */
 	memset(&bhead, 0, sizeof(BHead));
 	bhead.code = ENDB;
@@ -4053,7 +4235,7 @@ bool BLO_write_file(
 	BLI_snprintf(tempname, sizeof(tempname), "%s@", filepath);
 
 	if (write_flags & G_FILE_COMPRESS) {
-		ww_type = WW_WRAP_ZLIB;
+		ww_type = (write_flags & G_FILE_COMPRESS_CHUNKED) ? WW_WRAP_CHUNKED : WW_WRAP_ZLIB;
 	}
 	else {
 		ww_type = WW_WRAP_NONE;
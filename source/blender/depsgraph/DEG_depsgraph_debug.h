@@ -82,6 +82,20 @@ void DEG_stats_simple(const struct Depsgraph *graph,
                       size_t *r_operations,
                       size_t *r_relations);
 
+/* ************************************************ */
+/* Evaluation Profiling */
+
+/* Record every evaluated operation, only the most recent ones are kept. */
+void DEG_debug_profile_enable(bool enable);
+bool DEG_debug_profile_is_enabled(void);
+void DEG_debug_profile_clear(void);
+
+/* Write the recorded operations as Chrome trace JSON (chrome://tracing). */
+bool DEG_debug_profile_write_chrome_trace(const char *filepath);
+
+/* Print the time spent in each component of each ID, slowest first. */
+void DEG_debug_profile_print_summary(FILE *stream);
+
 /* ************************************************ */
 /* Diagram-Based Graph Debugging */
 
@@ -46,53 +46,43 @@
 
 namespace DEG {
 
-void deg_graph_detect_cycles(Depsgraph *graph)
+enum {
+	/* Not is not visited at all during traversal. */
+	NODE_NOT_VISITED = 0,
+	/* Node has been visited during traversal and not in current stack. */
+	NODE_VISITED = 1,
+	/* Node has been visited during traversal and is in current stack. */
+	NODE_IN_STACK = 2,
+};
+
+struct StackEntry {
+	OperationDepsNode *node;
+	StackEntry *from;
+	DepsRelation *via_relation;
+};
+
+static void push_traversal_root(BLI_Stack *traversal_stack, OperationDepsNode *node)
 {
-	enum {
-		/* Not is not visited at all during traversal. */
-		NODE_NOT_VISITED = 0,
-		/* Node has been visited during traversal and not in current stack. */
-		NODE_VISITED = 1,
-		/* Node has been visited during traversal and is in current stack. */
-		NODE_IN_STACK = 2,
-	};
-
-	struct StackEntry {
-		OperationDepsNode *node;
-		StackEntry *from;
-		DepsRelation *via_relation;
-	};
-
-	BLI_Stack *traversal_stack = BLI_stack_new(sizeof(StackEntry),
-	                                           "DEG detect cycles stack");
-
-	foreach (OperationDepsNode *node, graph->operations) {
-		bool has_inlinks = false;
-		foreach (DepsRelation *rel, node->inlinks) {
-			if (rel->from->type == DEG_NODE_TYPE_OPERATION) {
-				has_inlinks = true;
-			}
-		}
-		if (has_inlinks == false) {
-			StackEntry entry;
-			entry.node = node;
-			entry.from = NULL;
-			entry.via_relation = NULL;
-			BLI_stack_push(traversal_stack, &entry);
-			node->tag = NODE_IN_STACK;
-		}
-		else {
-			node->tag = NODE_NOT_VISITED;
-		}
-		node->done = 0;
-	}
+	StackEntry entry;
+	entry.node = node;
+	entry.from = NULL;
+	entry.via_relation = NULL;
+	BLI_stack_push(traversal_stack, &entry);
+	node->tag = NODE_IN_STACK;
+}
 
+static void solve_cycles(BLI_Stack *traversal_stack)
+{
 	while (!BLI_stack_is_empty(traversal_stack)) {
 		StackEntry *entry = (StackEntry *)BLI_stack_peek(traversal_stack);
 		OperationDepsNode *node = entry->node;
 		bool all_child_traversed = true;
 		for (int i = node->done; i < node->outlinks.size(); ++i) {
 			DepsRelation *rel = node->outlinks[i];
+			if (rel->flag & DEPSREL_FLAG_CYCLIC) {
+				/* Solved already, by a previous build. */
+				continue;
+			}
 			if (rel->to->type == DEG_NODE_TYPE_OPERATION) {
 				OperationDepsNode *to = (OperationDepsNode *)rel->to;
 				if (to->tag == NODE_IN_STACK) {
@@ -132,6 +122,54 @@ void deg_graph_detect_cycles(Depsgraph *graph)
 			BLI_stack_discard(traversal_stack);
 		}
 	}
+}
+
+void deg_graph_detect_cycles(Depsgraph *graph)
+{
+	BLI_Stack *traversal_stack = BLI_stack_new(sizeof(StackEntry),
+	                                           "DEG detect cycles stack");
+
+	foreach (OperationDepsNode *node, graph->operations) {
+		bool has_inlinks = false;
+		foreach (DepsRelation *rel, node->inlinks) {
+			if (rel->from->type == DEG_NODE_TYPE_OPERATION) {
+				has_inlinks = true;
+			}
+		}
+		if (has_inlinks == false) {
+			push_traversal_root(traversal_stack, node);
+		}
+		else {
+			node->tag = NODE_NOT_VISITED;
+		}
+		node->done = 0;
+	}
+
+	solve_cycles(traversal_stack);
+
+	BLI_stack_free(traversal_stack);
+}
+
+void deg_graph_detect_cycles_local(Depsgraph *graph,
+                                   const vector<OperationDepsNode *> &nodes)
+{
+	BLI_Stack *traversal_stack = BLI_stack_new(sizeof(StackEntry),
+	                                           "DEG detect cycles stack");
+
+	foreach (OperationDepsNode *node, graph->operations) {
+		node->tag = NODE_NOT_VISITED;
+		node->done = 0;
+	}
+
+	/* Any new cycle goes through one of the new relations, so passes through
+	 * one of the rebuilt nodes, which is where traversal starts from.
+	 */
+	foreach (OperationDepsNode *node, nodes) {
+		if (node->tag == NODE_NOT_VISITED) {
+			push_traversal_root(traversal_stack, node);
+			solve_cycles(traversal_stack);
+		}
+	}
 
 	BLI_stack_free(traversal_stack);
 }
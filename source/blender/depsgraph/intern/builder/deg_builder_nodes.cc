@@ -292,6 +292,15 @@ void DepsgraphNodeBuilder::begin_build(Main *bmain) {
 	} FOREACH_NODETREE_END
 }
 
+void DepsgraphNodeBuilder::begin_build_incremental(Main *bmain,
+                                                   const vector<ID *> &built_ids)
+{
+	begin_build(bmain);
+	foreach (ID *id, built_ids) {
+		id->tag |= LIB_TAG_DOIT;
+	}
+}
+
 void DepsgraphNodeBuilder::build_group(Scene *scene,
                                        Base *base,
                                        Group *group)
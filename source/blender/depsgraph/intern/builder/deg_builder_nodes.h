@@ -71,6 +71,10 @@ struct DepsgraphNodeBuilder {
 	~DepsgraphNodeBuilder();
 
 	void begin_build(Main *bmain);
+	/* Only build IDs which are not in the given list, nodes of those are kept
+	 * from the previous build.
+	 */
+	void begin_build_incremental(Main *bmain, const vector<ID *> &built_ids);
 
 	IDDepsNode *add_id_node(ID *id);
 	TimeSourceDepsNode *add_time_source();
@@ -138,6 +142,7 @@ struct DepsgraphNodeBuilder {
 	                         bPoseChannel *pchan,
 	                         bConstraint *con);
 	void build_rig(Scene *scene, Object *ob);
+	void build_pose_batch(Scene *scene, Object *ob);
 	void build_proxy_rig(Object *ob);
 	void build_shapekeys(Key *key);
 	void build_obdata_geom(Scene *scene, Object *ob);
@@ -34,11 +34,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "MEM_guardedalloc.h"
 
 #include "BLI_utildefines.h"
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
 #include "BLI_string.h"
 
 extern "C" {
@@ -64,6 +66,157 @@ extern "C" {
 
 namespace DEG {
 
+namespace {
+
+void pose_mark_drivers_targets(ListBase *drivers, const char *prefix,
+                               bPose *pose, GSet *unbatched)
+{
+	LINKLIST_FOREACH (FCurve *, fcu, drivers) {
+		if (fcu->rna_path == NULL || strstr(fcu->rna_path, prefix) == NULL) {
+			continue;
+		}
+		char *bone_name = BLI_str_quoted_substrN(fcu->rna_path, prefix);
+		if (bone_name != NULL) {
+			bPoseChannel *pchan = BKE_pose_channel_find_name(pose, bone_name);
+			if (pchan != NULL) {
+				BLI_gset_add(unbatched, pchan);
+			}
+			MEM_freeN(bone_name);
+		}
+	}
+}
+
+/* Bones which need their own operations: bones with constraints, bones in IK
+ * and Spline IK chains and bones which are written to by drivers.
+ */
+void pose_mark_unbatched_channels(Object *ob, GSet *unbatched)
+{
+	bArmature *arm = (bArmature *)ob->data;
+
+	LINKLIST_FOREACH (bPoseChannel *, pchan, &ob->pose->chanbase) {
+		if (pchan->constraints.first == NULL) {
+			continue;
+		}
+		BLI_gset_add(unbatched, pchan);
+
+		LINKLIST_FOREACH (bConstraint *, con, &pchan->constraints) {
+			bPoseChannel *parchan = pchan;
+			int chainlen = 0;
+			if (con->type == CONSTRAINT_TYPE_KINEMATIC) {
+				bKinematicConstraint *data = (bKinematicConstraint *)con->data;
+				if (!(data->flag & CONSTRAINT_IK_TIP)) {
+					parchan = pchan->parent;
+				}
+				chainlen = data->rootbone;
+			}
+			else if (con->type == CONSTRAINT_TYPE_SPLINEIK) {
+				bSplineIKConstraint *data = (bSplineIKConstraint *)con->data;
+				chainlen = data->chainlen + 1;
+			}
+			else {
+				continue;
+			}
+			/* Same walk as the relations builder does for the solvers. */
+			for (int segcount = 0; parchan != NULL; parchan = parchan->parent) {
+				BLI_gset_add(unbatched, parchan);
+				segcount++;
+				if ((segcount == chainlen) || (segcount > 255)) break;
+			}
+		}
+	}
+
+	if (ob->adt != NULL) {
+		pose_mark_drivers_targets(&ob->adt->drivers, "pose.bones[", ob->pose, unbatched);
+	}
+	if (arm->adt != NULL) {
+		pose_mark_drivers_targets(&arm->adt->drivers, "bones[", ob->pose, unbatched);
+	}
+}
+
+int pose_channel_batch_level(bPoseChannel *pchan)
+{
+	int level = 0;
+	for (bPoseChannel *parchan = pchan->parent; parchan; parchan = parchan->parent) {
+		level++;
+	}
+	return level;
+}
+
+/* Wrapper which gives the flattened channels to the evaluation callback. */
+void pose_eval_bone_batch(EvaluationContext *eval_ctx,
+                          Scene *scene,
+                          Object *ob,
+                          const vector<bPoseChannel *> &pchans)
+{
+	BKE_pose_eval_bone_batch(eval_ctx,
+	                         scene,
+	                         ob,
+	                         const_cast<bPoseChannel **>(&pchans[0]),
+	                         (int)pchans.size());
+}
+
+}  /* namespace */
+
+/* Bones which only depend on their parents are evaluated by a single pose
+ * operation, ordered by hierarchy level so parents come first. Their bone
+ * components only get a no-op "done" operation which others link to.
+ */
+void DepsgraphNodeBuilder::build_pose_batch(Scene *scene, Object *ob)
+{
+	GSet *unbatched = BLI_gset_ptr_new(__func__);
+	vector< vector<bPoseChannel *> > levels;
+	size_t num_batched = 0;
+
+	pose_mark_unbatched_channels(ob, unbatched);
+
+	LINKLIST_FOREACH (bPoseChannel *, pchan, &ob->pose->chanbase) {
+		bool batched = true;
+		for (bPoseChannel *parchan = pchan; parchan; parchan = parchan->parent) {
+			if (BLI_gset_haskey(unbatched, parchan)) {
+				batched = false;
+				break;
+			}
+		}
+		if (!batched) {
+			continue;
+		}
+		const int level = pose_channel_batch_level(pchan);
+		if (level >= (int)levels.size()) {
+			levels.resize(level + 1);
+		}
+		levels[level].push_back(pchan);
+		++num_batched;
+	}
+	BLI_gset_free(unbatched, NULL);
+
+	if (num_batched == 0) {
+		return;
+	}
+
+	vector<bPoseChannel *> pchans;
+	pchans.reserve(num_batched);
+	foreach (const vector<bPoseChannel *> &level, levels) {
+		pchans.insert(pchans.end(), level.begin(), level.end());
+	}
+
+	foreach (bPoseChannel *pchan, pchans) {
+		BoneComponentDepsNode *bone_node = (BoneComponentDepsNode *)
+		        add_component_node(&ob->id, DEG_NODE_TYPE_BONE, pchan->name);
+		bone_node->is_batched = true;
+
+		OperationDepsNode *op_node = add_operation_node(bone_node,
+		                                                NULL,
+		                                                DEG_OPCODE_BONE_DONE);
+		op_node->set_as_entry();
+		op_node->set_as_exit();
+	}
+
+	add_operation_node(&ob->id,
+	                   DEG_NODE_TYPE_EVAL_POSE,
+	                   function_bind(pose_eval_bone_batch, _1, scene, ob, pchans),
+	                   DEG_OPCODE_POSE_BONE_BATCH);
+}
+
 void DepsgraphNodeBuilder::build_pose_constraints(Scene *scene, Object *ob, bPoseChannel *pchan)
 {
 	/* create node for constraint stack */
@@ -186,8 +339,17 @@ void DepsgraphNodeBuilder::build_rig(Scene *scene, Object *ob)
 	                             DEG_OPCODE_POSE_DONE);
 	op_node->set_as_exit();
 
+	/* bones evaluated together */
+	build_pose_batch(scene, ob);
+
 	/* bones */
 	LINKLIST_FOREACH (bPoseChannel *, pchan, &ob->pose->chanbase) {
+		BoneComponentDepsNode *bone_node = (BoneComponentDepsNode *)
+		        add_component_node(&ob->id, DEG_NODE_TYPE_BONE, pchan->name);
+		if (bone_node->is_batched) {
+			continue;
+		}
+
 		/* node for bone eval */
 		op_node = add_operation_node(&ob->id, DEG_NODE_TYPE_BONE, pchan->name, NULL,
 		                             DEG_OPCODE_BONE_LOCAL);
@@ -194,7 +194,8 @@ RNAPathKey::RNAPathKey(ID *id, const char *path) :
 }
 
 DepsgraphRelationBuilder::DepsgraphRelationBuilder(Depsgraph *graph) :
-    m_graph(graph)
+    m_graph(graph),
+    m_skip_existing_relations(false)
 {
 }
 
@@ -224,6 +225,20 @@ ComponentDepsNode *DepsgraphRelationBuilder::find_node(
 	return node;
 }
 
+/* Bones evaluated by the pose batch only have a single operation, which
+ * stands in for all operations of the bone.
+ */
+static eDepsOperation_Code bone_operation_opcode(const ComponentDepsNode *comp_node,
+                                                 eDepsOperation_Code opcode)
+{
+	if (comp_node->type == DEG_NODE_TYPE_BONE &&
+	    ((const BoneComponentDepsNode *)comp_node)->is_batched)
+	{
+		return DEG_OPCODE_BONE_DONE;
+	}
+	return opcode;
+}
+
 OperationDepsNode *DepsgraphRelationBuilder::find_node(
         const OperationKey &key) const
 {
@@ -240,7 +255,7 @@ OperationDepsNode *DepsgraphRelationBuilder::find_node(
 		return NULL;
 	}
 
-	OperationDepsNode *op_node = comp_node->find_operation(key.opcode,
+	OperationDepsNode *op_node = comp_node->find_operation(bone_operation_opcode(comp_node, key.opcode),
 	                                                       key.name,
 	                                                       key.name_tag);
 	if (!op_node) {
@@ -267,7 +282,21 @@ OperationDepsNode *DepsgraphRelationBuilder::has_node(
 	if (!comp_node) {
 		return NULL;
 	}
-	return comp_node->has_operation(key.opcode, key.name, key.name_tag);
+	return comp_node->has_operation(bone_operation_opcode(comp_node, key.opcode),
+	                                key.name,
+	                                key.name_tag);
+}
+
+bool DepsgraphRelationBuilder::has_relation(const DepsNode *node_from,
+                                            const DepsNode *node_to) const
+{
+	/* Inlinks, time source has outlinks to most of the graph. */
+	foreach (DepsRelation *rel, node_to->inlinks) {
+		if (rel->from == node_from) {
+			return true;
+		}
+	}
+	return false;
 }
 
 void DepsgraphRelationBuilder::add_time_relation(TimeSourceDepsNode *timesrc,
@@ -275,6 +304,9 @@ void DepsgraphRelationBuilder::add_time_relation(TimeSourceDepsNode *timesrc,
                                                  const char *description)
 {
 	if (timesrc && node_to) {
+		if (m_skip_existing_relations && has_relation(timesrc, node_to)) {
+			return;
+		}
 		m_graph->add_new_relation(timesrc, node_to, description);
 	}
 	else {
@@ -291,6 +323,9 @@ void DepsgraphRelationBuilder::add_operation_relation(
         const char *description)
 {
 	if (node_from && node_to) {
+		if (m_skip_existing_relations && has_relation(node_from, node_to)) {
+			return;
+		}
 		m_graph->add_new_relation(node_from, node_to, description);
 	}
 	else {
@@ -387,6 +422,16 @@ void DepsgraphRelationBuilder::begin_build(Main *bmain)
 	} FOREACH_NODETREE_END
 }
 
+void DepsgraphRelationBuilder::begin_build_incremental(Main *bmain,
+                                                       const vector<ID *> &built_ids)
+{
+	begin_build(bmain);
+	foreach (ID *id, built_ids) {
+		id->tag |= LIB_TAG_DOIT;
+	}
+	m_skip_existing_relations = true;
+}
+
 void DepsgraphRelationBuilder::build_group(Main *bmain,
                                            Scene *scene,
                                            Object *object,
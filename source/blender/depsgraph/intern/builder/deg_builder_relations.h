@@ -168,6 +168,10 @@ struct DepsgraphRelationBuilder
 	DepsgraphRelationBuilder(Depsgraph *graph);
 
 	void begin_build(Main *bmain);
+	/* Only build relations of IDs which are not in the given list, and skip
+	 * relations which already exist in the graph.
+	 */
+	void begin_build_incremental(Main *bmain, const vector<ID *> &built_ids);
 
 	template <typename KeyFrom, typename KeyTo>
 	void add_relation(const KeyFrom& key_from,
@@ -237,6 +241,7 @@ protected:
 	OperationDepsNode *find_node(const OperationKey &key) const;
 	DepsNode *find_node(const RNAPathKey &key) const;
 	OperationDepsNode *has_node(const OperationKey &key) const;
+	bool has_relation(const DepsNode *node_from, const DepsNode *node_to) const;
 
 	void add_time_relation(TimeSourceDepsNode *timesrc,
 	                       DepsNode *node_to,
@@ -253,6 +258,8 @@ protected:
 
 private:
 	Depsgraph *m_graph;
+	/* Graph already has relations of the previous build. */
+	bool m_skip_existing_relations;
 };
 
 struct DepsNodeHandle
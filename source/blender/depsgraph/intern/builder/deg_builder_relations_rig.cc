@@ -373,6 +373,12 @@ void DepsgraphRelationBuilder::build_rig(Scene *scene, Object *ob)
 		add_relation(local_transform_key, pose_key, "Local Transforms");
 	}
 
+	/* bones evaluated together, only depend on pose init */
+	OperationKey batch_key(&ob->id, DEG_NODE_TYPE_EVAL_POSE, DEG_OPCODE_POSE_BONE_BATCH);
+	if (has_node(batch_key)) {
+		add_relation(init_key, batch_key, "PoseEval Source-Batch Link");
+	}
+
 	/* links between operations for each bone */
 	LINKLIST_FOREACH (bPoseChannel *, pchan, &ob->pose->chanbase) {
 		OperationKey bone_local_key(&ob->id, DEG_NODE_TYPE_BONE, pchan->name, DEG_OPCODE_BONE_LOCAL);
@@ -382,6 +388,14 @@ void DepsgraphRelationBuilder::build_rig(Scene *scene, Object *ob)
 
 		pchan->flag &= ~POSE_DONE;
 
+		BoneComponentDepsNode *bone_node = (BoneComponentDepsNode *)
+		        find_node(ComponentKey(&ob->id, DEG_NODE_TYPE_BONE, pchan->name));
+		if (bone_node != NULL && bone_node->is_batched) {
+			add_relation(batch_key, bone_done_key, "Bone Batch -> Done");
+			add_relation(bone_done_key, flush_key, "PoseEval Result-Bone Link");
+			continue;
+		}
+
 		/* pose init to bone local */
 		add_relation(init_key, bone_local_key, "PoseEval Source-Bone Link");
 
@@ -30,8 +30,13 @@
 
 #include "intern/builder/deg_builder_transitive.h"
 
+#include <algorithm>
+
 #include "MEM_guardedalloc.h"
 
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_operation.h"
@@ -62,14 +67,15 @@ enum {
 	OP_REACHABLE = 2,
 };
 
-static void deg_graph_tag_paths_recursive(DepsNode *node)
+static void deg_graph_tag_paths_recursive(DepsNode *node, vector<DepsNode *> *visited)
 {
 	if (node->done & OP_VISITED) {
 		return;
 	}
 	node->done |= OP_VISITED;
+	visited->push_back(node);
 	foreach (DepsRelation *rel, node->inlinks) {
-		deg_graph_tag_paths_recursive(rel->from);
+		deg_graph_tag_paths_recursive(rel->from, visited);
 		/* Do this only in inlinks loop, so the target node does not get
 		 * flagged.
 		 */
@@ -77,43 +83,90 @@ static void deg_graph_tag_paths_recursive(DepsNode *node)
 	}
 }
 
+/* Remove redundant relations to the target, expects tags of all nodes to be
+ * cleared and leaves them cleared.
+ */
+static void deg_graph_transitive_reduction_target(OperationDepsNode *target)
+{
+	vector<DepsNode *> visited;
+
+	/* mark nodes from which we can reach the target
+	 * start with children, so the target node and direct children are not
+	 * flagged.
+	 */
+	target->done |= OP_VISITED;
+	visited.push_back(target);
+	foreach (DepsRelation *rel, target->inlinks) {
+		deg_graph_tag_paths_recursive(rel->from, &visited);
+	}
+
+	/* Remove redundant paths to the target. */
+	DepsNode::Relations kept_relations;
+	foreach (DepsRelation *rel, target->inlinks) {
+		if (rel->from->type == DEG_NODE_TYPE_TIMESOURCE) {
+			/* HACK: time source nodes don't get "done" flag set/cleared. */
+			/* TODO: there will be other types in future, so iterators above
+			 * need modifying.
+			 */
+			kept_relations.push_back(rel);
+		}
+		else if (rel->from->done & OP_REACHABLE) {
+			DepsNode::Relations &outlinks = rel->from->outlinks;
+			outlinks.erase(std::find(outlinks.begin(), outlinks.end(), rel));
+			OBJECT_GUARDED_DELETE(rel, DepsRelation);
+		}
+		else {
+			kept_relations.push_back(rel);
+		}
+	}
+	target->inlinks.swap(kept_relations);
+
+	/* Clear tags. */
+	foreach (DepsNode *node, visited) {
+		node->done = 0;
+	}
+}
+
 void deg_graph_transitive_reduction(Depsgraph *graph)
 {
+	foreach (OperationDepsNode *node, graph->operations) {
+		node->done = 0;
+	}
 	foreach (OperationDepsNode *target, graph->operations) {
-		/* Clear tags. */
-		foreach (OperationDepsNode *node, graph->operations) {
-			node->done = 0;
-		}
+		deg_graph_transitive_reduction_target(target);
+	}
+}
 
-		/* mark nodes from which we can reach the target
-		 * start with children, so the target node and direct children are not
-		 * flagged.
-		 */
-		target->done |= OP_VISITED;
-		foreach (DepsRelation *rel, target->inlinks) {
-			deg_graph_tag_paths_recursive(rel->from);
+void deg_graph_transitive_reduction_local(Depsgraph *graph,
+                                          const vector<OperationDepsNode *> &nodes)
+{
+	foreach (OperationDepsNode *node, graph->operations) {
+		node->done = 0;
+	}
+	/* New relations go to the rebuilt nodes, which could also make relations
+	 * to their children redundant.
+	 */
+	GSet *targets = BLI_gset_ptr_new(__func__);
+	foreach (OperationDepsNode *node, nodes) {
+		if (BLI_gset_add(targets, node)) {
+			deg_graph_transitive_reduction_target(node);
 		}
-
-		/* Remove redundant paths to the target. */
-		for (DepsNode::Relations::const_iterator it_rel = target->inlinks.begin();
-		     it_rel != target->inlinks.end();
-		     )
-		{
-			DepsRelation *rel = *it_rel;
-			/* Increment in advance, so we can safely remove the relation. */
-			++it_rel;
-
-			if (rel->from->type == DEG_NODE_TYPE_TIMESOURCE) {
-				/* HACK: time source nodes don't get "done" flag set/cleared. */
-				/* TODO: there will be other types in future, so iterators above
-				 * need modifying.
-				 */
-			}
-			else if (rel->from->done & OP_REACHABLE) {
-				OBJECT_GUARDED_DELETE(rel, DepsRelation);
+		/* Reducing a child can remove the relation to it from our outlinks,
+		 * so gather the children first.
+		 */
+		vector<OperationDepsNode *> children;
+		foreach (DepsRelation *rel, node->outlinks) {
+			if (rel->to->type == DEG_NODE_TYPE_OPERATION &&
+			    BLI_gset_add(targets, rel->to))
+			{
+				children.push_back((OperationDepsNode *)rel->to);
 			}
 		}
+		foreach (OperationDepsNode *child, children) {
+			deg_graph_transitive_reduction_target(child);
+		}
 	}
+	BLI_gset_free(targets, NULL);
 }
 
 }  // namespace DEG
@@ -30,11 +30,18 @@
 
 #pragma once
 
+#include "intern/depsgraph_types.h"
+
 namespace DEG {
 
 struct Depsgraph;
+struct OperationDepsNode;
 
 /* Performs a transitive reduction to remove redundant relations. */
 void deg_graph_transitive_reduction(Depsgraph *graph);
 
+/* Transitive reduction of relations to the given nodes and their children. */
+void deg_graph_transitive_reduction_local(Depsgraph *graph,
+                                          const vector<OperationDepsNode *> &nodes);
+
 }  // namespace DEG
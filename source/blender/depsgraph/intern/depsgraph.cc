@@ -55,6 +55,7 @@ extern "C" {
 
 #include "DEG_depsgraph.h"
 
+#include "intern/eval/deg_eval_layout.h"
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_operation.h"
@@ -71,18 +72,25 @@ static DEG_EditorUpdateScenePreCb deg_editor_update_scene_pre_cb = NULL;
 Depsgraph::Depsgraph()
   : time_source(NULL),
     need_update(false),
+    eval_layout(NULL),
     layers(0)
 {
 	BLI_spin_init(&lock);
-	id_hash = BLI_ghash_ptr_new("Depsgraph id hash");
-	entry_tags = BLI_gset_ptr_new("Depsgraph entry_tags");
+	/* Only looked up, filled and iterated, so use the more cache friendly open addressing. */
+	id_hash = BLI_ghash_new_open_ex(BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp,
+	                                "Depsgraph id hash", 0);
+	entry_tags = BLI_gset_new_open_ex(BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp,
+	                                  "Depsgraph entry_tags", 0);
+	id_relations_tags = BLI_gset_ptr_new("Depsgraph id_relations_tags");
 }
 
 Depsgraph::~Depsgraph()
 {
+	clear_eval_layout();
 	clear_id_nodes();
 	BLI_ghash_free(id_hash, NULL, NULL);
 	BLI_gset_free(entry_tags, NULL);
+	BLI_gset_free(id_relations_tags, NULL);
 	if (time_source != NULL) {
 		OBJECT_GUARDED_DELETE(time_source, TimeSourceDepsNode);
 	}
@@ -296,6 +304,88 @@ void Depsgraph::clear_id_nodes()
 	BLI_ghash_clear(id_hash, NULL, id_node_deleter);
 }
 
+void Depsgraph::remove_id_nodes(const vector<IDDepsNode *> &id_nodes)
+{
+	GSet *removed_id_nodes = BLI_gset_ptr_new(__func__);
+	GSet *removed_operations = BLI_gset_ptr_new(__func__);
+	GSet *removed_relations = BLI_gset_ptr_new(__func__);
+	GSet *linked_nodes = BLI_gset_ptr_new(__func__);
+	vector<DepsRelation *> outgoing_relations;
+
+	clear_eval_layout();
+
+	foreach (IDDepsNode *id_node, id_nodes) {
+		BLI_gset_add(removed_id_nodes, id_node);
+	}
+
+	/* Forget about operations of the removed nodes. */
+	OperationNodes kept_operations;
+	kept_operations.reserve(operations.size());
+	foreach (OperationDepsNode *node, operations) {
+		if (BLI_gset_haskey(removed_id_nodes, node->owner->owner)) {
+			BLI_gset_add(removed_operations, node);
+			BLI_gset_remove(entry_tags, node, NULL);
+		}
+		else {
+			kept_operations.push_back(node);
+		}
+	}
+	operations.swap(kept_operations);
+
+	/* Relations to the rest of the graph. Incoming ones are freed together
+	 * with the nodes, outgoing ones are freed here.
+	 */
+	GSET_FOREACH_BEGIN(OperationDepsNode *, node, removed_operations)
+	{
+		foreach (DepsRelation *rel, node->inlinks) {
+			if (!BLI_gset_haskey(removed_operations, rel->from)) {
+				BLI_gset_add(removed_relations, rel);
+				BLI_gset_add(linked_nodes, rel->from);
+			}
+		}
+		foreach (DepsRelation *rel, node->outlinks) {
+			if (!BLI_gset_haskey(removed_operations, rel->to)) {
+				BLI_gset_add(removed_relations, rel);
+				BLI_gset_add(linked_nodes, rel->to);
+				outgoing_relations.push_back(rel);
+			}
+		}
+	}
+	GSET_FOREACH_END();
+
+	GSET_FOREACH_BEGIN(DepsNode *, node, linked_nodes)
+	{
+		DepsNode::Relations kept_relations;
+		foreach (DepsRelation *rel, node->inlinks) {
+			if (!BLI_gset_haskey(removed_relations, rel)) {
+				kept_relations.push_back(rel);
+			}
+		}
+		node->inlinks.swap(kept_relations);
+		kept_relations.clear();
+		foreach (DepsRelation *rel, node->outlinks) {
+			if (!BLI_gset_haskey(removed_relations, rel)) {
+				kept_relations.push_back(rel);
+			}
+		}
+		node->outlinks.swap(kept_relations);
+	}
+	GSET_FOREACH_END();
+
+	foreach (DepsRelation *rel, outgoing_relations) {
+		OBJECT_GUARDED_DELETE(rel, DepsRelation);
+	}
+
+	foreach (IDDepsNode *id_node, id_nodes) {
+		BLI_ghash_remove(id_hash, id_node->id, NULL, id_node_deleter);
+	}
+
+	BLI_gset_free(removed_id_nodes, NULL);
+	BLI_gset_free(removed_operations, NULL);
+	BLI_gset_free(removed_relations, NULL);
+	BLI_gset_free(linked_nodes, NULL);
+}
+
 /* Add new relationship between two nodes. */
 DepsRelation *Depsgraph::add_new_relation(OperationDepsNode *from,
                                           OperationDepsNode *to,
@@ -399,6 +489,7 @@ void Depsgraph::add_entry_tag(OperationDepsNode *node)
 
 void Depsgraph::clear_all_nodes()
 {
+	clear_eval_layout();
 	clear_id_nodes();
 	BLI_ghash_clear(id_hash, NULL, NULL);
 	if (time_source != NULL) {
@@ -407,6 +498,14 @@ void Depsgraph::clear_all_nodes()
 	}
 }
 
+void Depsgraph::clear_eval_layout()
+{
+	if (eval_layout != NULL) {
+		deg_eval_layout_free(eval_layout);
+		eval_layout = NULL;
+	}
+}
+
 void deg_editors_id_update(Main *bmain, ID *id)
 {
 	if (deg_editor_update_id_cb != NULL) {
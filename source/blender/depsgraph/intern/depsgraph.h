@@ -53,6 +53,7 @@ struct TimeSourceDepsNode;
 struct IDDepsNode;
 struct ComponentDepsNode;
 struct OperationDepsNode;
+struct DepsgraphEvalLayout;
 
 /* *************************** */
 /* Relationships Between Nodes */
@@ -113,6 +114,8 @@ struct Depsgraph {
 	IDDepsNode *find_id_node(const ID *id) const;
 	IDDepsNode *add_id_node(ID *id, const char *name = "");
 	void clear_id_nodes();
+	/* Free the nodes of the given IDs, together with all their relations. */
+	void remove_id_nodes(const vector<IDDepsNode *> &id_nodes);
 
 	/* Add new relationship between two nodes. */
 	DepsRelation *add_new_relation(OperationDepsNode *from,
@@ -129,6 +132,9 @@ struct Depsgraph {
 	/* Clear storage used by all nodes. */
 	void clear_all_nodes();
 
+	/* Free the evaluation layout, it is to be built again on next evaluation. */
+	void clear_eval_layout();
+
 	/* Core Graph Functionality ........... */
 
 	/* <ID : IDDepsNode> mapping from ID blocks to nodes representing these blocks
@@ -141,6 +147,11 @@ struct Depsgraph {
 	/* Indicates whether relations needs to be updated. */
 	bool need_update;
 
+	/* IDs whose nodes and relations are to be rebuilt, when the graph is not
+	 * tagged for a full relations update.
+	 */
+	GSet *id_relations_tags;
+
 	/* Quick-Access Temp Data ............. */
 
 	/* Nodes which have been tagged as "directly modified". */
@@ -152,6 +163,11 @@ struct Depsgraph {
 	/* All operation nodes, sorted in order of single-thread traversal order. */
 	OperationNodes operations;
 
+	/* Flat copy of the operations relations used by evaluation, built after
+	 * the relations and freed together with the nodes.
+	 */
+	DepsgraphEvalLayout *eval_layout;
+
 	/* Spin lock for threading-critical operations.
 	 * Mainly used by graph evaluation.
 	 */
@@ -36,6 +36,7 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
+#include "BLI_listbase.h"
 
 #ifdef DEBUG_TIME
 #  include "PIL_time.h"
@@ -64,6 +65,7 @@ extern "C" {
 #include "builder/deg_builder_relations.h"
 #include "builder/deg_builder_transitive.h"
 
+#include "intern/eval/deg_eval_layout.h"
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_operation.h"
@@ -232,6 +234,10 @@ void DEG_graph_build_from_scene(Depsgraph *graph, Main *bmain, Scene *scene)
 	/* 4) Flush visibility layer and re-schedule nodes for update. */
 	DEG::deg_graph_build_finalize(deg_graph);
 
+	/* 5) Flatten relations for the evaluation. */
+	deg_graph->clear_eval_layout();
+	deg_graph->eval_layout = DEG::deg_eval_layout_build(deg_graph);
+
 #if 0
 	if (!DEG_debug_consistency_check(deg_graph)) {
 		printf("Consistency validation failed, ABORTING!\n");
@@ -244,6 +250,185 @@ void DEG_graph_build_from_scene(Depsgraph *graph, Main *bmain, Scene *scene)
 #endif
 }
 
+/* Find base of the object in the scene or its sets. */
+static Base *deg_find_object_base(Scene *scene, Object *ob, Scene **r_scene)
+{
+	for (Scene *sce = scene; sce != NULL; sce = sce->set) {
+		LINKLIST_FOREACH (Base *, base, &sce->base) {
+			if (base->object == ob) {
+				*r_scene = sce;
+				return base;
+			}
+		}
+	}
+	*r_scene = scene;
+	return NULL;
+}
+
+/* Check whether objects tagged for relations update can be rebuilt without
+ * the rest of the graph, and collect the objects depending on them.
+ */
+static bool deg_graph_check_incremental(DEG::Depsgraph *graph,
+                                        std::vector<DEG::IDDepsNode *> *r_id_nodes,
+                                        GSet *r_dependents)
+{
+	GSET_FOREACH_BEGIN(ID *, id, graph->id_relations_tags)
+	{
+		if (GS(id->name) != ID_OB) {
+			return false;
+		}
+		Object *ob = (Object *)id;
+		/* Proxies have relations built from the other object. */
+		if (ob->proxy != NULL || ob->proxy_from != NULL || ob->proxy_group != NULL) {
+			return false;
+		}
+		DEG::IDDepsNode *id_node = graph->find_id_node(id);
+		if (id_node == NULL) {
+			return false;
+		}
+		r_id_nodes->push_back(id_node);
+	}
+	GSET_FOREACH_END();
+
+	foreach (DEG::OperationDepsNode *node, graph->operations) {
+		ID *id = node->owner->owner->id;
+		if (!BLI_gset_haskey(graph->id_relations_tags, id)) {
+			continue;
+		}
+		foreach (DEG::DepsRelation *rel, node->inlinks) {
+			if (rel->from->type == DEG::DEG_NODE_TYPE_OPERATION) {
+				ID *id_from = ((DEG::OperationDepsNode *)rel->from)->owner->owner->id;
+				/* Scene level relations, such as rigid body world. */
+				if (GS(id_from->name) == ID_SCE) {
+					return false;
+				}
+			}
+		}
+		foreach (DEG::DepsRelation *rel, node->outlinks) {
+			if (rel->to->type != DEG::DEG_NODE_TYPE_OPERATION) {
+				continue;
+			}
+			ID *id_to = ((DEG::OperationDepsNode *)rel->to)->owner->owner->id;
+			if (BLI_gset_haskey(graph->id_relations_tags, id_to)) {
+				continue;
+			}
+			/* Only objects are rebuilt, and relations to an ID are built
+			 * together with the ID.
+			 */
+			if (GS(id_to->name) != ID_OB) {
+				return false;
+			}
+			BLI_gset_add(r_dependents, id_to);
+		}
+	}
+	return true;
+}
+
+/* Rebuild nodes of the objects tagged with DEG_id_relations_tag_update() and
+ * relations of the objects depending on them, keeping the rest of the graph.
+ *
+ * Returns false without touching the graph when the tagged IDs can't be
+ * rebuilt on their own, the graph is to be fully rebuilt then.
+ */
+static bool deg_graph_build_incremental(DEG::Depsgraph *graph, Main *bmain, Scene *scene)
+{
+#ifdef DEBUG_TIME
+	TIMEIT_START(deg_graph_build_incremental);
+#endif
+
+	std::vector<DEG::IDDepsNode *> id_nodes;
+	GSet *dependents = BLI_gset_ptr_new(__func__);
+	if (!deg_graph_check_incremental(graph, &id_nodes, dependents)) {
+		BLI_gset_free(dependents, NULL);
+		return false;
+	}
+
+	/* 1) Remove tagged nodes, everything else is kept as it is. */
+	graph->remove_id_nodes(id_nodes);
+
+	std::vector<ID *> built_ids;
+	GSet *kept_ids = BLI_gset_ptr_new(__func__);
+	GHASH_FOREACH_BEGIN(DEG::IDDepsNode *, id_node, graph->id_hash)
+	{
+		built_ids.push_back(id_node->id);
+		if (!BLI_gset_haskey(dependents, id_node->id)) {
+			BLI_gset_add(kept_ids, id_node->id);
+		}
+	}
+	GHASH_FOREACH_END();
+
+	/* 2) Nodes of the tagged objects, and of IDs they started to use. */
+	DEG::DepsgraphNodeBuilder node_builder(bmain, graph);
+	node_builder.begin_build_incremental(bmain, built_ids);
+	GSET_FOREACH_BEGIN(Object *, ob, graph->id_relations_tags)
+	{
+		Scene *ob_scene;
+		Base *base = deg_find_object_base(scene, ob, &ob_scene);
+		node_builder.build_object(ob_scene, base, ob);
+	}
+	GSET_FOREACH_END();
+
+	/* 3) Relations of the new nodes, and relations of the dependent objects
+	 *    which were going to the removed nodes.
+	 */
+	built_ids.clear();
+	GSET_FOREACH_BEGIN(ID *, id, kept_ids)
+	{
+		built_ids.push_back(id);
+	}
+	GSET_FOREACH_END();
+
+	DEG::DepsgraphRelationBuilder relation_builder(graph);
+	relation_builder.begin_build_incremental(bmain, built_ids);
+	GSET_FOREACH_BEGIN(Object *, ob, graph->id_relations_tags)
+	{
+		Scene *ob_scene;
+		deg_find_object_base(scene, ob, &ob_scene);
+		relation_builder.build_object(bmain, ob_scene, ob);
+	}
+	GSET_FOREACH_END();
+	GSET_FOREACH_BEGIN(Object *, ob, dependents)
+	{
+		Scene *ob_scene;
+		deg_find_object_base(scene, ob, &ob_scene);
+		relation_builder.build_object(bmain, ob_scene, ob);
+	}
+	GSET_FOREACH_END();
+
+	std::vector<DEG::OperationDepsNode *> rebuilt_nodes;
+	foreach (DEG::OperationDepsNode *node, graph->operations) {
+		ID *id = node->owner->owner->id;
+		/* New relations can also request data from kept objects (vertex group
+		 * targets for example), masks only grow between full rebuilds.
+		 */
+		if (GS(id->name) == ID_OB) {
+			((Object *)id)->customdata_mask |= node->customdata_mask;
+		}
+		if (!BLI_gset_haskey(kept_ids, id)) {
+			rebuilt_nodes.push_back(node);
+		}
+	}
+
+	/* 4) Solve cycles and simplify only where relations changed. */
+	DEG::deg_graph_detect_cycles_local(graph, rebuilt_nodes);
+	if (G.debug_value == 799) {
+		DEG::deg_graph_transitive_reduction_local(graph, rebuilt_nodes);
+	}
+
+	/* 5) Flush visibility layer and re-schedule nodes for update. */
+	DEG::deg_graph_build_finalize(graph);
+	graph->eval_layout = DEG::deg_eval_layout_build(graph);
+
+	BLI_gset_free(dependents, NULL);
+	BLI_gset_free(kept_ids, NULL);
+
+#ifdef DEBUG_TIME
+	TIMEIT_END(deg_graph_build_incremental);
+#endif
+
+	return true;
+}
+
 /* Tag graph relations for update. */
 void DEG_graph_tag_relations_update(Depsgraph *graph)
 {
@@ -264,6 +449,23 @@ void DEG_relations_tag_update(Main *bmain)
 	}
 }
 
+/* Tag relations of the given ID for update, only the ID and the ones depending
+ * on it will be rebuilt if nothing else is tagged.
+ */
+void DEG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	for (Scene *scene = (Scene *)bmain->scene.first;
+	     scene != NULL;
+	     scene = (Scene *)scene->id.next)
+	{
+		if (scene->depsgraph != NULL) {
+			DEG::Depsgraph *deg_graph =
+			        reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
+			BLI_gset_add(deg_graph->id_relations_tags, id);
+		}
+	}
+}
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
@@ -278,14 +480,21 @@ void DEG_scene_relations_update(Main *bmain, Scene *scene)
 
 	DEG::Depsgraph *graph = reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
 	if (!graph->need_update) {
-		/* Graph is up to date, nothing to do. */
-		return;
+		if (BLI_gset_size(graph->id_relations_tags) == 0) {
+			/* Graph is up to date, nothing to do. */
+			return;
+		}
+		if (deg_graph_build_incremental(graph, bmain, scene)) {
+			BLI_gset_clear(graph->id_relations_tags, NULL);
+			return;
+		}
 	}
 
 	/* Clear all previous nodes and operations. */
 	graph->clear_all_nodes();
 	graph->operations.clear();
 	BLI_gset_clear(graph->entry_tags, NULL);
+	BLI_gset_clear(graph->id_relations_tags, NULL);
 
 	/* Build new nodes and relations. */
 	DEG_graph_build_from_scene(reinterpret_cast< ::Depsgraph * >(graph),
@@ -31,6 +31,7 @@
  */
 
 #include "BLI_utildefines.h"
+#include "BLI_fileops.h"
 #include "BLI_ghash.h"
 
 extern "C" {
@@ -42,6 +43,7 @@ extern "C" {
 #include "DEG_depsgraph_build.h"
 
 #include "intern/eval/deg_eval_debug.h"
+#include "intern/eval/deg_eval_profile.h"
 #include "intern/depsgraph_intern.h"
 #include "util/deg_util_foreach.h"
 
@@ -65,6 +67,36 @@ DepsgraphStatsID *DEG_stats_id(ID *id)
 	return DEG::DepsgraphDebug::get_id_stats(id, false);
 }
 
+void DEG_debug_profile_enable(bool enable)
+{
+	DEG::deg_eval_profile_enable(enable);
+}
+
+bool DEG_debug_profile_is_enabled(void)
+{
+	return DEG::deg_eval_profile_is_enabled();
+}
+
+void DEG_debug_profile_clear(void)
+{
+	DEG::deg_eval_profile_clear();
+}
+
+bool DEG_debug_profile_write_chrome_trace(const char *filepath)
+{
+	FILE *stream = BLI_fopen(filepath, "w");
+	if (stream == NULL) {
+		return false;
+	}
+	const bool ok = DEG::deg_eval_profile_write_chrome_trace(stream);
+	return (fclose(stream) == 0) && ok;
+}
+
+void DEG_debug_profile_print_summary(FILE *stream)
+{
+	DEG::deg_eval_profile_write_summary(stream);
+}
+
 bool DEG_debug_compare(const struct Depsgraph *graph1,
                        const struct Depsgraph *graph2)
 {
@@ -110,6 +110,7 @@ EvaluationContext *DEG_evaluation_context_new(int mode)
 void DEG_evaluation_context_init(EvaluationContext *eval_ctx, int mode)
 {
 	eval_ctx->mode = mode;
+	eval_ctx->mesh_share_cache = NULL;
 }
 
 /* Free evaluation context. */
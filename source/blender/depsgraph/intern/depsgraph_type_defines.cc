@@ -42,6 +42,7 @@
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_operation.h"
 
+#include "intern/eval/deg_eval_profile.h"
 #include "intern/depsgraph_intern.h"
 
 namespace DEG {
@@ -113,6 +114,7 @@ static const char *stringify_opcode(eDepsOperation_Code opcode)
 		STRINGIFY_OPCODE(POSE_DONE);
 		STRINGIFY_OPCODE(POSE_IK_SOLVER);
 		STRINGIFY_OPCODE(POSE_SPLINE_IK_SOLVER);
+		STRINGIFY_OPCODE(POSE_BONE_BATCH);
 		STRINGIFY_OPCODE(BONE_LOCAL);
 		STRINGIFY_OPCODE(BONE_POSE_PARENT);
 		STRINGIFY_OPCODE(BONE_CONSTRAINTS);
@@ -161,4 +163,7 @@ void DEG_register_node_types(void)
 void DEG_free_node_types(void)
 {
 	BLI_ghash_free(DEG::_depsnode_typeinfo_registry, NULL, NULL);
+
+	/* Recorded evaluation profile is kept until exit. */
+	DEG::deg_eval_profile_free();
 }
@@ -191,6 +191,9 @@ typedef enum eDepsOperation_Code {
 	DEG_OPCODE_POSE_IK_SOLVER,
 	DEG_OPCODE_POSE_SPLINE_IK_SOLVER,
 
+	/* Bones without constraints, IK or drivers, evaluated in one go */
+	DEG_OPCODE_POSE_BONE_BATCH,
+
 	/* Bone -------------------------------------------- */
 
 	/* Bone local transforms - Entrypoint */
@@ -32,14 +32,20 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <algorithm>
+
+#include "MEM_guardedalloc.h"
+
 #include "PIL_time.h"
 
 #include "BLI_utildefines.h"
+#include "BLI_math_base.h"
 #include "BLI_task.h"
 #include "BLI_ghash.h"
 
 extern "C" {
 #include "BKE_depsgraph.h"
+#include "BKE_DerivedMesh.h"
 #include "BKE_global.h"
 } /* extern "C" */
 
@@ -49,6 +55,8 @@ extern "C" {
 
 #include "intern/eval/deg_eval_debug.h"
 #include "intern/eval/deg_eval_flush.h"
+#include "intern/eval/deg_eval_layout.h"
+#include "intern/eval/deg_eval_profile.h"
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_operation.h"
@@ -56,13 +64,11 @@ extern "C" {
 #include "intern/depsgraph_intern.h"
 #include "util/deg_util_foreach.h"
 
-/* Unfinished and unused, and takes quite some pre-processing time. */
-#undef USE_EVAL_PRIORITY
+/* Weight of the last evaluation in the smoothed cost of an operation. */
+#define EVAL_COST_SMOOTH_FACTOR 0.25f
 
-/* Use integrated debugger to keep track how much each of the nodes was
- * evaluating.
- */
-#undef USE_DEBUGGER
+/* Cost of the operations which were never measured yet, in seconds. */
+#define EVAL_COST_DEFAULT 1e-6f
 
 namespace DEG {
 
@@ -70,16 +76,23 @@ namespace DEG {
 /* Evaluation Entrypoints */
 
 /* Forward declarations. */
+struct DepsgraphEvalState;
+
 static void schedule_children(TaskPool *pool,
-                              Depsgraph *graph,
-                              OperationDepsNode *node,
-                              const unsigned int layers,
+                              DepsgraphEvalState *state,
+                              const int index,
                               const int thread_id);
 
 struct DepsgraphEvalState {
 	EvaluationContext *eval_ctx;
 	Depsgraph *graph;
+	/* Relations and per-operation state, see deg_eval_layout.h. */
+	DepsgraphEvalLayout *layout;
 	unsigned int layers;
+	/* Measure operations and schedule the longest remaining path first. */
+	bool do_priority;
+	/* Record evaluated operations, see deg_eval_profile.h. */
+	bool do_profile;
 };
 
 static void deg_task_run_func(TaskPool *pool,
@@ -88,7 +101,8 @@ static void deg_task_run_func(TaskPool *pool,
 {
 	DepsgraphEvalState *state =
 	        reinterpret_cast<DepsgraphEvalState *>(BLI_task_pool_userdata(pool));
-	OperationDepsNode *node = reinterpret_cast<OperationDepsNode *>(taskdata);
+	const int index = GET_INT_FROM_POINTER(taskdata);
+	OperationDepsNode *node = state->layout->operations[index];
 
 	BLI_assert(!node->is_noop() && "NOOP nodes should not actually be scheduled");
 
@@ -108,71 +122,70 @@ static void deg_task_run_func(TaskPool *pool,
 	 * but that's all fine, we'll just scheduler it's children.
 	 */
 	if (node->evaluate) {
-			/* Take note of current time. */
-#ifdef USE_DEBUGGER
-		double start_time = PIL_check_seconds_timer();
-		DepsgraphDebug::task_started(state->graph, node);
-#endif
+		const bool do_timing = state->do_priority || state->do_profile;
 
 		/* Perform operation. */
+		const double start_time = do_timing ? PIL_check_seconds_timer() : 0.0;
+		const eMemScope mem_scope = MEM_scope_begin(MEM_SCOPE_DEPSGRAPH);
 		node->evaluate(state->eval_ctx);
+		MEM_scope_end(mem_scope);
+		const double end_time = do_timing ? PIL_check_seconds_timer() : 0.0;
+
+		if (state->do_priority) {
+			/* Smoothed, so a single slow evaluation doesn't reorder everything. */
+			const float cost = (float)(end_time - start_time);
+			node->eval_cost = (node->eval_cost == 0.0f) ?
+			                  cost :
+			                  interpf(cost, node->eval_cost, EVAL_COST_SMOOTH_FACTOR);
+		}
 
-			/* Note how long this took. */
-#ifdef USE_DEBUGGER
-		double end_time = PIL_check_seconds_timer();
-		DepsgraphDebug::task_completed(state->graph,
-		                               node,
-		                               end_time - start_time);
-#endif
+		if (state->do_profile) {
+			deg_eval_profile_record(node, thread_id, node->ready_time, start_time, end_time);
+		}
 	}
 
 	BLI_task_pool_delayed_push_begin(pool, thread_id);
-	schedule_children(pool, state->graph, node, state->layers, thread_id);
+	schedule_children(pool, state, index, thread_id);
 	BLI_task_pool_delayed_push_end(pool, thread_id);
 }
 
 typedef struct CalculatePengindData {
-	Depsgraph *graph;
+	DepsgraphEvalLayout *layout;
 	unsigned int layers;
 } CalculatePengindData;
 
+BLI_INLINE bool operation_needs_eval(const OperationDepsNode *node, const unsigned int layers)
+{
+	return (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0 &&
+	       (node->owner->owner->layers & layers) != 0;
+}
+
 static void calculate_pending_func(void *data_v, int i)
 {
 	CalculatePengindData *data = (CalculatePengindData *)data_v;
-	Depsgraph *graph = data->graph;
+	DepsgraphEvalLayout *layout = data->layout;
 	unsigned int layers = data->layers;
-	OperationDepsNode *node = graph->operations[i];
-	IDDepsNode *id_node = node->owner->owner;
+	DepsgraphEvalOperationState *op_state = &layout->state[i];
 
-	node->num_links_pending = 0;
-	node->scheduled = false;
+	op_state->num_links_pending = 0;
+	op_state->scheduled = false;
 
 	/* count number of inputs that need updates */
-	if ((id_node->layers & layers) != 0 &&
-	    (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0)
-	{
-		foreach (DepsRelation *rel, node->inlinks) {
-			if (rel->from->type == DEG_NODE_TYPE_OPERATION &&
-			    (rel->flag & DEPSREL_FLAG_CYCLIC) == 0)
-			{
-				OperationDepsNode *from = (OperationDepsNode *)rel->from;
-				IDDepsNode *id_from_node = from->owner->owner;
-				if ((id_from_node->layers & layers) != 0 &&
-				    (from->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0)
-				{
-					++node->num_links_pending;
-				}
+	if (operation_needs_eval(layout->operations[i], layers)) {
+		for (int p = layout->parents_offset[i]; p < layout->parents_offset[i + 1]; p++) {
+			if (operation_needs_eval(layout->operations[layout->parents[p]], layers)) {
+				++op_state->num_links_pending;
 			}
 		}
 	}
 }
 
-static void calculate_pending_parents(Depsgraph *graph, unsigned int layers)
+static void calculate_pending_parents(DepsgraphEvalLayout *layout, unsigned int layers)
 {
-	const int num_operations = graph->operations.size();
+	const int num_operations = layout->num_operations;
 	const bool do_threads = num_operations > 256;
 	CalculatePengindData data;
-	data.graph = graph;
+	data.layout = layout;
 	data.layers = layers;
 	BLI_task_parallel_range(0,
 	                        num_operations,
@@ -181,64 +194,103 @@ static void calculate_pending_parents(Depsgraph *graph, unsigned int layers)
 	                        do_threads);
 }
 
-#ifdef USE_EVAL_PRIORITY
-static void calculate_eval_priority(OperationDepsNode *node)
+static float operation_eval_cost(const OperationDepsNode *node)
 {
+	if (node->is_noop()) {
+		return 0.0f;
+	}
+	return (node->eval_cost != 0.0f) ? node->eval_cost : EVAL_COST_DEFAULT;
+}
+
+struct RelationEvalPriorityGreater {
+	const DepsgraphEvalLayout *layout;
+
+	bool operator()(const DepsgraphEvalRelation &a, const DepsgraphEvalRelation &b) const
+	{
+		return layout->operations[a.operation]->eval_priority >
+		       layout->operations[b.operation]->eval_priority;
+	}
+};
+
+/* Priority is the cost of the longest path from the node to the graph sinks,
+ * only counting the operations which are evaluated this time.
+ */
+static void calculate_eval_priority(DepsgraphEvalLayout *layout,
+                                    const int index,
+                                    const unsigned int layers)
+{
+	OperationDepsNode *node = layout->operations[index];
 	if (node->done) {
 		return;
 	}
 	node->done = 1;
 
-	if (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) {
-		/* XXX standard cost of a node, could be estimated somewhat later on */
-		const float cost = 1.0f;
-		/* NOOP nodes have no cost */
-		node->eval_priority = node->is_noop() ? cost : 0.0f;
-
-		foreach (DepsRelation *rel, node->outlinks) {
-			OperationDepsNode *to = (OperationDepsNode *)rel->to;
-			BLI_assert(to->type == DEG_NODE_TYPE_OPERATION);
-			calculate_eval_priority(to);
-			node->eval_priority += to->eval_priority;
+	if (operation_needs_eval(node, layers)) {
+		DepsgraphEvalRelation *children_begin = &layout->children[layout->children_offset[index]];
+		DepsgraphEvalRelation *children_end = &layout->children[layout->children_offset[index + 1]];
+		float children_priority = 0.0f;
+
+		for (DepsgraphEvalRelation *child = children_begin; child != children_end; child++) {
+			calculate_eval_priority(layout, child->operation, layers);
+			children_priority = max_ff(children_priority,
+			                           layout->operations[child->operation]->eval_priority);
 		}
+
+		/* Children are scheduled in this order, the first one ready is
+		 * evaluated next by the same thread.
+		 */
+		RelationEvalPriorityGreater priority_greater = {layout};
+		std::stable_sort(children_begin, children_end, priority_greater);
+
+		node->eval_priority = operation_eval_cost(node) + children_priority;
 	}
 	else {
 		node->eval_priority = 0.0f;
 	}
 }
-#endif
+
+struct OperationEvalPriorityLess {
+	const DepsgraphEvalLayout *layout;
+
+	bool operator()(const int a, const int b) const
+	{
+		return layout->operations[a]->eval_priority < layout->operations[b]->eval_priority;
+	}
+};
 
 /* Schedule a node if it needs evaluation.
  *   dec_parents: Decrement pending parents count, true when child nodes are
  *                scheduled after a task has been completed.
  */
-static void schedule_node(TaskPool *pool, Depsgraph *graph, unsigned int layers,
-                          OperationDepsNode *node, bool dec_parents,
+static void schedule_node(TaskPool *pool, DepsgraphEvalState *state,
+                          const int index, bool dec_parents,
                           const int thread_id)
 {
-	unsigned int id_layers = node->owner->owner->layers;
+	OperationDepsNode *node = state->layout->operations[index];
+	DepsgraphEvalOperationState *op_state = &state->layout->state[index];
 
-	if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0 &&
-	    (id_layers & layers) != 0)
-	{
+	if (operation_needs_eval(node, state->layers)) {
 		if (dec_parents) {
-			BLI_assert(node->num_links_pending > 0);
-			atomic_sub_and_fetch_uint32(&node->num_links_pending, 1);
+			BLI_assert(op_state->num_links_pending > 0);
+			atomic_sub_and_fetch_uint32(&op_state->num_links_pending, 1);
 		}
 
-		if (node->num_links_pending == 0) {
+		if (op_state->num_links_pending == 0) {
 			bool is_scheduled = atomic_fetch_and_or_uint8(
-			        (uint8_t *)&node->scheduled, (uint8_t)true);
+			        &op_state->scheduled, (uint8_t)true);
 			if (!is_scheduled) {
 				if (node->is_noop()) {
 					/* skip NOOP node, schedule children right away */
-					schedule_children(pool, graph, node, layers, thread_id);
+					schedule_children(pool, state, index, thread_id);
 				}
 				else {
+					if (state->do_profile) {
+						node->ready_time = PIL_check_seconds_timer();
+					}
 					/* children are scheduled once this task is completed */
 					BLI_task_pool_push_from_thread(pool,
 					                               deg_task_run_func,
-					                               node,
+					                               SET_INT_IN_POINTER(index),
 					                               false,
 					                               TASK_PRIORITY_HIGH,
 					                               thread_id);
@@ -248,33 +300,49 @@ static void schedule_node(TaskPool *pool, Depsgraph *graph, unsigned int layers,
 	}
 }
 
-static void schedule_graph(TaskPool *pool,
-                           Depsgraph *graph,
-                           const unsigned int layers)
+static void schedule_graph(TaskPool *pool, DepsgraphEvalState *state)
 {
-	foreach (OperationDepsNode *node, graph->operations) {
-		schedule_node(pool, graph, layers, node, false, 0);
+	DepsgraphEvalLayout *layout = state->layout;
+
+	if (state->do_priority) {
+		vector<int> roots;
+		for (int i = 0; i < layout->num_operations; i++) {
+			if (layout->state[i].num_links_pending == 0) {
+				roots.push_back(i);
+			}
+		}
+		/* Tasks of the suspended pool are queued in reverse order,
+		 * so push the lowest priority first.
+		 */
+		OperationEvalPriorityLess priority_less = {layout};
+		std::stable_sort(roots.begin(), roots.end(), priority_less);
+		foreach (int index, roots) {
+			schedule_node(pool, state, index, false, 0);
+		}
+	}
+	else {
+		for (int i = 0; i < layout->num_operations; i++) {
+			schedule_node(pool, state, i, false, 0);
+		}
 	}
 }
 
 static void schedule_children(TaskPool *pool,
-                              Depsgraph *graph,
-                              OperationDepsNode *node,
-                              const unsigned int layers,
+                              DepsgraphEvalState *state,
+                              const int index,
                               const int thread_id)
 {
-	foreach (DepsRelation *rel, node->outlinks) {
-		OperationDepsNode *child = (OperationDepsNode *)rel->to;
-		BLI_assert(child->type == DEG_NODE_TYPE_OPERATION);
-		if (child->scheduled) {
+	const DepsgraphEvalLayout *layout = state->layout;
+	for (int c = layout->children_offset[index]; c < layout->children_offset[index + 1]; c++) {
+		const DepsgraphEvalRelation *child = &layout->children[c];
+		if (layout->state[child->operation].scheduled) {
 			/* Happens when having cyclic dependencies. */
 			continue;
 		}
 		schedule_node(pool,
-		              graph,
-		              layers,
-		              child,
-		              (rel->flag & DEPSREL_FLAG_CYCLIC) == 0,
+		              state,
+		              child->operation,
+		              !child->is_cyclic,
 		              thread_id);
 	}
 }
@@ -307,11 +375,21 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 	TimeSourceDepsNode *time_src = graph->find_time_source();
 	eval_ctx->ctime = time_src->cfra;
 
+	const double start_time = PIL_check_seconds_timer();
+
+	/* Graphs built before the layout existed, or which had it cleared. */
+	if (graph->eval_layout == NULL) {
+		graph->eval_layout = deg_eval_layout_build(graph);
+	}
+
 	/* XXX could use a separate pool for each eval context */
 	DepsgraphEvalState state;
 	state.eval_ctx = eval_ctx;
 	state.graph = graph;
+	state.layout = graph->eval_layout;
 	state.layers = layers;
+	state.do_priority = (G.debug & G_DEBUG_DEPSGRAPH_NO_PRIORITY) == 0;
+	state.do_profile = deg_eval_profile_is_enabled();
 
 	TaskScheduler *task_scheduler;
 	bool need_free_scheduler;
@@ -327,7 +405,7 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 
 	TaskPool *task_pool = BLI_task_pool_create_suspended(task_scheduler, &state);
 
-	calculate_pending_parents(graph, layers);
+	calculate_pending_parents(state.layout, layers);
 
 	/* Clear tags. */
 	foreach (OperationDepsNode *node, graph->operations) {
@@ -335,19 +413,26 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 	}
 
 	/* Calculate priority for operation nodes. */
-#ifdef USE_EVAL_PRIORITY
-	foreach (OperationDepsNode *node, graph->operations) {
-		calculate_eval_priority(node);
+	if (state.do_priority) {
+		for (int i = 0; i < state.layout->num_operations; i++) {
+			calculate_eval_priority(state.layout, i, layers);
+		}
 	}
-#endif
+
+	/* Objects evaluating to the same mesh share it for this evaluation only. */
+	DerivedMeshShareCache *mesh_share_cache_prev = eval_ctx->mesh_share_cache;
+	eval_ctx->mesh_share_cache = DM_share_cache_new();
 
 	DepsgraphDebug::eval_begin(eval_ctx);
 
-	schedule_graph(task_pool, graph, layers);
+	schedule_graph(task_pool, &state);
 
 	BLI_task_pool_work_and_wait(task_pool);
 	BLI_task_pool_free(task_pool);
 
+	DM_share_cache_free(eval_ctx->mesh_share_cache);
+	eval_ctx->mesh_share_cache = mesh_share_cache_prev;
+
 	DepsgraphDebug::eval_end(eval_ctx);
 
 	/* Clear any uncleared tags - just in case. */
@@ -356,6 +441,11 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 	if (need_free_scheduler) {
 		BLI_task_scheduler_free(task_scheduler);
 	}
+
+	DEG_DEBUG_PRINTF("%s: %.3f ms (%s)\n",
+	                 __func__,
+	                 (PIL_check_seconds_timer() - start_time) * 1000.0,
+	                 state.do_priority ? "critical path priority" : "graph order");
 }
 
 }  // namespace DEG
@@ -0,0 +1,122 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/eval/deg_eval_layout.cc
+ *  \ingroup depsgraph
+ *
+ * Flat layout of the operations relations, used by the evaluation.
+ */
+
+#include "intern/eval/deg_eval_layout.h"
+
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_math_base.h"
+
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_operation.h"
+#include "intern/depsgraph.h"
+#include "util/deg_util_foreach.h"
+
+namespace DEG {
+
+DepsgraphEvalLayout *deg_eval_layout_build(Depsgraph *graph)
+{
+	DepsgraphEvalLayout *layout = OBJECT_GUARDED_NEW(DepsgraphEvalLayout);
+	const int num_operations = graph->operations.size();
+	int num_children = 0, num_parents = 0;
+
+	layout->num_operations = num_operations;
+	layout->operations = (OperationDepsNode **)MEM_mallocN(
+	        sizeof(*layout->operations) * max_ii(num_operations, 1), "DepsgraphEvalLayout operations");
+
+	/* Index of the operations in the layout, only needed while building it. */
+	for (int i = 0; i < num_operations; i++) {
+		OperationDepsNode *node = graph->operations[i];
+		layout->operations[i] = node;
+		node->tag = i;
+
+		foreach (DepsRelation *rel, node->outlinks) {
+			if (rel->to->type == DEG_NODE_TYPE_OPERATION) {
+				num_children++;
+				if ((rel->flag & DEPSREL_FLAG_CYCLIC) == 0) {
+					num_parents++;
+				}
+			}
+		}
+	}
+
+	layout->children_offset = (int *)MEM_mallocN(sizeof(int) * (num_operations + 1),
+	                                             "DepsgraphEvalLayout children_offset");
+	layout->children = (DepsgraphEvalRelation *)MEM_mallocN(
+	        sizeof(DepsgraphEvalRelation) * max_ii(num_children, 1), "DepsgraphEvalLayout children");
+	layout->parents_offset = (int *)MEM_mallocN(sizeof(int) * (num_operations + 1),
+	                                            "DepsgraphEvalLayout parents_offset");
+	layout->parents = (int *)MEM_mallocN(sizeof(int) * max_ii(num_parents, 1),
+	                                     "DepsgraphEvalLayout parents");
+
+	num_children = num_parents = 0;
+	for (int i = 0; i < num_operations; i++) {
+		OperationDepsNode *node = layout->operations[i];
+
+		layout->children_offset[i] = num_children;
+		foreach (DepsRelation *rel, node->outlinks) {
+			if (rel->to->type == DEG_NODE_TYPE_OPERATION) {
+				DepsgraphEvalRelation *child = &layout->children[num_children++];
+				child->operation = rel->to->tag;
+				child->is_cyclic = (rel->flag & DEPSREL_FLAG_CYCLIC) != 0;
+			}
+		}
+
+		layout->parents_offset[i] = num_parents;
+		foreach (DepsRelation *rel, node->inlinks) {
+			if (rel->from->type == DEG_NODE_TYPE_OPERATION &&
+			    (rel->flag & DEPSREL_FLAG_CYCLIC) == 0)
+			{
+				layout->parents[num_parents++] = rel->from->tag;
+			}
+		}
+	}
+	layout->children_offset[num_operations] = num_children;
+	layout->parents_offset[num_operations] = num_parents;
+
+	const size_t state_size = sizeof(DepsgraphEvalOperationState) * max_ii(num_operations, 1);
+	layout->state = (DepsgraphEvalOperationState *)MEM_mallocN_aligned(
+	        state_size, sizeof(DepsgraphEvalOperationState), "DepsgraphEvalLayout state");
+	memset(layout->state, 0, state_size);
+
+	return layout;
+}
+
+void deg_eval_layout_free(DepsgraphEvalLayout *layout)
+{
+	MEM_freeN(layout->operations);
+	MEM_freeN(layout->children_offset);
+	MEM_freeN(layout->children);
+	MEM_freeN(layout->parents_offset);
+	MEM_freeN(layout->parents);
+	MEM_freeN(layout->state);
+	OBJECT_GUARDED_DELETE(layout, DepsgraphEvalLayout);
+}
+
+}  // namespace DEG
@@ -0,0 +1,77 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/eval/deg_eval_layout.h
+ *  \ingroup depsgraph
+ *
+ * Flat layout of the operations relations, used by the evaluation.
+ */
+
+#pragma once
+
+#include "intern/depsgraph_types.h"
+
+namespace DEG {
+
+struct Depsgraph;
+struct OperationDepsNode;
+
+/* Relation from an operation to another one, index in the layout. */
+struct DepsgraphEvalRelation {
+	int operation;
+	bool is_cyclic;
+};
+
+/* Evaluation state of an operation, each one on its own cache line so threads
+ * updating operations next to each other don't invalidate each other's cache.
+ */
+struct DepsgraphEvalOperationState {
+	/* How many inputs are we still waiting on before we can be evaluated. */
+	uint32_t num_links_pending;
+	uint8_t scheduled;
+	char _pad[64 - sizeof(uint32_t) - sizeof(uint8_t)];
+};
+
+/* Operations and their relations in compressed sparse rows: the relations of
+ * operation i are stored in [offset[i], offset[i + 1]) of the relations array.
+ *
+ * Built once the graph relations are built, so evaluation walks contiguous
+ * arrays instead of the relations pointers of every node.
+ */
+struct DepsgraphEvalLayout {
+	int num_operations;
+	/* Same order as Depsgraph.operations. */
+	OperationDepsNode **operations;
+
+	/* Operations which depend on each operation. */
+	int *children_offset;
+	DepsgraphEvalRelation *children;
+
+	/* Operations each operation depends on, without cyclic relations. */
+	int *parents_offset;
+	int *parents;
+
+	DepsgraphEvalOperationState *state;
+};
+
+DepsgraphEvalLayout *deg_eval_layout_build(Depsgraph *graph);
+void deg_eval_layout_free(DepsgraphEvalLayout *layout);
+
+}  // namespace DEG
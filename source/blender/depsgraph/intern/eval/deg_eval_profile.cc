@@ -0,0 +1,257 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/eval/deg_eval_profile.cc
+ *  \ingroup depsgraph
+ *
+ * Profiling of the operations evaluation.
+ *
+ * When enabled, every evaluated operation is recorded in a ring buffer with its wall time,
+ * the thread it ran on and how long it waited between being ready and being started.
+ * Only the most recent operations are kept, so it can stay enabled during playback.
+ */
+
+#include "intern/eval/deg_eval_profile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+#include "MEM_guardedalloc.h"
+
+#include "PIL_time.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_string.h"
+
+extern "C" {
+#include "DNA_ID.h"
+}  /* extern "C" */
+
+#include "atomic_ops.h"
+
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_operation.h"
+#include "intern/depsgraph_intern.h"
+#include "util/deg_util_foreach.h"
+
+namespace DEG {
+
+/* Number of operations kept, the oldest ones are overwritten. */
+#define PROFILE_EVENTS_NUM (1 << 15)
+
+struct ProfileEvent {
+	char id_name[MAX_ID_NAME];
+	char component_name[64];
+	char operation_name[64];
+	eDepsNode_Type component_type;
+	eDepsOperation_Code opcode;
+	int thread_id;
+	double ready_time;
+	double start_time;
+	double end_time;
+};
+
+bool deg_eval_profile_enabled = false;
+
+static ProfileEvent *profile_events = NULL;
+/* Number of recorded events, the next one goes in (head % PROFILE_EVENTS_NUM). */
+static uint32_t profile_events_head = 0;
+/* Time origin of the trace. */
+static double profile_start_time = 0.0;
+
+void deg_eval_profile_record(const OperationDepsNode *node,
+                             const int thread_id,
+                             const double ready_time,
+                             const double start_time,
+                             const double end_time)
+{
+	if (profile_events == NULL) {
+		return;
+	}
+
+	const uint32_t index = atomic_fetch_and_add_uint32(&profile_events_head, 1) % PROFILE_EVENTS_NUM;
+	ProfileEvent *event = &profile_events[index];
+	const ComponentDepsNode *comp_node = node->owner;
+	const IDDepsNode *id_node = comp_node->owner;
+
+	BLI_strncpy(event->id_name, id_node->id ? id_node->id->name : "", sizeof(event->id_name));
+	BLI_strncpy(event->component_name, comp_node->name, sizeof(event->component_name));
+	BLI_strncpy(event->operation_name, node->name, sizeof(event->operation_name));
+	event->component_type = comp_node->type;
+	event->opcode = node->opcode;
+	event->thread_id = thread_id;
+	event->ready_time = ready_time;
+	event->start_time = start_time;
+	event->end_time = end_time;
+}
+
+void deg_eval_profile_enable(const bool enable)
+{
+	if (enable && profile_events == NULL) {
+		profile_events = (ProfileEvent *)MEM_mallocN(sizeof(ProfileEvent) * PROFILE_EVENTS_NUM,
+		                                             "Depsgraph Profile Events");
+		deg_eval_profile_clear();
+	}
+	/* Events are kept when disabling, so they can still be written. */
+	deg_eval_profile_enabled = enable;
+}
+
+void deg_eval_profile_clear()
+{
+	profile_events_head = 0;
+	profile_start_time = PIL_check_seconds_timer();
+}
+
+void deg_eval_profile_free()
+{
+	deg_eval_profile_enabled = false;
+	MEM_SAFE_FREE(profile_events);
+	profile_events_head = 0;
+}
+
+/* Recorded events, oldest first. */
+static uint32_t profile_events_num()
+{
+	return (profile_events != NULL) ? std::min(profile_events_head, (uint32_t)PROFILE_EVENTS_NUM) : 0;
+}
+
+static const ProfileEvent *profile_event_get(const uint32_t i)
+{
+	return &profile_events[(profile_events_head - profile_events_num() + i) % PROFILE_EVENTS_NUM];
+}
+
+static const char *profile_event_operation_name(const ProfileEvent *event)
+{
+	return (event->operation_name[0] != '\0') ? event->operation_name : DEG_OPNAMES[event->opcode];
+}
+
+static void json_write_string(FILE *stream, const char *str)
+{
+	fputc('"', stream);
+	for (; *str; str++) {
+		const unsigned char c = (unsigned char)*str;
+		if (ELEM(c, '"', '\\')) {
+			fprintf(stream, "\\%c", c);
+		}
+		else if (c < 0x20) {
+			fprintf(stream, "\\u%04x", c);
+		}
+		else {
+			fputc(c, stream);
+		}
+	}
+	fputc('"', stream);
+}
+
+/**
+ * Write the recorded operations in the Chrome trace event format,
+ * which can be loaded in chrome://tracing.
+ */
+bool deg_eval_profile_write_chrome_trace(FILE *stream)
+{
+	const uint32_t num_events = profile_events_num();
+
+	fprintf(stream, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	for (uint32_t i = 0; i < num_events; i++) {
+		const ProfileEvent *event = profile_event_get(i);
+		const DepsNodeFactory *factory = deg_get_node_factory(event->component_type);
+
+		fprintf(stream, "{\"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"name\": ",
+		        event->thread_id,
+		        (event->start_time - profile_start_time) * 1e6,
+		        (event->end_time - event->start_time) * 1e6);
+		json_write_string(stream, profile_event_operation_name(event));
+		fprintf(stream, ", \"cat\": ");
+		json_write_string(stream, factory->tname());
+		fprintf(stream, ", \"args\": {\"id\": ");
+		json_write_string(stream, event->id_name);
+		fprintf(stream, ", \"component\": ");
+		json_write_string(stream, event->component_name);
+		fprintf(stream, ", \"wait_us\": %.3f}}%s\n",
+		        (event->start_time - event->ready_time) * 1e6,
+		        (i + 1 < num_events) ? "," : "");
+	}
+	fprintf(stream, "]}\n");
+
+	return (ferror(stream) == 0);
+}
+
+struct ProfileSummary {
+	ProfileSummary() : count(0), total(0.0), max(0.0), wait(0.0) {}
+
+	string id_name;
+	string component_name;
+	int count;
+	double total;
+	double max;
+	double wait;
+};
+
+static bool profile_summary_total_greater(const ProfileSummary *a, const ProfileSummary *b)
+{
+	return a->total > b->total;
+}
+
+/**
+ * Print the time spent in each component of each ID, slowest first.
+ */
+void deg_eval_profile_write_summary(FILE *stream)
+{
+	const uint32_t num_events = profile_events_num();
+	std::map<string, ProfileSummary> summaries;
+	vector<ProfileSummary *> sorted;
+	double total = 0.0;
+
+	for (uint32_t i = 0; i < num_events; i++) {
+		const ProfileEvent *event = profile_event_get(i);
+		const double duration = event->end_time - event->start_time;
+		ProfileSummary &summary = summaries[string(event->id_name) + '\t' + event->component_name];
+
+		/* Skip the ID code. */
+		summary.id_name = (event->id_name[0] != '\0') ? event->id_name + 2 : "-";
+		summary.component_name = event->component_name;
+		summary.count++;
+		summary.total += duration;
+		summary.max = std::max(summary.max, duration);
+		summary.wait += event->start_time - event->ready_time;
+		total += duration;
+	}
+
+	for (std::map<string, ProfileSummary>::iterator it = summaries.begin(); it != summaries.end(); ++it) {
+		sorted.push_back(&it->second);
+	}
+	std::sort(sorted.begin(), sorted.end(), profile_summary_total_greater);
+
+	fprintf(stream, "Depsgraph profile: %u operations, %.3f ms\n", num_events, total * 1000.0);
+	fprintf(stream, "%10s %8s %10s %10s  %s\n", "Total ms", "Count", "Max ms", "Wait ms", "ID / Component");
+	foreach (const ProfileSummary *summary, sorted) {
+		fprintf(stream, "%10.3f %8d %10.3f %10.3f  %s / %s\n",
+		        summary->total * 1000.0,
+		        summary->count,
+		        summary->max * 1000.0,
+		        summary->wait * 1000.0,
+		        summary->id_name.c_str(),
+		        summary->component_name.c_str());
+	}
+}
+
+}  // namespace DEG
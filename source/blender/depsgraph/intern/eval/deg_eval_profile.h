@@ -0,0 +1,56 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/eval/deg_eval_profile.h
+ *  \ingroup depsgraph
+ *
+ * Profiling of the operations evaluation, can be enabled at runtime.
+ */
+
+#pragma once
+
+#include <cstdio>
+
+namespace DEG {
+
+struct OperationDepsNode;
+
+extern bool deg_eval_profile_enabled;
+
+inline bool deg_eval_profile_is_enabled()
+{
+	return deg_eval_profile_enabled;
+}
+
+/* Record an evaluated operation, times are from PIL_check_seconds_timer(). */
+void deg_eval_profile_record(const OperationDepsNode *node,
+                             const int thread_id,
+                             const double ready_time,
+                             const double start_time,
+                             const double end_time);
+
+void deg_eval_profile_enable(const bool enable);
+void deg_eval_profile_clear();
+void deg_eval_profile_free();
+
+bool deg_eval_profile_write_chrome_trace(FILE *stream);
+void deg_eval_profile_write_summary(FILE *stream);
+
+}  // namespace DEG
@@ -172,9 +172,10 @@ void IDDepsNode::init(const ID *id, const char *UNUSED(subdata))
 		this->layers = 0;
 	}
 
-	components = BLI_ghash_new(id_deps_node_hash_key,
-	                           id_deps_node_hash_key_cmp,
-	                           "Depsgraph id components hash");
+	components = BLI_ghash_new_open_ex(id_deps_node_hash_key,
+	                                   id_deps_node_hash_key_cmp,
+	                                   "Depsgraph id components hash",
+	                                   0);
 
 	/* NOTE: components themselves are created if/when needed.
 	 * This prevents problems with components getting added
@@ -126,9 +126,10 @@ ComponentDepsNode::ComponentDepsNode() :
     exit_operation(NULL),
     layers(0)
 {
-	operations_map = BLI_ghash_new(comp_node_hash_key,
-	                               comp_node_hash_key_cmp,
-	                               "Depsgraph id hash");
+	operations_map = BLI_ghash_new_open_ex(comp_node_hash_key,
+	                                       comp_node_hash_key_cmp,
+	                                       "Depsgraph id hash",
+	                                       0);
 }
 
 /* Initialize 'component' node - from pointer data given */
@@ -165,7 +166,7 @@ string ComponentDepsNode::identifier() const
 
 OperationDepsNode *ComponentDepsNode::find_operation(OperationIDKey key) const
 {
-	OperationDepsNode *node = reinterpret_cast<OperationDepsNode *>(BLI_ghash_lookup(operations_map, &key));
+	OperationDepsNode *node = has_operation(key);
 	if (node != NULL) {
 		return node;
 	}
@@ -187,7 +188,21 @@ OperationDepsNode *ComponentDepsNode::find_operation(eDepsOperation_Code opcode,
 
 OperationDepsNode *ComponentDepsNode::has_operation(OperationIDKey key) const
 {
-	return reinterpret_cast<OperationDepsNode *>(BLI_ghash_lookup(operations_map, &key));
+	if (operations_map != NULL) {
+		return reinterpret_cast<OperationDepsNode *>(BLI_ghash_lookup(operations_map, &key));
+	}
+	/* Component was finalized already, happens when the graph is rebuilt
+	 * incrementally. There are only a few operations per component.
+	 */
+	foreach (OperationDepsNode *op_node, operations) {
+		if (op_node->opcode == key.opcode &&
+		    op_node->name_tag == key.name_tag &&
+		    STREQ(op_node->name, key.name))
+		{
+			return op_node;
+		}
+	}
+	return NULL;
 }
 
 OperationDepsNode *ComponentDepsNode::has_operation(eDepsOperation_Code opcode,
@@ -209,8 +224,13 @@ OperationDepsNode *ComponentDepsNode::add_operation(const DepsEvalOperationCb& o
 		op_node = (OperationDepsNode *)factory->create_node(this->owner->id, "", name);
 
 		/* register opnode in this component's operation set */
-		OperationIDKey *key = OBJECT_GUARDED_NEW(OperationIDKey, opcode, name, name_tag);
-		BLI_ghash_insert(operations_map, key, op_node);
+		if (operations_map != NULL) {
+			OperationIDKey *key = OBJECT_GUARDED_NEW(OperationIDKey, opcode, name, name_tag);
+			BLI_ghash_insert(operations_map, key, op_node);
+		}
+		else {
+			operations.push_back(op_node);
+		}
 
 		/* set backlink */
 		op_node->owner = this;
@@ -225,6 +245,7 @@ OperationDepsNode *ComponentDepsNode::add_operation(const DepsEvalOperationCb& o
 	op_node->evaluate = op;
 	op_node->opcode = opcode;
 	op_node->name = name;
+	op_node->name_tag = name_tag;
 
 	return op_node;
 }
@@ -321,6 +342,10 @@ OperationDepsNode *ComponentDepsNode::get_exit_operation()
 
 void ComponentDepsNode::finalize_build()
 {
+	if (operations_map == NULL) {
+		/* Kept from before an incremental rebuild. */
+		return;
+	}
 	operations.reserve(BLI_ghash_size(operations_map));
 	GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, operations_map)
 	{
@@ -385,6 +410,7 @@ void BoneComponentDepsNode::init(const ID *id, const char *subdata)
 	/* bone-specific node data */
 	Object *ob = (Object *)id;
 	this->pchan = BKE_pose_channel_find_name(ob->pose, subdata);
+	this->is_batched = false;
 }
 
 DEG_DEPSNODE_DEFINE(BoneComponentDepsNode, DEG_NODE_TYPE_BONE, "Bone Component");
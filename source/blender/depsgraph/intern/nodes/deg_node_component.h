@@ -138,7 +138,8 @@ struct ComponentDepsNode : public DepsNode {
 	/* ** Inner nodes for this component ** */
 
 	/* Operations stored as a hash map, for faster build.
-	 * This hash map will be freed when graph is fully built.
+	 * This hash map will be freed when graph is fully built, lookups done
+	 * by incremental rebuilds afterwards go through the operations list.
 	 */
 	GHash *operations_map;
 
@@ -191,6 +192,7 @@ struct BoneComponentDepsNode : public ComponentDepsNode {
 	void init(const ID *id, const char *subdata);
 
 	struct bPoseChannel *pchan;     /* the bone that this component represents */
+	bool is_batched;                /* evaluated by the pose's bone batch operation */
 
 	DEG_DEPSNODE_DECLARE;
 };
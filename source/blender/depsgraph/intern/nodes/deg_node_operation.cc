@@ -45,6 +45,9 @@ namespace DEG {
 
 OperationDepsNode::OperationDepsNode() :
     eval_priority(0.0f),
+    eval_cost(0.0f),
+    ready_time(0.0),
+    name_tag(-1),
     flag(0),
     customdata_mask(0)
 {
@@ -79,11 +79,20 @@ struct OperationDepsNode : public DepsNode {
 
 	/* How many inlinks are we still waiting on before we can be evaluated. */
 	uint32_t num_links_pending;
+	/* Longest remaining path to the graph sinks, in seconds of evaluation. */
 	float eval_priority;
+	/* Time the operation took, smoothed over the evaluations it was part of. */
+	float eval_cost;
+	/* Time all the inputs were evaluated, only set when profiling. */
+	double ready_time;
 	bool scheduled;
 
 	/* Identifier for the operation being performed. */
 	eDepsOperation_Code opcode;
+	/* Disambiguates operations with the same opcode and name, see
+	 * ComponentDepsNode::OperationIDKey.
+	 */
+	int name_tag;
 
 	/* (eDepsOperation_Flag) extra settings affecting evaluation. */
 	int flag;
@@ -1199,6 +1199,9 @@ static int bake_exec(bContext *C, wmOperator *op)
 
 	RE_SetReports(re, bkr.reports);
 
+	/* keep the engine and its synced scene alive across all objects */
+	RE_bake_engine_batch_begin(re);
+
 	if (bkr.is_selected_to_active) {
 		result = bake(
 		        bkr.render, bkr.main, bkr.scene, bkr.ob, &bkr.selected_objects, bkr.reports,
@@ -1223,6 +1226,8 @@ static int bake_exec(bContext *C, wmOperator *op)
 		}
 	}
 
+	RE_bake_engine_batch_end(re);
+
 	RE_SetReports(re, NULL);
 
 
@@ -1257,6 +1262,9 @@ static void bake_startjob(void *bkv, short *UNUSED(stop), short *do_update, floa
 		bake_images_clear(bkr->main, is_tangent);
 	}
 
+	/* keep the engine and its synced scene alive across all objects */
+	RE_bake_engine_batch_begin(bkr->render);
+
 	if (bkr->is_selected_to_active) {
 		bkr->result = bake(
 		        bkr->render, bkr->main, bkr->scene, bkr->ob, &bkr->selected_objects, bkr->reports,
@@ -1280,10 +1288,15 @@ static void bake_startjob(void *bkv, short *UNUSED(stop), short *do_update, floa
 			        bkr->uv_layer);
 
 			if (bkr->result == OPERATOR_CANCELLED)
-				return;
+				break;
 		}
 	}
 
+	RE_bake_engine_batch_end(bkr->render);
+
+	if (bkr->result == OPERATOR_CANCELLED)
+		return;
+
 	RE_SetReports(bkr->render, NULL);
 }
 
@@ -93,6 +93,22 @@ static void modifier_skin_customdata_delete(struct Object *ob);
 
 /******************************** API ****************************/
 
+/* Tag relations for update after adding or removing a modifier. Some modifiers
+ * are looked up by other objects in the scene, only rebuild relations of the
+ * object itself for the others.
+ */
+static void object_modifier_relations_tag_update(Main *bmain, Object *ob, int type)
+{
+	if (ELEM(type, eModifierType_Collision, eModifierType_Surface, eModifierType_ParticleSystem,
+	         eModifierType_Smoke, eModifierType_DynamicPaint, eModifierType_Fluidsim))
+	{
+		DAG_relations_tag_update(bmain);
+	}
+	else {
+		DAG_id_relations_tag_update(bmain, &ob->id);
+	}
+}
+
 ModifierData *ED_object_modifier_add(ReportList *reports, Main *bmain, Scene *scene, Object *ob, const char *name, int type)
 {
 	ModifierData *md = NULL, *new_md = NULL;
@@ -172,7 +188,7 @@ ModifierData *ED_object_modifier_add(ReportList *reports, Main *bmain, Scene *sc
 	}
 
 	DAG_id_tag_update(&ob->id, OB_RECALC_DATA);
-	DAG_relations_tag_update(bmain);
+	object_modifier_relations_tag_update(bmain, ob, type);
 
 	return new_md;
 }
@@ -320,7 +336,7 @@ static bool object_modifier_remove(Main *bmain, Object *ob, ModifierData *md,
 		ob->mode &= ~OB_MODE_PARTICLE_EDIT;
 	}
 
-	DAG_relations_tag_update(bmain);
+	object_modifier_relations_tag_update(bmain, ob, md->type);
 
 	BLI_remlink(&ob->modifiers, md);
 	modifier_free(md);
@@ -341,8 +357,8 @@ bool ED_object_modifier_remove(ReportList *reports, Main *bmain, Object *ob, Mod
 		return 0;
 	}
 
+	/* Relations are tagged by object_modifier_remove(). */
 	DAG_id_tag_update(&ob->id, OB_RECALC_DATA);
-	DAG_relations_tag_update(bmain);
 
 	return 1;
 }
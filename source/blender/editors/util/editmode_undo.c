@@ -117,6 +117,7 @@ void undo_editmode_push(bContext *C, const char *name,
 	void *editdata;
 	int nr;
 	uintptr_t memused, totmem, maxmem;
+	const eMemScope mem_scope = MEM_scope_begin(MEM_SCOPE_UNDO);
 
 	/* at first here was code to prevent an "original" key to be inserted twice
 	 * this was giving conflicts for example when mesh changed due to keys or apply */
@@ -156,10 +157,10 @@ void undo_editmode_push(bContext *C, const char *name,
 	}
 
 	/* copy  */
-	memused = MEM_get_memory_in_use();
+	memused = MEM_get_scope_memory_in_use(MEM_SCOPE_UNDO);
 	editdata = getdata(C);
 	curundo->undodata = curundo->from_editmode(editdata, obedit->data);
-	curundo->undosize = MEM_get_memory_in_use() - memused;
+	curundo->undosize = MEM_get_scope_memory_in_use(MEM_SCOPE_UNDO) - memused;
 	curundo->ob = obedit;
 	curundo->id = obedit->id;
 	curundo->type = obedit->type;
@@ -187,6 +188,8 @@ void undo_editmode_push(bContext *C, const char *name,
 			}
 		}
 	}
+
+	MEM_scope_end(mem_scope);
 }
 
 /* helper to remove clean other objects from undo stack */
@@ -363,6 +363,7 @@ bool imb_enlargeencodedbufferImBuf(ImBuf *ibuf)
 
 bool imb_addrectfloatImBuf(ImBuf *ibuf)
 {
+	eMemScope mem_scope;
 	size_t size;
 	
 	if (ibuf == NULL) return false;
@@ -373,7 +374,11 @@ bool imb_addrectfloatImBuf(ImBuf *ibuf)
 	size = (size_t)ibuf->x * (size_t)ibuf->y * sizeof(float[4]);
 
 	ibuf->channels = 4;
-	if ((ibuf->rect_float = MEM_mapallocN(size, __func__))) {
+	mem_scope = MEM_scope_begin(MEM_SCOPE_IMAGE);
+	ibuf->rect_float = MEM_mapallocN(size, __func__);
+	MEM_scope_end(mem_scope);
+
+	if (ibuf->rect_float) {
 		ibuf->mall |= IB_rectfloat;
 		ibuf->flags |= IB_rectfloat;
 		return true;
@@ -385,6 +390,7 @@ bool imb_addrectfloatImBuf(ImBuf *ibuf)
 /* question; why also add zbuf? */
 bool imb_addrectImBuf(ImBuf *ibuf)
 {
+	eMemScope mem_scope;
 	size_t size;
 
 	if (ibuf == NULL) return false;
@@ -396,7 +402,11 @@ bool imb_addrectImBuf(ImBuf *ibuf)
 	
 	size = (size_t)ibuf->x * (size_t)ibuf->y * sizeof(unsigned int);
 
-	if ((ibuf->rect = MEM_mapallocN(size, __func__))) {
+	mem_scope = MEM_scope_begin(MEM_SCOPE_IMAGE);
+	ibuf->rect = MEM_mapallocN(size, __func__);
+	MEM_scope_end(mem_scope);
+
+	if (ibuf->rect) {
 		ibuf->mall |= IB_rect;
 		ibuf->flags |= IB_rect;
 		if (ibuf->planes > 32) {
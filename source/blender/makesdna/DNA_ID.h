@@ -339,6 +339,8 @@ enum {
 	/* RESET_AFTER_USE tag newly duplicated/copied IDs.
 	 * Also used internally in readfile.c to mark datablocks needing do_versions. */
 	LIB_TAG_NEW             = 1 << 8,
+	/* RESET_AFTER_USE tag datablocks kept as is from the previous state by undo, instead of being read again. */
+	LIB_TAG_UNDO_OLD_ID_REUSED = 1 << 9,
 	/* RESET_BEFORE_USE free test flag.
      * TODO make it a RESET_AFTER_USE too. */
 	LIB_TAG_DOIT            = 1 << 10,
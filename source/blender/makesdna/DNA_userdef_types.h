@@ -698,6 +698,7 @@ typedef enum eUserpref_UI_Flag2 {
 	USER_KEEP_SESSION			= (1 << 0),
 	USER_REGION_OVERLAP			= (1 << 1),
 	USER_TRACKPAD_NATURAL		= (1 << 2),
+	USER_GLOBALUNDO_COMPRESS	= (1 << 3),
 } eUserpref_UI_Flag2;
 	
 /* Auto-Keying mode.
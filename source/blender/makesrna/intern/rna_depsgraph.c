@@ -40,6 +40,8 @@
 
 #ifdef RNA_RUNTIME
 
+#include "BLI_fileops.h"
+
 #include "BKE_report.h"
 
 #include "DEG_depsgraph_debug.h"
@@ -65,6 +67,48 @@ static void rna_Depsgraph_debug_rebuild(Depsgraph *UNUSED(graph), Main *bmain)
 	}
 }
 
+static int rna_Depsgraph_use_debug_profile_get(PointerRNA *UNUSED(ptr))
+{
+	return DEG_debug_profile_is_enabled();
+}
+
+static void rna_Depsgraph_use_debug_profile_set(PointerRNA *UNUSED(ptr), int value)
+{
+	DEG_debug_profile_enable(value != 0);
+}
+
+static void rna_Depsgraph_debug_profile_clear(Depsgraph *UNUSED(graph))
+{
+	DEG_debug_profile_clear();
+}
+
+static void rna_Depsgraph_debug_profile_write(Depsgraph *UNUSED(graph), ReportList *reports, const char *filename)
+{
+	if (!DEG_debug_profile_write_chrome_trace(filename)) {
+		BKE_reportf(reports, RPT_ERROR, "Cannot write profile to '%s'", filename);
+	}
+}
+
+static void rna_Depsgraph_debug_profile_summary(Depsgraph *UNUSED(graph), ReportList *reports, const char *filename)
+{
+	FILE *f;
+
+	if (filename[0] == '\0') {
+		DEG_debug_profile_print_summary(stdout);
+		return;
+	}
+
+	f = BLI_fopen(filename, "w");
+	if (f == NULL) {
+		BKE_reportf(reports, RPT_ERROR, "Cannot write profile summary to '%s'", filename);
+		return;
+	}
+
+	DEG_debug_profile_print_summary(f);
+
+	fclose(f);
+}
+
 static void rna_Depsgraph_debug_stats(Depsgraph *graph, ReportList *reports)
 {
 	size_t outer, ops, rels;
@@ -85,7 +129,7 @@ static void rna_def_depsgraph(BlenderRNA *brna)
 {
 	StructRNA *srna;
 	FunctionRNA *func;
-	PropertyRNA *parm;
+	PropertyRNA *parm, *prop;
 
 	srna = RNA_def_struct(brna, "Depsgraph", NULL);
 	RNA_def_struct_ui_text(srna, "Dependency Graph", "");
@@ -101,6 +145,27 @@ static void rna_def_depsgraph(BlenderRNA *brna)
 	func = RNA_def_function(srna, "debug_stats", "rna_Depsgraph_debug_stats");
 	RNA_def_function_ui_description(func, "Report the number of elements in the Dependency Graph");
 	RNA_def_function_flag(func, FUNC_USE_REPORTS);
+
+	prop = RNA_def_property(srna, "use_debug_profile", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_funcs(prop, "rna_Depsgraph_use_debug_profile_get", "rna_Depsgraph_use_debug_profile_set");
+	RNA_def_property_ui_text(prop, "Profile Evaluation",
+	                         "Record the time, thread and wait time of the most recent evaluated operations");
+
+	func = RNA_def_function(srna, "debug_profile_clear", "rna_Depsgraph_debug_profile_clear");
+	RNA_def_function_ui_description(func, "Clear the recorded evaluation profile");
+
+	func = RNA_def_function(srna, "debug_profile_write", "rna_Depsgraph_debug_profile_write");
+	RNA_def_function_ui_description(func, "Write the recorded evaluation profile as Chrome trace JSON");
+	RNA_def_function_flag(func, FUNC_USE_REPORTS);
+	parm = RNA_def_string_file_path(func, "filename", NULL, FILE_MAX, "File Name",
+	                                "File in which to store the trace, for chrome://tracing");
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+
+	func = RNA_def_function(srna, "debug_profile_summary", "rna_Depsgraph_debug_profile_summary");
+	RNA_def_function_ui_description(func, "Write the time spent in each component of each ID, slowest first");
+	RNA_def_function_flag(func, FUNC_USE_REPORTS);
+	RNA_def_string_file_path(func, "filename", NULL, FILE_MAX, "File Name",
+	                         "File in which to store the summary, print it when empty");
 }
 
 void RNA_def_depsgraph(BlenderRNA *brna)
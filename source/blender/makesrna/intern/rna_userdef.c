@@ -3641,6 +3641,12 @@ static void rna_def_userdef_edit(BlenderRNA *brna)
 	                         "Global undo works by keeping a full copy of the file itself in memory, "
 	                         "so takes extra memory");
 
+	prop = RNA_def_property(srna, "use_global_undo_compress", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "uiflag2", USER_GLOBALUNDO_COMPRESS);
+	RNA_def_property_ui_text(prop, "Compress Undo",
+	                         "Compress the global undo steps which aren't next to the current one "
+	                         "(less memory, slower to undo further back)");
+
 	/* auto keyframing */
 	prop = RNA_def_property(srna, "use_auto_keying", PROP_BOOLEAN, PROP_NONE);
 	RNA_def_property_boolean_sdna(prop, NULL, "autokey_mode", AUTOKEY_ON);
@@ -47,6 +47,8 @@
 #include "bpy_app_handlers.h"
 #include "bpy_driver.h"
 
+#include "MEM_guardedalloc.h"
+
 #include "BLI_utildefines.h"
 
 #include "BKE_appdir.h"
@@ -343,6 +345,26 @@ static PyObject *bpy_app_preview_render_size_get(PyObject *UNUSED(self), void *c
 	return PyLong_FromLong((long)UI_preview_render_size(GET_INT_FROM_POINTER(closure)));
 }
 
+PyDoc_STRVAR(bpy_app_memory_scopes_doc,
+"Dictionary of the memory in use and peak memory in bytes of each subsystem, as (in_use, peak) tuples (read-only)"
+);
+static PyObject *bpy_app_memory_scopes_get(PyObject *UNUSED(self), void *UNUSED(closure))
+{
+	PyObject *dict = PyDict_New();
+	int scope;
+
+	for (scope = 0; scope < MEM_SCOPE_TOT; scope++) {
+		PyObject *item = PyTuple_New(2);
+		PyTuple_SET_ITEMS(item,
+		        PyLong_FromSize_t(MEM_get_scope_memory_in_use((eMemScope)scope)),
+		        PyLong_FromSize_t(MEM_get_scope_peak_memory((eMemScope)scope)));
+		PyDict_SetItemString(dict, MEM_scope_name((eMemScope)scope), item);
+		Py_DECREF(item);
+	}
+
+	return dict;
+}
+
 static PyObject *bpy_app_autoexec_fail_message_get(PyObject *UNUSED(self), void *UNUSED(closure))
 {
 	return PyC_UnicodeFromByte(G.autoexec_fail);
@@ -366,6 +388,7 @@ static PyGetSetDef bpy_app_getsets[] = {
 	{(char *)"debug_value", bpy_app_debug_value_get, bpy_app_debug_value_set, (char *)bpy_app_debug_value_doc, NULL},
 	{(char *)"tempdir", bpy_app_tempdir_get, NULL, (char *)bpy_app_tempdir_doc, NULL},
 	{(char *)"driver_namespace", bpy_app_driver_dict_get, NULL, (char *)bpy_app_driver_dict_doc, NULL},
+	{(char *)"memory_scopes", bpy_app_memory_scopes_get, NULL, (char *)bpy_app_memory_scopes_doc, NULL},
 
 	{(char *)"render_icon_size", bpy_app_preview_render_size_get, NULL, (char *)bpy_app_preview_render_size_doc, (void *)ICON_SIZE_ICON},
 	{(char *)"render_preview_size", bpy_app_preview_render_size_get, NULL, (char *)bpy_app_preview_render_size_doc, (void *)ICON_SIZE_PREVIEW},
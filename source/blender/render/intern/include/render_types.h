@@ -648,6 +648,7 @@ typedef struct LampRen {
 #define R_BAKING		64
 #define R_ANIMATION		128
 #define R_NEED_VCOL		256
+#define R_BAKE_BATCH	512
 
 /* vlakren->flag (vlak = face in dutch) char!!! */
 #define R_SMOOTH		1
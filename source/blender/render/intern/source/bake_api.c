@@ -69,6 +69,8 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "DNA_mesh_types.h"
 
@@ -265,19 +267,19 @@ static void calc_point_from_barycentric_extrusion(
 
 /**
  * This function populates pixel_array and returns TRUE if things are correct
+ *
+ * \param hits: Scratch storage for \a tot_highpoly ray hits, owned by the calling thread.
  */
 static bool cast_ray_highpoly(
         BVHTreeFromMesh *treeData, TriTessFace *triangle_low, TriTessFace *triangles[],
         BakePixel *pixel_array_low, BakePixel *pixel_array, float mat_low[4][4], BakeHighPolyData *highpoly,
-        const float co[3], const float dir[3], const int pixel_id, const int tot_highpoly)
+        const float co[3], const float dir[3], const int pixel_id, const int tot_highpoly,
+        BVHTreeRayHit *hits)
 {
 	int i;
 	int hit_mesh = -1;
 	float hit_distance = FLT_MAX;
 
-	BVHTreeRayHit *hits;
-	hits = MEM_mallocN(sizeof(BVHTreeRayHit) * tot_highpoly, "Bake Highpoly to Lowpoly: BVH Rays");
-
 	for (i = 0; i < tot_highpoly; i++) {
 		float co_high[3], dir_high[3];
 
@@ -367,7 +369,6 @@ static bool cast_ray_highpoly(
 		pixel_array[pixel_id].object_id = -1;
 	}
 
-	MEM_freeN(hits);
 	return hit_mesh != -1;
 }
 
@@ -476,14 +477,96 @@ static TriTessFace *mesh_calc_tri_tessface(
 	return triangles;
 }
 
+/* Number of pixels each task looks up, large enough to amortize scheduling. */
+#define BAKE_HIGHPOLY_TILE_SIZE 4096
+
+typedef struct BakeHighPolyTaskData {
+	BakePixel *pixel_array_from;
+	BakePixel *pixel_array_to;
+	size_t num_pixels;
+
+	BakeHighPolyData *highpoly;
+	int tot_highpoly;
+	BVHTreeFromMesh *treeData;
+
+	TriTessFace *tris_low;
+	TriTessFace *tris_cage;
+	TriTessFace **tris_high;
+
+	float (*mat_low)[4];
+	float (*imat_low)[4];
+	float (*mat_cage)[4];
+	float cage_extrusion;
+	bool is_cage;
+	bool is_custom_cage;
+
+	/* tot_highpoly hits per thread */
+	BVHTreeRayHit *hits;
+} BakeHighPolyTaskData;
+
+static void bake_highpoly_tile_cb_ex(
+        void *userdata, void *UNUSED(userdata_chunk), const int tile, const int thread_id)
+{
+	BakeHighPolyTaskData *data = userdata;
+	BakePixel *pixel_array_from = data->pixel_array_from;
+	BakePixel *pixel_array_to = data->pixel_array_to;
+	BVHTreeRayHit *hits = &data->hits[thread_id * data->tot_highpoly];
+
+	const size_t start = (size_t)tile * BAKE_HIGHPOLY_TILE_SIZE;
+	const size_t end = MIN2(start + BAKE_HIGHPOLY_TILE_SIZE, data->num_pixels);
+	size_t i;
+
+	for (i = start; i < end; i++) {
+		float co[3];
+		float dir[3];
+		float u, v;
+		TriTessFace *tri_low;
+		const int primitive_id = pixel_array_from[i].primitive_id;
+
+		if (primitive_id == -1) {
+			pixel_array_to[i].primitive_id = -1;
+			continue;
+		}
+
+		u = pixel_array_from[i].uv[0];
+		v = pixel_array_from[i].uv[1];
+
+		/* calculate from low poly mesh cage */
+		if (data->is_custom_cage) {
+			calc_point_from_barycentric_cage(
+			        data->tris_low, data->tris_cage, data->mat_low, data->mat_cage, primitive_id, u, v, co, dir);
+			tri_low = &data->tris_cage[primitive_id];
+		}
+		else if (data->is_cage) {
+			calc_point_from_barycentric_extrusion(
+			        data->tris_cage, data->mat_low, data->imat_low, primitive_id, u, v,
+			        data->cage_extrusion, co, dir, true);
+			tri_low = &data->tris_cage[primitive_id];
+		}
+		else {
+			calc_point_from_barycentric_extrusion(
+			        data->tris_low, data->mat_low, data->imat_low, primitive_id, u, v,
+			        data->cage_extrusion, co, dir, false);
+			tri_low = &data->tris_low[primitive_id];
+		}
+
+		/* cast ray */
+		if (!cast_ray_highpoly(data->treeData, tri_low, data->tris_high,
+		                       pixel_array_from, pixel_array_to, data->mat_low,
+		                       data->highpoly, co, dir, (int)i, data->tot_highpoly, hits))
+		{
+			/* if it fails mask out the original pixel array */
+			pixel_array_from[i].primitive_id = -1;
+		}
+	}
+}
+
 bool RE_bake_pixels_populate_from_objects(
         struct Mesh *me_low, BakePixel pixel_array_from[],  BakePixel pixel_array_to[],
         BakeHighPolyData highpoly[], const int tot_highpoly, const size_t num_pixels, const bool is_custom_cage,
         const float cage_extrusion, float mat_low[4][4], float mat_cage[4][4], struct Mesh *me_cage)
 {
-	size_t i;
-	int primitive_id;
-	float u, v;
+	int i;
 	float imat_low[4][4];
 	bool is_cage = me_cage != NULL;
 	bool result = true;
@@ -536,45 +619,37 @@ bool RE_bake_pixels_populate_from_objects(
 		}
 	}
 
-	for (i = 0; i < num_pixels; i++) {
-		float co[3];
-		float dir[3];
-		TriTessFace *tri_low;
-
-		primitive_id = pixel_array_from[i].primitive_id;
-
-		if (primitive_id == -1) {
-			pixel_array_to[i].primitive_id = -1;
-			continue;
-		}
-
-		u = pixel_array_from[i].uv[0];
-		v = pixel_array_from[i].uv[1];
-
-		/* calculate from low poly mesh cage */
-		if (is_custom_cage) {
-			calc_point_from_barycentric_cage(tris_low, tris_cage, mat_low, mat_cage, primitive_id, u, v, co, dir);
-			tri_low = &tris_cage[primitive_id];
-		}
-		else if (is_cage) {
-			calc_point_from_barycentric_extrusion(tris_cage, mat_low, imat_low, primitive_id, u, v, cage_extrusion, co, dir, true);
-			tri_low = &tris_cage[primitive_id];
-		}
-		else {
-			calc_point_from_barycentric_extrusion(tris_low, mat_low, imat_low, primitive_id, u, v, cage_extrusion, co, dir, false);
-			tri_low = &tris_low[primitive_id];
-		}
-
-		/* cast ray */
-		if (!cast_ray_highpoly(treeData, tri_low, tris_high,
-		                       pixel_array_from, pixel_array_to, mat_low,
-		                       highpoly, co, dir, i, tot_highpoly)) {
-			/* if it fails mask out the original pixel array */
-			pixel_array_from[i].primitive_id = -1;
-		}
+	{
+		const int num_threads = BLI_task_scheduler_num_threads(BLI_task_scheduler_get());
+		BakeHighPolyTaskData data = {
+			.pixel_array_from = pixel_array_from,
+			.pixel_array_to = pixel_array_to,
+			.num_pixels = num_pixels,
+			.highpoly = highpoly,
+			.tot_highpoly = tot_highpoly,
+			.treeData = treeData,
+			.tris_low = tris_low,
+			.tris_cage = tris_cage,
+			.tris_high = tris_high,
+			.mat_low = mat_low,
+			.imat_low = imat_low,
+			.mat_cage = mat_cage,
+			.cage_extrusion = cage_extrusion,
+			.is_cage = is_cage,
+			.is_custom_cage = is_custom_cage,
+		};
+		const int tot_tiles = (int)((num_pixels + BAKE_HIGHPOLY_TILE_SIZE - 1) / BAKE_HIGHPOLY_TILE_SIZE);
+
+		/* one ray hit buffer per worker thread, so tiles don't allocate per pixel */
+		data.hits = MEM_mallocN(sizeof(BVHTreeRayHit) * tot_highpoly * num_threads, "Bake Highpoly to Lowpoly: BVH Rays");
+
+		BLI_task_parallel_range_ex(
+		        0, tot_tiles, &data, NULL, 0, bake_highpoly_tile_cb_ex,
+		        tot_tiles > 1, true);
+
+		MEM_freeN(data.hits);
 	}
 
-
 	/* garbage collection */
 cleanup:
 	for (i = 0; i < tot_highpoly; i++) {
@@ -509,6 +509,7 @@ bool RE_bake_engine(
 	RenderEngineType *type = RE_engines_find(re->r.engine);
 	RenderEngine *engine;
 	bool persistent_data = (re->r.mode & R_PERSISTENT_DATA) != 0;
+	bool reuse_session;
 
 	/* set render info */
 	re->i.cfra = re->scene->r.cfra;
@@ -523,6 +524,9 @@ bool RE_bake_engine(
 		re->engine = engine;
 	}
 
+	/* engine was kept alive by an earlier bake of the same batch */
+	reuse_session = (engine->flag & RE_ENGINE_BAKE_BATCH) != 0;
+
 	engine->flag |= RE_ENGINE_RENDERING;
 
 	/* TODO: actually link to a parent which shouldn't happen */
@@ -535,8 +539,13 @@ bool RE_bake_engine(
 	engine->tile_x = re->r.tilex;
 	engine->tile_y = re->r.tiley;
 
-	/* update is only called so we create the engine.session */
-	if (type->update)
+	if (re->flag & R_BAKE_BATCH) {
+		engine->flag |= RE_ENGINE_BAKE_BATCH;
+	}
+
+	/* update is only called so we create the engine.session,
+	 * within a batch the session of the first bake is reused */
+	if (type->update && !reuse_session)
 		type->update(engine, re->main, re->scene);
 
 	if (type->bake)
@@ -548,8 +557,9 @@ bool RE_bake_engine(
 
 	BLI_rw_mutex_lock(&re->partsmutex, THREAD_LOCK_WRITE);
 
-	/* re->engine becomes zero if user changed active render engine during render */
-	if (!persistent_data || !re->engine) {
+	/* re->engine becomes zero if user changed active render engine during render,
+	 * inside a batch the engine is freed by RE_bake_engine_batch_end() */
+	if (!re->engine || !(persistent_data || (re->flag & R_BAKE_BATCH))) {
 		RE_engine_free(engine);
 		re->engine = NULL;
 	}
@@ -563,6 +573,37 @@ bool RE_bake_engine(
 	return true;
 }
 
+/**
+ * Bake many objects and passes with the same engine: between begin and end the
+ * engine (and the scene data it synced) is kept alive instead of being
+ * re-created for every #RE_bake_engine call.
+ */
+void RE_bake_engine_batch_begin(Render *re)
+{
+	re->flag |= R_BAKE_BATCH;
+}
+
+void RE_bake_engine_batch_end(Render *re)
+{
+	const bool persistent_data = (re->r.mode & R_PERSISTENT_DATA) != 0;
+
+	re->flag &= ~R_BAKE_BATCH;
+
+	BLI_rw_mutex_lock(&re->partsmutex, THREAD_LOCK_WRITE);
+
+	if (re->engine) {
+		if (persistent_data) {
+			re->engine->flag &= ~RE_ENGINE_BAKE_BATCH;
+		}
+		else {
+			RE_engine_free(re->engine);
+			re->engine = NULL;
+		}
+	}
+
+	BLI_rw_mutex_unlock(&re->partsmutex);
+}
+
 void RE_engine_frame_set(RenderEngine *engine, int frame, float subframe)
 {
 	Render *re = engine->re;
@@ -1283,6 +1283,9 @@ static void *do_render_thread(void *thread_v)
 {
 	RenderThread *thread = thread_v;
 	RenderPart *pa;
+
+	/* part threads are not reused, no need to restore the scope */
+	MEM_scope_begin(MEM_SCOPE_RENDER);
 	
 	while ((pa = BLI_thread_queue_pop(thread->workqueue))) {
 		pa->thread = thread->number;
@@ -2779,6 +2782,7 @@ static void do_render_all_options(Render *re)
 {
 	Object *camera;
 	bool render_seq = false;
+	const eMemScope mem_scope = MEM_scope_begin(MEM_SCOPE_RENDER);
 
 	re->current_scene_update(re->suh, re->scene);
 
@@ -2829,6 +2833,8 @@ static void do_render_all_options(Render *re)
 			re->display_update(re->duh, re->result, NULL);
 		}
 	}
+
+	MEM_scope_end(mem_scope);
 }
 
 bool RE_force_single_renderlayer(Scene *scene)
@@ -269,6 +269,7 @@ int main(
 	 *       guarded allocator before any allocation happened.
 	 */
 	{
+		bool use_guarded_allocator = false;
 		int i;
 		for (i = 0; i < argc; i++) {
 			if (STREQ(argv[i], "--debug") || STREQ(argv[i], "-d") ||
@@ -276,12 +277,18 @@ int main(
 			{
 				printf("Switching to fully guarded memory allocator.\n");
 				MEM_use_guarded_allocator();
+				use_guarded_allocator = true;
 				break;
 			}
 			else if (STREQ(argv[i], "--")) {
 				break;
 			}
 		}
+
+		/* Thread caching of small blocks, many small allocations happen during evaluation. */
+		if (!use_guarded_allocator) {
+			MEM_use_small_allocator();
+		}
 	}
 
 #ifdef BUILD_DATE
@@ -534,3 +534,138 @@ TEST(ghash, MultiRandIntMurmur2a200000)
 
 	multi_small_ghash_tests(ghash, "MultiSmall RandIntGHash - Murmur2a - 200000", 200000);
 }
+
+
+/* Open addressing: random integers, same insert/lookup/iterate workload for chained and open addressing tables. */
+
+static void openaddr_ghash_tests(GHash *ghash, const char *id, const unsigned int nbr)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	unsigned int *data = (unsigned int *)MEM_mallocN(sizeof(*data) * (size_t)nbr, __func__);
+	unsigned int *dt;
+	unsigned int i;
+
+	{
+		RNG *rng = BLI_rng_new(0);
+		for (i = nbr, dt = data; i--; dt++) {
+			*dt = BLI_rng_get_uint(rng);
+		}
+		BLI_rng_free(rng);
+	}
+
+	{
+		TIMEIT_START(int_insert);
+
+		for (i = nbr, dt = data; i--; dt++) {
+			BLI_ghash_reinsert(ghash, SET_UINT_IN_POINTER(*dt), SET_UINT_IN_POINTER(*dt), NULL, NULL);
+		}
+
+		TIMEIT_END(int_insert);
+	}
+
+	PRINTF_GHASH_STATS(ghash);
+
+	{
+		TIMEIT_START(int_lookup);
+
+		for (i = nbr, dt = data; i--; dt++) {
+			void *v = BLI_ghash_lookup(ghash, SET_UINT_IN_POINTER(*dt));
+			EXPECT_EQ(GET_UINT_FROM_POINTER(v), *dt);
+		}
+
+		TIMEIT_END(int_lookup);
+	}
+
+	{
+		unsigned int nbr_miss = 0;
+
+		TIMEIT_START(int_lookup_miss);
+
+		for (i = nbr, dt = data; i--; dt++) {
+			if (BLI_ghash_lookup(ghash, SET_UINT_IN_POINTER(~*dt)) == NULL) {
+				nbr_miss++;
+			}
+		}
+
+		TIMEIT_END(int_lookup_miss);
+		EXPECT_GT(nbr_miss, 0u);
+	}
+
+	{
+		GHashIterator gh_iter;
+		uintptr_t sum = 0;
+
+		TIMEIT_START(int_iterate);
+
+		GHASH_ITER (gh_iter, ghash) {
+			sum += (uintptr_t)BLI_ghashIterator_getValue(&gh_iter);
+		}
+
+		TIMEIT_END(int_iterate);
+		EXPECT_NE(sum, 0u);
+	}
+
+	BLI_ghash_free(ghash, NULL, NULL);
+	MEM_freeN(data);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(ghash, IntRandChained1000)
+{
+	GHash *ghash = BLI_ghash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	openaddr_ghash_tests(ghash, "IntRand - Chained - 1000", 1000);
+}
+
+TEST(ghash, IntRandOpen1000)
+{
+	GHash *ghash = BLI_ghash_new_open_ex(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, 0);
+
+	openaddr_ghash_tests(ghash, "IntRand - Open Addressing - 1000", 1000);
+}
+
+TEST(ghash, IntRandChained100000)
+{
+	GHash *ghash = BLI_ghash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	openaddr_ghash_tests(ghash, "IntRand - Chained - 100000", 100000);
+}
+
+TEST(ghash, IntRandOpen100000)
+{
+	GHash *ghash = BLI_ghash_new_open_ex(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, 0);
+
+	openaddr_ghash_tests(ghash, "IntRand - Open Addressing - 100000", 100000);
+}
+
+TEST(ghash, IntRandChained1000000)
+{
+	GHash *ghash = BLI_ghash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	openaddr_ghash_tests(ghash, "IntRand - Chained - 1000000", 1000000);
+}
+
+TEST(ghash, IntRandOpen1000000)
+{
+	GHash *ghash = BLI_ghash_new_open_ex(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, 0);
+
+	openaddr_ghash_tests(ghash, "IntRand - Open Addressing - 1000000", 1000000);
+}
+
+#ifdef GHASH_RUN_BIG
+TEST(ghash, IntRandChained10000000)
+{
+	GHash *ghash = BLI_ghash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	openaddr_ghash_tests(ghash, "IntRand - Chained - 10000000", 10000000);
+}
+
+TEST(ghash, IntRandOpen10000000)
+{
+	GHash *ghash = BLI_ghash_new_open_ex(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, 0);
+
+	openaddr_ghash_tests(ghash, "IntRand - Open Addressing - 10000000", 10000000);
+}
+#endif
@@ -198,3 +198,190 @@ TEST(ghash, Pop)
 
 	BLI_ghash_free(ghash, NULL, NULL);
 }
+
+/* Open addressing variants of the above tests. */
+
+TEST(ghash, OpenInsertLookupIter)
+{
+	GHash *ghash = BLI_ghash_new_open_ex(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, 0);
+	GHashIterator gh_iter;
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	init_keys(keys, 40);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_ghash_insert(ghash, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	EXPECT_EQ(BLI_ghash_size(ghash), TESTCASE_SIZE);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void *v = BLI_ghash_lookup(ghash, SET_UINT_IN_POINTER(*k));
+		EXPECT_EQ(GET_UINT_FROM_POINTER(v), *k);
+	}
+
+	i = 0;
+	GHASH_ITER (gh_iter, ghash) {
+		EXPECT_EQ(BLI_ghashIterator_getKey(&gh_iter), BLI_ghashIterator_getValue(&gh_iter));
+		i++;
+	}
+	EXPECT_EQ(i, TESTCASE_SIZE);
+
+	BLI_ghash_free(ghash, NULL, NULL);
+}
+
+TEST(ghash, OpenInsertRemove)
+{
+	GHash *ghash = BLI_ghash_new_open_ex(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, 0);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i, bkt_size;
+
+	init_keys(keys, 50);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_ghash_insert(ghash, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	EXPECT_EQ(BLI_ghash_size(ghash), TESTCASE_SIZE);
+	bkt_size = BLI_ghash_buckets_size(ghash);
+
+	/* Remove every other key first, remaining ones must still be found after the backward shifts. */
+	for (i = 0; i < TESTCASE_SIZE; i += 2) {
+		void *v = BLI_ghash_popkey(ghash, SET_UINT_IN_POINTER(keys[i]), NULL);
+		EXPECT_EQ(GET_UINT_FROM_POINTER(v), keys[i]);
+	}
+	for (i = 1; i < TESTCASE_SIZE; i += 2) {
+		void *v = BLI_ghash_lookup(ghash, SET_UINT_IN_POINTER(keys[i]));
+		EXPECT_EQ(GET_UINT_FROM_POINTER(v), keys[i]);
+		EXPECT_TRUE(BLI_ghash_remove(ghash, SET_UINT_IN_POINTER(keys[i]), NULL, NULL));
+	}
+
+	EXPECT_EQ(BLI_ghash_size(ghash), 0);
+	EXPECT_EQ(BLI_ghash_buckets_size(ghash), bkt_size);
+
+	BLI_ghash_free(ghash, NULL, NULL);
+}
+
+TEST(ghash, OpenInsertRemoveShrink)
+{
+	GHash *ghash = BLI_ghash_new_open_ex(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, 0);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i, bkt_size;
+
+	BLI_ghash_flag_set(ghash, GHASH_FLAG_ALLOW_SHRINK);
+	init_keys(keys, 60);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_ghash_insert(ghash, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	EXPECT_EQ(BLI_ghash_size(ghash), TESTCASE_SIZE);
+	bkt_size = BLI_ghash_buckets_size(ghash);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void *v = BLI_ghash_popkey(ghash, SET_UINT_IN_POINTER(*k), NULL);
+		EXPECT_EQ(GET_UINT_FROM_POINTER(v), *k);
+	}
+
+	EXPECT_EQ(BLI_ghash_size(ghash), 0);
+	EXPECT_LT(BLI_ghash_buckets_size(ghash), bkt_size);
+
+	BLI_ghash_free(ghash, NULL, NULL);
+}
+
+TEST(ghash, OpenCopy)
+{
+	GHash *ghash = BLI_ghash_new_open_ex(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, 0);
+	GHash *ghash_copy;
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	init_keys(keys, 70);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_ghash_insert(ghash, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	ghash_copy = BLI_ghash_copy(ghash, NULL, NULL);
+
+	EXPECT_EQ(BLI_ghash_size(ghash_copy), TESTCASE_SIZE);
+	EXPECT_EQ(BLI_ghash_buckets_size(ghash_copy), BLI_ghash_buckets_size(ghash));
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void *v = BLI_ghash_lookup(ghash_copy, SET_UINT_IN_POINTER(*k));
+		EXPECT_EQ(GET_UINT_FROM_POINTER(v), *k);
+	}
+
+	BLI_ghash_free(ghash, NULL, NULL);
+	BLI_ghash_free(ghash_copy, NULL, NULL);
+}
+
+TEST(ghash, OpenPop)
+{
+	GHash *ghash = BLI_ghash_new_open_ex(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, 0);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	BLI_ghash_flag_set(ghash, GHASH_FLAG_ALLOW_SHRINK);
+	init_keys(keys, 80);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_ghash_insert(ghash, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	GHashIterState pop_state = {0};
+
+	for (i = TESTCASE_SIZE / 2; i--; ) {
+		void *k, *v;
+		bool success = BLI_ghash_pop(ghash, &pop_state, &k, &v);
+		EXPECT_EQ(k, v);
+		EXPECT_TRUE(success);
+	}
+
+	EXPECT_EQ(BLI_ghash_size(ghash), TESTCASE_SIZE - TESTCASE_SIZE / 2);
+
+	{
+		void *k, *v;
+		while (BLI_ghash_pop(ghash, &pop_state, &k, &v)) {
+			EXPECT_EQ(k, v);
+		}
+	}
+	EXPECT_EQ(BLI_ghash_size(ghash), 0);
+
+	BLI_ghash_free(ghash, NULL, NULL);
+}
+
+static unsigned int ghashutil_tests_zerohash_p(const void *UNUSED(p))
+{
+	return 0;
+}
+
+/* Worst case: all keys share the same hash (which is also the 'empty slot' value),
+ * so every removal has to shift the whole cluster. */
+TEST(ghash, OpenCollisions)
+{
+	GSet *gset = BLI_gset_new_open_ex(ghashutil_tests_zerohash_p, BLI_ghashutil_intcmp, __func__, 0);
+	const unsigned int nbr = 500;
+	unsigned int i;
+
+	for (i = 0; i < nbr; i++) {
+		void **r_key;
+		EXPECT_FALSE(BLI_gset_ensure_p_ex(gset, SET_UINT_IN_POINTER(i), &r_key));
+		*r_key = SET_UINT_IN_POINTER(i);
+	}
+	EXPECT_EQ(BLI_gset_size(gset), nbr);
+
+	for (i = 0; i < nbr; i += 3) {
+		EXPECT_TRUE(BLI_gset_remove(gset, SET_UINT_IN_POINTER(i), NULL));
+	}
+	for (i = 0; i < nbr; i++) {
+		EXPECT_EQ(BLI_gset_haskey(gset, SET_UINT_IN_POINTER(i)), (i % 3) != 0);
+	}
+
+	BLI_gset_clear(gset, NULL);
+	EXPECT_EQ(BLI_gset_size(gset), 0);
+	EXPECT_FALSE(BLI_gset_haskey(gset, SET_UINT_IN_POINTER(1)));
+
+	BLI_gset_free(gset, NULL);
+}
@@ -0,0 +1,250 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_kdopbvh.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Run the longest tests! */
+//#define BVH_RUN_BIG
+
+/* Number of rays cast for each test. */
+#define RAYS_NUM 262144
+/* Number of nearest point queries (much slower than rays for points away from the surface). */
+#define NEAREST_NUM (RAYS_NUM / 16)
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+/**
+ * Bumpy grid of res x res quads (2 * res * res triangles), with a few denser regions,
+ * which is closer to actual meshes than uniformly distributed triangles.
+ */
+static float (*grid_tris_create(const int res, int *r_tris_len))[3][3]
+{
+	const int tris_len = 2 * res * res;
+	float (*tris)[3][3] = (float (*)[3][3])MEM_mallocN(sizeof(*tris) * (size_t)tris_len, __func__);
+	float (*tri)[3] = tris[0];
+
+	for (int y = 0; y < res; y++) {
+		for (int x = 0; x < res; x++) {
+			float co[4][3];
+			for (int i = 0; i < 4; i++) {
+				const float u = (float)(x + (i & 1)) / (float)res;
+				const float v = (float)(y + (i >> 1)) / (float)res;
+				/* Squeeze the grid toward one corner, so the density varies. */
+				co[i][0] = u * u * 2.0f - 1.0f;
+				co[i][1] = v * v * 2.0f - 1.0f;
+				co[i][2] = 0.1f * sinf(u * 40.0f) * cosf(v * 30.0f);
+			}
+			copy_v3_v3(tri[0], co[0]);
+			copy_v3_v3(tri[1], co[1]);
+			copy_v3_v3(tri[2], co[3]);
+			tri += 3;
+			copy_v3_v3(tri[0], co[0]);
+			copy_v3_v3(tri[1], co[3]);
+			copy_v3_v3(tri[2], co[2]);
+			tri += 3;
+		}
+	}
+
+	*r_tris_len = tris_len;
+	return tris;
+}
+
+static void raycast_tri_cb(void *userdata, int index, const BVHTreeRay *ray, BVHTreeRayHit *hit)
+{
+	const float (*tris)[3][3] = (const float (*)[3][3])userdata;
+	float dist;
+
+	if (isect_ray_tri_watertight_v3(
+	        ray->origin, ray->isect_precalc, tris[index][0], tris[index][1], tris[index][2], &dist, NULL) &&
+	    (dist >= 0.0f) && (dist < hit->dist))
+	{
+		hit->index = index;
+		hit->dist = dist;
+	}
+}
+
+static void nearest_tri_cb(void *userdata, int index, const float co[3], BVHTreeNearest *nearest)
+{
+	const float (*tris)[3][3] = (const float (*)[3][3])userdata;
+	float nearest_tmp[3], dist_sq;
+
+	closest_on_tri_to_point_v3(nearest_tmp, co, tris[index][0], tris[index][1], tris[index][2]);
+	dist_sq = len_squared_v3v3(co, nearest_tmp);
+
+	if (dist_sq < nearest->dist_sq) {
+		nearest->index = index;
+		nearest->dist_sq = dist_sq;
+		copy_v3_v3(nearest->co, nearest_tmp);
+	}
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+static void bvh_performance_test(const int res, const char tree_type, const int flag, const char *id)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	int tris_len;
+	float (*tris)[3][3] = grid_tris_create(res, &tris_len);
+	float (*co)[3] = (float (*)[3])MEM_mallocN(sizeof(*co) * RAYS_NUM, __func__);
+	float (*dir)[3] = (float (*)[3])MEM_mallocN(sizeof(*dir) * RAYS_NUM, __func__);
+	BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits) * RAYS_NUM, __func__);
+	BVHTree *tree;
+	int hits_num;
+
+	printf("%d triangles\n", tris_len);
+
+	{
+		TIMEIT_START(build);
+
+		tree = BLI_bvhtree_new_ex(tris_len, 0.0f, tree_type, 6, flag);
+		for (int i = 0; i < tris_len; i++) {
+			BLI_bvhtree_insert(tree, i, tris[i][0], 3);
+		}
+		BLI_bvhtree_balance(tree);
+
+		TIMEIT_END(build);
+	}
+
+	/* Coherent rays: a camera looking down at the grid, rays ordered in tiles of 2x2 pixels. */
+	{
+		const int side = 512;
+		BLI_assert(side * side == RAYS_NUM);
+		for (int i = 0; i < RAYS_NUM; i++) {
+			const int tile = i / 4, x = (tile % (side / 2)) * 2 + (i & 1), y = (tile / (side / 2)) * 2 + ((i >> 1) & 1);
+			const float target[3] = {(float)x / (float)side * 2.0f - 1.0f, (float)y / (float)side * 2.0f - 1.0f, 0.0f};
+			co[i][0] = 0.3f;
+			co[i][1] = 0.2f;
+			co[i][2] = 2.0f;
+			sub_v3_v3v3(dir[i], target, co[i]);
+			normalize_v3(dir[i]);
+		}
+
+		TIMEIT_START(raycast_coherent);
+
+		hits_num = 0;
+		for (int i = 0; i < RAYS_NUM; i++) {
+			BVHTreeRayHit hit = {-1};
+			hit.dist = BVH_RAYCAST_DIST_MAX;
+			hits_num += (BLI_bvhtree_ray_cast(tree, co[i], dir[i], 0.0f, &hit, raycast_tri_cb, tris) != -1);
+		}
+
+		TIMEIT_END(raycast_coherent);
+		EXPECT_GT(hits_num, RAYS_NUM / 2);
+
+		TIMEIT_START(raycast_coherent_packet);
+
+		for (int i = 0; i < RAYS_NUM; i++) {
+			hits[i].index = -1;
+			hits[i].dist = BVH_RAYCAST_DIST_MAX;
+		}
+		BLI_bvhtree_ray_cast_packet(tree, co, dir, RAYS_NUM, hits, raycast_tri_cb, tris, BVH_RAYCAST_DEFAULT);
+
+		TIMEIT_END(raycast_coherent_packet);
+	}
+
+	/* Incoherent rays: random origins and directions. */
+	{
+		RNG *rng = BLI_rng_new(0);
+		for (int i = 0; i < RAYS_NUM; i++) {
+			co[i][0] = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+			co[i][1] = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+			co[i][2] = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+			BLI_rng_get_float_unit_v3(rng, dir[i]);
+		}
+		BLI_rng_free(rng);
+
+		TIMEIT_START(raycast_random);
+
+		for (int i = 0; i < RAYS_NUM; i++) {
+			BVHTreeRayHit hit = {-1};
+			hit.dist = BVH_RAYCAST_DIST_MAX;
+			BLI_bvhtree_ray_cast(tree, co[i], dir[i], 0.0f, &hit, raycast_tri_cb, tris);
+		}
+
+		TIMEIT_END(raycast_random);
+	}
+
+	/* Nearest point queries, reusing the random origins. */
+	{
+		TIMEIT_START(find_nearest);
+
+		for (int i = 0; i < NEAREST_NUM; i++) {
+			BVHTreeNearest nearest = {-1};
+			nearest.dist_sq = FLT_MAX;
+			BLI_bvhtree_find_nearest(tree, co[i], &nearest, nearest_tri_cb, tris);
+		}
+
+		TIMEIT_END(find_nearest);
+	}
+
+	BLI_bvhtree_free(tree);
+	MEM_freeN(tris);
+	MEM_freeN(co);
+	MEM_freeN(dir);
+	MEM_freeN(hits);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdopbvh, Tris10k)
+{
+	bvh_performance_test(71, 4, 0, "Tris - Median - 10k");
+}
+
+TEST(kdopbvh, Tris10kSAH)
+{
+	bvh_performance_test(71, 4, BVH_TREE_SAH | BVH_TREE_SIMD, "Tris - SAH & SIMD - 10k");
+}
+
+TEST(kdopbvh, Tris100k)
+{
+	bvh_performance_test(224, 4, 0, "Tris - Median - 100k");
+}
+
+TEST(kdopbvh, Tris100kSAH)
+{
+	bvh_performance_test(224, 4, BVH_TREE_SAH | BVH_TREE_SIMD, "Tris - SAH & SIMD - 100k");
+}
+
+TEST(kdopbvh, Tris1M)
+{
+	bvh_performance_test(707, 4, 0, "Tris - Median - 1M");
+}
+
+TEST(kdopbvh, Tris1MSAH)
+{
+	bvh_performance_test(707, 4, BVH_TREE_SAH, "Tris - SAH - 1M");
+}
+
+TEST(kdopbvh, Tris1MSIMD)
+{
+	bvh_performance_test(707, 4, BVH_TREE_SIMD, "Tris - SIMD - 1M");
+}
+
+TEST(kdopbvh, Tris1MSAHSIMD)
+{
+	bvh_performance_test(707, 4, BVH_TREE_SAH | BVH_TREE_SIMD, "Tris - SAH & SIMD - 1M");
+}
+
+#ifdef BVH_RUN_BIG
+TEST(kdopbvh, Tris10M)
+{
+	bvh_performance_test(2236, 4, 0, "Tris - Median - 10M");
+}
+
+TEST(kdopbvh, Tris10MSAH)
+{
+	bvh_performance_test(2236, 4, BVH_TREE_SAH | BVH_TREE_SIMD, "Tris - SAH & SIMD - 10M");
+}
+#endif
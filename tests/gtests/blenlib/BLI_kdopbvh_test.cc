@@ -9,6 +9,7 @@ extern "C" {
 #include "BLI_kdopbvh.h"
 #include "BLI_rand.h"
 #include "BLI_math_vector.h"
+#include "BLI_math_geom.h"
 #include "MEM_guardedalloc.h"
 }
 
@@ -54,10 +55,12 @@ TEST(kdopbvh, Single)
  * Note that a small epsilon is added to the BVH nodes bounds, even if we pass in zero.
  * Use rounding to ensure very close nodes don't cause the wrong node to be found as nearest.
  */
-static void find_nearest_points_test(int points_len, float scale, int round, int random_seed)
+static void find_nearest_points_test(
+        int points_len, float scale, int round, int random_seed,
+        char tree_type = 8, char axis = 8, int flag = 0)
 {
 	struct RNG *rng = BLI_rng_new(random_seed);
-	BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 8, 8);
+	BVHTree *tree = BLI_bvhtree_new_ex(points_len, 0.0, tree_type, axis, flag);
 
 	void *mem = MEM_mallocN(sizeof(float[3]) * points_len, __func__);
 	float (*points)[3] = (float (*)[3])mem;
@@ -93,3 +96,112 @@ static void find_nearest_points_test(int points_len, float scale, int round, int
 TEST(kdopbvh, FindNearest_1)		{ find_nearest_points_test(1, 1.0, 1000, 1234); }
 TEST(kdopbvh, FindNearest_2)		{ find_nearest_points_test(2, 1.0, 1000, 123); }
 TEST(kdopbvh, FindNearest_500)		{ find_nearest_points_test(500, 1.0, 1000, 12); }
+TEST(kdopbvh, FindNearest_SAH_500)	{ find_nearest_points_test(500, 1.0, 1000, 12, 4, 6, BVH_TREE_SAH); }
+TEST(kdopbvh, FindNearest_SAH_10000)	{ find_nearest_points_test(10000, 1.0, 1000, 13, 2, 6, BVH_TREE_SAH); }
+
+static void raycast_tri_cb(void *userdata, int index, const BVHTreeRay *ray, BVHTreeRayHit *hit)
+{
+	const float (*tris)[3][3] = (const float (*)[3][3])userdata;
+	float dist;
+
+	if (isect_ray_tri_v3(ray->origin, ray->direction, tris[index][0], tris[index][1], tris[index][2], &dist, NULL) &&
+	    (dist < hit->dist))
+	{
+		hit->index = index;
+		hit->dist = dist;
+	}
+}
+
+static BVHTree *raycast_tree_create(const float (*tris)[3][3], int tris_len, char tree_type, int flag)
+{
+	BVHTree *tree = BLI_bvhtree_new_ex(tris_len, 0.0, tree_type, 6, flag);
+
+	for (int i = 0; i < tris_len; i++) {
+		BLI_bvhtree_insert(tree, i, tris[i][0], 3);
+	}
+	BLI_bvhtree_balance(tree);
+	return tree;
+}
+
+/**
+ * Check ray casts on trees built with \a flag, and packet ray casts, give the same hits as the default tree.
+ */
+static void raycast_test(int tris_len, int rays_len, char tree_type, int flag, int random_seed)
+{
+	struct RNG *rng = BLI_rng_new(random_seed);
+	float (*tris)[3][3] = (float (*)[3][3])MEM_mallocN(sizeof(*tris) * tris_len, __func__);
+	float (*co)[3] = (float (*)[3])MEM_mallocN(sizeof(*co) * rays_len, __func__);
+	float (*dir)[3] = (float (*)[3])MEM_mallocN(sizeof(*dir) * rays_len, __func__);
+	BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits) * rays_len, __func__);
+
+	/* Small random triangles, denser along x so the tree is uneven. */
+	for (int i = 0; i < tris_len; i++) {
+		float center[3];
+		rng_v3_round(center, 3, rng, 100000, 1.0f);
+		center[0] *= center[0] * center[0];
+		for (int j = 0; j < 3; j++) {
+			rng_v3_round(tris[i][j], 3, rng, 100000, 0.05f);
+			add_v3_v3(tris[i][j], center);
+		}
+	}
+
+	for (int i = 0; i < rays_len; i++) {
+		/* Aim at random points of the triangles region. */
+		float target[3];
+		rng_v3_round(co[i], 3, rng, 100000, 2.0f);
+		rng_v3_round(target, 3, rng, 100000, 0.5f);
+		sub_v3_v3v3(dir[i], target, co[i]);
+		normalize_v3(dir[i]);
+	}
+
+	BVHTree *tree_ref = raycast_tree_create(tris, tris_len, tree_type, 0);
+	BVHTree *tree = raycast_tree_create(tris, tris_len, tree_type, flag);
+
+	int hits_num = 0;
+	for (int i = 0; i < rays_len; i++) {
+		BVHTreeRayHit hit_ref = {-1}, hit = {-1};
+		hit_ref.dist = hit.dist = BVH_RAYCAST_DIST_MAX;
+
+		BLI_bvhtree_ray_cast(tree_ref, co[i], dir[i], 0.0f, &hit_ref, raycast_tri_cb, tris);
+		BLI_bvhtree_ray_cast(tree, co[i], dir[i], 0.0f, &hit, raycast_tri_cb, tris);
+
+		EXPECT_EQ(hit_ref.index, hit.index);
+		EXPECT_EQ(hit_ref.dist, hit.dist);
+
+		hits[i] = hit_ref;
+		hits_num += (hit_ref.index != -1);
+	}
+	/* Make sure the test does hit something. */
+	EXPECT_GT(hits_num, rays_len / 10);
+
+	/* Packets, with a partial last packet. */
+	for (int i = 0; i < rays_len - 1; i++) {
+		hits[i].index = -1;
+		hits[i].dist = BVH_RAYCAST_DIST_MAX;
+	}
+	BLI_bvhtree_ray_cast_packet(tree, co, dir, rays_len - 1, hits, raycast_tri_cb, tris, BVH_RAYCAST_DEFAULT);
+	for (int i = 0; i < rays_len - 1; i++) {
+		BVHTreeRayHit hit_ref = {-1};
+		hit_ref.dist = BVH_RAYCAST_DIST_MAX;
+
+		BLI_bvhtree_ray_cast(tree_ref, co[i], dir[i], 0.0f, &hit_ref, raycast_tri_cb, tris);
+
+		EXPECT_EQ(hit_ref.index, hits[i].index);
+		EXPECT_EQ(hit_ref.dist, hits[i].dist);
+	}
+
+	BLI_bvhtree_free(tree_ref);
+	BLI_bvhtree_free(tree);
+	BLI_rng_free(rng);
+	MEM_freeN(tris);
+	MEM_freeN(co);
+	MEM_freeN(dir);
+	MEM_freeN(hits);
+}
+
+TEST(kdopbvh, RayCast_Default)		{ raycast_test(2000, 1000, 4, 0, 1); }
+TEST(kdopbvh, RayCast_SAH)			{ raycast_test(2000, 1000, 4, BVH_TREE_SAH, 2); }
+TEST(kdopbvh, RayCast_SIMD)			{ raycast_test(2000, 1000, 4, BVH_TREE_SIMD, 3); }
+TEST(kdopbvh, RayCast_SAH_SIMD)		{ raycast_test(2000, 1000, 4, BVH_TREE_SAH | BVH_TREE_SIMD, 4); }
+TEST(kdopbvh, RayCast_SAH_SIMD_Binary)	{ raycast_test(2000, 1000, 2, BVH_TREE_SAH | BVH_TREE_SIMD, 5); }
+TEST(kdopbvh, RayCast_SAH_Octree)	{ raycast_test(2000, 1000, 8, BVH_TREE_SAH, 6); }
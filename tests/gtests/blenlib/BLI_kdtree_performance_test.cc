@@ -0,0 +1,153 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_kdtree.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Run the longest tests! */
+//#define KDTREE_RUN_BIG
+
+/* Number of query points for each test. */
+#define QUERIES_NUM 250000
+/* Number of nearest points looked up by the find nearest n queries. */
+#define NEAREST_N 8
+
+static bool range_count_cb(void *user_data, int UNUSED(index), const float UNUSED(co[3]), float UNUSED(dist_sq))
+{
+	(*(unsigned int *)user_data)++;
+	return true;
+}
+
+static bool range_count_batch_cb(
+        void *user_data, unsigned int co_index, int UNUSED(index), const float UNUSED(co[3]), float UNUSED(dist_sq))
+{
+	((unsigned int *)user_data)[co_index]++;
+	return true;
+}
+
+static void kdtree_performance_test(const int points_num, const char *id)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	float (*co)[3] = (float (*)[3])MEM_mallocN(sizeof(*co) * QUERIES_NUM, __func__);
+	KDTreeNearest *nearest = (KDTreeNearest *)MEM_mallocN(sizeof(*nearest) * QUERIES_NUM * NEAREST_N, __func__);
+	unsigned int *found = (unsigned int *)MEM_callocN(sizeof(*found) * QUERIES_NUM, __func__);
+	/* Roughly 10 points in range on average. */
+	const float range = cbrtf(10.0f / (float)points_num);
+	RNG *rng = BLI_rng_new(0);
+	KDTree *tree;
+
+	{
+		TIMEIT_START(build);
+
+		tree = BLI_kdtree_new((unsigned int)points_num);
+		for (int i = 0; i < points_num; i++) {
+			const float p[3] = {BLI_rng_get_float(rng), BLI_rng_get_float(rng), BLI_rng_get_float(rng)};
+			BLI_kdtree_insert(tree, i, p);
+		}
+		BLI_kdtree_balance(tree);
+
+		TIMEIT_END(build);
+	}
+
+	for (int i = 0; i < QUERIES_NUM; i++) {
+		co[i][0] = BLI_rng_get_float(rng);
+		co[i][1] = BLI_rng_get_float(rng);
+		co[i][2] = BLI_rng_get_float(rng);
+	}
+	BLI_rng_free(rng);
+
+	{
+		TIMEIT_START(find_nearest);
+
+		for (int i = 0; i < QUERIES_NUM; i++) {
+			BLI_kdtree_find_nearest(tree, co[i], &nearest[i]);
+		}
+
+		TIMEIT_END(find_nearest);
+
+		TIMEIT_START(find_nearest_batch);
+
+		BLI_kdtree_find_nearest_batch(tree, co, QUERIES_NUM, NULL, nearest);
+
+		TIMEIT_END(find_nearest_batch);
+	}
+
+	{
+		TIMEIT_START(find_nearest_n);
+
+		for (int i = 0; i < QUERIES_NUM; i++) {
+			BLI_kdtree_find_nearest_n(tree, co[i], &nearest[i * NEAREST_N], NEAREST_N);
+		}
+
+		TIMEIT_END(find_nearest_n);
+
+		TIMEIT_START(find_nearest_n_batch);
+
+		BLI_kdtree_find_nearest_n_batch(tree, co, QUERIES_NUM, nearest, NULL, NEAREST_N);
+
+		TIMEIT_END(find_nearest_n_batch);
+	}
+
+	{
+		TIMEIT_START(range_search);
+
+		for (int i = 0; i < QUERIES_NUM; i++) {
+			KDTreeNearest *range_nearest = NULL;
+			found[i] = (unsigned int)BLI_kdtree_range_search(tree, co[i], &range_nearest, range);
+			if (range_nearest) {
+				MEM_freeN(range_nearest);
+			}
+		}
+
+		TIMEIT_END(range_search);
+
+		TIMEIT_START(range_search_cb);
+
+		for (int i = 0; i < QUERIES_NUM; i++) {
+			found[i] = 0;
+			BLI_kdtree_range_search_cb(tree, co[i], range, range_count_cb, &found[i]);
+		}
+
+		TIMEIT_END(range_search_cb);
+
+		memset(found, 0, sizeof(*found) * QUERIES_NUM);
+
+		TIMEIT_START(range_search_batch_cb);
+
+		BLI_kdtree_range_search_batch_cb(tree, co, QUERIES_NUM, range, range_count_batch_cb, found);
+
+		TIMEIT_END(range_search_batch_cb);
+	}
+
+	BLI_kdtree_free(tree);
+	MEM_freeN(co);
+	MEM_freeN(nearest);
+	MEM_freeN(found);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdtree, Points10k)
+{
+	kdtree_performance_test(10000, "Points - 10k");
+}
+
+TEST(kdtree, Points1M)
+{
+	kdtree_performance_test(1000000, "Points - 1M");
+}
+
+#ifdef KDTREE_RUN_BIG
+TEST(kdtree, Points10M)
+{
+	kdtree_performance_test(10000000, "Points - 10M");
+}
+#endif
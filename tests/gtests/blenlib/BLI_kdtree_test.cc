@@ -0,0 +1,177 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_compiler_attrs.h"
+#include "BLI_kdtree.h"
+#include "BLI_rand.h"
+#include "BLI_math_vector.h"
+#include "MEM_guardedalloc.h"
+}
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+static float (*rng_points_create(int points_len, int random_seed))[3]
+{
+	float (*points)[3] = (float (*)[3])MEM_mallocN(sizeof(*points) * (size_t)points_len, __func__);
+	RNG *rng = BLI_rng_new(random_seed);
+
+	for (int i = 0; i < points_len; i++) {
+		for (int j = 0; j < 3; j++) {
+			points[i][j] = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+		}
+	}
+
+	BLI_rng_free(rng);
+	return points;
+}
+
+static KDTree *kdtree_create(const float (*points)[3], int points_len)
+{
+	KDTree *tree = BLI_kdtree_new((unsigned int)points_len);
+
+	for (int i = 0; i < points_len; i++) {
+		BLI_kdtree_insert(tree, i, points[i]);
+	}
+	BLI_kdtree_balance(tree);
+
+	return tree;
+}
+
+static int brute_force_nearest(const float (*points)[3], int points_len, const float co[3])
+{
+	float dist_sq_best = FLT_MAX;
+	int index_best = -1;
+
+	for (int i = 0; i < points_len; i++) {
+		const float dist_sq = len_squared_v3v3(points[i], co);
+		if (dist_sq < dist_sq_best) {
+			dist_sq_best = dist_sq;
+			index_best = i;
+		}
+	}
+	return index_best;
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+TEST(kdtree, Empty)
+{
+	KDTree *tree = BLI_kdtree_new(0);
+	const float co[1][3] = {{0.0f, 0.0f, 0.0f}};
+	int index = 0;
+
+	BLI_kdtree_balance(tree);
+	EXPECT_EQ(-1, BLI_kdtree_find_nearest(tree, co[0], NULL));
+
+	BLI_kdtree_find_nearest_batch(tree, co, 1, &index, NULL);
+	EXPECT_EQ(-1, index);
+
+	BLI_kdtree_free(tree);
+}
+
+static void find_nearest_test(int points_len, int queries_len, int random_seed)
+{
+	float (*points)[3] = rng_points_create(points_len, random_seed);
+	float (*queries)[3] = rng_points_create(queries_len, random_seed + 1);
+	KDTree *tree = kdtree_create(points, points_len);
+	int *index = (int *)MEM_mallocN(sizeof(*index) * (size_t)queries_len, __func__);
+	KDTreeNearest *nearest = (KDTreeNearest *)MEM_mallocN(sizeof(*nearest) * (size_t)queries_len, __func__);
+
+	BLI_kdtree_find_nearest_batch(tree, queries, (unsigned int)queries_len, index, nearest);
+
+	for (int i = 0; i < queries_len; i++) {
+		const int index_expect = brute_force_nearest(points, points_len, queries[i]);
+		EXPECT_EQ(index_expect, BLI_kdtree_find_nearest(tree, queries[i], NULL));
+		EXPECT_EQ(index_expect, index[i]);
+		EXPECT_EQ(index_expect, nearest[i].index);
+		EXPECT_FLOAT_EQ(len_v3v3(points[index_expect], queries[i]), nearest[i].dist);
+	}
+
+	BLI_kdtree_free(tree);
+	MEM_freeN(points);
+	MEM_freeN(queries);
+	MEM_freeN(index);
+	MEM_freeN(nearest);
+}
+
+TEST(kdtree, FindNearest_1)			{ find_nearest_test(1, 100, 1); }
+TEST(kdtree, FindNearest_100)		{ find_nearest_test(100, 1000, 2); }
+TEST(kdtree, FindNearest_20000)		{ find_nearest_test(20000, 1000, 3); }
+
+static void find_nearest_n_test(int points_len, int queries_len, unsigned int n, int random_seed)
+{
+	float (*points)[3] = rng_points_create(points_len, random_seed);
+	float (*queries)[3] = rng_points_create(queries_len, random_seed + 1);
+	KDTree *tree = kdtree_create(points, points_len);
+	KDTreeNearest *nearest = (KDTreeNearest *)MEM_mallocN(sizeof(*nearest) * n * (size_t)queries_len, __func__);
+	KDTreeNearest *nearest_single = (KDTreeNearest *)MEM_mallocN(sizeof(*nearest) * n, __func__);
+	int *found = (int *)MEM_mallocN(sizeof(*found) * (size_t)queries_len, __func__);
+
+	BLI_kdtree_find_nearest_n_batch(tree, queries, (unsigned int)queries_len, nearest, found, n);
+
+	for (int i = 0; i < queries_len; i++) {
+		const int found_single = BLI_kdtree_find_nearest_n(tree, queries[i], nearest_single, n);
+		EXPECT_EQ(found_single, found[i]);
+		EXPECT_EQ((int)min_ii(points_len, (int)n), found[i]);
+		for (int j = 0; j < found_single; j++) {
+			EXPECT_EQ(nearest_single[j].index, nearest[i * n + j].index);
+			EXPECT_EQ(nearest_single[j].dist, nearest[i * n + j].dist);
+		}
+		EXPECT_EQ(brute_force_nearest(points, points_len, queries[i]), nearest[i * n].index);
+	}
+
+	BLI_kdtree_free(tree);
+	MEM_freeN(points);
+	MEM_freeN(queries);
+	MEM_freeN(nearest);
+	MEM_freeN(nearest_single);
+	MEM_freeN(found);
+}
+
+TEST(kdtree, FindNearestN_3)		{ find_nearest_n_test(3, 100, 8, 4); }
+TEST(kdtree, FindNearestN_20000)	{ find_nearest_n_test(20000, 1000, 8, 5); }
+
+static bool range_count_cb(void *user_data, unsigned int co_index, int UNUSED(index), const float UNUSED(co[3]), float UNUSED(dist_sq))
+{
+	int *count = (int *)user_data;
+	count[co_index]++;
+	return true;
+}
+
+static void range_search_test(int points_len, int queries_len, float range, int random_seed)
+{
+	float (*points)[3] = rng_points_create(points_len, random_seed);
+	float (*queries)[3] = rng_points_create(queries_len, random_seed + 1);
+	KDTree *tree = kdtree_create(points, points_len);
+	int *count = (int *)MEM_callocN(sizeof(*count) * (size_t)queries_len, __func__);
+
+	BLI_kdtree_range_search_batch_cb(tree, queries, (unsigned int)queries_len, range, range_count_cb, count);
+
+	for (int i = 0; i < queries_len; i++) {
+		KDTreeNearest *nearest = NULL;
+		const int found = BLI_kdtree_range_search(tree, queries[i], &nearest, range);
+		int found_expect = 0;
+
+		for (int j = 0; j < points_len; j++) {
+			found_expect += (len_squared_v3v3(points[j], queries[i]) <= range * range);
+		}
+		EXPECT_EQ(found_expect, found);
+		EXPECT_EQ(found_expect, count[i]);
+
+		if (nearest) {
+			MEM_freeN(nearest);
+		}
+	}
+
+	BLI_kdtree_free(tree);
+	MEM_freeN(points);
+	MEM_freeN(queries);
+	MEM_freeN(count);
+}
+
+TEST(kdtree, RangeSearch_100)		{ range_search_test(100, 1000, 0.5f, 6); }
+TEST(kdtree, RangeSearch_20000)		{ range_search_test(20000, 1000, 0.1f, 7); }
@@ -0,0 +1,143 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "atomic_ops.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "PIL_time.h"
+};
+
+/* Number of tasks, each doing a tiny amount of work, so the measured time is
+ * dominated by the scheduler overhead. */
+#define NUM_TASKS 1000000
+#define NUM_RANGE_ITEMS 10000000
+#define NUM_REPEAT 5
+
+static void task_tiny_run(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	size_t *count = (size_t *)BLI_task_pool_userdata(pool);
+	atomic_add_and_fetch_z(count, 1);
+}
+
+static void task_tiny_spawn_run(TaskPool *__restrict pool, void *taskdata, int threadid)
+{
+	size_t depth = (size_t)taskdata;
+
+	task_tiny_run(pool, NULL, threadid);
+
+	if (depth > 0) {
+		for (int i = 0; i < 2; i++) {
+			BLI_task_pool_push_from_thread(pool, task_tiny_spawn_run, (void *)(depth - 1), false,
+			                               TASK_PRIORITY_LOW, threadid);
+		}
+	}
+}
+
+static void task_range_run(void *userdata, void *UNUSED(userdata_chunk), const int iter, const int UNUSED(thread_id))
+{
+	float *data = (float *)userdata;
+	data[iter] = data[iter] * 0.5f + 1.0f;
+}
+
+static void print_throughput(const char *id, double time, size_t num)
+{
+	printf("%s: %.3f sec, %.2f M tasks/sec\n", id, time, (double)num / time * 1e-6);
+}
+
+static void task_pool_throughput(TaskScheduler *scheduler, const bool is_suspended)
+{
+	double time = 0.0;
+
+	for (int r = 0; r < NUM_REPEAT; r++) {
+		size_t count = 0;
+		TaskPool *pool = is_suspended ? BLI_task_pool_create_suspended(scheduler, &count) :
+		                                BLI_task_pool_create(scheduler, &count);
+		const double start = PIL_check_seconds_timer();
+
+		for (int i = 0; i < NUM_TASKS; i++) {
+			BLI_task_pool_push(pool, task_tiny_run, NULL, false, TASK_PRIORITY_LOW);
+		}
+		BLI_task_pool_work_and_wait(pool);
+
+		time += PIL_check_seconds_timer() - start;
+		BLI_task_pool_free(pool);
+
+		EXPECT_EQ(count, NUM_TASKS);
+	}
+
+	print_throughput(is_suspended ? "Suspended pool push" : "Pool push", time / NUM_REPEAT, NUM_TASKS);
+}
+
+TEST(task, PoolPushThroughput)
+{
+	BLI_threadapi_init();
+
+	TaskScheduler *scheduler = BLI_task_scheduler_create(0);
+	printf("Threads: %d\n", BLI_task_scheduler_num_threads(scheduler));
+
+	task_pool_throughput(scheduler, false);
+	task_pool_throughput(scheduler, true);
+
+	BLI_task_scheduler_free(scheduler);
+
+	BLI_threadapi_exit();
+}
+
+TEST(task, NestedPushThroughput)
+{
+	BLI_threadapi_init();
+
+	TaskScheduler *scheduler = BLI_task_scheduler_create(0);
+	/* Binary tree of tasks, 2^20 - 1 in total. */
+	const size_t num_tasks = (1 << 20) - 1;
+	double time = 0.0;
+
+	for (int r = 0; r < NUM_REPEAT; r++) {
+		size_t count = 0;
+		TaskPool *pool = BLI_task_pool_create(scheduler, &count);
+		const double start = PIL_check_seconds_timer();
+
+		BLI_task_pool_push(pool, task_tiny_spawn_run, (void *)19, false, TASK_PRIORITY_LOW);
+		BLI_task_pool_work_and_wait(pool);
+
+		time += PIL_check_seconds_timer() - start;
+		BLI_task_pool_free(pool);
+
+		EXPECT_EQ(count, num_tasks);
+	}
+
+	print_throughput("Nested push", time / NUM_REPEAT, num_tasks);
+
+	BLI_task_scheduler_free(scheduler);
+
+	BLI_threadapi_exit();
+}
+
+TEST(task, ParallelRangeThroughput)
+{
+	BLI_threadapi_init();
+
+	float *data = (float *)MEM_callocN(sizeof(float) * NUM_RANGE_ITEMS, __func__);
+	double time = 0.0;
+
+	for (int r = 0; r < NUM_REPEAT; r++) {
+		const double start = PIL_check_seconds_timer();
+
+		BLI_task_parallel_range_ex(0, NUM_RANGE_ITEMS, data, NULL, 0, task_range_run, true, true);
+
+		time += PIL_check_seconds_timer() - start;
+	}
+
+	print_throughput("Parallel range (dynamic)", time / NUM_REPEAT, NUM_RANGE_ITEMS);
+
+	MEM_freeN(data);
+
+	BLI_threadapi_exit();
+}
@@ -0,0 +1,126 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "atomic_ops.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+};
+
+#define NUM_ITEMS 10000
+
+static void task_count_run(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	size_t *count = (size_t *)BLI_task_pool_userdata(pool);
+	atomic_add_and_fetch_z(count, (size_t)taskdata);
+}
+
+/* Pushes sub-tasks from within a task, exercising per-thread queues. */
+static void task_spawn_run(TaskPool *__restrict pool, void *taskdata, int threadid)
+{
+	size_t depth = (size_t)taskdata;
+
+	task_count_run(pool, (void *)1, threadid);
+
+	if (depth > 0) {
+		for (int i = 0; i < 4; i++) {
+			BLI_task_pool_push_from_thread(pool, task_spawn_run, (void *)(depth - 1), false,
+			                               TASK_PRIORITY_LOW, threadid);
+		}
+	}
+}
+
+static void task_pool_count(TaskScheduler *scheduler, const bool is_suspended, const bool is_background)
+{
+	size_t count = 0;
+	TaskPool *pool;
+
+	if (is_suspended)
+		pool = BLI_task_pool_create_suspended(scheduler, &count);
+	else if (is_background)
+		pool = BLI_task_pool_create_background(scheduler, &count);
+	else
+		pool = BLI_task_pool_create(scheduler, &count);
+
+	for (int i = 0; i < NUM_ITEMS; i++) {
+		BLI_task_pool_push(pool, task_count_run, (void *)1, false,
+		                   (i % 2) ? TASK_PRIORITY_HIGH : TASK_PRIORITY_LOW);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+
+	EXPECT_EQ(count, NUM_ITEMS);
+}
+
+TEST(task, PoolPush)
+{
+	BLI_threadapi_init();
+
+	TaskScheduler *scheduler = BLI_task_scheduler_create(8);
+	task_pool_count(scheduler, false, false);
+	task_pool_count(scheduler, true, false);
+	task_pool_count(scheduler, false, true);
+	BLI_task_scheduler_free(scheduler);
+
+	BLI_threadapi_exit();
+}
+
+TEST(task, PoolPushSingleThread)
+{
+	BLI_threadapi_init();
+
+	/* Only a background thread, regular pools must be handled by work_and_wait(). */
+	TaskScheduler *scheduler = BLI_task_scheduler_create(1);
+	task_pool_count(scheduler, false, false);
+	task_pool_count(scheduler, true, false);
+	task_pool_count(scheduler, false, true);
+	BLI_task_scheduler_free(scheduler);
+
+	BLI_threadapi_exit();
+}
+
+TEST(task, PoolNestedPush)
+{
+	BLI_threadapi_init();
+
+	TaskScheduler *scheduler = BLI_task_scheduler_create(8);
+	size_t count = 0;
+	TaskPool *pool = BLI_task_pool_create(scheduler, &count);
+
+	/* 1 + 4 + 16 + 64 + 256 + 1024 tasks per root. */
+	for (int i = 0; i < 8; i++) {
+		BLI_task_pool_push(pool, task_spawn_run, (void *)5, false, TASK_PRIORITY_LOW);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+
+	EXPECT_EQ(count, 8 * 1365);
+
+	BLI_task_scheduler_free(scheduler);
+
+	BLI_threadapi_exit();
+}
+
+static void task_range_count(void *userdata, const int iter)
+{
+	size_t *counts = (size_t *)userdata;
+	atomic_add_and_fetch_z(&counts[iter % 2], 1);
+}
+
+TEST(task, ParallelRange)
+{
+	BLI_threadapi_init();
+
+	size_t counts[2] = {0, 0};
+	BLI_task_parallel_range(0, NUM_ITEMS, counts, task_range_count, true);
+
+	EXPECT_EQ(counts[0], NUM_ITEMS / 2);
+	EXPECT_EQ(counts[1], NUM_ITEMS / 2);
+
+	BLI_threadapi_exit();
+}
@@ -0,0 +1,146 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "PIL_time.h"
+}
+
+#define THREADS_NUM 8
+/* Allocations done by each thread, for each pattern. */
+#define ALLOCS_NUM 1000000
+/* Blocks alive at once in each thread. */
+#define ALIVE_NUM 1024
+
+namespace {
+
+struct ThreadData {
+	int seed;
+	/* Blocks allocated by this thread and freed by the previous one, for the cross thread pattern. */
+	void **blocks;
+	void **blocks_free;
+};
+
+unsigned int BlockSize(unsigned int *seed)
+{
+	/* Mostly small sizes, like most allocations in Blender, with the occasional bigger one. */
+	*seed = *seed * 1103515245u + 12345u;
+	const unsigned int r = (*seed >> 16) & 0xff;
+	return (r < 240) ? 8 + (r & 0x7f) : 512 + r * 8;
+}
+
+/* Allocate and free short-lived blocks, keeping a ring of blocks alive. */
+void *LocalThread(void *userdata)
+{
+	ThreadData *data = (ThreadData *)userdata;
+	unsigned int seed = (unsigned int)data->seed;
+	void *alive[ALIVE_NUM] = {NULL};
+
+	for (int i = 0; i < ALLOCS_NUM; i++) {
+		void **slot = &alive[i % ALIVE_NUM];
+		if (*slot) {
+			MEM_freeN(*slot);
+		}
+		*slot = MEM_mallocN(BlockSize(&seed), __func__);
+	}
+	for (int i = 0; i < ALIVE_NUM; i++) {
+		if (alive[i]) {
+			MEM_freeN(alive[i]);
+		}
+	}
+	return NULL;
+}
+
+/* Allocate blocks which are freed by another thread. */
+void *AllocThread(void *userdata)
+{
+	ThreadData *data = (ThreadData *)userdata;
+	unsigned int seed = (unsigned int)data->seed;
+
+	for (int i = 0; i < ALLOCS_NUM / 8; i++) {
+		data->blocks[i] = MEM_mallocN(BlockSize(&seed), __func__);
+	}
+	return NULL;
+}
+
+void *FreeThread(void *userdata)
+{
+	ThreadData *data = (ThreadData *)userdata;
+
+	for (int i = 0; i < ALLOCS_NUM / 8; i++) {
+		MEM_freeN(data->blocks_free[i]);
+	}
+	return NULL;
+}
+
+double RunThreads(void *(*func)(void *), ThreadData *data, const int threads_num)
+{
+	pthread_t threads[THREADS_NUM];
+	const double time_start = PIL_check_seconds_timer();
+
+	for (int t = 0; t < threads_num; t++) {
+		pthread_create(&threads[t], NULL, func, &data[t]);
+	}
+	for (int t = 0; t < threads_num; t++) {
+		pthread_join(threads[t], NULL);
+	}
+
+	return PIL_check_seconds_timer() - time_start;
+}
+
+void AllocPerformanceTest(const char *id)
+{
+	ThreadData data[THREADS_NUM];
+
+	printf("\n========== STARTING %s ==========\n", id);
+
+	for (int t = 0; t < THREADS_NUM; t++) {
+		data[t].seed = t;
+		data[t].blocks = (void **)malloc(sizeof(void *) * (ALLOCS_NUM / 8));
+	}
+
+	for (int threads_num = 1; threads_num <= THREADS_NUM; threads_num *= 2) {
+		const double time = RunThreads(LocalThread, data, threads_num);
+		printf("local, %d thread(s): %f s, %.1f M allocs/s\n",
+		       threads_num, time, (double)(threads_num * ALLOCS_NUM) / time * 1e-6);
+	}
+
+	{
+		double time = RunThreads(AllocThread, data, THREADS_NUM);
+		/* Each thread frees the blocks of the next one. */
+		for (int t = 0; t < THREADS_NUM; t++) {
+			data[t].blocks_free = data[(t + 1) % THREADS_NUM].blocks;
+		}
+		time += RunThreads(FreeThread, data, THREADS_NUM);
+		printf("cross thread, %d threads: %f s, %.1f M allocs/s\n",
+		       THREADS_NUM, time, (double)(THREADS_NUM * (ALLOCS_NUM / 8)) / time * 1e-6);
+	}
+
+	for (int t = 0; t < THREADS_NUM; t++) {
+		free(data[t].blocks);
+	}
+
+	EXPECT_EQ(0, MEM_get_memory_blocks_in_use());
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+}  // namespace
+
+/* Run in this order, the small allocator can't be disabled once used. */
+TEST(guardedalloc, LockfreePerformance)
+{
+	AllocPerformanceTest("Lock-free");
+}
+
+TEST(guardedalloc, LockfreeSmallPerformance)
+{
+	MEM_use_small_allocator();
+	AllocPerformanceTest("Lock-free & small blocks");
+}
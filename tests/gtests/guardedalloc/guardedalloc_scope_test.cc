@@ -0,0 +1,96 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <pthread.h>
+
+#include "MEM_guardedalloc.h"
+
+#define BLOCKS_NUM 100
+
+namespace {
+
+void *ThreadScope(void *userdata)
+{
+	/* The scope is per thread, new threads start without any. */
+	*(eMemScope *)userdata = MEM_scope_get();
+	return NULL;
+}
+
+void DoScopeChecks(void)
+{
+	const size_t undo_in_use = MEM_get_scope_memory_in_use(MEM_SCOPE_UNDO);
+	const size_t other_in_use = MEM_get_scope_memory_in_use(MEM_SCOPE_OTHER);
+	void *blocks[BLOCKS_NUM];
+	size_t len_total = 0;
+
+	EXPECT_EQ(MEM_SCOPE_OTHER, MEM_scope_get());
+
+	const eMemScope scope_prev = MEM_scope_begin(MEM_SCOPE_UNDO);
+	EXPECT_EQ(MEM_SCOPE_OTHER, scope_prev);
+	EXPECT_EQ(MEM_SCOPE_UNDO, MEM_scope_get());
+
+	/* Nested scopes. */
+	const eMemScope scope_nested = MEM_scope_begin(MEM_SCOPE_IMAGE);
+	EXPECT_EQ(MEM_SCOPE_UNDO, scope_nested);
+	MEM_scope_end(scope_nested);
+	EXPECT_EQ(MEM_SCOPE_UNDO, MEM_scope_get());
+
+	eMemScope thread_scope = MEM_SCOPE_TOT;
+	pthread_t thread;
+	pthread_create(&thread, NULL, ThreadScope, &thread_scope);
+	pthread_join(thread, NULL);
+	EXPECT_EQ(MEM_SCOPE_OTHER, thread_scope);
+
+	for (int i = 0; i < BLOCKS_NUM; i++) {
+		blocks[i] = (i % 3 == 0) ? MEM_mallocN((size_t)(i * 64 + 4), __func__) :
+		            (i % 3 == 1) ? MEM_callocN((size_t)(i * 64 + 4), __func__) :
+		                           MEM_mallocN_aligned((size_t)(i * 64 + 4), 16, __func__);
+		len_total += MEM_allocN_len(blocks[i]);
+	}
+
+	MEM_scope_end(scope_prev);
+	EXPECT_EQ(MEM_SCOPE_OTHER, MEM_scope_get());
+
+	EXPECT_EQ(undo_in_use + len_total, MEM_get_scope_memory_in_use(MEM_SCOPE_UNDO));
+	EXPECT_LE(undo_in_use + len_total, MEM_get_scope_peak_memory(MEM_SCOPE_UNDO));
+	EXPECT_EQ(other_in_use, MEM_get_scope_memory_in_use(MEM_SCOPE_OTHER));
+
+	/* Blocks are accounted to the scope they were allocated in, wherever they are freed. */
+	MEM_scope_begin(MEM_SCOPE_RENDER);
+	for (int i = 0; i < BLOCKS_NUM; i++) {
+		MEM_freeN(blocks[i]);
+	}
+	MEM_scope_end(MEM_SCOPE_OTHER);
+
+	EXPECT_EQ(undo_in_use, MEM_get_scope_memory_in_use(MEM_SCOPE_UNDO));
+	EXPECT_LE(undo_in_use + len_total, MEM_get_scope_peak_memory(MEM_SCOPE_UNDO));
+
+	MEM_reset_peak_memory();
+	EXPECT_EQ(undo_in_use, MEM_get_scope_peak_memory(MEM_SCOPE_UNDO));
+}
+
+}  // namespace
+
+TEST(guardedalloc, LockfreeScope)
+{
+	DoScopeChecks();
+}
+
+TEST(guardedalloc, LockfreeSmallScope)
+{
+	MEM_use_small_allocator();
+	DoScopeChecks();
+}
+
+TEST(guardedalloc, GuardedScope)
+{
+	MEM_use_guarded_allocator();
+	DoScopeChecks();
+}
+
+TEST(guardedalloc, ScopeNames)
+{
+	EXPECT_STREQ("Other", MEM_scope_name(MEM_SCOPE_OTHER));
+	EXPECT_STREQ("Undo", MEM_scope_name(MEM_SCOPE_UNDO));
+}
@@ -0,0 +1,151 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#define THREADS_NUM 4
+#define BLOCKS_NUM 10000
+
+namespace {
+
+/* Sizes covering all small size classes and some bigger blocks. */
+size_t BlockSize(const int i)
+{
+	return (size_t)(i % 600) + 1;
+}
+
+void *FreeBlocksThread(void *userdata)
+{
+	void **blocks = (void **)userdata;
+	for (int i = 0; i < BLOCKS_NUM; i++) {
+		MEM_freeN(blocks[i]);
+	}
+	return NULL;
+}
+
+void *AllocFreeBlocksThread(void *userdata)
+{
+	void **blocks = (void **)userdata;
+	for (int i = 0; i < BLOCKS_NUM; i++) {
+		blocks[i] = MEM_mallocN(BlockSize(i), __func__);
+		memset(blocks[i], i & 0xff, BlockSize(i));
+	}
+	for (int i = 0; i < BLOCKS_NUM; i++) {
+		const unsigned char *data = (const unsigned char *)blocks[i];
+		EXPECT_EQ(i & 0xff, data[0]);
+		EXPECT_EQ(i & 0xff, data[BlockSize(i) - 1]);
+		MEM_freeN(blocks[i]);
+	}
+	return NULL;
+}
+
+}  // namespace
+
+TEST(guardedalloc, SmallAllocStats)
+{
+	MEM_use_small_allocator();
+
+	const size_t mem_in_use = MEM_get_memory_in_use();
+	const unsigned int blocks_in_use = MEM_get_memory_blocks_in_use();
+	void **blocks = (void **)MEM_mallocN(sizeof(*blocks) * BLOCKS_NUM, __func__);
+	size_t len_total = 0;
+
+	for (int i = 0; i < BLOCKS_NUM; i++) {
+		blocks[i] = MEM_mallocN(BlockSize(i), __func__);
+		EXPECT_EQ((BlockSize(i) + 3) & ~(size_t)3, MEM_allocN_len(blocks[i]));
+		len_total += MEM_allocN_len(blocks[i]);
+	}
+
+	EXPECT_EQ(mem_in_use + MEM_allocN_len(blocks) + len_total, MEM_get_memory_in_use());
+	EXPECT_EQ(blocks_in_use + 1 + BLOCKS_NUM, MEM_get_memory_blocks_in_use());
+
+	for (int i = 0; i < BLOCKS_NUM; i++) {
+		MEM_freeN(blocks[i]);
+	}
+	MEM_freeN(blocks);
+
+	EXPECT_EQ(mem_in_use, MEM_get_memory_in_use());
+	EXPECT_EQ(blocks_in_use, MEM_get_memory_blocks_in_use());
+}
+
+TEST(guardedalloc, SmallAllocCallocRealloc)
+{
+	MEM_use_small_allocator();
+
+	/* Dirty a block, so the next one of the same size class is dirty too. */
+	char *data = (char *)MEM_mallocN(64, __func__);
+	memset(data, 0xff, 64);
+	MEM_freeN(data);
+
+	data = (char *)MEM_callocN(64, __func__);
+	for (int i = 0; i < 64; i++) {
+		EXPECT_EQ(0, data[i]);
+		data[i] = (char)i;
+	}
+
+	data = (char *)MEM_recallocN(data, 128);
+	for (int i = 0; i < 128; i++) {
+		EXPECT_EQ((i < 64) ? i : 0, data[i]);
+	}
+
+	char *data_dup = (char *)MEM_dupallocN(data);
+	EXPECT_EQ(0, memcmp(data, data_dup, 128));
+	MEM_freeN(data_dup);
+
+	data = (char *)MEM_reallocN(data, 16);
+	for (int i = 0; i < 16; i++) {
+		EXPECT_EQ(i, data[i]);
+	}
+
+	/* Grow beyond the small blocks. */
+	data = (char *)MEM_reallocN(data, 4096);
+	for (int i = 0; i < 16; i++) {
+		EXPECT_EQ(i, data[i]);
+	}
+	MEM_freeN(data);
+}
+
+TEST(guardedalloc, SmallAllocThreads)
+{
+	MEM_use_small_allocator();
+
+	const size_t mem_in_use = MEM_get_memory_in_use();
+	void *blocks[THREADS_NUM][BLOCKS_NUM];
+	pthread_t threads[THREADS_NUM];
+
+	/* Each thread allocating and freeing its own blocks. */
+	for (int t = 0; t < THREADS_NUM; t++) {
+		pthread_create(&threads[t], NULL, AllocFreeBlocksThread, blocks[t]);
+	}
+	for (int t = 0; t < THREADS_NUM; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	EXPECT_EQ(mem_in_use, MEM_get_memory_in_use());
+
+	/* Blocks freed by other threads than the one which allocated them. */
+	for (int t = 0; t < THREADS_NUM; t++) {
+		for (int i = 0; i < BLOCKS_NUM; i++) {
+			blocks[t][i] = MEM_mallocN(BlockSize(i), __func__);
+		}
+	}
+	for (int t = 0; t < THREADS_NUM; t++) {
+		pthread_create(&threads[t], NULL, FreeBlocksThread, blocks[t]);
+	}
+	for (int t = 0; t < THREADS_NUM; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	EXPECT_EQ(mem_in_use, MEM_get_memory_in_use());
+
+	/* Again, with the caches of the exited threads back in the global pool. */
+	for (int t = 0; t < THREADS_NUM; t++) {
+		pthread_create(&threads[t], NULL, AllocFreeBlocksThread, blocks[t]);
+	}
+	for (int t = 0; t < THREADS_NUM; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	EXPECT_EQ(mem_in_use, MEM_get_memory_in_use());
+}